@@ -0,0 +1,296 @@
+//--------------------------------------------------------------------------------
+// BenchCommon.h - Minimal timing harness shared by the SafeStrings benchmarks
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Each measurement runs the body a fixed number of times, repeats that a
+// handful of times, and keeps the fastest repetition - the one least
+// disturbed by interrupts, migrations and cold caches.
+//
+// MeasureCounted also reads the CPU's performance counters around each
+// repetition, through perf_event_open, and reports them per call for the
+// repetition it keeps.  Counters the kernel won't hand out - in a VM with no
+// PMU, with perf_event_paranoid above 2, or off Linux - come back as NaN
+// and the timing is unaffected.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Bench
+{
+    // DoNotOptimize
+    //
+    // Convinces the compiler that the memory behind p is read, so that the
+    // work which produced it can't be thrown away.
+
+    inline void DoNotOptimize(const void * p)
+    {
+        asm volatile("" : : "r"(p) : "memory");
+    }
+
+    // Opaque
+    //
+    // Returns p unchanged, but hides where it came from so the compiler
+    // can't specialize a call on a known argument - turning
+    // snprintf(buf, n, "%s", s) into a strcpy, for instance.
+
+    template <typename T>
+    inline T * Opaque(T * p)
+    {
+        asm volatile("" : "+r"(p));
+        return p;
+    }
+
+    // MeasureNs
+    //
+    // Best-of-cRepetitions average time, in nanoseconds, of one call to body.
+
+    template <typename Body>
+    double MeasureNs(size_t cIterations, Body && body, int cRepetitions = 5)
+    {
+        double nsBest = 1e300;
+        for (int rep = 0; rep < cRepetitions; rep++)
+        {
+            auto tStart = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < cIterations; i++)
+                body();
+            auto tEnd = std::chrono::steady_clock::now();
+
+            double ns = std::chrono::duration<double, std::nano>(tEnd - tStart).count() / cIterations;
+            nsBest = std::min(nsBest, ns);
+        }
+        return nsBest;
+    }
+
+    // Counter
+    //
+    // The counters MeasureCounted reports.  The cache counters are read
+    // misses: loads that missed the L1 data cache and the last level cache.
+
+    enum Counter
+    {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1DMisses,
+        LLCMisses,
+        c_cCounters
+    };
+
+    inline const char * CounterName(int iCounter)
+    {
+        static const char * const c_rgpszNames[c_cCounters] =
+        {
+            "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses"
+        };
+        return c_rgpszNames[iCounter];
+    }
+
+    // Counters
+    //
+    // One perf event per counter for the calling thread, user mode only.
+    // The events are inherited, so threads it starts after they're opened -
+    // the batch functions' worker pool, started on first use - count toward
+    // them too, and reading one sums them all.
+    // They're opened separately rather than as a group so that one the CPU
+    // lacks doesn't take the rest with it; when there are more than the
+    // hardware can count at once the kernel takes turns, and Stop scales
+    // each count up by the share of the time it was running.
+
+    class Counters
+    {
+    public:
+        Counters()
+        {
+            std::fill(_rgfd, _rgfd + c_cCounters, -1);
+
+#if defined(__linux__)
+            const uint64_t c_readMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const struct { uint32_t type; uint64_t config; } c_rgEvents[c_cCounters] =
+            {
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES          },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS        },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES       },
+                { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | c_readMiss },
+                { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL  | c_readMiss },
+            };
+
+            for (int iCounter = 0; iCounter < c_cCounters; iCounter++)
+            {
+                perf_event_attr attr = {};
+                attr.size           = sizeof attr;
+                attr.type           = c_rgEvents[iCounter].type;
+                attr.config         = c_rgEvents[iCounter].config;
+                attr.disabled       = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv     = 1;
+                attr.inherit        = 1;
+                attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                _rgfd[iCounter] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+            }
+#endif
+        }
+
+        ~Counters()
+        {
+#if defined(__linux__)
+            for (int fd : _rgfd)
+                if (fd >= 0)
+                    close(fd);
+#endif
+        }
+
+        Counters(const Counters &) = delete;
+        Counters & operator=(const Counters &) = delete;
+
+        bool Available(int iCounter) const
+        {
+            return _rgfd[iCounter] >= 0;
+        }
+
+        bool AnyAvailable() const
+        {
+            return std::any_of(_rgfd, _rgfd + c_cCounters, [](int fd) { return fd >= 0; });
+        }
+
+        void Start()
+        {
+#if defined(__linux__)
+            for (int fd : _rgfd)
+            {
+                if (fd >= 0)
+                {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+#endif
+        }
+
+        // Stop
+        //
+        // Stores each count since Start in rgCounts, or NaN for a counter
+        // that's unavailable or never got a turn.
+
+        void Stop(double rgCounts[c_cCounters])
+        {
+            std::fill(rgCounts, rgCounts + c_cCounters, NAN);
+
+#if defined(__linux__)
+            for (int fd : _rgfd)
+                if (fd >= 0)
+                    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+            for (int iCounter = 0; iCounter < c_cCounters; iCounter++)
+            {
+                struct { uint64_t value, timeEnabled, timeRunning; } reading;
+                if (_rgfd[iCounter] >= 0 &&
+                    read(_rgfd[iCounter], &reading, sizeof reading) == (ssize_t) sizeof reading &&
+                    reading.timeRunning > 0)
+                {
+                    rgCounts[iCounter] = (double) reading.value * reading.timeEnabled / reading.timeRunning;
+                }
+            }
+#endif
+        }
+
+    private:
+        int _rgfd[c_cCounters];
+    };
+
+    // MeasureCounted
+    //
+    // MeasureNs, along with the counts per call from the repetition whose
+    // time it keeps.
+
+    struct Measurement
+    {
+        double ns;
+        double rgPerCall[c_cCounters];
+    };
+
+    template <typename Body>
+    Measurement MeasureCounted(Counters & counters, size_t cIterations, Body && body, int cRepetitions = 5)
+    {
+        Measurement best;
+        best.ns = 1e300;
+        std::fill(best.rgPerCall, best.rgPerCall + c_cCounters, NAN);
+
+        for (int rep = 0; rep < cRepetitions; rep++)
+        {
+            double rgCounts[c_cCounters];
+
+            counters.Start();
+            auto tStart = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < cIterations; i++)
+                body();
+            auto tEnd = std::chrono::steady_clock::now();
+            counters.Stop(rgCounts);
+
+            double ns = std::chrono::duration<double, std::nano>(tEnd - tStart).count() / cIterations;
+            if (ns < best.ns)
+            {
+                best.ns = ns;
+                for (int iCounter = 0; iCounter < c_cCounters; iCounter++)
+                    best.rgPerCall[iCounter] = rgCounts[iCounter] / cIterations;
+            }
+        }
+        return best;
+    }
+
+    inline void PrintHeader(const char * pszTitle)
+    {
+        printf("%s\n", pszTitle);
+        printf("  %-40s %14s\n", "case", "ns/call");
+    }
+
+    inline void PrintResult(const char * pszCase, double ns)
+    {
+        printf("  %-40s %14.2f\n", pszCase, ns);
+    }
+
+    // PrintHeaderCounted / PrintCounted
+    //
+    // As PrintHeader and PrintResult, with the counters after the time.
+    // Both are divided by cPerCall, to report per item of a batch; a counter
+    // that couldn't be read prints as "-".
+
+    inline void PrintHeaderCounted(const char * pszTitle)
+    {
+        printf("%s\n", pszTitle);
+        printf("  %-40s %14s", "case", "ns");
+        for (int iCounter = 0; iCounter < c_cCounters; iCounter++)
+            printf(" %14s", CounterName(iCounter));
+        printf("\n");
+    }
+
+    inline void PrintCounted(const char * pszCase, const Measurement & measurement, double cPerCall = 1)
+    {
+        printf("  %-40s %14.2f", pszCase, measurement.ns / cPerCall);
+        for (int iCounter = 0; iCounter < c_cCounters; iCounter++)
+        {
+            if (isnan(measurement.rgPerCall[iCounter]))
+                printf(" %14s", "-");
+            else
+                printf(" %14.3f", measurement.rgPerCall[iCounter] / cPerCall);
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,663 @@
+//--------------------------------------------------------------------------------
+// CheatSheetBench.cpp - Every row of the cheat sheet, old function against new
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Times each "Olden Days" function against its "Hipsters" replacement on
+// strings from empty to 1MB, with hot and cold caches, and for the _s side
+// with an output that fits and one that doesn't.  The results are written
+// as JSON - to stdout, or to argv[1] - one record per case, so runs can be
+// kept and compared; progress goes to stderr.
+//
+// Where the kernel provides them, each record also carries the CPU's
+// counters - cycles, instructions, branch misses, L1 and last level cache
+// misses - per call and per byte of the string, which show why a case is
+// slow rather than just that it is.  The header lists the counters that
+// could be read; without any, the records carry times alone.
+//
+// Hot, every call reuses the same input and output.  Cold, each call gets
+// its own copy of the input and its own output, spread over twice the last
+// level cache, visited in a shuffled order and flushed from the cache before
+// timing starts, so each call begins with its strings in memory.
+//
+// glibc has no makepath, _splitpath, snscanf or gets, so those rows measure
+// what code written for it does instead: a hand-rolled unbounded path
+// builder and splitter, plain sscanf, and fgets with the newline stripped.
+// The old functions can't be told the output is too small, so they have no
+// truncation case; that side is null.  Truncation cases use a handler that
+// returns.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "SafeStrings.h"
+
+#include <limits.h>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const size_t c_rgcchLengths[] = { 0, 16, 256, 4 << 10, 64 << 10, 1 << 20 };
+
+    enum class Cache { Hot, Cold };
+    enum class Path  { Success, Truncation };
+
+    const char * c_rgpszCache[] = { "hot", "cold" };
+    const char * c_rgpszPath[]  = { "success", "truncation" };
+
+    // The pieces makepath joins and _splitpath takes apart around the word
+
+    const char c_szDrive[]  = "C";
+    const char c_szDir[]    = "\\foo\\";
+    const char c_szExt[]    = "txt";
+    const char c_szPrefix[] = "key=";
+
+    const char * g_pszFormatS = "%s";
+
+    size_t g_cchSink;
+    size_t g_cchInput;      // Length of the current input, for _snscanf_s
+
+    Bench::Counters * g_pCounters;
+
+    void QuietHandler(const wchar_t *, const wchar_t *, const wchar_t *, unsigned int, uintptr_t)
+    {
+    }
+
+    size_t RoundUp(size_t cb, size_t cbAlign)
+    {
+        return (cb + cbAlign - 1) / cbAlign * cbAlign;
+    }
+
+    std::string Word(size_t cch)
+    {
+        std::string str(cch, '\0');
+        for (size_t i = 0; i < cch; i++)
+            str[i] = 'a' + i % 26;
+        return str;
+    }
+
+    // Arena
+    //
+    // Inputs and outputs for one row at one length.  A slot is a copy of the
+    // input and an output buffer; hot there is one slot, cold as many as fit
+    // in the arena.
+
+    class Arena
+    {
+    public:
+        explicit Arena(size_t cb)
+          : _cb(cb),
+            _pbSource((char *) aligned_alloc(4096, cb)),
+            _pbDest((char *) aligned_alloc(4096, cb))
+        {
+            if (_pbSource == nullptr || _pbDest == nullptr)
+            {
+                fprintf(stderr, "Can't allocate two %zu MB arenas\n", cb >> 20);
+                exit(1);
+            }
+            memset(_pbSource, 0, cb);
+            memset(_pbDest, 0, cb);
+        }
+
+        ~Arena()
+        {
+            free(_pbSource);
+            free(_pbDest);
+        }
+
+        void Prepare(const std::string & strInput, size_t cbDest, Cache cache)
+        {
+            _cbSourceStride = RoundUp(strInput.size() + 1, 64);
+            _cbDestStride   = RoundUp(cbDest, 64);
+            _cSlots         = (cache == Cache::Hot) ? 1 : std::min(_cb / _cbSourceStride, _cb / _cbDestStride);
+
+            for (size_t iSlot = 0; iSlot < _cSlots; iSlot++)
+                memcpy(_pbSource + iSlot * _cbSourceStride, strInput.c_str(), strInput.size() + 1);
+
+            _rgiOrder.resize(_cSlots);
+            for (size_t iSlot = 0; iSlot < _cSlots; iSlot++)
+                _rgiOrder[iSlot] = (uint32_t) iSlot;
+            std::shuffle(_rgiOrder.begin(), _rgiOrder.end(), std::mt19937(42));
+            _iNext = 0;
+
+            if (cache == Cache::Cold)
+            {
+                Flush(_pbSource, _cSlots * _cbSourceStride);
+                Flush(_pbDest, _cSlots * _cbDestStride);
+            }
+        }
+
+        // Next
+        //
+        // The slot for the next call, carrying on through the order from one
+        // measurement to the next so a slot isn't revisited until every
+        // other one has been.
+
+        void Next(const char ** ppszSource, char ** ppchDest)
+        {
+            uint32_t iSlot = _rgiOrder[_iNext];
+            if (++_iNext == _cSlots)
+                _iNext = 0;
+
+            *ppszSource = _pbSource + iSlot * _cbSourceStride;
+            *ppchDest   = _pbDest + iSlot * _cbDestStride;
+        }
+
+    private:
+        static void Flush(const char * pb, size_t cb)
+        {
+#if defined(__SSE2__)
+            for (size_t ib = 0; ib < cb; ib += 64)
+                _mm_clflush(pb + ib);
+            _mm_mfence();
+#else
+            (void) pb;
+            (void) cb;
+#endif
+        }
+
+        size_t                _cb;
+        char *                _pbSource;
+        char *                _pbDest;
+        size_t                _cbSourceStride = 0;
+        size_t                _cbDestStride   = 0;
+        size_t                _cSlots         = 0;
+        size_t                _iNext          = 0;
+        std::vector<uint32_t> _rgiOrder;
+    };
+
+    // Iterations
+    //
+    // About 4MB of string per repetition, within limits.
+
+    size_t Iterations(size_t cch)
+    {
+        return std::clamp<size_t>((4 << 20) / (cch + 64), 16, 65536);
+    }
+
+    template <typename Body>
+    Bench::Measurement Measure(size_t cch, Body && body)
+    {
+        return Bench::MeasureCounted(*g_pCounters, Iterations(cch), body);
+    }
+
+    template <typename Body>
+    Bench::Measurement Measure(Arena & arena, size_t cch, Body && body)
+    {
+        return Measure(cch, [&]
+        {
+            const char * pszSource;
+            char *       pchDest;
+            arena.Next(&pszSource, &pchDest);
+            body(pszSource, pchDest);
+            Bench::DoNotOptimize(pchDest);
+        });
+    }
+
+    // Results
+    //
+    // One record per row, length, cache and path.  The truncation case has
+    // no legacy side.
+
+    struct Record
+    {
+        const char *       pszLegacy;
+        const char *       pszSafe;
+        size_t             cch;
+        Cache              cache;
+        Path               path;
+        bool               fLegacy;
+        Bench::Measurement legacy;
+        Bench::Measurement safe;
+    };
+
+    std::vector<Record> g_rgRecords;
+
+    // WriteCounters
+    //
+    // "name": { "cycles": ..., ... } with each available counter divided
+    // by divisor; a counter that didn't get a turn is null.
+
+    void WriteCounters(FILE * file, const char * pszName, const Bench::Measurement & measurement, double divisor)
+    {
+        fprintf(file, ", \"%s\": {", pszName);
+        const char * pszSeparator = " ";
+        for (int iCounter = 0; iCounter < Bench::c_cCounters; iCounter++)
+        {
+            if (!g_pCounters->Available(iCounter))
+                continue;
+
+            double count = measurement.rgPerCall[iCounter] / divisor;
+            if (isnan(count))
+                fprintf(file, "%s\"%s\": null", pszSeparator, Bench::CounterName(iCounter));
+            else
+                fprintf(file, "%s\"%s\": %.4g", pszSeparator, Bench::CounterName(iCounter), count);
+            pszSeparator = ", ";
+        }
+        fprintf(file, " }");
+    }
+
+    void WriteSide(FILE * file, const char * pszSide, bool fPresent, const Bench::Measurement & measurement, size_t cch)
+    {
+        char szName[32];
+        snprintf(szName, sizeof szName, "%s_ns", pszSide);
+        if (!fPresent)
+        {
+            fprintf(file, ", \"%s\": null", szName);
+            return;
+        }
+        fprintf(file, ", \"%s\": %.3f", szName, measurement.ns);
+
+        if (!g_pCounters->AnyAvailable())
+            return;
+
+        snprintf(szName, sizeof szName, "%s_per_call", pszSide);
+        WriteCounters(file, szName, measurement, 1);
+        if (cch > 0)
+        {
+            snprintf(szName, sizeof szName, "%s_per_byte", pszSide);
+            WriteCounters(file, szName, measurement, (double) cch);
+        }
+    }
+
+    void WriteJson(FILE * file)
+    {
+        fprintf(file, "{\n");
+        fprintf(file, "  \"benchmark\": \"CheatSheetBench\",\n");
+        fprintf(file, "  \"compiler\": \"%s\",\n", __VERSION__);
+        fprintf(file, "  \"llc_bytes\": %ld,\n", sysconf(_SC_LEVEL3_CACHE_SIZE));
+        fprintf(file, "  \"counters\": [");
+        const char * pszSeparator = "";
+        for (int iCounter = 0; iCounter < Bench::c_cCounters; iCounter++)
+        {
+            if (g_pCounters->Available(iCounter))
+            {
+                fprintf(file, "%s\"%s\"", pszSeparator, Bench::CounterName(iCounter));
+                pszSeparator = ", ";
+            }
+        }
+        fprintf(file, "],\n");
+        fprintf(file, "  \"results\": [\n");
+        for (size_t i = 0; i < g_rgRecords.size(); i++)
+        {
+            const Record & record = g_rgRecords[i];
+            fprintf(file, "    { \"legacy\": \"%s\", \"safe\": \"%s\", \"length\": %zu, \"cache\": \"%s\", \"path\": \"%s\"",
+                    record.pszLegacy, record.pszSafe, record.cch,
+                    c_rgpszCache[(int) record.cache], c_rgpszPath[(int) record.path]);
+            WriteSide(file, "legacy", record.fLegacy, record.legacy, record.cch);
+            WriteSide(file, "safe", true, record.safe, record.cch);
+            fprintf(file, " }%s\n", (i + 1 < g_rgRecords.size()) ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+    }
+
+    // Row
+    //
+    // One cheat sheet row: what the input looks like, and how many bytes of
+    // output the word needs around it.
+
+    enum class Input { Word, Path };
+
+    struct Row
+    {
+        const char * pszLegacy;
+        const char * pszSafe;
+        Input        input;
+        size_t       cbExtra;       // Output bytes needed beyond the word
+    };
+
+    // RunRow
+    //
+    // legacy(source, dest) and safe(source, dest, cbDest) for every length,
+    // cache and path.  The truncation case leaves room for only half the
+    // word.
+
+    template <typename Legacy, typename Safe>
+    void RunRow(Arena & arena, const Row & row, Legacy && legacy, Safe && safe)
+    {
+        fprintf(stderr, "%s -> %s\n", row.pszLegacy, row.pszSafe);
+
+        for (size_t cch : c_rgcchLengths)
+        {
+            std::string strWord  = Word(cch);
+            std::string strInput = (row.input == Input::Path)
+                                 ? std::string("C:") + c_szDir + strWord + "." + c_szExt
+                                 : strWord;
+
+            size_t cbNeeded = cch + row.cbExtra;
+            g_cchInput = strInput.size();
+
+            for (Cache cache : { Cache::Hot, Cache::Cold })
+            {
+                arena.Prepare(strInput, cbNeeded, cache);
+
+                Record record = { row.pszLegacy, row.pszSafe, cch, cache, Path::Success, true, {}, {} };
+                record.legacy = Measure(arena, cch, legacy);
+                record.safe   = Measure(arena, cch, [&](const char * pszSource, char * pchDest)
+                {
+                    safe(pszSource, pchDest, cbNeeded);
+                });
+                g_rgRecords.push_back(record);
+
+                // An empty word always fits
+
+                if (cch == 0)
+                    continue;
+
+                size_t cbTruncated = cbNeeded - (cch + 1) / 2;
+                record = { row.pszLegacy, row.pszSafe, cch, cache, Path::Truncation, false, {}, {} };
+                record.safe = Measure(arena, cch, [&](const char * pszSource, char * pchDest)
+                {
+                    safe(pszSource, pchDest, cbTruncated);
+                });
+                g_rgRecords.push_back(record);
+            }
+        }
+    }
+
+    // The stand-ins for what glibc doesn't have
+
+    void LegacyMakePath(char * path, const char * drive, const char * dir, const char * fname, const char * ext)
+    {
+        char * p = path;
+        if (*drive)
+        {
+            *p++ = *drive;
+            *p++ = ':';
+        }
+
+        size_t cch = strlen(dir);
+        memcpy(p, dir, cch);
+        p += cch;
+        if (cch > 0 && p[-1] != '\\' && p[-1] != '/')
+            *p++ = '\\';
+
+        cch = strlen(fname);
+        memcpy(p, fname, cch);
+        p += cch;
+
+        if (*ext)
+        {
+            if (*ext != '.')
+                *p++ = '.';
+            cch = strlen(ext);
+            memcpy(p, ext, cch);
+            p += cch;
+        }
+        *p = '\0';
+    }
+
+    void LegacySplitPath(const char * path, char * drive, char * dir, char * fname, char * ext)
+    {
+        const char * p = path;
+        drive[0] = '\0';
+        if (p[0] != '\0' && p[1] == ':')
+        {
+            memcpy(drive, p, 2);
+            drive[2] = '\0';
+            p += 2;
+        }
+
+        const char * pName = p;
+        const char * pDot  = nullptr;
+        for (const char * pch = p; *pch; pch++)
+        {
+            if (*pch == '\\' || *pch == '/')
+            {
+                pName = pch + 1;
+                pDot  = nullptr;
+            }
+            else if (*pch == '.')
+            {
+                pDot = pch;
+            }
+        }
+        const char * pEnd = pName + strlen(pName);
+        if (pDot == nullptr)
+            pDot = pEnd;
+
+        memcpy(dir, p, pName - p);
+        dir[pName - p] = '\0';
+        memcpy(fname, pName, pDot - pName);
+        fname[pDot - pName] = '\0';
+        memcpy(ext, pDot, pEnd - pDot + 1);
+    }
+
+    int LegacyVsprintf(char * buffer, const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int result = vsprintf(buffer, format, args);
+        va_end(args);
+        return result;
+    }
+
+    int SafeVsnprintf(char * buffer, size_t sizeOfBuffer, const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int result = vsnprintf_s(buffer, sizeOfBuffer, _TRUNCATE, format, args);
+        va_end(args);
+        return result;
+    }
+
+    // RunGets
+    //
+    // Lines read through stdin from a file of copies of the word, starting
+    // over at the end.  The line comes through stdio's buffer either way, so
+    // there's only the hot case.
+
+    void RunGets()
+    {
+        fprintf(stderr, "gets -> gets_s\n");
+
+        char szPath[] = "/tmp/CheatSheetBenchXXXXXX";
+        int  fd = mkstemp(szPath);
+        if (fd < 0)
+        {
+            perror("mkstemp");
+            exit(1);
+        }
+        close(fd);
+
+        for (size_t cch : c_rgcchLengths)
+        {
+            std::string strLine = Word(cch) + "\n";
+            FILE * file = fopen(szPath, "wb");
+            if (file == nullptr)
+            {
+                perror(szPath);
+                exit(1);
+            }
+            size_t cLines = std::max<size_t>(16, (4 << 20) / strLine.size());
+            for (size_t iLine = 0; iLine < cLines; iLine++)
+                fwrite(strLine.data(), 1, strLine.size(), file);
+            fclose(file);
+
+            if (freopen(szPath, "rb", stdin) == nullptr)
+            {
+                perror(szPath);
+                exit(1);
+            }
+
+            std::vector<char> rgchBuffer(cch + 2);
+            char * buffer = rgchBuffer.data();
+
+            auto legacy = [&]
+            {
+                if (fgets(buffer, INT_MAX, stdin) == nullptr)
+                {
+                    rewind(stdin);
+                    fgets(buffer, INT_MAX, stdin);
+                }
+                size_t cchLine = strlen(buffer);
+                if (cchLine > 0 && buffer[cchLine - 1] == '\n')
+                    buffer[cchLine - 1] = '\0';
+                Bench::DoNotOptimize(buffer);
+            };
+
+            auto safe = [&](size_t cb)
+            {
+                if (gets_s(buffer, cb) == nullptr && feof(stdin))
+                {
+                    rewind(stdin);
+                    gets_s(buffer, cb);
+                }
+                Bench::DoNotOptimize(buffer);
+            };
+
+            Record record = { "gets", "gets_s", cch, Cache::Hot, Path::Success, true, {}, {} };
+            record.legacy = Measure(cch, legacy);
+            record.safe   = Measure(cch, [&] { safe(cch + 1); });
+            g_rgRecords.push_back(record);
+
+            if (cch > 0)
+            {
+                size_t cbTruncated = cch + 1 - (cch + 1) / 2;
+                record = { "gets", "gets_s", cch, Cache::Hot, Path::Truncation, false, {}, {} };
+                record.safe = Measure(cch, [&] { safe(cbTruncated); });
+                g_rgRecords.push_back(record);
+            }
+        }
+
+        unlink(szPath);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    _set_invalid_parameter_handler(QuietHandler);
+
+    Bench::Counters counters;
+    g_pCounters = &counters;
+    for (int iCounter = 0; iCounter < Bench::c_cCounters; iCounter++)
+        if (!counters.Available(iCounter))
+            fprintf(stderr, "No %s counter; it won't be reported\n", Bench::CounterName(iCounter));
+
+    long cbCache = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    Arena arena(RoundUp(2 * (size_t) (cbCache > 0 ? cbCache : 32 << 20), 4096));
+
+    RunRow(arena, { "strlen", "strnlen_s", Input::Word, 1 },
+        [](const char * pszSource, char *)
+        {
+            g_cchSink += strlen(pszSource);
+        },
+        [](const char * pszSource, char *, size_t cb)
+        {
+            g_cchSink += strnlen_s(pszSource, cb);
+        });
+
+    RunRow(arena, { "strcpy", "strcpy_s", Input::Word, 1 },
+        [](const char * pszSource, char * pchDest)
+        {
+            strcpy(pchDest, pszSource);
+        },
+        [](const char * pszSource, char * pchDest, size_t cb)
+        {
+            strcpy_s(pchDest, cb, pszSource);
+        });
+
+    RunRow(arena, { "strcat", "strcat_s", Input::Word, sizeof c_szPrefix },
+        [](const char * pszSource, char * pchDest)
+        {
+            memcpy(pchDest, c_szPrefix, sizeof c_szPrefix);
+            strcat(pchDest, pszSource);
+        },
+        [](const char * pszSource, char * pchDest, size_t cb)
+        {
+            memcpy(pchDest, c_szPrefix, sizeof c_szPrefix);
+            strcat_s(pchDest, cb, pszSource);
+        });
+
+    RunRow(arena, { "sprintf", "_snprintf_s", Input::Word, 1 },
+        [](const char * pszSource, char * pchDest)
+        {
+            sprintf(pchDest, Bench::Opaque(g_pszFormatS), pszSource);
+        },
+        [](const char * pszSource, char * pchDest, size_t cb)
+        {
+            _snprintf_s(pchDest, cb, _TRUNCATE, Bench::Opaque(g_pszFormatS), pszSource);
+        });
+
+    RunRow(arena, { "vsprintf", "vsnprintf_s", Input::Word, 1 },
+        [](const char * pszSource, char * pchDest)
+        {
+            LegacyVsprintf(pchDest, Bench::Opaque(g_pszFormatS), pszSource);
+        },
+        [](const char * pszSource, char * pchDest, size_t cb)
+        {
+            SafeVsnprintf(pchDest, cb, Bench::Opaque(g_pszFormatS), pszSource);
+        });
+
+    // "C:" + dir + word + "." + ext and a terminator
+
+    RunRow(arena, { "makepath", "_makepath_s", Input::Word, 2 + strlen(c_szDir) + 1 + strlen(c_szExt) + 1 },
+        [](const char * pszSource, char * pchDest)
+        {
+            LegacyMakePath(pchDest, c_szDrive, c_szDir, pszSource, c_szExt);
+        },
+        [](const char * pszSource, char * pchDest, size_t cb)
+        {
+            _makepath_s(pchDest, cb, c_szDrive, c_szDir, pszSource, c_szExt);
+        });
+
+    // The output measured is the file name; the other parts are short
+
+    static char s_szDrive[_MAX_DRIVE], s_szDir[_MAX_DIR], s_szExt[_MAX_EXT];
+
+    RunRow(arena, { "_splitpath", "_splitpath_s", Input::Path, 1 },
+        [](const char * pszSource, char * pchDest)
+        {
+            LegacySplitPath(pszSource, s_szDrive, s_szDir, pchDest, s_szExt);
+        },
+        [](const char * pszSource, char * pchDest, size_t cb)
+        {
+            _splitpath_s(pszSource, s_szDrive, sizeof s_szDrive, s_szDir, sizeof s_szDir,
+                         pchDest, cb, s_szExt, sizeof s_szExt);
+        });
+
+    RunRow(arena, { "sscanf", "sscanf_s", Input::Word, 1 },
+        [](const char * pszSource, char * pchDest)
+        {
+            g_cchSink += sscanf(pszSource, Bench::Opaque(g_pszFormatS), pchDest);
+        },
+        [](const char * pszSource, char * pchDest, size_t cb)
+        {
+            g_cchSink += sscanf_s(pszSource, Bench::Opaque(g_pszFormatS), pchDest, (rsize_t) cb);
+        });
+
+    RunRow(arena, { "sscanf", "_snscanf_s", Input::Word, 1 },
+        [](const char * pszSource, char * pchDest)
+        {
+            g_cchSink += sscanf(pszSource, Bench::Opaque(g_pszFormatS), pchDest);
+        },
+        [](const char * pszSource, char * pchDest, size_t cb)
+        {
+            g_cchSink += _snscanf_s(pszSource, g_cchInput, Bench::Opaque(g_pszFormatS), pchDest, (rsize_t) cb);
+        });
+
+    RunGets();
+
+    FILE * file = (argc > 1) ? fopen(argv[1], "w") : stdout;
+    if (file == nullptr)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    WriteJson(file);
+    if (file != stdout)
+        fclose(file);
+
+    fprintf(stderr, "%zu cases\n", g_rgRecords.size());
+    return 0;
+}
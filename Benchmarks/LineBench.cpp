@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------------
+// LineBench.cpp - LineReader vs. gets_s and fgets on a large file
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Writes a temporary file of lines between 8 and 120 characters long (256MB
+// by default, or argv[1] MB), then reads it back through stdin each way.
+// The file is read once first so every pass comes from the page cache.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "LineReader.h"
+#include "SafeStrings.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace
+{
+    // ReadAll
+    //
+    // One pass over the file on stdin; returns the number of lines and the
+    // best-of-three seconds taken.
+
+    template <typename Body>
+    size_t ReadAll(const char * pszPath, double & secBest, Body && body)
+    {
+        size_t cLines = 0;
+        secBest = 1e300;
+        for (int rep = 0; rep < 3; rep++)
+        {
+            if (freopen(pszPath, "rb", stdin) == nullptr)
+            {
+                perror(pszPath);
+                exit(1);
+            }
+
+            auto tStart = std::chrono::steady_clock::now();
+            cLines = body();
+            auto tEnd = std::chrono::steady_clock::now();
+            secBest = std::min(secBest, std::chrono::duration<double>(tEnd - tStart).count());
+        }
+        return cLines;
+    }
+
+    void Report(const char * pszCase, size_t cLines, size_t cbFile, double sec)
+    {
+        char szCase[64];
+        snprintf(szCase, sizeof szCase, "%s (%.0f MB/s)", pszCase, cbFile / sec / 1e6);
+        Bench::PrintResult(szCase, sec * 1e9 / cLines);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t cbTarget = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 256) << 20;
+
+    char szPath[] = "/tmp/LineBenchXXXXXX";
+    int  fd = mkstemp(szPath);
+    FILE * file = (fd >= 0) ? fdopen(fd, "wb") : nullptr;
+    if (file == nullptr)
+    {
+        perror("mkstemp");
+        return 1;
+    }
+
+    uint32_t seed   = 12345;
+    size_t   cbFile = 0;
+    char     szLine[128];
+    while (cbFile < cbTarget)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t cch = 8 + (seed >> 16) % 113;
+        for (size_t i = 0; i < cch; i++)
+            szLine[i] = 'a' + (i + seed) % 26;
+        szLine[cch] = '\n';
+        fwrite(szLine, 1, cch + 1, file);
+        cbFile += cch + 1;
+    }
+    fclose(file);
+
+    double sec;
+    char   szBuffer[4096];
+    size_t cLines;
+
+    Bench::PrintHeader("Reading lines from stdin (ns per line)");
+
+    cLines = ReadAll(szPath, sec, [&]
+    {
+        size_t c = 0;
+        while (gets_s(szBuffer, sizeof szBuffer) != nullptr)
+            c++;
+        return c;
+    });
+    Report("gets_s", cLines, cbFile, sec);
+
+    cLines = ReadAll(szPath, sec, [&]
+    {
+        size_t c = 0;
+        while (fgets(szBuffer, sizeof szBuffer, stdin) != nullptr)
+            c++;
+        return c;
+    });
+    Report("fgets", cLines, cbFile, sec);
+
+    cLines = ReadAll(szPath, sec, [&]
+    {
+        SafeStrings::LineReader reader(stdin, sizeof szBuffer - 1);
+        std::string_view line;
+        size_t c = 0;
+        while (reader.ReadLine(line))
+        {
+            Bench::DoNotOptimize(line.data());
+            c++;
+        }
+        return c;
+    });
+    Report("LineReader", cLines, cbFile, sec);
+
+    unlink(szPath);
+    return 0;
+}
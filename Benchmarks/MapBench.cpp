@@ -0,0 +1,172 @@
+//--------------------------------------------------------------------------------
+// MapBench.cpp - MappedFile vs. a gets_s loop over a large on-disk file
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Writes a temporary file of "name value count" records (10GB by default,
+// or argv[1] GB) and reads it back line by line, then line and fields, each
+// way.  Every case takes the best of two passes; a file larger than memory
+// comes from disk every time, a smaller one from the page cache.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "LineReader.h"
+#include "MappedFile.h"
+#include "SafeStrings.h"
+#include "Tokenizer.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace
+{
+    template <typename Body>
+    size_t Time(const char * pszPath, double & secBest, Body && body)
+    {
+        size_t cLines = 0;
+        secBest = 1e300;
+        for (int rep = 0; rep < 2; rep++)
+        {
+            if (freopen(pszPath, "rb", stdin) == nullptr)
+            {
+                perror(pszPath);
+                exit(1);
+            }
+
+            auto tStart = std::chrono::steady_clock::now();
+            cLines = body();
+            auto tEnd = std::chrono::steady_clock::now();
+            secBest = std::min(secBest, std::chrono::duration<double>(tEnd - tStart).count());
+        }
+        return cLines;
+    }
+
+    void Report(const char * pszCase, size_t cLines, size_t cbFile, double sec)
+    {
+        char szCase[64];
+        snprintf(szCase, sizeof szCase, "%s (%.0f MB/s)", pszCase, cbFile / sec / 1e6);
+        Bench::PrintResult(szCase, sec * 1e9 / cLines);
+    }
+
+    size_t MappedLines(const char * pszPath, SafeStrings::MapOptions options)
+    {
+        SafeStrings::MappedFile file(pszPath, options);
+        SafeStrings::LineCursor lines(file.View());
+        std::string_view line;
+        size_t c = 0;
+        while (lines.ReadLine(line))
+        {
+            Bench::DoNotOptimize(line.data());
+            c++;
+        }
+        return c;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t cbTarget = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 10) << 30;
+
+    char szPath[] = "/tmp/MapBenchXXXXXX";
+    int  fd = mkstemp(szPath);
+    FILE * file = (fd >= 0) ? fdopen(fd, "wb") : nullptr;
+    if (file == nullptr)
+    {
+        perror("mkstemp");
+        return 1;
+    }
+
+    uint32_t seed   = 12345;
+    size_t   cbFile = 0;
+    char     szLine[128];
+    while (cbFile < cbTarget)
+    {
+        seed = seed * 1103515245 + 12345;
+        int cch = snprintf(szLine, sizeof szLine, "sensor%u %u.%02u %u\n",
+                           seed >> 24, (seed >> 8) & 0xffff, seed & 0x3f, seed >> 12);
+        fwrite(szLine, 1, cch, file);
+        cbFile += cch;
+    }
+    fclose(file);
+
+    double sec;
+    char   szBuffer[4096];
+    size_t cLines;
+
+    Bench::PrintHeader("Lines (ns per line)");
+
+    cLines = Time(szPath, sec, [&]
+    {
+        size_t c = 0;
+        while (gets_s(szBuffer, sizeof szBuffer) != nullptr)
+            c++;
+        return c;
+    });
+    Report("gets_s", cLines, cbFile, sec);
+
+    cLines = Time(szPath, sec, [&]
+    {
+        SafeStrings::LineReader reader(stdin, sizeof szBuffer - 1);
+        std::string_view line;
+        size_t c = 0;
+        while (reader.ReadLine(line))
+        {
+            Bench::DoNotOptimize(line.data());
+            c++;
+        }
+        return c;
+    });
+    Report("LineReader", cLines, cbFile, sec);
+
+    cLines = Time(szPath, sec, [&] { return MappedLines(szPath, SafeStrings::MapOptions()); });
+    Report("MappedFile", cLines, cbFile, sec);
+
+    SafeStrings::MapOptions huge;
+    huge.fHugePages = true;
+    cLines = Time(szPath, sec, [&] { return MappedLines(szPath, huge); });
+    Report("MappedFile, huge pages", cLines, cbFile, sec);
+
+    char     szName[32];
+    char     szValue[32];
+    unsigned count;
+
+    printf("\n");
+    Bench::PrintHeader("Lines and fields (ns per line)");
+
+    cLines = Time(szPath, sec, [&]
+    {
+        size_t c = 0;
+        while (gets_s(szBuffer, sizeof szBuffer) != nullptr)
+        {
+            _snscanf_s(szBuffer, sizeof szBuffer, "%s %s %u", szName, sizeof szName, szValue, sizeof szValue, &count);
+            c++;
+        }
+        return c;
+    });
+    Report("gets_s, _snscanf_s", cLines, cbFile, sec);
+
+    cLines = Time(szPath, sec, [&]
+    {
+        SafeStrings::MappedFile mapped(szPath);
+        SafeStrings::LineCursor lines(mapped.View());
+        std::string_view line;
+        std::string_view rgFields[3];
+        size_t c = 0;
+        while (lines.ReadLine(line))
+        {
+            SafeStrings::Tokenize(line.data(), line.size(), rgFields);
+            Bench::DoNotOptimize(rgFields);
+            c++;
+        }
+        return c;
+    });
+    Report("MappedFile, Tokenize", cLines, cbFile, sec);
+
+    unlink(szPath);
+    return 0;
+}
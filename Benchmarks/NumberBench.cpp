@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------------
+// NumberBench.cpp - ParseNumber vs. sscanf_s, strtol and strtod
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Parses integers and floats of mixed lengths, cycling through a table so
+// that no one length is learned by the branch predictor.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "NumberParse.h"
+#include "SafeStrings.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+    const char * const g_rgszIntegers[] =
+    {
+        "7", "-42", "65535", "123456789", "-2147483648", "8080", "31337", "1000000",
+    };
+
+    const char * const g_rgszFloats[] =
+    {
+        "21.5", "-4.25", "0.0031", "1013.25", "3.14159265358979", "12.5e-3", "6.02214076e23", "-0.5",
+    };
+
+    size_t g_rgcchIntegers[8];
+    size_t g_rgcchFloats[8];
+}
+
+int main()
+{
+    const size_t cIterations = 2000000;
+    size_t i = 0;
+
+    for (size_t j = 0; j < 8; j++)
+    {
+        g_rgcchIntegers[j] = strlen(g_rgszIntegers[j]);
+        g_rgcchFloats[j]   = strlen(g_rgszFloats[j]);
+    }
+
+    int value;
+
+    Bench::PrintHeader("int");
+
+    Bench::PrintResult("sscanf_s(\"%d\")", Bench::MeasureNs(cIterations, [&]
+    {
+        sscanf_s(Bench::Opaque(g_rgszIntegers[i++ & 7]), "%d", &value);
+        Bench::DoNotOptimize(&value);
+    }));
+
+    Bench::PrintResult("strtol", Bench::MeasureNs(cIterations, [&]
+    {
+        value = (int) strtol(Bench::Opaque(g_rgszIntegers[i++ & 7]), nullptr, 10);
+        Bench::DoNotOptimize(&value);
+    }));
+
+    Bench::PrintResult("ParseNumber", Bench::MeasureNs(cIterations, [&]
+    {
+        size_t j = i++ & 7;
+        SafeStrings::ParseNumber(Bench::Opaque(g_rgszIntegers[j]), g_rgcchIntegers[j], value);
+        Bench::DoNotOptimize(&value);
+    }));
+
+    double number;
+
+    printf("\n");
+    Bench::PrintHeader("double");
+
+    Bench::PrintResult("sscanf_s(\"%lf\")", Bench::MeasureNs(cIterations, [&]
+    {
+        sscanf_s(Bench::Opaque(g_rgszFloats[i++ & 7]), "%lf", &number);
+        Bench::DoNotOptimize(&number);
+    }));
+
+    Bench::PrintResult("strtod", Bench::MeasureNs(cIterations, [&]
+    {
+        number = strtod(Bench::Opaque(g_rgszFloats[i++ & 7]), nullptr);
+        Bench::DoNotOptimize(&number);
+    }));
+
+    Bench::PrintResult("ParseNumber", Bench::MeasureNs(cIterations, [&]
+    {
+        size_t j = i++ & 7;
+        SafeStrings::ParseNumber(Bench::Opaque(g_rgszFloats[j]), g_rgcchFloats[j], number);
+        Bench::DoNotOptimize(&number);
+    }));
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+//--------------------------------------------------------------------------------
+// PathBench.cpp - SplitPath views vs. _splitpath_s into _MAX_* buffers
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Splits a few thousand file-tree shaped paths, cycling through them so the
+// branch predictor can't learn any one path.  _splitpath_s copies into the
+// four worst-case buffers the demo uses; SplitPath just finds the parts.
+//
+// The second half splits a whole catalog - a million distinct paths, far
+// more than fit in cache - then a hundred passes over it for 100M paths,
+// comparing a _splitpath_s loop with the batch functions.  Pass the number
+// of passes for the long run as the first argument (0 skips it).  Along
+// with the time, the catalog runs report the CPU's counters per path -
+// cache misses above all, as the catalog streams through memory - summed
+// over the worker pool's threads as well as the caller's.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "PathBatch.h"
+#include "PathParts.h"
+#include "SafeStrings.h"
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::vector<std::string> MakePaths(size_t cPaths)
+    {
+        static const char * const rgszDirs[]  = { "Users", "dev", "src", "SafeStrings", "Benchmarks", "build",
+                                                  "Release", "obj", "include", "third_party" };
+        static const char * const rgszExts[]  = { ".cpp", ".h", ".txt", ".obj", "", ".tar.gz" };
+
+        std::vector<std::string> paths;
+        unsigned seed = 12345;
+        for (size_t i = 0; i < cPaths; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            std::string str = (seed & 0x100) ? "C:" : "";
+            for (unsigned cDirs = 1 + (seed >> 16) % 6; cDirs > 0; cDirs--)
+            {
+                seed = seed * 1103515245 + 12345;
+                str += '\\';
+                str += rgszDirs[(seed >> 16) % std::size(rgszDirs)];
+            }
+            str += "\\file";
+            str += std::to_string(i);
+            str += rgszExts[(seed >> 8) % std::size(rgszExts)];
+            paths.push_back(std::move(str));
+        }
+        return paths;
+    }
+
+    // CompareCatalog
+    //
+    // ns and counts per path for cPasses passes over every path in the
+    // catalog.
+
+    void CompareCatalog(Bench::Counters & counters, const std::vector<std::string> & paths, size_t cPasses,
+                        int cRepetitions)
+    {
+        const size_t cPaths = paths.size();
+
+        std::vector<const char *> rgpszPaths;
+        std::string               strArena;
+        for (const std::string & str : paths)
+        {
+            rgpszPaths.push_back(str.c_str());
+            strArena.append(str.c_str(), str.size() + 1);
+        }
+
+        std::vector<uint32_t> rgichDir(cPaths), rgichFname(cPaths), rgichExt(cPaths), rgichEnd(cPaths);
+        std::vector<size_t>   rgibStart(cPaths);
+        SafeStrings::SplitPathColumns columns =
+            { rgichDir.data(), rgichFname.data(), rgichExt.data(), rgichEnd.data(), rgibStart.data() };
+
+        SafeStrings::SplitPathOptions optionsAll;
+        optionsAll.cThreads = 0;
+
+        char szDrive [_MAX_DRIVE];
+        char szFolder[_MAX_DIR];
+        char szFile  [_MAX_FNAME];
+        char szExt   [_MAX_EXT];
+
+        char szTitle[80];
+        snprintf(szTitle, sizeof szTitle, "Splitting %zuM paths (per path)", cPaths * cPasses / 1000000);
+        Bench::PrintHeaderCounted(szTitle);
+
+        auto Print = [&](const char * pszCase, const Bench::Measurement & measurement)
+        {
+            Bench::PrintCounted(pszCase, measurement, (double) cPaths);
+        };
+
+        Print("_splitpath_s loop", Bench::MeasureCounted(counters, cPasses, [&]
+        {
+            for (const char * pszPath : rgpszPaths)
+            {
+                _splitpath_s(pszPath, szDrive, sizeof szDrive, szFolder, sizeof szFolder,
+                             szFile, sizeof szFile, szExt, sizeof szExt);
+                Bench::DoNotOptimize(szExt);
+            }
+        }, cRepetitions));
+
+        Print("SplitPaths", Bench::MeasureCounted(counters, cPasses, [&]
+        {
+            SafeStrings::SplitPaths(rgpszPaths.data(), cPaths, columns);
+            Bench::DoNotOptimize(rgichEnd.data());
+        }, cRepetitions));
+
+        Print("SplitPathArena", Bench::MeasureCounted(counters, cPasses, [&]
+        {
+            SafeStrings::SplitPathArena(strArena.data(), strArena.size(), cPaths, columns);
+            Bench::DoNotOptimize(rgichEnd.data());
+        }, cRepetitions));
+
+        Print("SplitPaths, all threads", Bench::MeasureCounted(counters, cPasses, [&]
+        {
+            SafeStrings::SplitPaths(rgpszPaths.data(), cPaths, columns, optionsAll);
+            Bench::DoNotOptimize(rgichEnd.data());
+        }, cRepetitions));
+
+        Print("SplitPathArena, all threads", Bench::MeasureCounted(counters, cPasses, [&]
+        {
+            SafeStrings::SplitPathArena(strArena.data(), strArena.size(), cPaths, columns, optionsAll);
+            Bench::DoNotOptimize(rgichEnd.data());
+        }, cRepetitions));
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    // Opened before anything starts the worker pool, so its threads inherit
+    // the counters
+
+    Bench::Counters counters;
+    for (int iCounter = 0; iCounter < Bench::c_cCounters; iCounter++)
+        if (!counters.Available(iCounter))
+            fprintf(stderr, "No %s counter; it won't be reported\n", Bench::CounterName(iCounter));
+
+    const std::vector<std::string> paths = MakePaths(4096);
+    const size_t cIterations = 1000000;
+    size_t iPath = 0;
+
+    Bench::PrintHeader("Splitting a path into its four parts");
+
+    char szDrive [_MAX_DRIVE];
+    char szFolder[_MAX_DIR];
+    char szFile  [_MAX_FNAME];
+    char szExt   [_MAX_EXT];
+
+    Bench::PrintResult("_splitpath_s", Bench::MeasureNs(cIterations, [&]
+    {
+        const char * pszPath = paths[iPath++ & 4095].c_str();
+        _splitpath_s(pszPath, szDrive, sizeof szDrive, szFolder, sizeof szFolder,
+                     szFile, sizeof szFile, szExt, sizeof szExt);
+        Bench::DoNotOptimize(szExt);
+    }));
+
+    Bench::PrintResult("SplitPath(const char *)", Bench::MeasureNs(cIterations, [&]
+    {
+        SafeStrings::PathParts parts;
+        SafeStrings::SplitPath(paths[iPath++ & 4095].c_str(), parts);
+        Bench::DoNotOptimize(&parts);
+    }));
+
+    Bench::PrintResult("SplitPath(string_view)", Bench::MeasureNs(cIterations, [&]
+    {
+        SafeStrings::PathParts parts = SafeStrings::SplitPath(paths[iPath++ & 4095]);
+        Bench::DoNotOptimize(&parts);
+    }));
+
+    const std::vector<std::string> catalog = MakePaths(1000000);
+    const size_t cPassesLong = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 100;
+
+    printf("\n");
+    CompareCatalog(counters, catalog, 1, 5);
+
+    if (cPassesLong != 0)
+    {
+        printf("\n");
+        CompareCatalog(counters, catalog, cPassesLong, 1);
+    }
+
+    return EXIT_SUCCESS;
+}
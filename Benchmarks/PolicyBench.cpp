@@ -0,0 +1,128 @@
+//--------------------------------------------------------------------------------
+// PolicyBench.cpp - The _s functions against their compile-time policy forms
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Times strcpy_s, strcat_s and _snprintf_s against Copy, Append and Format
+// from Policy.h, on strings that fit and on strings that don't.  The _s
+// functions run with a handler that just returns, so both sides of a
+// failing call do the same work apart from how the failure is reported.
+// Then the same copy into a char[16], given its size and left to infer it.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "Policy.h"
+#include "SafeStrings.h"
+
+#include <string.h>
+
+namespace
+{
+    // Not on the stack: an aligned block of a source there can take in
+    // part of szBuffer, and stall on the store that just wrote it.
+
+    const char c_szShort[]  = "Dave's Garage";
+    const char c_szLong[]   = "This is a long string which is almost assuredly too big to fit.";
+    const char c_szPrefix[] = "C:\\";
+
+    void QuietHandler(const wchar_t *, const wchar_t *, const wchar_t *, unsigned int, uintptr_t)
+    {
+    }
+}
+
+int main()
+{
+    using namespace SafeStrings;
+
+    const size_t cIterations = 10000000;
+    char         szBuffer[32];
+
+    _set_invalid_parameter_handler(QuietHandler);
+
+    Bench::PrintHeader("Copy, fits");
+    Bench::PrintResult("strcpy_s", Bench::MeasureNs(cIterations, [&]
+    {
+        strcpy_s(szBuffer, sizeof szBuffer, Bench::Opaque(c_szShort));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+    Bench::PrintResult("Copy<Ignore>", Bench::MeasureNs(cIterations, [&]
+    {
+        Copy<Policy::Ignore>(szBuffer, sizeof szBuffer, Bench::Opaque(c_szShort));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+    Bench::PrintResult("Copy<Throw>", Bench::MeasureNs(cIterations, [&]
+    {
+        Copy<Policy::Throw>(szBuffer, sizeof szBuffer, Bench::Opaque(c_szShort));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    printf("\n");
+    Bench::PrintHeader("Copy, too long");
+    Bench::PrintResult("strcpy_s", Bench::MeasureNs(cIterations, [&]
+    {
+        strcpy_s(szBuffer, sizeof szBuffer, Bench::Opaque(c_szLong));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+    Bench::PrintResult("Copy<Truncate>", Bench::MeasureNs(cIterations, [&]
+    {
+        Copy<Policy::Truncate>(szBuffer, sizeof szBuffer, Bench::Opaque(c_szLong));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+    Bench::PrintResult("Copy<Count>", Bench::MeasureNs(cIterations, [&]
+    {
+        Copy<Policy::Count>(szBuffer, sizeof szBuffer, Bench::Opaque(c_szLong));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    printf("\n");
+    Bench::PrintHeader("Append, fits");
+    Bench::PrintResult("strcat_s", Bench::MeasureNs(cIterations, [&]
+    {
+        memcpy(szBuffer, c_szPrefix, sizeof c_szPrefix);
+        strcat_s(szBuffer, sizeof szBuffer, Bench::Opaque(c_szShort));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+    Bench::PrintResult("Append<Ignore>", Bench::MeasureNs(cIterations, [&]
+    {
+        memcpy(szBuffer, c_szPrefix, sizeof c_szPrefix);
+        Append<Policy::Ignore>(szBuffer, sizeof szBuffer, Bench::Opaque(c_szShort));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    printf("\n");
+    Bench::PrintHeader("Format, fits");
+    Bench::PrintResult("_snprintf_s", Bench::MeasureNs(cIterations / 4, [&]
+    {
+        _snprintf_s(szBuffer, sizeof szBuffer, sizeof szBuffer - 1, "%s #%d", Bench::Opaque(c_szShort), 42);
+        Bench::DoNotOptimize(szBuffer);
+    }));
+    Bench::PrintResult("Format<Ignore>", Bench::MeasureNs(cIterations / 4, [&]
+    {
+        Format<Policy::Ignore>(szBuffer, sizeof szBuffer, "%s #%d", Bench::Opaque(c_szShort), 42);
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    char szSmall[16];
+
+    printf("\n");
+    Bench::PrintHeader("Copy into char[16], fits");
+    Bench::PrintResult("strcpy_s(sz, sizeof sz, src)", Bench::MeasureNs(cIterations, [&]
+    {
+        strcpy_s(szSmall, sizeof szSmall, Bench::Opaque(c_szShort));
+        Bench::DoNotOptimize(szSmall);
+    }));
+    Bench::PrintResult("strcpy_s(sz, src)", Bench::MeasureNs(cIterations, [&]
+    {
+        strcpy_s(szSmall, Bench::Opaque(c_szShort));
+        Bench::DoNotOptimize(szSmall);
+    }));
+    Bench::PrintResult("Copy<Ignore>(sz, src)", Bench::MeasureNs(cIterations, [&]
+    {
+        Copy<Policy::Ignore>(szSmall, Bench::Opaque(c_szShort));
+        Bench::DoNotOptimize(szSmall);
+    }));
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------------
+// ScanBench.cpp - Scan and ScanPlan vs. _snscanf_s on fixed-format records
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Parses a few record shapes, cycling through a table of records so that the
+// number parsers see varying lengths: "%d %s %x" as in the request that
+// prompted Scan, the demo's four words, and a record with floats.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "SafeStrings.h"
+#include "ScanPlan.h"
+
+#include <stdlib.h>
+
+namespace
+{
+    const char * const g_rgszRecords[] =
+    {
+        "12345 alpha 1f2e",
+        "-7 beta ffffffff",
+        "2147483647 gamma 0",
+        "42 delta 7fffabcd",
+    };
+
+    const char * const g_rgszMeasurements[] =
+    {
+        "sensor7 21.5 0.0031 1013",
+        "sensor12 -4.25 12.5e-3 998",
+        "sensor3 37.125 1.5 1020",
+        "sensor40 0.5 0.25 1001",
+    };
+
+    const char g_szLongString[] = "This is a long string which is almost "
+                                  "assuredly too big to fit into szBuffer.";
+}
+
+int main()
+{
+    const size_t cIterations = 1000000;
+    size_t iRecord = 0;
+
+    int      value;
+    char     szName[16];
+    unsigned flags;
+
+    Bench::PrintHeader("\"%d %s %x\" records");
+
+    Bench::PrintResult("_snscanf_s", Bench::MeasureNs(cIterations, [&]
+    {
+        const char * pszRecord = g_rgszRecords[iRecord++ & 3];
+        _snscanf_s(pszRecord, 64, "%d %s %x", &value, szName, sizeof szName, &flags);
+        Bench::DoNotOptimize(szName);
+    }));
+
+    static const SafeStrings::ScanPlan s_planRecord("%d %s %x");
+    Bench::PrintResult("ScanPlan", Bench::MeasureNs(cIterations, [&]
+    {
+        const char * pszRecord = g_rgszRecords[iRecord++ & 3];
+        s_planRecord.Scan(pszRecord, 64, &value, szName, sizeof szName, &flags);
+        Bench::DoNotOptimize(szName);
+    }));
+
+    Bench::PrintResult("Scan<\"%d %s %x\">", Bench::MeasureNs(cIterations, [&]
+    {
+        const char * pszRecord = g_rgszRecords[iRecord++ & 3];
+        SafeStrings::Scan<"%d %s %x">(pszRecord, 64, &value, szName, sizeof szName, &flags);
+        Bench::DoNotOptimize(szName);
+    }));
+
+    char szWord1[16];
+    char szWord2[16];
+    char szWord3[16];
+    char szWord4[16];
+
+    printf("\n");
+    Bench::PrintHeader("\"%s %s %s %s\" from szLongString");
+
+    Bench::PrintResult("_snscanf_s", Bench::MeasureNs(cIterations, [&]
+    {
+        _snscanf_s(Bench::Opaque(g_szLongString), sizeof g_szLongString, "%s %s %s %s",
+                   szWord1, sizeof szWord1, szWord2, sizeof szWord2,
+                   szWord3, sizeof szWord3, szWord4, sizeof szWord4);
+        Bench::DoNotOptimize(szWord4);
+    }));
+
+    Bench::PrintResult("Scan<\"%s %s %s %s\">", Bench::MeasureNs(cIterations, [&]
+    {
+        SafeStrings::Scan<"%s %s %s %s">(Bench::Opaque(g_szLongString), sizeof g_szLongString,
+                                         szWord1, sizeof szWord1, szWord2, sizeof szWord2,
+                                         szWord3, sizeof szWord3, szWord4, sizeof szWord4);
+        Bench::DoNotOptimize(szWord4);
+    }));
+
+    double temperature, drift;
+    int    pressure;
+
+    printf("\n");
+    Bench::PrintHeader("\"%s %lf %lf %d\" measurements");
+
+    Bench::PrintResult("_snscanf_s", Bench::MeasureNs(cIterations, [&]
+    {
+        const char * pszRecord = g_rgszMeasurements[iRecord++ & 3];
+        _snscanf_s(pszRecord, 64, "%s %lf %lf %d", szName, sizeof szName, &temperature, &drift, &pressure);
+        Bench::DoNotOptimize(&drift);
+    }));
+
+    Bench::PrintResult("Scan<\"%s %lf %lf %d\">", Bench::MeasureNs(cIterations, [&]
+    {
+        const char * pszRecord = g_rgszMeasurements[iRecord++ & 3];
+        SafeStrings::Scan<"%s %lf %lf %d">(pszRecord, 64, szName, sizeof szName, &temperature, &drift, &pressure);
+        Bench::DoNotOptimize(&drift);
+    }));
+
+    return EXIT_SUCCESS;
+}
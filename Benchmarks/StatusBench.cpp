@@ -0,0 +1,139 @@
+//--------------------------------------------------------------------------------
+// StatusBench.cpp - Result-returning calls against the handler, half failing
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Copies, appends and formats a shuffled set of fields into a 32 byte
+// buffer, half of them too long to fit, so neither side can count on the
+// branch predictor.  The _s functions report each overflow through a
+// handler - one that just returns, and CountingHandler installed for the
+// thread - and TryCopy, TryAppend and TryFormat return it in a Result.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "FastFormat.h"
+#include "Result.h"
+#include "SafeStrings.h"
+#include "ScopedHandler.h"
+
+#include <random>
+#include <string.h>
+
+namespace
+{
+    const size_t c_cFields  = 1024;
+    const size_t c_cbBuffer = 32;
+
+    char         g_rgchFields[c_cFields][64];
+    const char * g_rgpszFields[c_cFields];
+
+    // BuildFields
+    //
+    // Fields of 8 to 24 characters that fit and 40 to 60 that don't, in a
+    // fixed random order.
+
+    void BuildFields()
+    {
+        std::mt19937 rng(42);
+        for (size_t i = 0; i < c_cFields; i++)
+        {
+            bool   fLong = (i % 2) != 0;
+            size_t cch   = fLong ? 40 + rng() % 21 : 8 + rng() % 17;
+            for (size_t ich = 0; ich < cch; ich++)
+                g_rgchFields[i][ich] = 'a' + rng() % 26;
+            g_rgchFields[i][cch] = '\0';
+            g_rgpszFields[i] = g_rgchFields[i];
+        }
+        std::shuffle(g_rgpszFields, g_rgpszFields + c_cFields, rng);
+    }
+
+    void QuietHandler(const wchar_t *, const wchar_t *, const wchar_t *, unsigned int, uintptr_t)
+    {
+    }
+
+    // Measure
+    //
+    // ns per call over the whole set of fields.
+
+    template <typename Body>
+    double Measure(Body && body)
+    {
+        const size_t cPasses = 5000;
+        return Bench::MeasureNs(cPasses, [&]
+        {
+            for (size_t i = 0; i < c_cFields; i++)
+                body(Bench::Opaque(g_rgpszFields[i]));
+        }) / c_cFields;
+    }
+}
+
+int main()
+{
+    using namespace SafeStrings;
+
+    BuildFields();
+
+    char   szBuffer[c_cbBuffer];
+    size_t cOk = 0;
+
+    Bench::PrintHeader("Copy, 50% overflow");
+
+    _set_invalid_parameter_handler(QuietHandler);
+    Bench::PrintResult("strcpy_s, returning handler", Measure([&](const char * psz)
+    {
+        cOk += strcpy_s(szBuffer, sizeof szBuffer, psz) == 0;
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    {
+        ScopedHandler handler(CountingHandler);
+        Bench::PrintResult("strcpy_s, CountingHandler", Measure([&](const char * psz)
+        {
+            cOk += strcpy_s(szBuffer, sizeof szBuffer, psz) == 0;
+            Bench::DoNotOptimize(szBuffer);
+        }));
+    }
+
+    Bench::PrintResult("TryCopy", Measure([&](const char * psz)
+    {
+        cOk += TryCopy(szBuffer, sizeof szBuffer, psz).Ok();
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    printf("\n");
+    Bench::PrintHeader("Append to 4 characters, 50% overflow");
+
+    Bench::PrintResult("strcat_s, returning handler", Measure([&](const char * psz)
+    {
+        memcpy(szBuffer, "key=", 5);
+        cOk += strcat_s(szBuffer, sizeof szBuffer, psz) == 0;
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    Bench::PrintResult("TryAppend", Measure([&](const char * psz)
+    {
+        memcpy(szBuffer, "key=", 5);
+        cOk += TryAppend(szBuffer, sizeof szBuffer, psz).Ok();
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    printf("\n");
+    Bench::PrintHeader("Format \"%s;%d\", 50% overflow");
+
+    Bench::PrintResult("FastFormat, returning handler", Measure([&](const char * psz)
+    {
+        cOk += FastFormat(szBuffer, sizeof szBuffer, sizeof szBuffer, "%s;%d", psz, 42) >= 0;
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    Bench::PrintResult("TryFormat", Measure([&](const char * psz)
+    {
+        cOk += TryFormat(szBuffer, sizeof szBuffer, "%s;%d", psz, 42).Ok();
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    printf("\n%zu calls succeeded\n", cOk);
+    return 0;
+}
@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------------
+// TokenBench.cpp - Tokenize and TokenizeCopy vs. _snscanf_s "%s %s %s %s"
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Pulls the first four words out of the demo's szLongString, as main() does,
+// and then every field out of a typical access-log line.  _snscanf_s and
+// TokenizeCopy copy each word into a fixed buffer; Tokenize only finds
+// them.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "SafeStrings.h"
+#include "Tokenizer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+    const char g_szLongString[] = "This is a long string which is almost "
+                                  "assuredly too big to fit into szBuffer.";
+
+    const char g_szLogLine[]    = "10.1.7.42 - - [16/Oct/2026:09:14:07 +0000] GET /api/v2/items/8812 "
+                                  "HTTP/1.1 200 5123 0.0041 \"curl/8.5.0\"";
+}
+
+int main()
+{
+    const size_t cIterations = 1000000;
+
+    char szWord1[16];
+    char szWord2[16];
+    char szWord3[16];
+    char szWord4[16];
+
+    Bench::PrintHeader("Four words from szLongString");
+
+    Bench::PrintResult("_snscanf_s \"%s %s %s %s\"", Bench::MeasureNs(cIterations, [&]
+    {
+        _snscanf_s(Bench::Opaque(g_szLongString), sizeof g_szLongString, "%s %s %s %s",
+                   szWord1, sizeof szWord1, szWord2, sizeof szWord2,
+                   szWord3, sizeof szWord3, szWord4, sizeof szWord4);
+        Bench::DoNotOptimize(szWord4);
+    }));
+
+    Bench::PrintResult("TokenizeCopy", Bench::MeasureNs(cIterations, [&]
+    {
+        SafeStrings::TokenizeCopy(Bench::Opaque(g_szLongString), sizeof g_szLongString,
+                                  szWord1, szWord2, szWord3, szWord4);
+        Bench::DoNotOptimize(szWord4);
+    }));
+
+    Bench::PrintResult("Tokenize", Bench::MeasureNs(cIterations, [&]
+    {
+        std::string_view rgWords[4];
+        SafeStrings::Tokenize(Bench::Opaque(g_szLongString), sizeof g_szLongString, rgWords);
+        Bench::DoNotOptimize(rgWords);
+    }));
+
+    char rgszFields[12][32];
+
+    printf("\n");
+    Bench::PrintHeader("Twelve fields from an access-log line");
+
+    Bench::PrintResult("_snscanf_s \"%s\" x 12", Bench::MeasureNs(cIterations, [&]
+    {
+        _snscanf_s(Bench::Opaque(g_szLogLine), sizeof g_szLogLine, "%s %s %s %s %s %s %s %s %s %s %s %s",
+                   rgszFields[0], 32, rgszFields[1], 32, rgszFields[2],  32, rgszFields[3],  32,
+                   rgszFields[4], 32, rgszFields[5], 32, rgszFields[6],  32, rgszFields[7],  32,
+                   rgszFields[8], 32, rgszFields[9], 32, rgszFields[10], 32, rgszFields[11], 32);
+        Bench::DoNotOptimize(rgszFields);
+    }));
+
+    Bench::PrintResult("TokenizeCopy", Bench::MeasureNs(cIterations, [&]
+    {
+        SafeStrings::TokenizeCopy(Bench::Opaque(g_szLogLine), sizeof g_szLogLine,
+                                  rgszFields[0], rgszFields[1], rgszFields[2],  rgszFields[3],
+                                  rgszFields[4], rgszFields[5], rgszFields[6],  rgszFields[7],
+                                  rgszFields[8], rgszFields[9], rgszFields[10], rgszFields[11]);
+        Bench::DoNotOptimize(rgszFields);
+    }));
+
+    Bench::PrintResult("Tokenize", Bench::MeasureNs(cIterations, [&]
+    {
+        std::string_view rgFields[12];
+        SafeStrings::Tokenize(Bench::Opaque(g_szLogLine), sizeof g_szLogLine, rgFields);
+        Bench::DoNotOptimize(rgFields);
+    }));
+
+    return EXIT_SUCCESS;
+}
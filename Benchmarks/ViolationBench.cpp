@@ -0,0 +1,79 @@
+//--------------------------------------------------------------------------------
+// ViolationBench.cpp - What reporting violations costs, failing and not
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Times strcpy_s into a buffer that is too small, with a handler that
+// prints each violation the way the demo used to, and with ViolationLog's.
+// Both write to /dev/null, so this is the cost to the failing thread alone.
+// Then times a strcpy_s that fits, bare and through SAFE_COUNTED.
+//
+//--------------------------------------------------------------------------------
+
+#include "BenchCommon.h"
+#include "CallSites.h"
+#include "SafeStrings.h"
+#include "ViolationLog.h"
+
+namespace
+{
+    FILE * g_pfileNull;
+
+    void PrintingHandler(const wchar_t * expression, const wchar_t * function, const wchar_t * file,
+                         unsigned int line, uintptr_t)
+    {
+        fprintf(g_pfileNull, "Bad Mojo!  The invalid parameter handler has been "
+                "called in %ls\nFunction:%ls\nFile:%ls\nLine:%u\n",
+                expression, function, file, line);
+        fflush(g_pfileNull);
+    }
+}
+
+int main()
+{
+    const size_t cIterations = 200000;
+    const char   szLongString[] = "This is a long string which is almost "
+                                  "assuredly too big to fit into szBuffer.";
+    char szBuffer[16];
+
+    g_pfileNull = fopen("/dev/null", "w");
+
+    Bench::PrintHeader("Failing strcpy_s");
+
+    _set_invalid_parameter_handler(PrintingHandler);
+    Bench::PrintResult("printing handler", Bench::MeasureNs(cIterations, [&]
+    {
+        strcpy_s(szBuffer, sizeof szBuffer, Bench::Opaque(szLongString));
+    }));
+
+    {
+        // Large enough that the writer never falls behind and drops
+
+        SafeStrings::ViolationLog log(g_pfileNull, cIterations);
+        _set_invalid_parameter_handler(SafeStrings::ViolationLog::Handler);
+        Bench::PrintResult("ViolationLog::Handler", Bench::MeasureNs(cIterations, [&]
+        {
+            strcpy_s(szBuffer, sizeof szBuffer, Bench::Opaque(szLongString));
+        }, 1));
+    }
+
+    const char szShortString[] = "short";
+
+    printf("\n");
+    Bench::PrintHeader("Succeeding strcpy_s");
+
+    Bench::PrintResult("strcpy_s", Bench::MeasureNs(cIterations * 50, [&]
+    {
+        strcpy_s(szBuffer, sizeof szBuffer, Bench::Opaque(szShortString));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    Bench::PrintResult("SAFE_COUNTED(strcpy_s)", Bench::MeasureNs(cIterations * 50, [&]
+    {
+        SAFE_COUNTED(strcpy_s(szBuffer, sizeof szBuffer, Bench::Opaque(szShortString)));
+        Bench::DoNotOptimize(szBuffer);
+    }));
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+//--------------------------------------------------------------------------------
+// CallSites.cpp - Per-call-site counters and their export
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "CallSites.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+constinit thread_local SafeStrings::CallSite * SafeStrings::Internal::t_pCallSite = nullptr;
+
+using SafeStrings::CallSite;
+using SafeStrings::MetricsFormat;
+
+namespace
+{
+    std::atomic<CallSite *> g_pFirstSite { nullptr };
+
+    // RecordSizes
+    //
+    // Keeps the largest request seen at the site, and what it was up
+    // against.  The two are stored separately, so a reader racing a new
+    // maximum can see the pair mismatched; they are diagnostics, not books.
+
+    void RecordSizes(CallSite * pSite, size_t cbRequested, size_t cbAvailable)
+    {
+        uint64_t cbMax = pSite->cbRequestedMax.load(std::memory_order_relaxed);
+        while (cbRequested > cbMax)
+        {
+            if (pSite->cbRequestedMax.compare_exchange_weak(cbMax, cbRequested, std::memory_order_relaxed))
+            {
+                pSite->cbAvailable.store(cbAvailable, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+
+    // WriteQuoted
+    //
+    // A label value or JSON string: backslashes, quotes and newlines
+    // escaped, which is all either format needs of a file or function name.
+
+    void WriteQuoted(FILE * out, const char * psz)
+    {
+        fputc('"', out);
+        for (; *psz != '\0'; psz++)
+        {
+            if (*psz == '\\' || *psz == '"')
+            {
+                fputc('\\', out);
+                fputc(*psz, out);
+            }
+            else if (*psz == '\n')
+            {
+                fputs("\\n", out);
+            }
+            else
+            {
+                fputc(*psz, out);
+            }
+        }
+        fputc('"', out);
+    }
+
+    struct Metric
+    {
+        const char *                     pszName;
+        const char *                     pszType;
+        const char *                     pszHelp;
+        std::atomic<uint64_t> CallSite:: * pCounter;
+    };
+
+    const Metric c_rgMetrics[] =
+    {
+        { "safestrings_calls_total",         "counter", "Calls made through the call site.",                  &CallSite::cCalls         },
+        { "safestrings_violations_total",    "counter", "Constraint violations raised at the call site.",     &CallSite::cViolations    },
+        { "safestrings_truncations_total",   "counter", "Silent _TRUNCATE truncations at the call site.",     &CallSite::cTruncations   },
+        { "safestrings_requested_bytes_max", "gauge",   "Largest size a failure at the call site needed.",    &CallSite::cbRequestedMax },
+        { "safestrings_available_bytes",     "gauge",   "Size available to that largest failure.",            &CallSite::cbAvailable    },
+    };
+
+    void WritePrometheus(FILE * out)
+    {
+        for (const Metric & metric : c_rgMetrics)
+        {
+            fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", metric.pszName, metric.pszHelp, metric.pszName, metric.pszType);
+            for (const CallSite * pSite = SafeStrings::FirstCallSite(); pSite != nullptr; pSite = pSite->pNext)
+            {
+                fprintf(out, "%s{file=", metric.pszName);
+                WriteQuoted(out, pSite->pszFile);
+                fprintf(out, ",line=\"%u\",function=", pSite->line);
+                WriteQuoted(out, pSite->pszFunction);
+                fprintf(out, "} %llu\n", (unsigned long long)(pSite->*metric.pCounter).load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    void WriteJson(FILE * out)
+    {
+        fputs("[", out);
+        const char * pszSeparator = "\n";
+        for (const CallSite * pSite = SafeStrings::FirstCallSite(); pSite != nullptr; pSite = pSite->pNext)
+        {
+            fprintf(out, "%s  { \"file\": ", pszSeparator);
+            WriteQuoted(out, pSite->pszFile);
+            fprintf(out, ", \"line\": %u, \"function\": ", pSite->line);
+            WriteQuoted(out, pSite->pszFunction);
+            fprintf(out, ", \"calls\": %llu, \"violations\": %llu, \"truncations\": %llu"
+                         ", \"requested_bytes_max\": %llu, \"available_bytes\": %llu }",
+                    (unsigned long long) pSite->cCalls.load(std::memory_order_relaxed),
+                    (unsigned long long) pSite->cViolations.load(std::memory_order_relaxed),
+                    (unsigned long long) pSite->cTruncations.load(std::memory_order_relaxed),
+                    (unsigned long long) pSite->cbRequestedMax.load(std::memory_order_relaxed),
+                    (unsigned long long) pSite->cbAvailable.load(std::memory_order_relaxed));
+            pszSeparator = ",\n";
+        }
+        fputs("\n]\n", out);
+    }
+}
+
+SafeStrings::CallSite::CallSite(const char * pszFileIn, unsigned int lineIn, const char * pszFunctionIn)
+    : pszFile(pszFileIn),
+      pszFunction(pszFunctionIn),
+      line(lineIn),
+      pNext(g_pFirstSite.load(std::memory_order_relaxed))
+{
+    while (!g_pFirstSite.compare_exchange_weak(pNext, this, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+const CallSite * SafeStrings::FirstCallSite()
+{
+    return g_pFirstSite.load(std::memory_order_acquire);
+}
+
+void SafeStrings::Internal::NoteFailureSizes(size_t cbRequested, size_t cbAvailable)
+{
+    if (t_pCallSite != nullptr)
+        RecordSizes(t_pCallSite, cbRequested, cbAvailable);
+}
+
+void SafeStrings::Internal::NoteTruncation(size_t cbRequested, size_t cbAvailable)
+{
+    if (t_pCallSite != nullptr)
+    {
+        t_pCallSite->cTruncations.fetch_add(1, std::memory_order_relaxed);
+        RecordSizes(t_pCallSite, cbRequested, cbAvailable);
+    }
+}
+
+void SafeStrings::Internal::NoteViolation()
+{
+    if (t_pCallSite != nullptr)
+        t_pCallSite->cViolations.fetch_add(1, std::memory_order_relaxed);
+}
+
+errno_t SafeStrings::WriteCallSiteMetrics(FILE * out, MetricsFormat format)
+{
+    if (SAFE_UNLIKELY(out == nullptr))
+        return SAFE_RAISE(EINVAL, "out != nullptr", "WriteCallSiteMetrics");
+
+    if (format == MetricsFormat::Json)
+        WriteJson(out);
+    else
+        WritePrometheus(out);
+
+    return (fflush(out) == 0 && !ferror(out)) ? 0 : (errno ? errno : EIO);
+}
+
+// WriteCallSiteMetrics
+//
+// Writes a temporary file next to pszPath and renames it over the top, so
+// a collector never reads half a snapshot.
+
+errno_t SafeStrings::WriteCallSiteMetrics(const char * pszPath, MetricsFormat format)
+{
+    if (SAFE_UNLIKELY(pszPath == nullptr))
+        return SAFE_RAISE(EINVAL, "pszPath != nullptr", "WriteCallSiteMetrics");
+
+    char szTemp[_MAX_PATH + 32];
+    if (snprintf(szTemp, sizeof szTemp, "%s.%d.tmp", pszPath, (int) getpid()) >= (int) sizeof szTemp)
+        return ENAMETOOLONG;
+
+    FILE * out = fopen(szTemp, "w");
+    if (out == nullptr)
+        return errno;
+
+    errno_t err = WriteCallSiteMetrics(out, format);
+    if (fclose(out) != 0 && err == 0)
+        err = errno;
+
+    if (err == 0 && rename(szTemp, pszPath) != 0)
+        err = errno;
+
+    if (err != 0)
+        unlink(szTemp);
+    return err;
+}
@@ -0,0 +1,128 @@
+//--------------------------------------------------------------------------------
+// CallSites.h - Per-call-site violation and truncation counters
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// The handler hears about each violation, but not which of the program's
+// many strcpy_s calls it came from, nor how often that call succeeds.
+// Wrapping a call in SAFE_COUNTED gives it a counter block of its own,
+// keyed by file, line and function:
+//
+//    SAFE_COUNTED(strcpy_s(szBuffer, sizeof szBuffer, szLongString));
+//
+// The block counts the calls, the violations the handler is told about,
+// and the truncations _TRUNCATE asks for silently, and remembers the
+// largest size a failing call wanted along with the size it had.  The
+// formatters know the whole size; strcpy_s and strcat_s stop reading the
+// source once it won't fit, so for them it is one more than they had.  The
+// wrapped call's value is the value of SAFE_COUNTED, and its handler,
+// errno and results are unchanged.
+//
+// A call that succeeds costs the wrapper a guarded static, a counter bump
+// and a store to thread-local storage - well under a nanosecond.  To keep
+// it that way the call count is bumped with relaxed loads and stores, not
+// a locked add, so calls from several threads through the same site at
+// the same moment may now and then be counted once.  Violations and
+// truncations are rare, and counted exactly.
+//
+// WriteCallSiteMetrics writes every site that has been reached as
+// Prometheus text or as JSON, to a FILE or to a path.  A path is replaced
+// all at once, as a textfile collector expects.
+//
+// SAFE_COUNTED uses a GNU statement expression, so it is for GCC and Clang.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace SafeStrings
+{
+    // CallSite
+    //
+    // One per SAFE_COUNTED, registered the first time it is reached.  Each
+    // takes its own cache lines, so busy sites don't slow each other down.
+
+    struct alignas(64) CallSite
+    {
+        CallSite(const char * pszFile, unsigned int line, const char * pszFunction);
+
+        const char *          pszFile;
+        const char *          pszFunction;
+        unsigned int          line;
+
+        std::atomic<uint64_t> cCalls         { 0 };
+        std::atomic<uint64_t> cViolations    { 0 };
+        std::atomic<uint64_t> cTruncations   { 0 };
+        std::atomic<uint64_t> cbRequestedMax { 0 };     // The most any failure here wanted
+        std::atomic<uint64_t> cbAvailable    { 0 };     // What that failure had
+
+        CallSite *            pNext;                    // The site registered before this one
+    };
+
+    // FirstCallSite
+    //
+    // The most recently registered site; follow pNext for the rest.
+
+    const CallSite * FirstCallSite();
+
+    enum class MetricsFormat
+    {
+        Prometheus,
+        Json,
+    };
+
+    errno_t WriteCallSiteMetrics(FILE * out, MetricsFormat format);
+    errno_t WriteCallSiteMetrics(const char * pszPath, MetricsFormat format);
+
+    namespace Internal
+    {
+        // The site of the SAFE_COUNTED call in progress on this thread, for
+        // the library's failure paths to charge.  constinit lets other
+        // modules reach it directly rather than through a TLS wrapper.
+
+        extern constinit thread_local CallSite * t_pCallSite;
+
+        class CallSiteScope
+        {
+        public:
+
+            explicit CallSiteScope(CallSite & site)
+                : _pPrevious(t_pCallSite)
+            {
+                site.cCalls.store(site.cCalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                t_pCallSite = &site;
+            }
+
+            ~CallSiteScope()
+            {
+                t_pCallSite = _pPrevious;
+            }
+
+            CallSiteScope(const CallSiteScope &) = delete;
+            CallSiteScope & operator=(const CallSiteScope &) = delete;
+
+        private:
+
+            CallSite * _pPrevious;
+        };
+    }
+}
+
+// SAFE_COUNTED
+//
+// Evaluates call, charging any violation or truncation inside it to this
+// line of this function.
+
+#define SAFE_COUNTED(call)                                                          \
+    __extension__ ({                                                                \
+        static SafeStrings::CallSite s_safeCallSite(__FILE__, __LINE__, __func__);  \
+        SafeStrings::Internal::CallSiteScope safeCallSiteScope(s_safeCallSite);     \
+        call;                                                                       \
+    })
@@ -0,0 +1,335 @@
+//--------------------------------------------------------------------------------
+// CheckedFormat.h - _snprintf_s with the format validated at compile time
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// _snprintf_s and vsnprintf_s walk the format on every call looking for %n
+// and for %s arguments that are null.  When the format is a literal, all of
+// that except the null check can be settled by the compiler:
+//
+//    SafeStrings::CheckedFormat(szBuffer, _TRUNCATE, "%s", szLongString);
+//
+// FormatString parses the literal in a consteval constructor and fails to
+// compile on %n, on a conversion that doesn't exist, on the wrong number of
+// arguments, or on an argument whose type doesn't match its conversion.  It
+// also records which arguments feed a %s, so at runtime only those pointers
+// are tested before the arguments go straight to the formatter.
+//
+// A va_list can't be checked this way, so code like TestVarArgs that
+// forwards its arguments should become a variadic template that takes a
+// FormatString and calls CheckedFormat, rather than calling vsnprintf_s.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <array>
+#include <errno.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace SafeStrings
+{
+    // VFormatPrevalidated / FormatPrevalidated
+    //
+    // vsnprintf_s and _snprintf_s without the format walk.  Only for formats
+    // that have already been validated, which in practice means via
+    // FormatString; everything else should use the _s functions.
+
+    int VFormatPrevalidated(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list argptr);
+    int FormatPrevalidated(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...);
+
+    namespace FormatCheck
+    {
+        // None of these are defined.  Reaching one during the consteval
+        // parse is what turns a bad format into a compile error, and its name
+        // is what shows up in the diagnostic.
+
+        void PercentNIsNotAllowed();
+        void InvalidConversionSpecifier();
+        void ArgumentTypeDoesNotMatchConversion();
+        void TooFewArgumentsForFormat();
+        void TooManyArgumentsForFormat();
+
+        enum class ArgKind : uint8_t
+        {
+            Unsupported,
+            Integer,
+            Double,
+            LongDouble,
+            NarrowString,
+            WideString,
+            Pointer,
+        };
+
+        struct ArgInfo
+        {
+            ArgKind kind;
+            size_t  cbPromoted;     // Integers only: size after default promotion
+        };
+
+        template <typename T>
+        consteval ArgInfo DescribeArg()
+        {
+            using U = std::remove_cv_t<T>;
+
+            if constexpr (std::is_integral_v<U> || std::is_enum_v<U>)
+                return { ArgKind::Integer, sizeof(U) < sizeof(int) ? sizeof(int) : sizeof(U) };
+            else if constexpr (std::is_same_v<U, long double>)
+                return { ArgKind::LongDouble, 0 };
+            else if constexpr (std::is_floating_point_v<U>)
+                return { ArgKind::Double, 0 };
+            else if constexpr (std::is_pointer_v<U> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<U>>, char>)
+                return { ArgKind::NarrowString, 0 };
+            else if constexpr (std::is_pointer_v<U> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<U>>, wchar_t>)
+                return { ArgKind::WideString, 0 };
+            else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>)
+                return { ArgKind::Pointer, 0 };
+            else
+                return { ArgKind::Unsupported, 0 };
+        }
+
+        constexpr bool IsDigit(char ch)
+        {
+            return ch >= '0' && ch <= '9';
+        }
+
+        // Parse
+        //
+        // Mirrors the runtime walk in vsnprintf_s, but against argument types
+        // instead of argument values.  Returns a bit per argument that is the
+        // string behind a %s (narrow or wide), which is all that remains to be
+        // checked at runtime.
+
+        template <typename... Args>
+        consteval uint64_t Parse(const char * format)
+        {
+            static_assert(sizeof...(Args) <= 64, "CheckedFormat supports at most 64 arguments");
+
+            constexpr std::array<ArgInfo, sizeof...(Args)> rgArgs = { DescribeArg<Args>()... };
+
+            size_t   iArg     = 0;
+            uint64_t maskNull = 0;
+
+            auto NextArg = [&]() -> ArgInfo
+            {
+                if (iArg >= rgArgs.size())
+                    TooFewArgumentsForFormat();
+                return rgArgs[iArg++];
+            };
+
+            auto ExpectInteger = [&](size_t cb)
+            {
+                ArgInfo arg = NextArg();
+                if (arg.kind != ArgKind::Integer || arg.cbPromoted != cb)
+                    ArgumentTypeDoesNotMatchConversion();
+            };
+
+            for (const char * p = format; *p; ++p)
+            {
+                if (*p != '%')
+                    continue;
+
+                if (*++p == '%')
+                    continue;
+
+                while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'')
+                    ++p;
+
+                if (*p == '*')
+                {
+                    ExpectInteger(sizeof(int));
+                    ++p;
+                }
+                else
+                {
+                    while (IsDigit(*p))
+                        ++p;
+                }
+
+                if (*p == '.')
+                {
+                    if (*++p == '*')
+                    {
+                        ExpectInteger(sizeof(int));
+                        ++p;
+                    }
+                    else
+                    {
+                        while (IsDigit(*p))
+                            ++p;
+                    }
+                }
+
+                // Integer conversions expect the promoted size for the modifier
+
+                size_t cbInteger = sizeof(int);
+                bool   fWide     = false;
+                bool   fLong     = false;
+                switch (*p)
+                {
+                    case 'h': if (p[1] == 'h') ++p; ++p; break;
+                    case 'l':
+                        if (p[1] == 'l')
+                        {
+                            cbInteger = sizeof(long long);
+                            ++p;
+                        }
+                        else
+                        {
+                            cbInteger = sizeof(long);
+                            fWide     = true;
+                        }
+                        ++p;
+                        break;
+                    case 'j': cbInteger = sizeof(intmax_t);  ++p; break;
+                    case 'z': cbInteger = sizeof(size_t);    ++p; break;
+                    case 't': cbInteger = sizeof(ptrdiff_t); ++p; break;
+                    case 'L': fLong = true;                  ++p; break;
+                }
+
+                switch (*p)
+                {
+                    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                        ExpectInteger(cbInteger);
+                        break;
+
+                    case 'c':
+                        ExpectInteger(fWide ? sizeof(wint_t) : sizeof(int));
+                        break;
+
+                    case 's':
+                    {
+                        ArgInfo arg = NextArg();
+                        if (arg.kind != (fWide ? ArgKind::WideString : ArgKind::NarrowString))
+                            ArgumentTypeDoesNotMatchConversion();
+                        maskNull |= uint64_t(1) << (iArg - 1);
+                        break;
+                    }
+
+                    case 'p':
+                    {
+                        ArgKind kind = NextArg().kind;
+                        if (kind != ArgKind::Pointer && kind != ArgKind::NarrowString && kind != ArgKind::WideString)
+                            ArgumentTypeDoesNotMatchConversion();
+                        break;
+                    }
+
+                    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                        if (NextArg().kind != (fLong ? ArgKind::LongDouble : ArgKind::Double))
+                            ArgumentTypeDoesNotMatchConversion();
+                        break;
+
+                    case 'n':
+                        PercentNIsNotAllowed();
+                        break;
+
+                    default:
+                        InvalidConversionSpecifier();
+                        break;
+                }
+            }
+
+            if (iArg != rgArgs.size())
+                TooManyArgumentsForFormat();
+
+            return maskNull;
+        }
+    }
+
+    // FormatString
+    //
+    // A format literal that has been checked against the argument types
+    // Args.  Constructed implicitly from the literal at each call site.
+
+    template <typename... Args>
+    class FormatString
+    {
+    public:
+
+        template <size_t M>
+        consteval FormatString(const char (&format)[M])
+            : _pszFormat(format), _maskNullChecks(FormatCheck::Parse<Args...>(format))
+        {
+        }
+
+        constexpr const char * c_str()          const { return _pszFormat; }
+        constexpr uint64_t     NullCheckMask()  const { return _maskNullChecks; }
+
+    private:
+
+        const char * _pszFormat;
+        uint64_t     _maskNullChecks;
+    };
+
+    namespace FormatCheck
+    {
+        // AnyNullString
+        //
+        // The one runtime check left: is any argument flagged by the parse a
+        // null pointer?  Unflagged arguments aren't even looked at.
+
+        template <typename... Args>
+        inline bool AnyNullString(uint64_t mask, const Args &... args)
+        {
+            if constexpr (sizeof...(Args) == 0)
+            {
+                (void) mask;
+                return false;
+            }
+            else
+            {
+                if (mask == 0)
+                    return false;
+
+                bool   fNull = false;
+                size_t iArg  = 0;
+                auto Check = [&](const auto & arg)
+                {
+                    if constexpr (std::is_pointer_v<std::remove_cvref_t<decltype(arg)>>)
+                    {
+                        if ((mask >> iArg) & 1)
+                            fNull |= (arg == nullptr);
+                    }
+                    iArg++;
+                };
+                (Check(args), ...);
+                return fNull;
+            }
+        }
+
+        [[gnu::cold, gnu::noinline]]
+        inline int NullStringViolation(char * buffer, size_t sizeOfBuffer)
+        {
+            if (buffer != nullptr && sizeOfBuffer != 0 && sizeOfBuffer <= RSIZE_MAX)
+                buffer[0] = '\0';
+            Internal::ConstraintViolation(EINVAL, L"(string argument != nullptr)", L"CheckedFormat", L"" __FILE__, __LINE__);
+            return -1;
+        }
+    }
+
+    // CheckedFormat
+    //
+    // _snprintf_s(buffer, sizeOfBuffer, count, format, args...) with the same
+    // count/_TRUNCATE semantics and return value, minus the runtime parse.
+
+    template <typename... Args>
+    inline int CheckedFormat(char * buffer, size_t sizeOfBuffer, size_t count,
+                             FormatString<std::type_identity_t<Args>...> format, Args... args)
+    {
+        if (FormatCheck::AnyNullString(format.NullCheckMask(), args...))
+            return FormatCheck::NullStringViolation(buffer, sizeOfBuffer);
+
+        return FormatPrevalidated(buffer, sizeOfBuffer, count, format.c_str(), args...);
+    }
+
+    template <size_t size, typename... Args>
+    inline int CheckedFormat(char (&buffer)[size], size_t count,
+                             FormatString<std::type_identity_t<Args>...> format, Args... args)
+    {
+        return CheckedFormat<Args...>(buffer, size, count, format, args...);
+    }
+}
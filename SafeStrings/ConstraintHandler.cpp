@@ -0,0 +1,125 @@
+//--------------------------------------------------------------------------------
+// ConstraintHandler.cpp - Invalid parameter handler registration and dispatch
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "Policy.h"
+#include "ScopedHandler.h"
+
+#include <atomic>
+#include <stdlib.h>
+
+namespace
+{
+    std::atomic<_invalid_parameter_handler> g_pfnInvalidParameterHandler { nullptr };
+
+    // Only ever touched by its own thread, so a plain variable will do
+
+    thread_local _invalid_parameter_handler t_pfnInvalidParameterHandler = nullptr;
+    thread_local size_t                     t_cViolations                = 0;
+
+    // DefaultInvalidParameterHandler
+    //
+    // What you get when nobody has called _set_invalid_parameter_handler.
+    // The CRT terminates the process, and so do we - silently carrying on
+    // with a truncated or empty string is exactly what these functions are
+    // meant to prevent.
+
+    [[noreturn]] void DefaultInvalidParameterHandler(const wchar_t * expression,
+                                                     const wchar_t * function,
+                                                     const wchar_t * file,
+                                                     unsigned int    line)
+    {
+        fprintf(stderr, "Invalid parameter passed to %ls: %ls (%ls:%u)\n",
+                function, expression, file, line);
+        abort();
+    }
+}
+
+extern "C" _invalid_parameter_handler _set_invalid_parameter_handler(_invalid_parameter_handler pNew)
+{
+    return g_pfnInvalidParameterHandler.exchange(pNew, std::memory_order_acq_rel);
+}
+
+extern "C" _invalid_parameter_handler _get_invalid_parameter_handler(void)
+{
+    return g_pfnInvalidParameterHandler.load(std::memory_order_acquire);
+}
+
+extern "C" _invalid_parameter_handler _set_thread_local_invalid_parameter_handler(_invalid_parameter_handler pNew)
+{
+    _invalid_parameter_handler pfnOld = t_pfnInvalidParameterHandler;
+    t_pfnInvalidParameterHandler = pNew;
+    return pfnOld;
+}
+
+extern "C" _invalid_parameter_handler _get_thread_local_invalid_parameter_handler(void)
+{
+    return t_pfnInvalidParameterHandler;
+}
+
+extern "C" void _invalid_parameter(const wchar_t * expression,
+                                   const wchar_t * function,
+                                   const wchar_t * file,
+                                   unsigned int    line,
+                                   uintptr_t       pReserved)
+{
+    _invalid_parameter_handler pfn = t_pfnInvalidParameterHandler;
+    if (pfn == nullptr)
+        pfn = g_pfnInvalidParameterHandler.load(std::memory_order_acquire);
+    if (pfn == nullptr)
+        DefaultInvalidParameterHandler(expression, function, file, line);
+
+    pfn(expression, function, file, line, pReserved);
+}
+
+void SafeStrings::CountingHandler(const wchar_t *, const wchar_t *, const wchar_t *, unsigned int, uintptr_t)
+{
+    t_cViolations++;
+}
+
+void SafeStrings::AbortingHandler(const wchar_t * expression, const wchar_t * function, const wchar_t * file,
+                                  unsigned int line, uintptr_t)
+{
+    DefaultInvalidParameterHandler(expression, function, file, line);
+}
+
+size_t SafeStrings::ThreadViolationCount()
+{
+    return t_cViolations;
+}
+
+void SafeStrings::ResetThreadViolationCount()
+{
+    t_cViolations = 0;
+}
+
+void SafeStrings::Internal::CountThreadViolation()
+{
+    t_cViolations++;
+}
+
+void SafeStrings::Internal::AbortOnViolation(const char * expression, const char * function)
+{
+    fprintf(stderr, "Invalid parameter passed to %s: %s\n", function, expression);
+    abort();
+}
+
+namespace SafeStrings::Internal
+{
+    errno_t ConstraintViolation(errno_t         err,
+                                const wchar_t * expression,
+                                const wchar_t * function,
+                                const wchar_t * file,
+                                unsigned int    line)
+    {
+        errno = err;
+        NoteViolation();
+        _invalid_parameter(expression, function, file, line, 0);
+        return err;
+    }
+}
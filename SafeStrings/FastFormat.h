@@ -0,0 +1,114 @@
+//--------------------------------------------------------------------------------
+// FastFormat.h - _snprintf_s semantics without the printf machinery
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// FastFormat takes the same arguments as _snprintf_s and honors the same
+// count and _TRUNCATE rules, but formats the common conversions itself:
+//
+//    d i u o x X c s            with - 0 + space, width, precision and '*'
+//    f F e E g G                likewise, and with an optional L
+//
+// Output is always in the "C" locale.  A float conversion with an explicit
+// precision prints exactly what printf would; without one it prints the
+// shortest text that reads back to the same value ("%f" of 0.1 is "0.1",
+// not "0.100000").
+//
+// Anything else vsnprintf_s accepts (%p, %a, '#', wide characters and
+// strings) is passed to vsnprintf one conversion at a time.  Formats that
+// vsnprintf_s rejects - %n, a null %s, positional or unknown conversions -
+// are rejected here too, with the same errno and handler call.
+//
+// FormatMeasured and FormatAppend are for output of unknown length.  The
+// first truncates like _TRUNCATE but also reports the length the whole
+// result needed, counted in the same pass; the second appends to a
+// std::string, allocating at most once.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <string>
+
+namespace SafeStrings
+{
+    int VFastFormat(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list argptr);
+
+    __attribute__((format(printf, 4, 5)))
+    int FastFormat(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...);
+
+    // The array forms are C-variadic too, so the compiler checks their
+    // arguments against the format as it does the pointer forms'.
+
+    template <size_t size>
+    __attribute__((format(printf, 3, 4)))
+    inline int FastFormat(char (&buffer)[size], size_t count, const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int result = VFastFormat(buffer, size, count, format, args);
+        va_end(args);
+        return result;
+    }
+
+    // FormatMeasured / VFormatMeasured
+    //
+    // FastFormat(buffer, sizeOfBuffer, _TRUNCATE, ...), which also stores in
+    // *pcchNeeded the length of the untruncated result, not counting the
+    // terminator.  A null buffer with a size of 0 just measures.  After a
+    // violation *pcchNeeded is 0.
+
+    int VFormatMeasured(char * buffer, size_t sizeOfBuffer, size_t * pcchNeeded, const char * format, va_list argptr);
+
+    __attribute__((format(printf, 4, 5)))
+    int FormatMeasured(char * buffer, size_t sizeOfBuffer, size_t * pcchNeeded, const char * format, ...);
+
+    template <size_t size>
+    __attribute__((format(printf, 3, 4)))
+    inline int FormatMeasured(char (&buffer)[size], size_t * pcchNeeded, const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int result = VFormatMeasured(buffer, size, pcchNeeded, format, args);
+        va_end(args);
+        return result;
+    }
+
+    // FormatAppend / VFormatAppend
+    //
+    // Appends to str.  The text is formatted into a small local buffer and
+    // copied over, so the cost follows the output rather than str's
+    // capacity; only when it doesn't fit there is str grown, once, by the
+    // measured length and the text formatted again in place.  Returns 0, or
+    // the errno value of a violation, in which case str is left unchanged.
+
+    errno_t VFormatAppend(std::string & str, const char * format, va_list argptr);
+
+    __attribute__((format(printf, 2, 3)))
+    errno_t FormatAppend(std::string & str, const char * format, ...);
+
+    namespace Internal
+    {
+        // FormatStatus / VFormatStatus
+        //
+        // The engine with no policy at all: formats into buffer and says
+        // what happened without raising anything or touching errno.  err is
+        // 0, STRUNCATE (buffer holds the terminated prefix that fit), or
+        // EINVAL / EILSEQ (buffer emptied where there is one), and
+        // pszExpression names the failed check.  The counts leave out the
+        // terminator; cchNeeded is the length of the untruncated result.
+
+        struct FormatStatus
+        {
+            errno_t      err;
+            size_t       cchWritten;
+            size_t       cchNeeded;
+            const char * pszExpression;
+        };
+
+        FormatStatus VFormatStatus(char * buffer, size_t sizeOfBuffer, const char * format, va_list & args);
+    }
+}
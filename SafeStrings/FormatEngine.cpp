@@ -0,0 +1,893 @@
+//--------------------------------------------------------------------------------
+// FormatEngine.cpp - The printf subset behind FastFormat
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// glibc's vsnprintf is general: it consults the locale for the decimal point
+// and digit grouping, supports positional arguments and wide output, and
+// runs every conversion through the same state machine.  This engine handles
+// the conversions that make up nearly every log line - d i u o x X c s and
+// f F e E g G, with width, precision, '*' and the - 0 + space flags - and
+// always formats as the "C" locale would.  Whatever else vsnprintf_s accepts
+// is handed to vsnprintf one conversion at a time.
+//
+// Integers are written two digits at a time from a 200-byte pair table.
+// Floats go through std::to_chars: with a precision the output is exactly
+// what printf would produce, and without one it is the shortest string that
+// reads back as the same value, rather than printf's default of 6 places.
+// %.Nf of a double with N <= 9 has a faster exact path of its own.
+//
+//--------------------------------------------------------------------------------
+
+#include "FormatEngine.h"
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <limits.h>
+
+namespace
+{
+    using namespace SafeStrings::Internal;
+
+    constexpr auto c_rgDigitPairs = []
+    {
+        std::array<char, 200> rgch { };
+        for (int i = 0; i < 100; i++)
+        {
+            rgch[i * 2]     = (char) ('0' + i / 10);
+            rgch[i * 2 + 1] = (char) ('0' + i % 10);
+        }
+        return rgch;
+    }();
+
+    // Big enough for any double in fixed notation, shortest or with a
+    // moderate precision.  Anything larger is left to vsnprintf_s.
+
+    constexpr size_t c_cchFloatMax = 512;
+
+    inline bool IsDigit(char ch)
+    {
+        return ch >= '0' && ch <= '9';
+    }
+
+    // WriteDecimal / WriteHex / WriteOctal
+    //
+    // Write value backwards so that it ends just before pEnd, and return
+    // where it starts.
+
+    // Most values fit in 32 bits, where dividing by 100 is a much cheaper
+    // multiply than it is at 64
+
+    template <typename T>
+    inline char * WriteDecimal(char * pEnd, T value)
+    {
+        char * p = pEnd;
+        while (value >= 100)
+        {
+            size_t i = (size_t) (value % 100) * 2;
+            value /= 100;
+            p -= 2;
+            memcpy(p, &c_rgDigitPairs[i], 2);
+        }
+
+        if (value >= 10)
+        {
+            p -= 2;
+            memcpy(p, &c_rgDigitPairs[value * 2], 2);
+        }
+        else
+        {
+            *--p = (char) ('0' + value);
+        }
+        return p;
+    }
+
+    inline char * WriteHex(char * pEnd, uintmax_t value, bool fUpper)
+    {
+        const char * pszDigits = fUpper ? "0123456789ABCDEF" : "0123456789abcdef";
+        char * p = pEnd;
+        do
+        {
+            *--p = pszDigits[value & 0xF];
+            value >>= 4;
+        } while (value != 0);
+        return p;
+    }
+
+    inline char * WriteOctal(char * pEnd, uintmax_t value)
+    {
+        char * p = pEnd;
+        do
+        {
+            *--p = (char) ('0' + (value & 7));
+            value >>= 3;
+        } while (value != 0);
+        return p;
+    }
+
+    // EmitField
+    //
+    // Lays out [padding][prefix][zeros][body][padding] for a field of at
+    // least cchWidth characters.  Zero padding goes between the sign and the
+    // digits, which is why the prefix is kept separate from the body.
+
+    void EmitField(OutputBuffer & out, size_t cchWidth, bool fLeft, bool fZeroPad,
+                   const char * pPrefix, size_t cchPrefix, size_t cchZeros,
+                   const char * pBody, size_t cchBody)
+    {
+        size_t cch    = cchPrefix + cchZeros + cchBody;
+        size_t cchPad = (cchWidth > cch) ? cchWidth - cch : 0;
+
+        if (SAFE_LIKELY(cchPad == 0 && cchZeros == 0))
+        {
+            out.Append(pPrefix, cchPrefix);
+            out.Append(pBody, cchBody);
+            return;
+        }
+
+        if (!fLeft && !fZeroPad)
+            out.Fill(' ', cchPad);
+
+        out.Append(pPrefix, cchPrefix);
+
+        if (!fLeft && fZeroPad)
+            cchZeros += cchPad;
+
+        out.Fill('0', cchZeros);
+        out.Append(pBody, cchBody);
+
+        if (fLeft)
+            out.Fill(' ', cchPad);
+    }
+
+    intmax_t SignedArg(LengthModifier length, va_list & args)
+    {
+        switch (length)
+        {
+            case LengthModifier::hh: return (signed char) va_arg(args, int);
+            case LengthModifier::h:  return (short) va_arg(args, int);
+            case LengthModifier::l:  return va_arg(args, long);
+            case LengthModifier::ll: return va_arg(args, long long);
+            case LengthModifier::j:  return va_arg(args, intmax_t);
+            case LengthModifier::z:  return (ptrdiff_t) va_arg(args, size_t);
+            case LengthModifier::t:  return va_arg(args, ptrdiff_t);
+            default:                 return va_arg(args, int);
+        }
+    }
+
+    uintmax_t UnsignedArg(LengthModifier length, va_list & args)
+    {
+        switch (length)
+        {
+            case LengthModifier::hh: return (unsigned char) va_arg(args, unsigned int);
+            case LengthModifier::h:  return (unsigned short) va_arg(args, unsigned int);
+            case LengthModifier::l:  return va_arg(args, unsigned long);
+            case LengthModifier::ll: return va_arg(args, unsigned long long);
+            case LengthModifier::j:  return va_arg(args, uintmax_t);
+            case LengthModifier::z:  return va_arg(args, size_t);
+            case LengthModifier::t:  return (size_t) va_arg(args, ptrdiff_t);
+            default:                 return va_arg(args, unsigned int);
+        }
+    }
+
+    void EmitInteger(OutputBuffer & out, const FormatSpec & spec, uintmax_t value, char chSign,
+                     size_t cchWidth, int precision, bool fLeft)
+    {
+        char   rgch[3 * sizeof(uintmax_t)];
+        char * pEnd = rgch + sizeof rgch;
+        char * pDigits;
+
+        if (precision == 0 && value == 0)
+            pDigits = pEnd;
+        else if (spec.chConversion == 'x' || spec.chConversion == 'X')
+            pDigits = WriteHex(pEnd, value, spec.chConversion == 'X');
+        else if (spec.chConversion == 'o')
+            pDigits = WriteOctal(pEnd, value);
+        else if (value <= UINT32_MAX)
+            pDigits = WriteDecimal(pEnd, (uint32_t) value);
+        else
+            pDigits = WriteDecimal(pEnd, value);
+
+        size_t cchDigits = pEnd - pDigits;
+        size_t cchZeros  = (precision > 0 && (size_t) precision > cchDigits) ? precision - cchDigits : 0;
+        bool   fZeroPad  = (spec.flags & FlagZero) && precision == c_NoPrecision;
+
+        EmitField(out, cchWidth, fLeft, fZeroPad, &chSign, chSign ? 1 : 0, cchZeros, pDigits, cchDigits);
+    }
+
+    // AppendShortInteger
+    //
+    // %d, %u and %x with at most a one-digit width, optionally zero padded
+    // (%02d, %08x), laid out in one local buffer and appended in one go.
+
+    inline void AppendShortInteger(OutputBuffer & out, uint32_t value, bool fNegative, bool fHex,
+                                   size_t cchWidth = 0, bool fZeroPad = false)
+    {
+        char   rgch[24];
+        char * pEnd = rgch + sizeof rgch;
+        char * p    = fHex ? WriteHex(pEnd, value, false) : WriteDecimal(pEnd, value);
+
+        if (fZeroPad)
+        {
+            while ((size_t) (pEnd - p) + fNegative < cchWidth)
+                *--p = '0';
+        }
+
+        if (fNegative)
+            *--p = '-';
+
+        while ((size_t) (pEnd - p) < cchWidth)
+            *--p = ' ';
+
+        out.Append(p, pEnd - p);
+    }
+
+    // WriteFixed
+    //
+    // %.Nf of a double for small N, rounded exactly as printf rounds it but
+    // in a fraction of the time to_chars takes.  value * 10^N is formed
+    // along with its exact rounding error (via fma), which is enough to tell
+    // which integer the true product rounds to - unless it lies within a
+    // hair of a tie, in which case this gives up and returns nullptr, as it
+    // does for products too big to hold in a double's mantissa.
+
+    constexpr double   c_rgPow10[]    = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    constexpr uint32_t c_rgPow10Int[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+    char * WriteFixed(char * pEnd, double value, int precision)
+    {
+        double magnitude = std::fabs(value);
+        double product   = magnitude * c_rgPow10[precision];
+        if (!(product < 0x1p52))
+            return nullptr;
+
+        double error    = std::fma(magnitude, c_rgPow10[precision], -product);
+        double integer  = std::nearbyint(product);
+        double fraction = (product - integer) + error;
+
+        if (std::fabs(std::fabs(fraction) - 0.5) < 0x1p-20)
+            return nullptr;
+        if (fraction > 0.5)
+            integer += 1;
+        else if (fraction < -0.5)
+            integer -= 1;
+
+        uint64_t digits = (uint64_t) integer;
+        char *   p      = pEnd;
+        if (precision > 0)
+        {
+            uint32_t fractionDigits = (uint32_t) (digits % c_rgPow10Int[precision]);
+            digits /= c_rgPow10Int[precision];
+
+            p = WriteDecimal(pEnd, fractionDigits);
+            while (pEnd - p < precision)
+                *--p = '0';
+            *--p = '.';
+        }
+
+        p = WriteDecimal(p, digits);
+        if (std::signbit(value))
+            *--p = '-';
+        return p;
+    }
+
+    // EmitPassThrough
+    //
+    // Formats a single conversion with vsnprintf, straight into the output,
+    // then steps args past whatever that conversion consumed.
+
+    EmitStatus EmitPassThrough(OutputBuffer & out, const FormatSpec & spec, va_list & args)
+    {
+        char szSpec[64];
+        if (spec.cchText + 2 > sizeof szSpec)
+            return EmitStatus::BadConversion;
+
+        szSpec[0] = '%';
+        memcpy(szSpec + 1, spec.pText, spec.cchText);
+        szSpec[spec.cchText + 1] = '\0';
+
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        int cch = vsnprintf(out.Cursor(), out.Room() + 1, szSpec, argsCopy);
+        va_end(argsCopy);
+
+        if (SAFE_UNLIKELY(cch < 0))
+            return EmitStatus::EncodingError;
+        out.Advance(cch);
+
+        if (spec.width == c_FromArgument)
+            (void) va_arg(args, int);
+        if (spec.precision == c_FromArgument)
+            (void) va_arg(args, int);
+
+        switch (spec.chConversion)
+        {
+            case 'd': case 'i':
+                (void) SignedArg(spec.length, args);
+                break;
+
+            case 'u': case 'o': case 'x': case 'X':
+                (void) UnsignedArg(spec.length, args);
+                break;
+
+            case 'c':
+                if (spec.length == LengthModifier::l)
+                    (void) va_arg(args, wint_t);
+                else
+                    (void) va_arg(args, int);
+                break;
+
+            case 's':
+                if (spec.length == LengthModifier::l)
+                    (void) va_arg(args, const wchar_t *);
+                else
+                    (void) va_arg(args, const char *);
+                break;
+
+            case 'p':
+                (void) va_arg(args, void *);
+                break;
+
+            default:
+                if (spec.length == LengthModifier::L)
+                    (void) va_arg(args, long double);
+                else
+                    (void) va_arg(args, double);
+                break;
+        }
+
+        return EmitStatus::Ok;
+    }
+
+    template <typename T>
+    EmitStatus EmitFloat(OutputBuffer & out, const FormatSpec & spec, T value,
+                         size_t cchWidth, int precision, bool fLeft)
+    {
+        std::chars_format format;
+        switch (spec.chConversion)
+        {
+            case 'f': case 'F': format = std::chars_format::fixed;      break;
+            case 'e': case 'E': format = std::chars_format::scientific; break;
+            default:            format = std::chars_format::general;    break;
+        }
+
+        char   rgch[c_cchFloatMax];
+        char * pBegin = nullptr;
+        char * pEnd   = rgch + sizeof rgch;
+
+        if constexpr (std::is_same_v<T, double>)
+        {
+            if (format == std::chars_format::fixed && precision >= 0 && precision < (int) std::size(c_rgPow10))
+                pBegin = WriteFixed(pEnd, value, precision);
+        }
+
+        if (pBegin == nullptr)
+        {
+            std::to_chars_result result = (precision == c_NoPrecision)
+                                              ? std::to_chars(rgch, pEnd, value, format)
+                                              : std::to_chars(rgch, pEnd, value, format, precision);
+            pBegin = rgch;
+            pEnd   = result.ptr;
+
+            // Too long for the local buffer, which holds a precision in
+            // the hundreds.  printf copes with those, so rebuild the
+            // conversion and let it have this one.
+
+            if (SAFE_UNLIKELY(result.ec != std::errc()))
+            {
+                char   szSpec[16];
+                char * p = szSpec;
+                *p++ = '%';
+                if (fLeft)
+                    *p++ = '-';
+                if (spec.flags & FlagPlus)
+                    *p++ = '+';
+                if (spec.flags & FlagSpace)
+                    *p++ = ' ';
+                if (spec.flags & FlagZero)
+                    *p++ = '0';
+                *p++ = '*';
+                *p++ = '.';
+                *p++ = '*';
+                if (spec.length == LengthModifier::L)
+                    *p++ = 'L';
+                *p++ = spec.chConversion;
+                *p   = '\0';
+
+                int cch = snprintf(out.Cursor(), out.Room() + 1, szSpec, (int) cchWidth,
+                                   (precision == c_NoPrecision) ? 6 : precision, value);
+                if (SAFE_UNLIKELY(cch < 0))
+                    return EmitStatus::EncodingError;
+                out.Advance(cch);
+                return EmitStatus::Ok;
+            }
+        }
+
+        if (spec.chConversion == 'F' || spec.chConversion == 'E' || spec.chConversion == 'G')
+        {
+            for (char * p = pBegin; p < pEnd; p++)
+            {
+                if (*p >= 'a' && *p <= 'z')
+                    *p = (char) (*p - 'a' + 'A');
+            }
+        }
+
+        const char * pBody = pBegin;
+        char chSign = 0;
+        if (*pBody == '-')
+            chSign = *pBody++;
+        else if (spec.flags & FlagPlus)
+            chSign = '+';
+        else if (spec.flags & FlagSpace)
+            chSign = ' ';
+
+        bool fZeroPad = (spec.flags & FlagZero) && std::isfinite(value);
+
+        EmitField(out, cchWidth, fLeft, fZeroPad, &chSign, chSign ? 1 : 0, 0, pBody, pEnd - pBody);
+        return EmitStatus::Ok;
+    }
+}
+
+namespace SafeStrings::Internal
+{
+    const char * ParseSpec(const char * p, FormatSpec & spec)
+    {
+        spec.pText        = p;
+        spec.flags        = 0;
+        spec.fPassThrough = false;
+        for (;; ++p)
+        {
+            if (*p == '-')
+                spec.flags |= FlagLeft;
+            else if (*p == '0')
+                spec.flags |= FlagZero;
+            else if (*p == '+')
+                spec.flags |= FlagPlus;
+            else if (*p == ' ')
+                spec.flags |= FlagSpace;
+            else if (*p == '#' || *p == '\'')
+                spec.fPassThrough = true;
+            else
+                break;
+        }
+
+        // Width, or a positional argument if the digits end in '$', which
+        // vsnprintf_s doesn't accept either
+
+        spec.width = 0;
+        if (*p == '*')
+        {
+            spec.width = c_FromArgument;
+            ++p;
+        }
+        else
+        {
+            for (; IsDigit(*p); ++p)
+            {
+                if (spec.width > (INT_MAX - 9) / 10)
+                    return nullptr;
+                spec.width = spec.width * 10 + (*p - '0');
+            }
+            if (*p == '$')
+                return nullptr;
+        }
+
+        spec.precision = c_NoPrecision;
+        if (*p == '.')
+        {
+            if (*++p == '*')
+            {
+                spec.precision = c_FromArgument;
+                ++p;
+            }
+            else
+            {
+                spec.precision = 0;
+                for (; IsDigit(*p); ++p)
+                {
+                    if (spec.precision > (INT_MAX - 9) / 10)
+                        return nullptr;
+                    spec.precision = spec.precision * 10 + (*p - '0');
+                }
+            }
+        }
+
+        spec.length = LengthModifier::None;
+        switch (*p)
+        {
+            case 'h': spec.length = (p[1] == 'h') ? (++p, LengthModifier::hh) : LengthModifier::h; ++p; break;
+            case 'l': spec.length = (p[1] == 'l') ? (++p, LengthModifier::ll) : LengthModifier::l; ++p; break;
+            case 'j': spec.length = LengthModifier::j; ++p; break;
+            case 'z': spec.length = LengthModifier::z; ++p; break;
+            case 't': spec.length = LengthModifier::t; ++p; break;
+            case 'L': spec.length = LengthModifier::L; ++p; break;
+        }
+
+        spec.chConversion = *p;
+        switch (*p)
+        {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                if (spec.length == LengthModifier::L)
+                    spec.fPassThrough = true;
+                break;
+
+            case 'c': case 's':
+                if (spec.length != LengthModifier::None || (spec.flags & FlagZero))
+                    spec.fPassThrough = true;
+                break;
+
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+                if (spec.length != LengthModifier::None && spec.length != LengthModifier::L)
+                    spec.fPassThrough = true;
+                break;
+
+            case 'p': case 'a': case 'A':
+                spec.fPassThrough = true;
+                break;
+
+            case 'n':
+                break;
+
+            default:
+                // Includes a format that ends in the middle of a conversion
+                return nullptr;
+        }
+
+        spec.cchText = p + 1 - spec.pText;
+        return p + 1;
+    }
+
+    EmitStatus EmitConversion(OutputBuffer & out, const FormatSpec & spec, va_list & args)
+    {
+        if (SAFE_UNLIKELY(spec.chConversion == 'n'))
+            return EmitStatus::PercentN;
+
+        // A null string is refused before vsnprintf sees it, as it would
+        // be by vsnprintf_s
+
+        if (SAFE_UNLIKELY(spec.fPassThrough))
+        {
+            if (spec.chConversion == 's')
+            {
+                va_list argsCopy;
+                va_copy(argsCopy, args);
+                if (spec.width == c_FromArgument)
+                    (void) va_arg(argsCopy, int);
+                if (spec.precision == c_FromArgument)
+                    (void) va_arg(argsCopy, int);
+                bool fNull = (va_arg(argsCopy, const void *) == nullptr);
+                va_end(argsCopy);
+                if (fNull)
+                    return EmitStatus::NullString;
+            }
+            return EmitPassThrough(out, spec, args);
+        }
+
+        bool   fLeft     = spec.flags & FlagLeft;
+        size_t cchWidth  = spec.width;
+        int    precision = spec.precision;
+
+        if (spec.width == c_FromArgument)
+        {
+            int width = va_arg(args, int);
+            if (width < 0)
+            {
+                fLeft    = true;
+                cchWidth = 0u - (unsigned int) width;
+            }
+            else
+            {
+                cchWidth = width;
+            }
+        }
+
+        if (precision == c_FromArgument)
+        {
+            precision = va_arg(args, int);
+            if (precision < 0)
+                precision = c_NoPrecision;
+        }
+
+        switch (spec.chConversion)
+        {
+            case 'd': case 'i':
+            {
+                intmax_t  value     = SignedArg(spec.length, args);
+                uintmax_t magnitude = (value < 0) ? 0 - (uintmax_t) value : (uintmax_t) value;
+                char      chSign    = (value < 0)                ? '-'
+                                    : (spec.flags & FlagPlus)    ? '+'
+                                    : (spec.flags & FlagSpace)   ? ' '
+                                    : 0;
+                EmitInteger(out, spec, magnitude, chSign, cchWidth, precision, fLeft);
+                return EmitStatus::Ok;
+            }
+
+            case 'u': case 'o': case 'x': case 'X':
+                EmitInteger(out, spec, UnsignedArg(spec.length, args), 0, cchWidth, precision, fLeft);
+                return EmitStatus::Ok;
+
+            case 'c':
+            {
+                char ch = (char) va_arg(args, int);
+                EmitField(out, cchWidth, fLeft, false, "", 0, 0, &ch, 1);
+                return EmitStatus::Ok;
+            }
+
+            case 's':
+            {
+                const char * psz = va_arg(args, const char *);
+                if (SAFE_UNLIKELY(psz == nullptr))
+                    return EmitStatus::NullString;
+
+                if (SAFE_LIKELY(cchWidth == 0 && precision == c_NoPrecision))
+                {
+                    out.AppendString(psz);
+                }
+                else
+                {
+                    size_t cch = (precision == c_NoPrecision) ? strlen(psz) : strnlen(psz, precision);
+                    EmitField(out, cchWidth, fLeft, false, "", 0, 0, psz, cch);
+                }
+                return EmitStatus::Ok;
+            }
+
+            default:
+                if (spec.length == LengthModifier::L)
+                    return EmitFloat(out, spec, va_arg(args, long double), cchWidth, precision, fLeft);
+                return EmitFloat(out, spec, va_arg(args, double), cchWidth, precision, fLeft);
+        }
+    }
+
+    EmitStatus FormatTo(OutputBuffer & out, const char * format, va_list & args)
+    {
+        const char * p = format;
+        for (;;)
+        {
+            const char * pLiteral = p;
+            while (*p != '%' && *p != '\0')
+                ++p;
+            out.Append(pLiteral, p - pLiteral);
+
+            if (*p == '\0')
+                return EmitStatus::Ok;
+
+            // The bare conversions - no flags, width, precision or length -
+            // are most of what real formats contain, so they skip the
+            // FormatSpec and field layout entirely.  So do the integers with
+            // a one-digit width that timestamps and ids tend to use.
+
+            const char * pShort = p + 1 + (p[1] == '0');
+            if (*pShort >= '1' && *pShort <= '9' && (pShort[1] == 'd' || pShort[1] == 'u' || pShort[1] == 'x'))
+            {
+                size_t cchWidth = *pShort - '0';
+                bool   fZeroPad = (p[1] == '0');
+                if (pShort[1] == 'd')
+                {
+                    int value = va_arg(args, int);
+                    AppendShortInteger(out, (value < 0) ? 0u - (unsigned int) value : (unsigned int) value, value < 0,
+                                       false, cchWidth, fZeroPad);
+                }
+                else
+                {
+                    AppendShortInteger(out, va_arg(args, unsigned int), false, pShort[1] == 'x', cchWidth, fZeroPad);
+                }
+                p = pShort + 2;
+                continue;
+            }
+
+            switch (p[1])
+            {
+                case '%':
+                    out.Append(p, 1);
+                    p += 2;
+                    continue;
+
+                case 'd': case 'i':
+                {
+                    int value = va_arg(args, int);
+                    AppendShortInteger(out, (value < 0) ? 0u - (unsigned int) value : (unsigned int) value, value < 0, false);
+                    p += 2;
+                    continue;
+                }
+
+                case 'u':
+                    AppendShortInteger(out, va_arg(args, unsigned int), false, false);
+                    p += 2;
+                    continue;
+
+                case 'x':
+                    AppendShortInteger(out, va_arg(args, unsigned int), false, true);
+                    p += 2;
+                    continue;
+
+                case 's':
+                {
+                    const char * psz = va_arg(args, const char *);
+                    if (SAFE_UNLIKELY(psz == nullptr))
+                        return EmitStatus::NullString;
+                    out.AppendString(psz);
+                    p += 2;
+                    continue;
+                }
+            }
+
+            FormatSpec spec;
+            p = ParseSpec(p + 1, spec);
+            if (p == nullptr)
+                return EmitStatus::BadConversion;
+
+            EmitStatus status = EmitConversion(out, spec, args);
+            if (status != EmitStatus::Ok)
+                return status;
+        }
+    }
+
+    void CompileSteps(const char * format, std::vector<FormatStep> & steps, std::string & literals)
+    {
+        steps.clear();
+        literals.clear();
+
+        FormatStep step = { };
+        const char * p = format;
+        for (;;)
+        {
+            const char * pLiteral = p;
+            while (*p != '%' && *p != '\0')
+                ++p;
+            literals.append(pLiteral, p - pLiteral);
+
+            if (*p == '\0')
+            {
+                step.kind = StepKind::End;
+                break;
+            }
+
+            // %% just extends the literal text of the current step
+
+            if (p[1] == '%')
+            {
+                literals.push_back('%');
+                p += 2;
+                continue;
+            }
+
+            // The same shortcuts FormatTo takes, recognized once here
+
+            const char * pShort = p + 1 + (p[1] == '0');
+            bool fShort = (*pShort >= '1' && *pShort <= '9');
+            const char * pConversion = fShort ? pShort + 1 : p + 1;
+
+            step.kind = StepKind::Conversion;
+            switch (*pConversion)
+            {
+                case 'd': step.kind = StepKind::Signed;   break;
+                case 'u': step.kind = StepKind::Unsigned; break;
+                case 'x': step.kind = StepKind::Hex;      break;
+                case 'i': if (!fShort) step.kind = StepKind::Signed; break;
+                case 's': if (!fShort) step.kind = StepKind::String; break;
+            }
+
+            if (step.kind == StepKind::Conversion)
+            {
+                p = ParseSpec(p + 1, step.spec);
+                if (p == nullptr)
+                {
+                    step.kind = StepKind::Invalid;
+                    break;
+                }
+            }
+            else
+            {
+                step.cchWidth = fShort ? (uint8_t) (*pShort - '0') : 0;
+                step.fZeroPad = fShort && p[1] == '0';
+                p = pConversion + 1;
+            }
+
+            step.cchLiteral = literals.size() - step.ichLiteral;
+            steps.push_back(step);
+
+            step = { };
+            step.ichLiteral = literals.size();
+        }
+
+        step.cchLiteral = literals.size() - step.ichLiteral;
+        steps.push_back(step);
+    }
+
+    EmitStatus EmitSteps(OutputBuffer & out, const FormatStep * pStep, const char * pLiterals, va_list & args)
+    {
+        for (;; ++pStep)
+        {
+            out.Append(pLiterals + pStep->ichLiteral, pStep->cchLiteral);
+
+            switch (pStep->kind)
+            {
+                case StepKind::End:
+                    return EmitStatus::Ok;
+
+                case StepKind::Signed:
+                {
+                    int value = va_arg(args, int);
+                    AppendShortInteger(out, (value < 0) ? 0u - (unsigned int) value : (unsigned int) value, value < 0,
+                                       false, pStep->cchWidth, pStep->fZeroPad);
+                    break;
+                }
+
+                case StepKind::Unsigned:
+                case StepKind::Hex:
+                    AppendShortInteger(out, va_arg(args, unsigned int), false, pStep->kind == StepKind::Hex,
+                                       pStep->cchWidth, pStep->fZeroPad);
+                    break;
+
+                case StepKind::String:
+                {
+                    const char * psz = va_arg(args, const char *);
+                    if (SAFE_UNLIKELY(psz == nullptr))
+                        return EmitStatus::NullString;
+                    out.AppendString(psz);
+                    break;
+                }
+
+                case StepKind::Conversion:
+                {
+                    EmitStatus status = EmitConversion(out, pStep->spec, args);
+                    if (status != EmitStatus::Ok)
+                        return status;
+                    break;
+                }
+
+                case StepKind::Invalid:
+                    return EmitStatus::BadConversion;
+            }
+        }
+    }
+
+    errno_t ReportEmitFailure(EmitStatus status, const wchar_t * function)
+    {
+        switch (status)
+        {
+            case EmitStatus::Ok:
+                return 0;
+
+            case EmitStatus::PercentN:
+                return ConstraintViolation(EINVAL, L"('n' format not allowed)", function, L"" __FILE__, __LINE__);
+
+            case EmitStatus::NullString:
+                return ConstraintViolation(EINVAL, L"(string argument != nullptr)", function, L"" __FILE__, __LINE__);
+
+            case EmitStatus::BadConversion:
+                return ConstraintViolation(EINVAL, L"(valid format specifier)", function, L"" __FILE__, __LINE__);
+
+            case EmitStatus::EncodingError:
+                return ConstraintViolation(EILSEQ, L"(encoding error)", function, L"" __FILE__, __LINE__);
+        }
+        return 0;
+    }
+
+    int FinishFormat(OutputBuffer & out, char * buffer, bool fTruncate, EmitStatus status, const wchar_t * function)
+    {
+        if (SAFE_UNLIKELY(status != EmitStatus::Ok))
+        {
+            buffer[0] = '\0';
+            ReportEmitFailure(status, function);
+            return -1;
+        }
+
+        out.Terminate();
+        if (SAFE_LIKELY(!out.Truncated()))
+            return (int) out.Written();
+
+        if (fTruncate)
+        {
+            NoteTruncation(out.Needed() + 1, out.Written() + 1);
+            return -1;
+        }
+
+        buffer[0] = '\0';
+        NoteFailureSizes(out.Needed() + 1, out.Written() + 1);
+        ConstraintViolation(ERANGE, L"Buffer too small", function, L"" __FILE__, __LINE__);
+        return -1;
+    }
+}
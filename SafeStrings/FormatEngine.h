@@ -0,0 +1,284 @@
+//--------------------------------------------------------------------------------
+// FormatEngine.h - The printf subset behind FastFormat
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Not part of the public interface.  The engine is split into a parse step
+// that turns one conversion into a FormatSpec and an emit step that consumes
+// its arguments and writes the result, so that anything which wants to parse
+// once and emit many times can reuse the second half.
+//
+// The argument list is taken by reference and advanced in place.  Copying a
+// va_list right after va_start costs a store-forwarding stall on x86-64,
+// which at these speeds is a noticeable share of a whole call.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStringsInternal.h"
+#include "StringKernels.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace SafeStrings::Internal
+{
+    enum class LengthModifier : uint8_t
+    {
+        None, hh, h, l, ll, j, z, t, L
+    };
+
+    enum FormatFlags : uint8_t
+    {
+        FlagLeft  = 0x01,       // '-'
+        FlagZero  = 0x02,       // '0'
+        FlagPlus  = 0x04,       // '+'
+        FlagSpace = 0x08,       // ' '
+    };
+
+    constexpr int c_NoPrecision   = -1;    // No precision given
+    constexpr int c_FromArgument  = -2;    // Width or precision was '*'
+
+    struct FormatSpec
+    {
+        char           chConversion;
+        uint8_t        flags;
+        LengthModifier length;
+        bool           fPassThrough;    // Formatted by vsnprintf, see below
+        int            width;           // 0 when absent
+        int            precision;       // c_NoPrecision when absent
+        const char *   pText;           // The conversion as written, after the '%'
+        size_t         cchText;
+    };
+
+    enum class EmitStatus
+    {
+        Ok,
+        PercentN,               // %n, which is never allowed
+        NullString,             // %s with a null pointer
+        BadConversion,          // Not a conversion vsnprintf_s accepts
+        EncodingError,          // vsnprintf failed on a pass-through conversion
+    };
+
+    // OutputBuffer
+    //
+    // A bounded writer that keeps counting once it runs out of room, so the
+    // caller learns both what fit and how long the whole result would have
+    // been.  The last byte of the limit is always kept for the terminator.
+
+    class OutputBuffer
+    {
+    public:
+
+        OutputBuffer(char * buffer, size_t cbLimit)
+            : _pStart(buffer), _p(buffer), _pLimit(buffer + cbLimit - 1)
+        {
+        }
+
+        // Pieces are mostly a few characters of literal text or a number,
+        // which CopySmall moves without a call to memcpy
+
+        void Append(const char * src, size_t cch)
+        {
+            size_t cchRoom = _pLimit - _p;
+            if (SAFE_LIKELY(cch <= cchRoom))
+            {
+                if (SAFE_LIKELY(cch <= 64))
+                    CopySmall(_p, src, cch);
+                else
+                    memcpy(_p, src, cch);
+                _p += cch;
+            }
+            else
+            {
+                memcpy(_p, src, cchRoom);
+                _p = _pLimit;
+                _cchLost += cch - cchRoom;
+            }
+        }
+
+        // Padding is usually a handful of characters too, which two
+        // overlapping stores of a repeated pattern cover
+
+        void Fill(char ch, size_t cch)
+        {
+            size_t cchRoom = _pLimit - _p;
+            if (SAFE_LIKELY(cch <= cchRoom))
+            {
+                uint64_t pattern = 0x0101010101010101ull * (unsigned char) ch;
+                if (cch >= 8 && cch <= 16)
+                {
+                    memcpy(_p, &pattern, 8);
+                    memcpy(_p + cch - 8, &pattern, 8);
+                }
+                else if (cch >= 4 && cch < 8)
+                {
+                    memcpy(_p, &pattern, 4);
+                    memcpy(_p + cch - 4, &pattern, 4);
+                }
+                else if (cch < 4)
+                {
+                    for (size_t i = 0; i < cch; i++)
+                        _p[i] = ch;
+                }
+                else
+                {
+                    memset(_p, ch, cch);
+                }
+                _p += cch;
+            }
+            else
+            {
+                memset(_p, ch, cchRoom);
+                _p = _pLimit;
+                _cchLost += cch - cchRoom;
+            }
+        }
+
+        // AppendString
+        //
+        // A whole C string in a single pass: copy it with the fused kernel,
+        // and only if it didn't fit go back for the prefix (CopyBounded
+        // doesn't promise how much of one it leaves) and the full length.
+
+        void AppendString(const char * src)
+        {
+            size_t cbRoom = _pLimit - _p + 1;
+            size_t cch    = CopyBounded(_p, cbRoom, src);
+            if (SAFE_LIKELY(cch < cbRoom))
+            {
+                _p += cch;
+            }
+            else
+            {
+                memcpy(_p, src, cbRoom - 1);
+                _p        = _pLimit;
+                _cchLost += strlen(src + cbRoom - 1);
+            }
+        }
+
+        // Cursor / Room / Advance
+        //
+        // For writers that format in place, such as vsnprintf: they get
+        // Room() characters plus a terminator at Cursor(), and report the
+        // full length they wanted to write.
+
+        char * Cursor() const { return _p; }
+        size_t Room()   const { return _pLimit - _p; }
+
+        void Advance(size_t cch)
+        {
+            size_t cchRoom = _pLimit - _p;
+            if (SAFE_LIKELY(cch <= cchRoom))
+            {
+                _p += cch;
+            }
+            else
+            {
+                _p        = _pLimit;
+                _cchLost += cch - cchRoom;
+            }
+        }
+
+        char * Terminate()
+        {
+            *_p = '\0';
+            return _pStart;
+        }
+
+        bool   Truncated() const { return _cchLost != 0; }
+        size_t Written()   const { return _p - _pStart; }
+        size_t Needed()    const { return Written() + _cchLost; }
+
+    private:
+
+        char * _pStart;
+        char * _p;
+        char * _pLimit;
+        size_t _cchLost = 0;
+    };
+
+    // ParseSpec
+    //
+    // p points just past the '%'.  Fills in spec and returns the character
+    // after the conversion, or nullptr if it isn't one vsnprintf_s accepts.
+    // Conversions the engine doesn't format itself (%p, %a, wide characters
+    // and strings, the '#' and '\'' flags) are marked fPassThrough, and are
+    // handed one at a time to vsnprintf.
+
+    const char * ParseSpec(const char * p, FormatSpec & spec);
+
+    // EmitConversion
+    //
+    // Consumes the arguments for one parsed conversion and writes it.
+
+    EmitStatus EmitConversion(OutputBuffer & out, const FormatSpec & spec, va_list & args);
+
+    // FormatTo
+    //
+    // Parse and emit a whole format.  Anything but Ok may be returned after
+    // some output has been written, which the caller is expected to discard.
+
+    EmitStatus FormatTo(OutputBuffer & out, const char * format, va_list & args);
+
+    // FormatStep
+    //
+    // One step of a compiled format: a run of literal text (with any %%
+    // already collapsed) followed by a conversion.  The conversions FormatTo
+    // special-cases get kinds of their own, so emitting them needs no
+    // FormatSpec at all; the last step of every plan is End or Invalid.
+
+    enum class StepKind : uint8_t
+    {
+        End,                    // Literal text only
+        Signed,                 // %d, %i and %Nd / %0Nd for N in 1-9
+        Unsigned,               // Likewise for u
+        Hex,                    // Likewise for x
+        String,                 // %s
+        Conversion,             // Anything else, described by spec
+        Invalid,                // Not a conversion vsnprintf_s accepts
+    };
+
+    struct FormatStep
+    {
+        size_t     ichLiteral;
+        size_t     cchLiteral;
+        StepKind   kind;
+        uint8_t    cchWidth;        // Signed, Unsigned, Hex
+        bool       fZeroPad;        // Signed, Unsigned, Hex
+        FormatSpec spec;            // Conversion
+    };
+
+    // CompileSteps
+    //
+    // Parses format once into steps and the literal text they refer to.  The
+    // specs point into format, which has to outlive them.
+
+    void CompileSteps(const char * format, std::vector<FormatStep> & steps, std::string & literals);
+
+    // EmitSteps
+    //
+    // FormatTo for a compiled format.
+
+    EmitStatus EmitSteps(OutputBuffer & out, const FormatStep * pStep, const char * pLiterals, va_list & args);
+
+    // FinishFormat
+    //
+    // The tail shared by the engine's entry points: raises the violation
+    // for a failed status, or terminates the output and applies the
+    // vsnprintf_s count rules.  function names the caller in the report.
+
+    int FinishFormat(OutputBuffer & out, char * buffer, bool fTruncate, EmitStatus status, const wchar_t * function);
+
+    // ReportEmitFailure
+    //
+    // Raises the violation that goes with a failed status and returns its
+    // errno value, or returns 0 for Ok.
+
+    errno_t ReportEmitFailure(EmitStatus status, const wchar_t * function);
+}
@@ -0,0 +1,565 @@
+//--------------------------------------------------------------------------------
+// FormatFunctions.cpp - _snprintf_s, vsnprintf_s
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "CheckedFormat.h"
+#include "FastFormat.h"
+#include "FormatEngine.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+    enum class FormatCheck
+    {
+        Ok,
+        PercentN,
+        NullString,
+        BadConversion
+    };
+
+    using SafeStrings::Internal::LengthModifier;
+
+    inline bool IsDigit(char ch)
+    {
+        return ch >= '0' && ch <= '9';
+    }
+
+    // ValidateFormat
+    //
+    // Walks the format alongside a copy of the argument list so that each
+    // conversion can be matched with the argument it will consume.  This is
+    // what catches %n and a null pointer handed to %s before vsnprintf ever
+    // sees them.
+
+    FormatCheck ValidateFormat(const char * format, va_list argptr)
+    {
+        FormatCheck result = FormatCheck::Ok;
+
+        va_list args;
+        va_copy(args, argptr);
+
+        for (const char * p = format; *p; ++p)
+        {
+            if (*p != '%')
+                continue;
+
+            if (*++p == '%')
+                continue;
+
+            while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'')
+                ++p;
+
+            if (*p == '*')
+            {
+                (void) va_arg(args, int);
+                ++p;
+            }
+            else
+            {
+                while (IsDigit(*p))
+                    ++p;
+            }
+
+            if (*p == '.')
+            {
+                if (*++p == '*')
+                {
+                    (void) va_arg(args, int);
+                    ++p;
+                }
+                else
+                {
+                    while (IsDigit(*p))
+                        ++p;
+                }
+            }
+
+            LengthModifier length = LengthModifier::None;
+            switch (*p)
+            {
+                case 'h': length = (p[1] == 'h') ? (++p, LengthModifier::hh) : LengthModifier::h; ++p; break;
+                case 'l': length = (p[1] == 'l') ? (++p, LengthModifier::ll) : LengthModifier::l; ++p; break;
+                case 'j': length = LengthModifier::j; ++p; break;
+                case 'z': length = LengthModifier::z; ++p; break;
+                case 't': length = LengthModifier::t; ++p; break;
+                case 'L': length = LengthModifier::L; ++p; break;
+            }
+
+            switch (*p)
+            {
+                case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                    switch (length)
+                    {
+                        case LengthModifier::l:  (void) va_arg(args, long);      break;
+                        case LengthModifier::ll: (void) va_arg(args, long long); break;
+                        case LengthModifier::j:  (void) va_arg(args, intmax_t);  break;
+                        case LengthModifier::z:  (void) va_arg(args, size_t);    break;
+                        case LengthModifier::t:  (void) va_arg(args, ptrdiff_t); break;
+                        default:                 (void) va_arg(args, int);       break;
+                    }
+                    break;
+
+                case 'c':
+                    if (length == LengthModifier::l)
+                        (void) va_arg(args, wint_t);
+                    else
+                        (void) va_arg(args, int);
+                    break;
+
+                case 's':
+                    if (length == LengthModifier::l)
+                    {
+                        if (va_arg(args, const wchar_t *) == nullptr)
+                            result = FormatCheck::NullString;
+                    }
+                    else
+                    {
+                        if (va_arg(args, const char *) == nullptr)
+                            result = FormatCheck::NullString;
+                    }
+                    break;
+
+                case 'p':
+                    (void) va_arg(args, void *);
+                    break;
+
+                case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                    if (length == LengthModifier::L)
+                        (void) va_arg(args, long double);
+                    else
+                        (void) va_arg(args, double);
+                    break;
+
+                case 'n':
+                    result = FormatCheck::PercentN;
+                    break;
+
+                default:
+                    // Includes a format that ends in the middle of a conversion
+                    // and positional (%1$s) arguments, which the CRT rejects too
+
+                    result = FormatCheck::BadConversion;
+                    break;
+            }
+
+            // Stop at the first failure, which may have left p on the
+            // terminator
+
+            if (result != FormatCheck::Ok)
+                break;
+        }
+
+        va_end(args);
+        return result;
+    }
+
+    // FormatToBuffer
+    //
+    // The buffer and count handling shared by vsnprintf_s and the
+    // prevalidated entry points, once the format is known to be safe.
+    // Returns as VSnprintfStatus does.
+
+    errno_t FormatToBuffer(char * buffer, size_t sizeOfBuffer, size_t count, size_t * pcchWritten,
+                           const char * format, va_list argptr)
+    {
+        bool   fTruncate = (count == _TRUNCATE || count < sizeOfBuffer);
+        size_t cbLimit   = (count < sizeOfBuffer) ? count + 1 : sizeOfBuffer;
+
+        *pcchWritten = 0;
+
+        int cch = vsnprintf(buffer, cbLimit, format, argptr);
+        if (SAFE_UNLIKELY(cch < 0))
+        {
+            buffer[0] = '\0';
+            return SAFE_RAISE(EILSEQ, "(encoding error)", "vsnprintf_s");
+        }
+
+        if (SAFE_LIKELY((size_t) cch < cbLimit))
+        {
+            *pcchWritten = (size_t) cch;
+            return 0;
+        }
+
+        // Didn't fit.  vsnprintf has already left a terminated prefix in the
+        // buffer, which is exactly what the truncating modes want.
+
+        if (fTruncate)
+        {
+            SafeStrings::Internal::NoteTruncation((size_t) cch + 1, cbLimit);
+            *pcchWritten = cbLimit - 1;
+            return STRUNCATE;
+        }
+
+        buffer[0] = '\0';
+        SafeStrings::Internal::NoteFailureSizes((size_t) cch + 1, cbLimit);
+        return SAFE_RAISE(ERANGE, "Buffer too small", "vsnprintf_s");
+    }
+
+    // CrtResult
+    //
+    // What vsnprintf_s returns for a status: the length, or -1 for anything
+    // but success.
+
+    inline int CrtResult(errno_t err, size_t cchWritten)
+    {
+        return (err == 0) ? (int) cchWritten : -1;
+    }
+
+    // FormatChecked
+    //
+    // The body of vsnprintf_s, returning as VSnprintfStatus does.
+
+    errno_t FormatChecked(char * buffer, size_t sizeOfBuffer, size_t count, size_t * pcchWritten,
+                          const char * format, va_list argptr)
+    {
+        *pcchWritten = 0;
+
+        if (count == 0 && buffer == nullptr && sizeOfBuffer == 0)
+            return 0;
+
+        SAFE_VALIDATE_STRING(buffer, sizeOfBuffer, "vsnprintf_s", EINVAL);
+
+        if (SAFE_UNLIKELY(format == nullptr))
+        {
+            buffer[0] = '\0';
+            return SAFE_RAISE(EINVAL, "format != nullptr", "vsnprintf_s");
+        }
+
+        switch (ValidateFormat(format, argptr))
+        {
+            case FormatCheck::Ok:
+                break;
+
+            case FormatCheck::PercentN:
+                buffer[0] = '\0';
+                return SAFE_RAISE(EINVAL, "('n' format not allowed)", "vsnprintf_s");
+
+            case FormatCheck::NullString:
+                buffer[0] = '\0';
+                return SAFE_RAISE(EINVAL, "(string argument != nullptr)", "vsnprintf_s");
+
+            case FormatCheck::BadConversion:
+                buffer[0] = '\0';
+                return SAFE_RAISE(EINVAL, "(valid format specifier)", "vsnprintf_s");
+        }
+
+        return FormatToBuffer(buffer, sizeOfBuffer, count, pcchWritten, format, argptr);
+    }
+}
+
+// vsnprintf_s
+//
+// Formats into buffer, never writing more than sizeOfBuffer bytes.  count is
+// the most characters the caller wants, not counting the terminator:
+//
+//  - count == _TRUNCATE        : write what fits, return -1 if truncated
+//  - count <  sizeOfBuffer     : write at most count, return -1 if truncated
+//  - otherwise                 : if it doesn't fit, empty the buffer and raise
+//
+// The return value is the number of characters written, or -1.
+
+extern "C" int vsnprintf_s(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list argptr)
+{
+    size_t  cchWritten;
+    errno_t err = SafeStrings::Internal::VSnprintfStatus(buffer, sizeOfBuffer, count, &cchWritten, format, argptr);
+    return CrtResult(err, cchWritten);
+}
+
+errno_t SafeStrings::Internal::VSnprintfStatus(char * buffer, size_t sizeOfBuffer, size_t count,
+                                               size_t * pcchWritten, const char * format, va_list argptr)
+{
+    return FormatChecked(buffer, sizeOfBuffer, count, pcchWritten, format, argptr);
+}
+
+// _snprintf_s
+//
+// Variadic front end for vsnprintf_s.
+
+extern "C" int _snprintf_s(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int result = vsnprintf_s(buffer, sizeOfBuffer, count, format, args);
+    va_end(args);
+    return result;
+}
+
+// VFormatPrevalidated
+//
+// vsnprintf_s minus the format walk, for callers (CheckedFormat) that have
+// already proven the format safe at compile time.
+
+int SafeStrings::VFormatPrevalidated(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list argptr)
+{
+    SAFE_VALIDATE_STRING(buffer, sizeOfBuffer, "vsnprintf_s", -1);
+
+    size_t  cchWritten;
+    errno_t err = FormatToBuffer(buffer, sizeOfBuffer, count, &cchWritten, format, argptr);
+    return CrtResult(err, cchWritten);
+}
+
+int SafeStrings::FormatPrevalidated(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int result = VFormatPrevalidated(buffer, sizeOfBuffer, count, format, args);
+    va_end(args);
+    return result;
+}
+
+namespace
+{
+    // FastFormatTo
+    //
+    // The body of FastFormat and VFastFormat, with the same buffer and count
+    // handling as vsnprintf_s and the same violations for the same formats.
+
+    int FastFormatTo(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list & args)
+    {
+        using namespace SafeStrings::Internal;
+
+        if (count == 0 && buffer == nullptr && sizeOfBuffer == 0)
+            return 0;
+
+        SAFE_VALIDATE_STRING(buffer, sizeOfBuffer, "FastFormat", -1);
+
+        if (SAFE_UNLIKELY(format == nullptr))
+        {
+            buffer[0] = '\0';
+            SAFE_RAISE(EINVAL, "format != nullptr", "FastFormat");
+            return -1;
+        }
+
+        bool   fTruncate = (count == _TRUNCATE || count < sizeOfBuffer);
+        size_t cbLimit   = (count < sizeOfBuffer) ? count + 1 : sizeOfBuffer;
+
+        OutputBuffer out(buffer, cbLimit);
+        EmitStatus   status = FormatTo(out, format, args);
+        return FinishFormat(out, buffer, fTruncate, status, L"FastFormat");
+    }
+}
+
+// VFormatStatus
+//
+// FastFormatTo's checks and engine, reporting instead of raising.
+
+SafeStrings::Internal::FormatStatus SafeStrings::Internal::VFormatStatus(char * buffer, size_t sizeOfBuffer,
+                                                                         const char * format, va_list & args)
+{
+    if (SAFE_UNLIKELY(buffer == nullptr || sizeOfBuffer == 0 || sizeOfBuffer > RSIZE_MAX))
+        return { EINVAL, 0, 0, "buffer != nullptr && 0 < sizeOfBuffer <= RSIZE_MAX" };
+
+    if (SAFE_UNLIKELY(format == nullptr))
+    {
+        buffer[0] = '\0';
+        return { EINVAL, 0, 0, "format != nullptr" };
+    }
+
+    OutputBuffer out(buffer, sizeOfBuffer);
+    EmitStatus   status = FormatTo(out, format, args);
+    out.Terminate();
+
+    switch (status)
+    {
+        case EmitStatus::Ok:
+            break;
+
+        case EmitStatus::PercentN:
+            buffer[0] = '\0';
+            return { EINVAL, 0, 0, "('n' format not allowed)" };
+
+        case EmitStatus::NullString:
+            buffer[0] = '\0';
+            return { EINVAL, 0, 0, "(string argument != nullptr)" };
+
+        case EmitStatus::BadConversion:
+            buffer[0] = '\0';
+            return { EINVAL, 0, 0, "(valid format specifier)" };
+
+        case EmitStatus::EncodingError:
+            buffer[0] = '\0';
+            return { EILSEQ, 0, 0, "(encoding error)" };
+    }
+
+    if (SAFE_UNLIKELY(out.Truncated()))
+        return { STRUNCATE, out.Written(), out.Needed(), "Buffer too small" };
+
+    return { 0, out.Written(), out.Written(), nullptr };
+}
+
+// VFastFormat
+//
+// Prefer FastFormat where there's a choice; the va_list has to be copied
+// here before the engine can advance it.
+
+int SafeStrings::VFastFormat(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list argptr)
+{
+    va_list args;
+    va_copy(args, argptr);
+    int result = FastFormatTo(buffer, sizeOfBuffer, count, format, args);
+    va_end(args);
+    return result;
+}
+
+int SafeStrings::FastFormat(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int result = FastFormatTo(buffer, sizeOfBuffer, count, format, args);
+    va_end(args);
+    return result;
+}
+
+namespace
+{
+    // FormatMeasuredTo
+    //
+    // The body of FormatMeasured and VFormatMeasured.  The engine keeps
+    // counting once the buffer is full, so the length needed comes out of
+    // the same pass as the truncated text.
+
+    int FormatMeasuredTo(char * buffer, size_t sizeOfBuffer, size_t * pcchNeeded, const char * format, va_list & args)
+    {
+        using namespace SafeStrings::Internal;
+
+        if (SAFE_UNLIKELY(pcchNeeded == nullptr))
+        {
+            if (buffer != nullptr && sizeOfBuffer != 0 && sizeOfBuffer <= RSIZE_MAX)
+                buffer[0] = '\0';
+            SAFE_RAISE(EINVAL, "pcchNeeded != nullptr", "FormatMeasured");
+            return -1;
+        }
+
+        *pcchNeeded = 0;
+
+        // Measuring only: the engine still needs somewhere to put the
+        // terminator, which a one-byte scratch buffer provides
+
+        char chScratch;
+        bool fMeasureOnly = (buffer == nullptr && sizeOfBuffer == 0);
+        if (fMeasureOnly)
+        {
+            buffer       = &chScratch;
+            sizeOfBuffer = 1;
+        }
+
+        SAFE_VALIDATE_STRING(buffer, sizeOfBuffer, "FormatMeasured", -1);
+
+        if (SAFE_UNLIKELY(format == nullptr))
+        {
+            buffer[0] = '\0';
+            SAFE_RAISE(EINVAL, "format != nullptr", "FormatMeasured");
+            return -1;
+        }
+
+        OutputBuffer out(buffer, sizeOfBuffer);
+        EmitStatus   status = FormatTo(out, format, args);
+        int          result = FinishFormat(out, buffer, true, status, L"FormatMeasured");
+
+        if (SAFE_LIKELY(status == EmitStatus::Ok))
+            *pcchNeeded = out.Needed();
+        return fMeasureOnly ? 0 : result;
+    }
+}
+
+int SafeStrings::VFormatMeasured(char * buffer, size_t sizeOfBuffer, size_t * pcchNeeded, const char * format, va_list argptr)
+{
+    va_list args;
+    va_copy(args, argptr);
+    int result = FormatMeasuredTo(buffer, sizeOfBuffer, pcchNeeded, format, args);
+    va_end(args);
+    return result;
+}
+
+int SafeStrings::FormatMeasured(char * buffer, size_t sizeOfBuffer, size_t * pcchNeeded, const char * format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int result = FormatMeasuredTo(buffer, sizeOfBuffer, pcchNeeded, format, args);
+    va_end(args);
+    return result;
+}
+
+namespace
+{
+    // Most formatted text is a line or less, which fits here without
+    // touching the heap until it is appended
+
+    constexpr size_t c_cbAppendLocal = 256;
+
+    // FormatAppendTo
+    //
+    // The body of FormatAppend and VFormatAppend.  args formats into a local
+    // buffer first, so the usual short append is one copy and never touches
+    // str's spare capacity beyond the bytes it adds.  Only if that comes up
+    // short does argsAgain - a second, untouched list for the same
+    // arguments - format into str once it has grown by the measured length.
+
+    errno_t FormatAppendTo(std::string & str, const char * format, va_list & args, va_list & argsAgain)
+    {
+        using namespace SafeStrings::Internal;
+
+        if (SAFE_UNLIKELY(format == nullptr))
+            return SAFE_RAISE(EINVAL, "format != nullptr", "FormatAppend");
+
+        char         szLocal[c_cbAppendLocal];
+        OutputBuffer out(szLocal, sizeof szLocal);
+        EmitStatus   status = FormatTo(out, format, args);
+        if (SAFE_UNLIKELY(status != EmitStatus::Ok))
+            return ReportEmitFailure(status, L"FormatAppend");
+
+        if (SAFE_LIKELY(!out.Truncated()))
+        {
+            str.append(szLocal, out.Written());
+            return 0;
+        }
+
+        // Grow by exactly what was measured, the one allocation this makes.
+        // The engine's terminator lands on str's own, which is the one write
+        // past size() a std::string allows.
+
+        size_t ichStart = str.size();
+        size_t cch      = out.Needed();
+        str.resize(ichStart + cch);
+
+        OutputBuffer outFull(&str[ichStart], cch + 1);
+        status = FormatTo(outFull, format, argsAgain);
+        if (SAFE_UNLIKELY(status != EmitStatus::Ok || outFull.Truncated()))
+        {
+            str.resize(ichStart);
+            return ReportEmitFailure(status == EmitStatus::Ok ? EmitStatus::EncodingError : status, L"FormatAppend");
+        }
+
+        outFull.Terminate();
+        return 0;
+    }
+}
+
+errno_t SafeStrings::VFormatAppend(std::string & str, const char * format, va_list argptr)
+{
+    va_list args, argsAgain;
+    va_copy(args, argptr);
+    va_copy(argsAgain, argptr);
+    errno_t err = FormatAppendTo(str, format, args, argsAgain);
+    va_end(argsAgain);
+    va_end(args);
+    return err;
+}
+
+errno_t SafeStrings::FormatAppend(std::string & str, const char * format, ...)
+{
+    va_list args, argsAgain;
+    va_start(args, format);
+    va_start(argsAgain, format);
+    errno_t err = FormatAppendTo(str, format, args, argsAgain);
+    va_end(argsAgain);
+    va_end(args);
+    return err;
+}
@@ -0,0 +1,211 @@
+//--------------------------------------------------------------------------------
+// FormatPlan.cpp - Compiled formats and the per-thread plan cache
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "FormatPlan.h"
+#include "FormatEngine.h"
+
+#include <memory>
+#include <stdint.h>
+
+using SafeStrings::FormatPlan;
+using namespace SafeStrings::Internal;
+
+namespace
+{
+    // CompiledFormat
+    //
+    // What formatting needs from a plan, held by value in the cache so that
+    // a hit goes straight from the set to the steps.
+
+    struct CompiledFormat
+    {
+        const FormatStep * pSteps;
+        const char *       pLiterals;
+    };
+
+    // PlanCache
+    //
+    // 512 plans in 128 sets of 4, indexed by a multiplicative hash of the
+    // format's address.  A few hundred hot formats fit without evicting each
+    // other; beyond that, each set replaces its entries in turn.  Every
+    // thread has its own, so a hit takes no lock and touches no shared line.
+
+    class PlanCache
+    {
+    public:
+
+        CompiledFormat Lookup(const char * format)
+        {
+            Set & set = _rgSets[Hash(format)];
+            for (size_t i = 0; i < c_cWays; i++)
+            {
+                if (SAFE_LIKELY(set.rgpszFormat[i] == format))
+                    return set.rgCompiled[i];
+            }
+            return Insert(set, format);
+        }
+
+        void Clear()
+        {
+            for (Set & set : _rgSets)
+                set = Set();
+        }
+
+    private:
+
+        static constexpr size_t c_cWays    = 4;
+        static constexpr size_t c_cSetBits = 7;
+
+        struct Set
+        {
+            const char *                rgpszFormat[c_cWays] = { };
+            CompiledFormat              rgCompiled[c_cWays]  = { };
+            std::unique_ptr<FormatPlan> rgpPlan[c_cWays];
+            size_t                      iNext = 0;
+        };
+
+        static size_t Hash(const char * format)
+        {
+            return (size_t) (((uintptr_t) format * 0x9E3779B97F4A7C15ull) >> (64 - c_cSetBits));
+        }
+
+        // A miss compiles the plan, which is the slow part anyway
+
+        [[gnu::noinline]]
+        CompiledFormat Insert(Set & set, const char * format)
+        {
+            size_t i = set.iNext;
+            set.iNext = (i + 1) % c_cWays;
+
+            set.rgpPlan[i]     = std::make_unique<FormatPlan>(format);
+            set.rgCompiled[i]  = { set.rgpPlan[i]->Steps(), set.rgpPlan[i]->Literals() };
+            set.rgpszFormat[i] = format;
+            return set.rgCompiled[i];
+        }
+
+        Set _rgSets[size_t(1) << c_cSetBits];
+    };
+
+    thread_local PlanCache t_planCache;
+
+    // FormatCompiled
+    //
+    // FastFormat's count handling around a compiled format, once the
+    // caller has checked the buffer and the format.
+
+    inline int FormatCompiled(CompiledFormat compiled, char * buffer, size_t sizeOfBuffer, size_t count,
+                              va_list & args, const wchar_t * function)
+    {
+        bool   fTruncate = (count == _TRUNCATE || count < sizeOfBuffer);
+        size_t cbLimit   = (count < sizeOfBuffer) ? count + 1 : sizeOfBuffer;
+
+        OutputBuffer out(buffer, cbLimit);
+        EmitStatus   status = EmitSteps(out, compiled.pSteps, compiled.pLiterals, args);
+        return FinishFormat(out, buffer, fTruncate, status, function);
+    }
+}
+
+SafeStrings::FormatPlan::FormatPlan(const char * format)
+    : _fNullFormat(format == nullptr), _strFormat(format ? format : "")
+{
+    CompileSteps(_strFormat.c_str(), _steps, _strLiterals);
+}
+
+SafeStrings::FormatPlan::~FormatPlan() = default;
+
+const FormatStep * SafeStrings::FormatPlan::Steps() const
+{
+    return _steps.data();
+}
+
+int SafeStrings::FormatPlan::FormatTo(char * buffer, size_t sizeOfBuffer, size_t count, va_list & args) const
+{
+    if (count == 0 && buffer == nullptr && sizeOfBuffer == 0)
+        return 0;
+
+    SAFE_VALIDATE_STRING(buffer, sizeOfBuffer, "FormatPlan", -1);
+
+    if (SAFE_UNLIKELY(_fNullFormat))
+    {
+        buffer[0] = '\0';
+        SAFE_RAISE(EINVAL, "format != nullptr", "FormatPlan");
+        return -1;
+    }
+
+    return FormatCompiled({ Steps(), Literals() }, buffer, sizeOfBuffer, count, args, L"FormatPlan");
+}
+
+int SafeStrings::FormatPlan::VFormat(char * buffer, size_t sizeOfBuffer, size_t count, va_list argptr) const
+{
+    va_list args;
+    va_copy(args, argptr);
+    int result = FormatTo(buffer, sizeOfBuffer, count, args);
+    va_end(args);
+    return result;
+}
+
+int SafeStrings::FormatPlan::Format(char * buffer, size_t sizeOfBuffer, size_t count, ...) const
+{
+    va_list args;
+    va_start(args, count);
+    int result = FormatTo(buffer, sizeOfBuffer, count, args);
+    va_end(args);
+    return result;
+}
+
+// VFormatCached / FormatCached
+//
+// The checks are made before the lookup, so that a null format is reported
+// like it is everywhere else instead of being cached.
+
+int SafeStrings::VFormatCached(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list argptr)
+{
+    if (count == 0 && buffer == nullptr && sizeOfBuffer == 0)
+        return 0;
+
+    SAFE_VALIDATE_STRING(buffer, sizeOfBuffer, "VFormatCached", -1);
+
+    if (SAFE_UNLIKELY(format == nullptr))
+    {
+        buffer[0] = '\0';
+        SAFE_RAISE(EINVAL, "format != nullptr", "VFormatCached");
+        return -1;
+    }
+
+    va_list args;
+    va_copy(args, argptr);
+    int result = FormatCompiled(t_planCache.Lookup(format), buffer, sizeOfBuffer, count, args, L"VFormatCached");
+    va_end(args);
+    return result;
+}
+
+int SafeStrings::FormatCached(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...)
+{
+    if (count == 0 && buffer == nullptr && sizeOfBuffer == 0)
+        return 0;
+
+    SAFE_VALIDATE_STRING(buffer, sizeOfBuffer, "FormatCached", -1);
+
+    if (SAFE_UNLIKELY(format == nullptr))
+    {
+        buffer[0] = '\0';
+        SAFE_RAISE(EINVAL, "format != nullptr", "FormatCached");
+        return -1;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int result = FormatCompiled(t_planCache.Lookup(format), buffer, sizeOfBuffer, count, args, L"FormatCached");
+    va_end(args);
+    return result;
+}
+
+void SafeStrings::ClearFormatPlanCache()
+{
+    t_planCache.Clear();
+}
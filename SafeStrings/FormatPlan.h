@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------------
+// FormatPlan.h - Formats parsed once and reused, with a per-thread plan cache
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// CheckedFormat settles a literal format at compile time, but a format that
+// only exists at runtime - one looked up in a table of message templates, or
+// forwarded through a va_list as TestVarArgs does - is parsed again by
+// vsnprintf_s on every call.  A FormatPlan parses it once, into runs of
+// literal text and the conversions between them, and formats from that:
+//
+//    static const SafeStrings::FormatPlan plan(g_rgszTemplates[iMessage]);
+//    plan.Format(szBuffer, _TRUNCATE, pszUser, cbSent);
+//
+// When there are too many formats to hold a plan for each, VFormatCached
+// and FormatCached look the plan up by the format's address in a bounded
+// cache belonging to the calling thread, compiling it on a miss:
+//
+//    void LogMessage(const char * format, ...)
+//    {
+//        ...
+//        SafeStrings::VFormatCached(szBuffer, sizeof szBuffer, _TRUNCATE, format, args);
+//    }
+//
+// The cache never reads the format again once it holds a plan for that
+// address, so it is only for formats whose text doesn't change while the
+// thread uses them: literals, and tables that aren't rewritten.  Anything
+// built at runtime in a reused buffer belongs in a FormatPlan of its own,
+// or in FastFormat.
+//
+// Formatting follows FastFormat in every respect - count and _TRUNCATE,
+// the conversions it handles itself, and the violations it raises, which
+// for a format that was bad all along are raised on each call that uses it.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <string>
+#include <vector>
+
+namespace SafeStrings
+{
+    namespace Internal
+    {
+        struct FormatStep;
+    }
+
+    class FormatPlan
+    {
+    public:
+
+        explicit FormatPlan(const char * format);
+        ~FormatPlan();
+
+        // The steps point into the plan's own copy of the format
+
+        FormatPlan(const FormatPlan &)             = delete;
+        FormatPlan & operator=(const FormatPlan &) = delete;
+
+        int VFormat(char * buffer, size_t sizeOfBuffer, size_t count, va_list argptr) const;
+        int Format(char * buffer, size_t sizeOfBuffer, size_t count, ...) const;
+
+        template <size_t size, typename... Args>
+        int Format(char (&buffer)[size], size_t count, Args... args) const
+        {
+            return Format(buffer, size, count, args...);
+        }
+
+        // For the plan cache, which formats from these directly
+
+        const Internal::FormatStep * Steps()    const;
+        const char *                 Literals() const { return _strLiterals.data(); }
+
+    private:
+
+        int FormatTo(char * buffer, size_t sizeOfBuffer, size_t count, va_list & args) const;
+
+        bool                              _fNullFormat;
+        std::string                       _strFormat;
+        std::string                       _strLiterals;
+        std::vector<Internal::FormatStep> _steps;
+    };
+
+    int VFormatCached(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list argptr);
+
+    __attribute__((format(printf, 4, 5)))
+    int FormatCached(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...);
+
+    template <size_t size, typename... Args>
+    inline int FormatCached(char (&buffer)[size], size_t count, const char * format, Args... args)
+    {
+        return FormatCached(buffer, size, count, format, args...);
+    }
+
+    // ClearFormatPlanCache
+    //
+    // Drops every plan cached by the calling thread, for a thread that is
+    // about to rewrite formats it has used.
+
+    void ClearFormatPlanCache();
+}
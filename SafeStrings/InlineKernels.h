@@ -0,0 +1,250 @@
+//--------------------------------------------------------------------------------
+// InlineKernels.h - Copy and length loops compiled into the caller
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Not part of the public interface; SafeStrings.h includes it for the array
+// forms of the cheat-sheet functions, and Policy.h uses it too.  These are
+// small enough to inline where the library's kernels are a call through the
+// dispatch table, and they follow the same rule: vector loads are aligned,
+// so a load never crosses a page, and a load is only issued if one of its
+// bytes lies inside the caller's bound.
+//
+// FixedCopy and FixedLength take the bound as a template argument.  Up to
+// 64 bytes the block loop has a known trip count and is unrolled away, so
+// copying into a char[16] is two block tests and a couple of moves; past
+// that they hand over to the dispatched kernels, which are faster on long
+// strings.
+//
+// The bytes a block load reads past the terminator, or before src, are
+// never used, but AddressSanitizer can't know that and reports them, so
+// its builds use CopyBounded and strnlen_s instead.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// gcc says it's building for AddressSanitizer one way and clang another
+
+#if defined(__SANITIZE_ADDRESS__)
+#define SAFESTRINGS_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SAFESTRINGS_ASAN 1
+#endif
+#endif
+
+#if defined(__SSE2__) && !defined(SAFESTRINGS_ASAN)
+#define SAFESTRINGS_BLOCK_LOADS 1
+#include <emmintrin.h>
+#endif
+
+namespace SafeStrings::Internal
+{
+    // CopyTail
+    //
+    // 1 to 16 bytes with at most two overlapping moves.
+    //
+    // cb comes from a terminator's position in a vector mask, which the
+    // compiler can't bound.  Inlined with src a short literal, it sees the
+    // wider moves as reading past the literal and warns, though those
+    // branches only run when the terminator is further in.  The warning is
+    // off here so that callers' own -Warray-bounds stays meaningful.
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+#endif
+
+    inline __attribute__((always_inline)) void CopyTail(char * dest, const char * src, size_t cb)
+    {
+        if (cb >= 8)
+        {
+            memcpy(dest, src, 8);
+            memcpy(dest + cb - 8, src + cb - 8, 8);
+        }
+        else if (cb >= 4)
+        {
+            memcpy(dest, src, 4);
+            memcpy(dest + cb - 4, src + cb - 4, 4);
+        }
+        else if (cb >= 2)
+        {
+            memcpy(dest, src, 2);
+            memcpy(dest + cb - 2, src + cb - 2, 2);
+        }
+        else
+        {
+            *dest = *src;
+        }
+    }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#if defined(SAFESTRINGS_BLOCK_LOADS)
+
+    // AlignedBlock
+    //
+    // The aligned block holding p.  A block load can start before the
+    // caller's buffer and be wider than it, which once inlined lets the
+    // compiler decide the load can't touch the buffer and move the caller's
+    // last stores to it past the load.  The empty asm hides where the
+    // address came from, and its memory clobber keeps those stores ahead.
+
+    inline __attribute__((always_inline)) const char * AlignedBlock(const char * p)
+    {
+        const char * pBlock = p - ((uintptr_t) p & 15);
+        asm("" : "+r"(pBlock) : : "memory");
+        return pBlock;
+    }
+
+    inline __attribute__((always_inline)) unsigned ZeroMask16(const char * pBlock)
+    {
+        __m128i v = _mm_load_si128((const __m128i *) pBlock);
+        return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+    }
+
+    // CopyBlocks
+    //
+    // The body of InlineCopy and FixedCopy.  cBlocksMax bounds the aligned
+    // blocks after the first one; when it and destsz are constants the
+    // compiler unrolls the loop completely.
+
+    template <size_t cBlocksMax>
+    inline __attribute__((always_inline)) size_t CopyBlocks(char * dest, const char * src, size_t destsz)
+    {
+        uintptr_t    offset = (uintptr_t) src & 15;
+        const char * pBlock = AlignedBlock(src);
+        size_t       cch    = 16 - offset;      // Bytes of src in the first block
+
+        unsigned mask = ZeroMask16(pBlock) >> offset;
+        if (mask)
+        {
+            size_t idx = __builtin_ctz(mask);
+            if (idx >= destsz)
+                return destsz;
+            CopyTail(dest, src, idx + 1);
+            return idx;
+        }
+
+        if (cch >= destsz)
+            return destsz;
+        CopyTail(dest, src, cch);
+
+        for (size_t iBlock = 0; iBlock < cBlocksMax; iBlock++)
+        {
+            pBlock += 16;
+            __m128i v = _mm_load_si128((const __m128i *) pBlock);
+            mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+            if (mask)
+            {
+                size_t idx = __builtin_ctz(mask);
+                if (cch + idx >= destsz)
+                    return destsz;
+                CopyTail(dest + cch, pBlock, idx + 1);
+                return cch + idx;
+            }
+
+            // No terminator, so src needs at least cch + 17 bytes
+
+            if (cch + 16 >= destsz)
+                return destsz;
+            _mm_storeu_si128((__m128i *)(dest + cch), v);
+            cch += 16;
+        }
+
+        return destsz;
+    }
+
+#endif
+
+    // InlineCopy
+    //
+    // The contract of CopyBounded (the length of src if it fit, else destsz
+    // with an unspecified prefix in dest), compiled into the caller.
+    // Strings here are usually short enough that one or two blocks hold
+    // them.
+
+    inline size_t InlineCopy(char * dest, const char * src, size_t destsz)
+    {
+#if defined(SAFESTRINGS_BLOCK_LOADS)
+        return CopyBlocks<SIZE_MAX>(dest, src, destsz);
+#else
+        return CopyBounded(dest, destsz, src);
+#endif
+    }
+
+    // InlineLength
+    //
+    // strnlen_s for a non-null pointer and a non-zero bound.
+
+    inline size_t InlineLength(const char * str, size_t cchMax)
+    {
+#if defined(SAFESTRINGS_BLOCK_LOADS)
+        uintptr_t    offset = (uintptr_t) str & 15;
+        const char * pBlock = AlignedBlock(str);
+
+        unsigned mask = ZeroMask16(pBlock) >> offset;
+        if (mask)
+        {
+            size_t idx = __builtin_ctz(mask);
+            return idx < cchMax ? idx : cchMax;
+        }
+
+        for (size_t cch = 16 - offset; cch < cchMax; cch += 16)
+        {
+            pBlock += 16;
+            mask    = ZeroMask16(pBlock);
+            if (mask)
+            {
+                size_t idx = cch + __builtin_ctz(mask);
+                return idx < cchMax ? idx : cchMax;
+            }
+        }
+
+        return cchMax;
+#else
+        return strnlen_s(str, cchMax);
+#endif
+    }
+
+    // FixedCopy
+    //
+    // InlineCopy into a buffer of N bytes.  The first block holds at least
+    // one byte of src, so the other N - 1 take at most (N + 14) / 16 more.
+
+    template <size_t N>
+    inline size_t FixedCopy(char * dest, const char * src)
+    {
+        static_assert(N > 0, "FixedCopy needs room for the terminator");
+
+#if defined(SAFESTRINGS_BLOCK_LOADS)
+        if constexpr (N <= 64)
+            return CopyBlocks<(N + 14) / 16>(dest, src, N);
+        else
+#endif
+            return CopyBounded(dest, N, src);
+    }
+
+    // FixedLength
+    //
+    // strnlen_s of an N byte buffer.
+
+    template <size_t N>
+    inline size_t FixedLength(const char * str)
+    {
+        static_assert(N > 0, "FixedLength needs a non-empty buffer");
+
+        if constexpr (N <= 64)
+            return InlineLength(str, N);
+        else
+            return strnlen_s(str, N);
+    }
+}
@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------------
+// InputFunctions.cpp - gets_s
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// gets_s
+//
+// Reads one line from stdin into buffer, dropping the newline.  Returns
+// buffer, or nullptr at end of file.  A line that won't fit in
+// sizeInCharacters - 1 characters is read and discarded in full, the buffer
+// is emptied, and the handler is called with ERANGE.
+
+extern "C" char * gets_s(char * buffer, rsize_t sizeInCharacters)
+{
+    SAFE_VALIDATE_STRING(buffer, sizeInCharacters, "gets_s", nullptr);
+
+    flockfile(stdin);
+
+    // fgets does the bulk copying with glibc's vectorized memchr; all we have
+    // to work out afterwards is whether the line really ended.
+
+    if (fgets_unlocked(buffer, (int)(sizeInCharacters < INT32_MAX ? sizeInCharacters : INT32_MAX), stdin) == nullptr)
+    {
+        funlockfile(stdin);
+        buffer[0] = '\0';
+        return nullptr;
+    }
+
+    size_t cch = strlen(buffer);
+    if (cch > 0 && buffer[cch - 1] == '\n')
+    {
+        buffer[cch - 1] = '\0';
+        funlockfile(stdin);
+        return buffer;
+    }
+
+    // Filled the buffer without seeing a newline.  That's fine if the line
+    // ends right here; otherwise swallow the rest of it and fail.
+
+    int ch = getc_unlocked(stdin);
+    if (ch == '\n' || ch == EOF)
+    {
+        funlockfile(stdin);
+        return (ch == EOF && cch == 0) ? nullptr : buffer;
+    }
+
+    while (ch != '\n' && ch != EOF)
+        ch = getc_unlocked(stdin);
+
+    funlockfile(stdin);
+
+    buffer[0] = '\0';
+    SAFE_RAISE(ERANGE, "Buffer is too small", "gets_s");
+    return nullptr;
+}
@@ -0,0 +1,144 @@
+//--------------------------------------------------------------------------------
+// LineReader.cpp - LineReader
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "LineReader.h"
+
+#include <algorithm>
+#include <string.h>
+
+SafeStrings::LineReader::LineReader(FILE * file, size_t cchMaxLine, LongLinePolicy policy, size_t cbBuffer)
+    : _file(file),
+      _cchMaxLine(cchMaxLine),
+      _policy(policy),
+      _cbBuffer(std::max(cbBuffer, cchMaxLine + 1))
+{
+    if (SAFE_UNLIKELY(file == nullptr))
+    {
+        _fEof = true;
+        _err  = EINVAL;
+        _cbBuffer = 0;
+        SAFE_RAISE(EINVAL, "file != nullptr", "LineReader");
+        return;
+    }
+
+    _pBuffer.reset(new char[_cbBuffer]);
+}
+
+// Refill
+//
+// Slides the unfinished line to the front of the buffer and reads as much
+// as fits behind it.  The line is never longer than cchMaxLine, so the move
+// is short and there is always room for more.
+
+bool SafeStrings::LineReader::Refill()
+{
+    if (_fEof)
+        return false;
+
+    if (_ibStart != 0)
+    {
+        memmove(_pBuffer.get(), _pBuffer.get() + _ibStart, _ibEnd - _ibStart);
+        _ibScan -= _ibStart;
+        _ibEnd  -= _ibStart;
+        _ibStart = 0;
+    }
+
+    size_t cbRead = fread_unlocked(_pBuffer.get() + _ibEnd, 1, _cbBuffer - _ibEnd, _file);
+    if (cbRead == 0)
+    {
+        _fEof = true;
+        if (ferror_unlocked(_file))
+            _err = errno ? errno : EIO;
+        return false;
+    }
+
+    _ibEnd += cbRead;
+    return true;
+}
+
+bool SafeStrings::LineReader::ReadLine(std::string_view & line)
+{
+    // Also covers a reader that never got a file, and so has no buffer
+
+    if (Eof())
+        return false;
+
+    char * pBuffer = _pBuffer.get();
+
+    for (;;)
+    {
+        const char * pNewline = (const char *) memchr(pBuffer + _ibScan, '\n', _ibEnd - _ibScan);
+        size_t       ibLineEnd;
+
+        if (pNewline != nullptr)
+        {
+            ibLineEnd = pNewline - pBuffer;
+        }
+        else if (_ibEnd - _ibStart > _cchMaxLine || (_fDiscarding && _ibEnd != _ibStart))
+        {
+            // Too long already, and no end in sight: nothing more of this
+            // line needs keeping
+
+            ibLineEnd = _ibEnd;
+        }
+        else
+        {
+            _ibScan = _ibEnd;
+            if (Refill())
+            {
+                pBuffer = _pBuffer.get();
+                continue;
+            }
+
+            // End of file.  A last line without a newline is still a line.
+
+            if (_ibStart == _ibEnd)
+                return false;
+            ibLineEnd = _ibEnd;
+        }
+
+        size_t ibStart = _ibStart;
+        size_t cch     = ibLineEnd - ibStart;
+        bool   fEnded  = (pNewline != nullptr) || _fEof;
+
+        // Past the newline, or past everything read so far for a line that
+        // goes on
+
+        _ibStart = _ibScan = (pNewline != nullptr) ? ibLineEnd + 1 : ibLineEnd;
+
+        if (_fDiscarding)
+        {
+            _fDiscarding = !fEnded;
+            continue;
+        }
+
+        if (SAFE_UNLIKELY(cch > _cchMaxLine))
+        {
+            _fDiscarding = !fEnded;
+
+            switch (_policy)
+            {
+                case LongLinePolicy::Truncate:
+                    line = std::string_view(pBuffer + ibStart, _cchMaxLine);
+                    return true;
+
+                case LongLinePolicy::Skip:
+                    continue;
+
+                case LongLinePolicy::Raise:
+                    line = std::string_view();
+                    SAFE_RAISE(ERANGE, "Buffer is too small", "LineReader::ReadLine");
+                    return false;
+            }
+        }
+
+        line = std::string_view(pBuffer + ibStart, cch);
+        return true;
+    }
+}
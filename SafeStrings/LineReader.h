@@ -0,0 +1,95 @@
+//--------------------------------------------------------------------------------
+// LineReader.h - Bounded line reading without gets_s
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// gets_s copies every line out of stdio's small buffer into the caller's,
+// and looking for the end of a line that turns out to be too long takes
+// one getc at a time.  LineReader reads its input in large blocks into one
+// buffer of its own, finds newlines with the library's vectorized memchr,
+// and hands back each line as a view into that buffer:
+//
+//    SafeStrings::LineReader reader(stdin);
+//    std::string_view line;
+//    while (reader.ReadLine(line))
+//        ...
+//
+// A line is valid until the next ReadLine.  As with gets_s the newline is
+// dropped, and a last line with no newline still counts.
+//
+// A line longer than cchMaxLine is handled as the policy says:
+//
+//    Truncate   its first cchMaxLine characters are returned
+//    Skip       it is dropped without a word, and the next line returned
+//    Raise      what gets_s does: it is dropped, the handler is called
+//               with ERANGE, and ReadLine returns false.  If the handler
+//               returns, reading carries on with the next line.
+//
+// Either way the rest of the line is never buffered, so memory stays at
+// the buffer size however long the line is.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <memory>
+#include <stdio.h>
+#include <string_view>
+
+namespace SafeStrings
+{
+    enum class LongLinePolicy
+    {
+        Truncate,
+        Skip,
+        Raise,
+    };
+
+    class LineReader
+    {
+    public:
+
+        // Reads from file, which must stay open for the reader's lifetime.
+        // The buffer is made at least cchMaxLine + 1 bytes so that any line
+        // of the allowed length fits.  A null file is reported through the
+        // handler and leaves a reader at end of file.
+
+        explicit LineReader(FILE *         file       = stdin,
+                            size_t         cchMaxLine = 4096,
+                            LongLinePolicy policy     = LongLinePolicy::Raise,
+                            size_t         cbBuffer   = 1 << 20);
+
+        LineReader(const LineReader &) = delete;
+        LineReader & operator=(const LineReader &) = delete;
+
+        // ReadLine
+        //
+        // Points line at the next line and returns true, or returns false
+        // at end of file, on a read error, or for a line the Raise policy
+        // rejected.
+
+        bool ReadLine(std::string_view & line);
+
+        bool    Eof()   const { return _fEof && _ibStart == _ibEnd; }
+        errno_t Error() const { return _err; }
+
+    private:
+
+        bool Refill();
+
+        FILE *                  _file;
+        size_t                  _cchMaxLine;
+        LongLinePolicy          _policy;
+        std::unique_ptr<char[]> _pBuffer;
+        size_t                  _cbBuffer;
+        size_t                  _ibStart     = 0;       // Start of the next line
+        size_t                  _ibScan      = 0;       // Searched for a newline up to here
+        size_t                  _ibEnd       = 0;       // End of the data read
+        bool                    _fEof        = false;   // The file has nothing more
+        bool                    _fDiscarding = false;   // Dropping the rest of a long line
+        errno_t                 _err         = 0;       // The read error, or EINVAL for a null file
+    };
+}
@@ -0,0 +1,160 @@
+//--------------------------------------------------------------------------------
+// MappedFile.cpp - MappedFile, LineCursor, SplitFields
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SafeStrings::MappedFile::MappedFile(const char * pszPath, MapOptions options)
+{
+    if (SAFE_UNLIKELY(pszPath == nullptr))
+    {
+        _err = EINVAL;
+        SAFE_RAISE(EINVAL, "pszPath != nullptr", "MappedFile");
+        return;
+    }
+
+    // O_NONBLOCK so that a FIFO with no writer is turned away below rather
+    // than waited on here; it means nothing for a regular file
+
+    int fd = open(pszPath, O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0)
+    {
+        _err = errno;
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        _err = errno;
+        close(fd);
+        return;
+    }
+
+    // A pipe or a device has no size to map by, and would otherwise look
+    // like an empty file that opened fine.  procfs and sysfs files pass for
+    // regular files but report a size of 0 whatever they hold, so an empty
+    // file only counts as one if there is really nothing to read.
+
+    char ch;
+    if (!S_ISREG(st.st_mode) || (st.st_size == 0 && read(fd, &ch, 1) != 0))
+    {
+        _err = ENODEV;
+        close(fd);
+        return;
+    }
+
+    // mmap refuses a length of zero; an empty file is just an empty view
+
+    if (st.st_size > 0)
+    {
+        void * p = mmap(nullptr, (size_t) st.st_size, PROT_READ,
+                        MAP_PRIVATE | (options.fPopulate ? MAP_POPULATE : 0), fd, 0);
+        if (p == MAP_FAILED)
+        {
+            _err = errno;
+        }
+        else
+        {
+            _pData  = (const char *) p;
+            _cbData = (size_t) st.st_size;
+
+            // Only hints; a kernel without them still maps the file
+
+            if (options.fSequential)
+                madvise(p, _cbData, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+            if (options.fHugePages)
+                madvise(p, _cbData, MADV_HUGEPAGE);
+#endif
+        }
+    }
+
+    close(fd);
+}
+
+SafeStrings::MappedFile::~MappedFile()
+{
+    if (_pData != nullptr)
+        munmap((void *) _pData, _cbData);
+}
+
+// ReadLine
+//
+// With the whole text in memory a long line is known to be long the moment
+// its newline is found, so unlike LineReader there is nothing to stream
+// past.
+
+bool SafeStrings::LineCursor::ReadLine(std::string_view & line)
+{
+    while (_p < _pEnd)
+    {
+        const char * pStart   = _p;
+        const char * pNewline = (const char *) memchr(_p, '\n', _pEnd - _p);
+        const char * pLineEnd = pNewline ? pNewline : _pEnd;
+        _p = pNewline ? pNewline + 1 : _pEnd;
+
+        size_t cch = pLineEnd - pStart;
+        if (SAFE_UNLIKELY(cch > _cchMaxLine))
+        {
+            switch (_policy)
+            {
+                case LongLinePolicy::Truncate:
+                    line = std::string_view(pStart, _cchMaxLine);
+                    return true;
+
+                case LongLinePolicy::Skip:
+                    continue;
+
+                case LongLinePolicy::Raise:
+                    line = std::string_view();
+                    SAFE_RAISE(ERANGE, "Buffer is too small", "LineCursor::ReadLine");
+                    return false;
+            }
+        }
+
+        line = std::string_view(pStart, cch);
+        return true;
+    }
+
+    return false;
+}
+
+size_t SafeStrings::SplitFields(std::string_view line, char chDelimiter, std::string_view * rgFields, size_t cFieldsMax)
+{
+    if (SAFE_UNLIKELY(rgFields == nullptr && cFieldsMax != 0))
+    {
+        SAFE_RAISE(EINVAL, "rgFields != nullptr", "SplitFields");
+        return 0;
+    }
+
+    if (cFieldsMax == 0)
+        return 0;
+
+    const char * p    = line.data();
+    const char * pEnd = p + line.size();
+    size_t       cFields = 0;
+
+    while (cFields + 1 < cFieldsMax)
+    {
+        const char * pDelimiter = (const char *) memchr(p, chDelimiter, pEnd - p);
+        if (pDelimiter == nullptr)
+            break;
+        rgFields[cFields++] = std::string_view(p, pDelimiter - p);
+        p = pDelimiter + 1;
+    }
+
+    rgFields[cFields++] = std::string_view(p, pEnd - p);
+    return cFields;
+}
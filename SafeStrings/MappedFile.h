@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------------
+// MappedFile.h - Lines and fields of a file read through a memory mapping
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Even LineReader copies every byte twice: from the page cache into its
+// buffer with read(), then out again by whoever uses the line.  For a file
+// on disk MappedFile maps the whole thing read-only instead, and LineCursor
+// walks it a line at a time with each line a view into the mapping - no
+// system calls after the first, and no copies at all:
+//
+//    SafeStrings::MappedFile file("access.log");
+//    SafeStrings::LineCursor lines(file.View());
+//    std::string_view line;
+//    while (lines.ReadLine(line))
+//    {
+//        std::string_view rgFields[8];
+//        size_t cFields = SafeStrings::Tokenize(line.data(), line.size(), rgFields);
+//        ...
+//    }
+//
+// LineCursor has LineReader's rules: the newline is dropped, a last line
+// without one still counts, and lines longer than cchMaxLine are
+// truncated, skipped or raised on as the policy says.  SplitFields is the
+// counterpart of Tokenize for fields separated by a single character, as
+// in tab- or comma-separated files, where empty fields count.
+//
+// The mapping is advised as sequential, so the kernel reads ahead
+// aggressively and drops pages behind the reader.  MapOptions can also ask
+// for transparent huge pages, which cuts TLB misses on a large file when
+// the kernel and filesystem support them for the page cache (and is
+// otherwise ignored), or for the whole file to be read in up front.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "LineReader.h"
+#include "SafeStrings.h"
+
+#include <string_view>
+
+namespace SafeStrings
+{
+    struct MapOptions
+    {
+        bool fSequential = true;        // MADV_SEQUENTIAL
+        bool fHugePages  = false;       // MADV_HUGEPAGE
+        bool fPopulate   = false;       // MAP_POPULATE: read the whole file now
+    };
+
+    class MappedFile
+    {
+    public:
+
+        // Maps the file at pszPath.  A null path is reported through the
+        // handler; a file that can't be opened or mapped just leaves the
+        // view empty, with the reason in Error().  Only regular files can
+        // be mapped: anything else - a pipe, a device, /dev/stdin or a
+        // procfs file - fails with ENODEV, and belongs in a LineReader.
+
+        explicit MappedFile(const char * pszPath, MapOptions options = MapOptions());
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator=(const MappedFile &) = delete;
+
+        std::string_view View()   const { return std::string_view(_pData, _cbData); }
+        bool             IsOpen() const { return _err == 0; }
+        errno_t          Error()  const { return _err; }
+
+    private:
+
+        const char * _pData  = nullptr;
+        size_t       _cbData = 0;
+        errno_t      _err    = 0;
+    };
+
+    class LineCursor
+    {
+    public:
+
+        explicit LineCursor(std::string_view text,
+                            size_t           cchMaxLine = 4096,
+                            LongLinePolicy   policy     = LongLinePolicy::Raise)
+            : _p(text.data()), _pEnd(text.data() + text.size()), _cchMaxLine(cchMaxLine), _policy(policy)
+        {
+        }
+
+        // ReadLine
+        //
+        // Points line at the next line and returns true, or returns false
+        // at the end of the text or for a line the Raise policy rejected.
+
+        bool ReadLine(std::string_view & line);
+
+        bool Eof() const { return _p == _pEnd; }
+
+    private:
+
+        const char *   _p;
+        const char *   _pEnd;
+        size_t         _cchMaxLine;
+        LongLinePolicy _policy;
+    };
+
+    // SplitFields
+    //
+    // Splits line at each chDelimiter into up to cFieldsMax views and
+    // returns how many it stored.  The last one stored takes whatever is
+    // left of the line, delimiters and all, so nothing is lost when there
+    // are more fields than room.
+
+    size_t SplitFields(std::string_view line, char chDelimiter, std::string_view * rgFields, size_t cFieldsMax);
+
+    template <size_t N>
+    size_t SplitFields(std::string_view line, char chDelimiter, std::string_view (&rgFields)[N])
+    {
+        return SplitFields(line, chDelimiter, rgFields, N);
+    }
+}
@@ -0,0 +1,350 @@
+//--------------------------------------------------------------------------------
+// NumberParse.cpp - ParseNumber
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "NumberParse.h"
+
+#include <charconv>
+#include <limits>
+#include <type_traits>
+
+using namespace SafeStrings::Internal;
+
+namespace
+{
+    inline bool IsDigit(char ch)
+    {
+        return (unsigned)(ch - '0') <= 9;
+    }
+
+    errno_t InputViolation(size_t * pcchUsed)
+    {
+        if (pcchUsed != nullptr)
+            *pcchUsed = 0;
+        return SAFE_RAISE(EINVAL, "input != nullptr", "ParseNumber");
+    }
+
+    errno_t NoNumber(size_t * pcchUsed)
+    {
+        if (pcchUsed != nullptr)
+            *pcchUsed = 0;
+        return EINVAL;
+    }
+
+    errno_t RangeViolation()
+    {
+        return SAFE_RAISE(ERANGE, "value within the range of its type", "ParseNumber");
+    }
+
+    // ParseInteger
+    //
+    // Leading zeros are skipped before counting, so only the significant
+    // digits decide overflow: up to 19 always fit in 64 bits, 20 might,
+    // and more never do.
+
+    template <typename T>
+    errno_t ParseInteger(const char * input, size_t length, T & value, size_t * pcchUsed)
+    {
+        if (SAFE_UNLIKELY(input == nullptr))
+            return InputViolation(pcchUsed);
+
+        const char * p         = input;
+        const char * pEnd      = input + length;
+        bool         fNegative = false;
+        if (p < pEnd && (*p == '-' || *p == '+'))
+            fNegative = (*p++ == '-');
+
+        const char * pDigits = p;
+        while (p < pEnd && *p == '0')
+            ++p;
+
+        const char * pSignificant = p;
+        uint64_t     magnitude    = 0;
+        size_t       cDigits      = ReadDigits(p, pEnd, magnitude);
+        if (p == pDigits)
+            return NoNumber(pcchUsed);
+
+        if (pcchUsed != nullptr)
+            *pcchUsed = p - input;
+
+        bool fOverflow = cDigits > 20;
+        if (cDigits == 20)
+        {
+            uint64_t     leading = 0;
+            const char * q       = pSignificant;
+            ReadDigits(q, pSignificant + 19, leading);
+            fOverflow = __builtin_mul_overflow(leading, 10, &magnitude) ||
+                        __builtin_add_overflow(magnitude, (uint64_t)(pSignificant[19] - '0'), &magnitude);
+        }
+
+        using Limits = std::numeric_limits<T>;
+        if constexpr (std::is_signed_v<T>)
+        {
+            uint64_t limit = fNegative ? (uint64_t) Limits::max() + 1 : (uint64_t) Limits::max();
+            if (SAFE_UNLIKELY(fOverflow || magnitude > limit))
+            {
+                value = fNegative ? Limits::min() : Limits::max();
+                return RangeViolation();
+            }
+            value = fNegative ? (T)(0 - magnitude) : (T) magnitude;
+        }
+        else
+        {
+            // Only zero can be negative
+
+            if (SAFE_UNLIKELY(fOverflow || magnitude > Limits::max() || (fNegative && magnitude != 0)))
+            {
+                value = fNegative ? 0 : Limits::max();
+                return RangeViolation();
+            }
+            value = (T) magnitude;
+        }
+        return 0;
+    }
+
+    // FloatTraits
+    //
+    // Clinger's fast path: when the digits fit in the significand and the
+    // power of ten is exact too, one correctly rounded multiply or divide
+    // gives the correctly rounded result.
+
+    template <typename T>
+    struct FloatTraits;
+
+    template <>
+    struct FloatTraits<float>
+    {
+        static constexpr uint64_t c_maxExactSignificand = 1ull << 24;
+        static constexpr int      c_maxExactPower       = 10;
+    };
+
+    template <>
+    struct FloatTraits<double>
+    {
+        static constexpr uint64_t c_maxExactSignificand = 1ull << 53;
+        static constexpr int      c_maxExactPower       = 22;
+    };
+
+    template <typename T>
+    constexpr T c_rgExactPowers[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    // IsOverflow
+    //
+    // from_chars reports overflow and underflow alike.  Which one it was
+    // follows from where the first significant digit of [p, pEnd) sits
+    // relative to the decimal point, moved by the exponent.
+
+    bool IsOverflow(const char * p, const char * pEnd)
+    {
+        long position = 0;
+        bool fLeading = true;
+
+        for (; p < pEnd && IsDigit(*p); ++p)
+        {
+            if (*p != '0' || !fLeading)
+            {
+                fLeading = false;
+                ++position;
+            }
+        }
+
+        if (p < pEnd && *p == '.')
+        {
+            for (++p; p < pEnd && IsDigit(*p); ++p)
+            {
+                if (fLeading && *p == '0')
+                    --position;
+                else
+                    fLeading = false;
+            }
+        }
+
+        long exponent = 0;
+        if (p < pEnd && (*p | 0x20) == 'e')
+        {
+            bool fNegative = (++p < pEnd && *p == '-');
+            if (p < pEnd && (*p == '-' || *p == '+'))
+                ++p;
+            for (; p < pEnd && IsDigit(*p); ++p)
+                exponent = exponent < 1000000 ? exponent * 10 + (*p - '0') : exponent;
+            if (fNegative)
+                exponent = -exponent;
+        }
+
+        return position + exponent > 0;
+    }
+
+    // SpecialTextEnd
+    //
+    // The end of the characters at p that could belong to "inf", "infinity"
+    // or "nan(...)", read one at a time so they stop at a terminator.
+
+    const char * SpecialTextEnd(const char * p, const char * pEnd)
+    {
+        for (; p < pEnd; ++p)
+        {
+            char ch = *p;
+            if (!IsDigit(ch) && (unsigned)((ch | 0x20) - 'a') > 25 && ch != '_' && ch != '(' && ch != ')')
+                break;
+        }
+        return p;
+    }
+
+    // ParseFloatSlow
+    //
+    // from_chars on [pNumber, pEnd), which must end at or before the first
+    // character that isn't part of the number: from_chars reads whole words
+    // at a time up to pEnd, and pEnd needn't be readable past a terminator.
+
+    template <typename T>
+    errno_t ParseFloatSlow(const char * input, const char * pNumber, const char * pEnd, bool fNegative,
+                           T & value, size_t * pcchUsed)
+    {
+        T result;
+        std::from_chars_result parsed = std::from_chars(pNumber, pEnd, result);
+        if (parsed.ptr == pNumber)
+            return NoNumber(pcchUsed);
+
+        if (pcchUsed != nullptr)
+            *pcchUsed = parsed.ptr - input;
+
+        if (parsed.ec == std::errc::result_out_of_range)
+        {
+            if (IsOverflow(pNumber, parsed.ptr))
+            {
+                value = fNegative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+                return RangeViolation();
+            }
+            result = 0;
+        }
+
+        value = fNegative ? -result : result;
+        return 0;
+    }
+
+    template <typename T>
+    errno_t ParseFloat(const char * input, size_t length, T & value, size_t * pcchUsed)
+    {
+        if (SAFE_UNLIKELY(input == nullptr))
+            return InputViolation(pcchUsed);
+
+        const char * p         = input;
+        const char * pEnd      = input + length;
+        bool         fNegative = false;
+        if (p < pEnd && (*p == '-' || *p == '+'))
+            fNegative = (*p++ == '-');
+
+        const char * pNumber     = p;
+        uint64_t     significand = 0;
+        size_t       cDigits     = ReadDigits(p, pEnd, significand);
+        size_t       cFraction   = 0;
+
+        if (p < pEnd && *p == '.')
+        {
+            const char * pFraction = p + 1;
+            cFraction = ReadDigits(pFraction, pEnd, significand);
+            if (cDigits + cFraction != 0)
+                p = pFraction;
+        }
+
+        // No digits: "inf", "nan", or nothing
+
+        if (cDigits + cFraction == 0)
+        {
+            if (p < pEnd && ((*p | 0x20) == 'i' || (*p | 0x20) == 'n'))
+                return ParseFloatSlow(input, pNumber, SpecialTextEnd(pNumber, pEnd), fNegative, value, pcchUsed);
+            return NoNumber(pcchUsed);
+        }
+
+        // The exponent only counts with a digit after its sign
+
+        int exponent = 0;
+        if (p < pEnd && (*p | 0x20) == 'e')
+        {
+            const char * q = p + 1;
+            bool fNegativeExponent = (q < pEnd && *q == '-');
+            if (q < pEnd && (*q == '-' || *q == '+'))
+                ++q;
+
+            if (q < pEnd && IsDigit(*q))
+            {
+                for (; q < pEnd && IsDigit(*q); ++q)
+                    exponent = exponent < 100000 ? exponent * 10 + (*q - '0') : exponent;
+                if (fNegativeExponent)
+                    exponent = -exponent;
+                p = q;
+            }
+        }
+
+        using Traits = FloatTraits<T>;
+        if (SAFE_LIKELY(cDigits + cFraction <= 19 &&
+                        significand <= Traits::c_maxExactSignificand &&
+                        exponent - (int) cFraction >= -Traits::c_maxExactPower &&
+                        exponent - (int) cFraction <= Traits::c_maxExactPower))
+        {
+            exponent -= (int) cFraction;
+
+            T result = (T) significand;
+            if (exponent < 0)
+                result /= c_rgExactPowers<T>[-exponent];
+            else
+                result *= c_rgExactPowers<T>[exponent];
+
+            value = fNegative ? -result : result;
+            if (pcchUsed != nullptr)
+                *pcchUsed = p - input;
+            return 0;
+        }
+
+        return ParseFloatSlow(input, pNumber, p, fNegative, value, pcchUsed);
+    }
+}
+
+errno_t SafeStrings::ParseNumber(const char * input, size_t length, int & value, size_t * pcchUsed)
+{
+    return ParseInteger(input, length, value, pcchUsed);
+}
+
+errno_t SafeStrings::ParseNumber(const char * input, size_t length, long & value, size_t * pcchUsed)
+{
+    return ParseInteger(input, length, value, pcchUsed);
+}
+
+errno_t SafeStrings::ParseNumber(const char * input, size_t length, long long & value, size_t * pcchUsed)
+{
+    return ParseInteger(input, length, value, pcchUsed);
+}
+
+errno_t SafeStrings::ParseNumber(const char * input, size_t length, unsigned int & value, size_t * pcchUsed)
+{
+    return ParseInteger(input, length, value, pcchUsed);
+}
+
+errno_t SafeStrings::ParseNumber(const char * input, size_t length, unsigned long & value, size_t * pcchUsed)
+{
+    return ParseInteger(input, length, value, pcchUsed);
+}
+
+errno_t SafeStrings::ParseNumber(const char * input, size_t length, unsigned long long & value, size_t * pcchUsed)
+{
+    return ParseInteger(input, length, value, pcchUsed);
+}
+
+errno_t SafeStrings::ParseNumber(const char * input, size_t length, float & value, size_t * pcchUsed)
+{
+    return ParseFloat(input, length, value, pcchUsed);
+}
+
+errno_t SafeStrings::ParseNumber(const char * input, size_t length, double & value, size_t * pcchUsed)
+{
+    return ParseFloat(input, length, value, pcchUsed);
+}
@@ -0,0 +1,137 @@
+//--------------------------------------------------------------------------------
+// NumberParse.h - Bounded number parsing without sscanf_s
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// The cheat sheet has no safe replacement for atoi and strtod on a buffer
+// that isn't terminated, so the usual answer is _snscanf_s(p, n, "%d"),
+// which is slow and depends on the locale.  ParseNumber reads one number
+// from the first length characters of input (fewer if a terminator comes
+// first, so length can be the size of the whole buffer the field sits in;
+// nothing past the terminator has to be readable) and reports how many
+// characters it used:
+//
+//    int    port;
+//    size_t cchUsed;
+//    if (SafeStrings::ParseNumber(pField, cchField, port, &cchUsed) == 0)
+//        ...
+//
+// The number starts at input - no whitespace is skipped - and is always
+// read in the "C" locale:
+//
+//    integers    an optional '+' or '-', then decimal digits
+//    floats      the same sign, digits with an optional '.' fraction and
+//                'e' exponent, or "inf", "infinity" and "nan"
+//
+// ParseNumber returns 0 on success.  If there is no number at input it
+// returns EINVAL and leaves value alone; that is a mismatch, not a
+// violation, so the handler isn't called.  A number that doesn't fit in
+// value is a violation: value is saturated (to the type's limits, or to an
+// infinity), *pcchUsed still covers the whole number, and the handler is
+// called with ERANGE.  A float too small to represent becomes zero without
+// complaint, as it would from a literal in source.  A null input calls the
+// handler with EINVAL.
+//
+// Digits are converted eight at a time with SWAR arithmetic on a 64-bit
+// word.  Floats whose digits and exponent are exactly representable take
+// Clinger's fast path, one multiply or divide; the rest go to from_chars,
+// which rounds correctly with Eisel-Lemire.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <stdint.h>
+#include <string.h>
+
+namespace SafeStrings
+{
+    errno_t ParseNumber(const char * input, size_t length, int                & value, size_t * pcchUsed = nullptr);
+    errno_t ParseNumber(const char * input, size_t length, long               & value, size_t * pcchUsed = nullptr);
+    errno_t ParseNumber(const char * input, size_t length, long long          & value, size_t * pcchUsed = nullptr);
+    errno_t ParseNumber(const char * input, size_t length, unsigned int       & value, size_t * pcchUsed = nullptr);
+    errno_t ParseNumber(const char * input, size_t length, unsigned long      & value, size_t * pcchUsed = nullptr);
+    errno_t ParseNumber(const char * input, size_t length, unsigned long long & value, size_t * pcchUsed = nullptr);
+    errno_t ParseNumber(const char * input, size_t length, float              & value, size_t * pcchUsed = nullptr);
+    errno_t ParseNumber(const char * input, size_t length, double             & value, size_t * pcchUsed = nullptr);
+
+    namespace Internal
+    {
+        // CountLeadingDigits
+        //
+        // The number of decimal digits at the start of the eight characters
+        // in word, loaded little-endian.  Each byte gets its high bit set
+        // unless it is '0' through '9'; a borrow or carry can only leak
+        // upward out of a byte that is flagged already, so the lowest flag
+        // is exact.
+
+        inline size_t CountLeadingDigits(uint64_t word)
+        {
+            uint64_t nonDigits = ((word + 0x4646464646464646ull) | (word - 0x3030303030303030ull)) & 0x8080808080808080ull;
+            return nonDigits ? __builtin_ctzll(nonDigits) >> 3 : 8;
+        }
+
+        // ParseEightDigits
+        //
+        // Eight digit characters to their value, in three multiplies: pairs
+        // of digits, then pairs of pairs, then the two halves.
+
+        inline uint32_t ParseEightDigits(uint64_t word)
+        {
+            word = ((word & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+            word = ((word & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+            return (uint32_t)(((word & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32);
+        }
+
+        // ReadDigits
+        //
+        // Appends the decimal digits at p to value, reading no further than
+        // pEnd, and returns how many there were.  value wraps past 19
+        // digits; callers go by the count.
+        //
+        // pEnd is the caller's length, which may run well past a terminator
+        // into memory that isn't there, so a word is only loaded when it
+        // can't cross into the next page; the first byte is readable, so the
+        // rest of its page is too.  The bytes past a terminator that this
+        // reads are never used, as the terminator ends the digits, but
+        // AddressSanitizer can't know that, so its builds take the byte loop.
+
+        inline size_t ReadDigits(const char *& p, const char * pEnd, uint64_t & value)
+        {
+            size_t cDigits = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && !defined(SAFESTRINGS_ASAN)
+            static constexpr uint64_t c_rgPowers[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+            static constexpr uintptr_t c_cbPage   = 4096;
+
+            while (pEnd - p >= 8 && ((uintptr_t) p & (c_cbPage - 1)) <= c_cbPage - 8)
+            {
+                uint64_t word;
+                memcpy(&word, p, 8);
+
+                size_t cLeading = CountLeadingDigits(word);
+                if (cLeading == 0)
+                    return cDigits;
+
+                // Fewer than eight: slide them to the top and pad with
+                // leading '0's
+
+                if (cLeading < 8)
+                    word = (word << (8 * (8 - cLeading))) | (0x3030303030303030ull >> (8 * cLeading));
+
+                value    = value * c_rgPowers[cLeading] + ParseEightDigits(word);
+                p       += cLeading;
+                cDigits += cLeading;
+
+                if (cLeading < 8)
+                    return cDigits;
+            }
+#endif
+            for (; p < pEnd && (unsigned)(*p - '0') <= 9; ++p, ++cDigits)
+                value = value * 10 + (unsigned)(*p - '0');
+            return cDigits;
+        }
+    }
+}
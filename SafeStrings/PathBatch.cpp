@@ -0,0 +1,253 @@
+//--------------------------------------------------------------------------------
+// PathBatch.cpp - SplitPaths, SplitPathArena
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Each path costs one call to the ScanPath kernel, which finds its length,
+// last separator and last dot in the same vector pass, plus a few compares
+// to turn those into column values.  Multithreaded batches are cut into
+// pieces of cPathsPerThread paths that the worker pool hands out in turn.
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "PathBatch.h"
+#include "StringKernels.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+#include <vector>
+
+using namespace SafeStrings::Internal;
+
+namespace
+{
+    // How far ahead of the current path SplitPaths touches the next one.
+    // Paths in a catalog are separate allocations, and a miss on each would
+    // otherwise cost more than splitting it.
+
+    constexpr size_t c_cPrefetchAhead = 8;
+
+    // StoreParts
+    //
+    // The drive, the directory and extension rules of _splitpath_s applied
+    // to one scan.  The drive is only ever the first two characters, so a
+    // separator or dot inside it doesn't count.
+
+    inline void StoreParts(const SafeStrings::SplitPathColumns & columns, size_t i, const char * psz, const PathScan & scan)
+    {
+        size_t ichDir   = (scan.cch >= 2 && psz[1] == ':') ? 2 : 0;
+        size_t ichFname = std::max(scan.ichAfterSeparator, ichDir);
+        size_t ichExt   = (scan.ichAfterDot > ichFname) ? scan.ichAfterDot - 1 : scan.cch;
+
+        columns.rgichDir[i]   = (uint32_t) ichDir;
+        columns.rgichFname[i] = (uint32_t) ichFname;
+        columns.rgichExt[i]   = (uint32_t) ichExt;
+        columns.rgichEnd[i]   = (uint32_t) scan.cch;
+    }
+
+    inline void ClearParts(const SafeStrings::SplitPathColumns & columns, size_t i)
+    {
+        columns.rgichDir[i]   = 0;
+        columns.rgichFname[i] = 0;
+        columns.rgichExt[i]   = 0;
+        columns.rgichEnd[i]   = 0;
+    }
+
+    bool ColumnsValid(const SafeStrings::SplitPathColumns & columns)
+    {
+        return columns.rgichDir != nullptr && columns.rgichFname != nullptr &&
+               columns.rgichExt != nullptr && columns.rgichEnd   != nullptr;
+    }
+
+    // ThreadsFor
+    //
+    // How many threads a batch of cPaths is worth under options.
+
+    size_t ThreadsFor(size_t cPaths, const SafeStrings::SplitPathOptions & options)
+    {
+        if (options.cThreads == 1 || cPaths < 2 * std::max<size_t>(options.cPathsPerThread, 1))
+            return 1;
+
+        size_t cThreads = WorkerPool::Instance().Threads();
+        if (options.cThreads != 0)
+            cThreads = std::min<size_t>(cThreads, options.cThreads);
+        return std::min(cThreads, cPaths / std::max<size_t>(options.cPathsPerThread, 1));
+    }
+
+    // SplitRange
+    //
+    // Paths [iFirst, iLast) of a pointer batch.  Returns 0, or the errno
+    // value for the first path that couldn't be split.
+
+    errno_t SplitRange(const char * const * rgpszPaths, size_t iFirst, size_t iLast,
+                       const SafeStrings::SplitPathColumns & columns)
+    {
+        errno_t err = 0;
+        for (size_t i = iFirst; i < iLast; i++)
+        {
+            if (i + c_cPrefetchAhead < iLast)
+                __builtin_prefetch(rgpszPaths[i + c_cPrefetchAhead]);
+
+            const char * psz = rgpszPaths[i];
+            if (SAFE_UNLIKELY(psz == nullptr))
+            {
+                ClearParts(columns, i);
+                err = err ? err : EINVAL;
+                continue;
+            }
+
+            PathScan scan = ScanPath(psz, UINT32_MAX);
+            if (SAFE_UNLIKELY(scan.cch == UINT32_MAX))
+            {
+                ClearParts(columns, i);
+                err = err ? err : ERANGE;
+                continue;
+            }
+
+            StoreParts(columns, i, psz, scan);
+        }
+        return err;
+    }
+
+    // SplitArenaRange
+    //
+    // Up to cPaths paths from the arena bytes [ib, ibEnd), numbered from
+    // iFirst.  Returns how many were complete.
+
+    size_t SplitArenaRange(const char * pArena, size_t ib, size_t ibEnd, size_t iFirst, size_t cPaths,
+                           const SafeStrings::SplitPathColumns & columns)
+    {
+        size_t i = iFirst;
+        for (; i < iFirst + cPaths && ib < ibEnd; i++)
+        {
+            const char * psz  = pArena + ib;
+            size_t       cchMax = std::min<size_t>(ibEnd - ib, UINT32_MAX);
+            PathScan     scan = ScanPath(psz, cchMax);
+            if (SAFE_UNLIKELY(scan.cch == cchMax))
+                break;
+
+            StoreParts(columns, i, psz, scan);
+            columns.rgibStart[i] = ib;
+            ib += scan.cch + 1;
+        }
+        return i - iFirst;
+    }
+}
+
+errno_t SafeStrings::SplitPaths(const char * const * rgpszPaths, size_t cPaths,
+                                const SplitPathColumns & columns, const SplitPathOptions & options)
+{
+    if (SAFE_UNLIKELY((rgpszPaths == nullptr && cPaths != 0) || !ColumnsValid(columns)))
+        return SAFE_RAISE(EINVAL, "rgpszPaths != nullptr && columns != nullptr", "SplitPaths");
+
+    errno_t err = 0;
+    size_t  cThreads = ThreadsFor(cPaths, options);
+    if (cThreads <= 1)
+    {
+        err = SplitRange(rgpszPaths, 0, cPaths, columns);
+    }
+    else
+    {
+        size_t cchPiece = options.cPathsPerThread;
+        size_t cPieces  = (cPaths + cchPiece - 1) / cchPiece;
+
+        std::atomic<errno_t> errFirst { 0 };
+        WorkerPool::Instance().Run(cPieces, cThreads, [&](size_t iPiece)
+        {
+            size_t  iFirst   = iPiece * cchPiece;
+            errno_t errPiece = SplitRange(rgpszPaths, iFirst, std::min(iFirst + cchPiece, cPaths), columns);
+            if (errPiece != 0)
+            {
+                errno_t errNone = 0;
+                errFirst.compare_exchange_strong(errNone, errPiece);
+            }
+        });
+        err = errFirst.load();
+    }
+
+    // Reported here, on the caller's thread, rather than by whichever
+    // worker found the path
+
+    if (SAFE_UNLIKELY(err == EINVAL))
+        return SAFE_RAISE(EINVAL, "rgpszPaths[i] != nullptr", "SplitPaths");
+    if (SAFE_UNLIKELY(err == ERANGE))
+        return SAFE_RAISE(ERANGE, "path length < 4GB", "SplitPaths");
+    return 0;
+}
+
+// SplitPathArena
+//
+// Threads can't just take every Nth path, since where a path starts is
+// only known once the one before it has been scanned.  Instead the arena is
+// cut into byte ranges at terminators, each range's terminators are counted
+// (a plain vectorized count), and the running total gives every range the
+// index of its first path.  Then the ranges are split independently.
+
+errno_t SafeStrings::SplitPathArena(const char * pArena, size_t cbArena, size_t cPaths,
+                                    const SplitPathColumns & columns, const SplitPathOptions & options)
+{
+    if (SAFE_UNLIKELY((pArena == nullptr && cbArena != 0) || !ColumnsValid(columns) || columns.rgibStart == nullptr))
+        return SAFE_RAISE(EINVAL, "pArena != nullptr && columns != nullptr", "SplitPathArena");
+
+    size_t cComplete = 0;
+    size_t cThreads  = ThreadsFor(cPaths, options);
+    if (cThreads <= 1)
+    {
+        cComplete = SplitArenaRange(pArena, 0, cbArena, 0, cPaths, columns);
+    }
+    else
+    {
+        // A few ranges per thread so a slow one doesn't hold up the rest
+
+        size_t              cRanges = cThreads * 4;
+        std::vector<size_t> rgibRange(cRanges + 1);
+        rgibRange[0]       = 0;
+        rgibRange[cRanges] = cbArena;
+        for (size_t k = 1; k < cRanges; k++)
+        {
+            size_t ib = std::max(cbArena / cRanges * k, rgibRange[k - 1]);
+            const char * pEnd = (const char *) memchr(pArena + ib, '\0', cbArena - ib);
+            rgibRange[k] = pEnd ? (size_t) (pEnd - pArena) + 1 : cbArena;
+        }
+
+        std::vector<size_t> rgcPaths(cRanges);
+        WorkerPool::Instance().Run(cRanges, cThreads, [&](size_t k)
+        {
+            rgcPaths[k] = std::count(pArena + rgibRange[k], pArena + rgibRange[k + 1], '\0');
+        });
+
+        std::vector<size_t> rgiFirst(cRanges);
+        size_t iPath = 0;
+        for (size_t k = 0; k < cRanges; k++)
+        {
+            rgiFirst[k] = iPath;
+            iPath      += rgcPaths[k];
+        }
+
+        std::atomic<size_t> cDone { 0 };
+        WorkerPool::Instance().Run(cRanges, cThreads, [&](size_t k)
+        {
+            if (rgiFirst[k] >= cPaths)
+                return;
+            size_t cWanted = std::min(rgcPaths[k], cPaths - rgiFirst[k]);
+            cDone += SplitArenaRange(pArena, rgibRange[k], rgibRange[k + 1], rgiFirst[k], cWanted, columns);
+        });
+        cComplete = cDone.load();
+    }
+
+    if (SAFE_UNLIKELY(cComplete < cPaths))
+    {
+        for (size_t i = cComplete; i < cPaths; i++)
+        {
+            ClearParts(columns, i);
+            columns.rgibStart[i] = 0;
+        }
+        return SAFE_RAISE(EINVAL, "pArena holds cPaths terminated paths", "SplitPathArena");
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+//--------------------------------------------------------------------------------
+// PathBatch.h - SplitPath for whole catalogs of paths at once
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Splitting paths one call at a time spends as much on the call, the copies
+// and the branchy byte loop as on the paths themselves.  SplitPaths and
+// SplitPathArena take a whole batch and classify each path in one pass of
+// vector compares - terminator, '\' or '/', and '.' together - and write
+// the results column by column, structure-of-arrays style:
+//
+//    std::vector<uint32_t> rgichDir(cPaths), rgichFname(cPaths), rgichExt(cPaths), rgichEnd(cPaths);
+//    SafeStrings::SplitPathColumns columns =
+//        { rgichDir.data(), rgichFname.data(), rgichExt.data(), rgichEnd.data() };
+//    SafeStrings::SplitPaths(rgpszPaths, cPaths, columns);
+//
+// For path i the four parts are the same as SplitPath (and _splitpath_s)
+// would give:
+//
+//    drive  [0,              rgichDir[i])
+//    dir    [rgichDir[i],    rgichFname[i])
+//    fname  [rgichFname[i],  rgichExt[i])
+//    ext    [rgichExt[i],    rgichEnd[i])          rgichEnd[i] is the length
+//
+// A large batch can be spread over the library's worker pool by asking for
+// more than one thread; the results are identical either way.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <stdint.h>
+
+namespace SafeStrings
+{
+    // SplitPathColumns
+    //
+    // One array per column, each with room for a value per path.
+
+    struct SplitPathColumns
+    {
+        uint32_t * rgichDir;
+        uint32_t * rgichFname;
+        uint32_t * rgichExt;
+        uint32_t * rgichEnd;
+        size_t *   rgibStart = nullptr;     // SplitPathArena only: where each path starts
+    };
+
+    struct SplitPathOptions
+    {
+        unsigned cThreads        = 1;       // 0 for every hardware thread
+        size_t   cPathsPerThread = 65536;   // Fewer than this aren't worth a thread
+    };
+
+    // SplitPaths
+    //
+    // Splits cPaths C strings.  A null entry, or a path of 4GB or more, gets
+    // zeros in every column and fails the batch (EINVAL or ERANGE, through
+    // the handler) once the rest have been split.
+
+    errno_t SplitPaths(const char * const * rgpszPaths, size_t cPaths,
+                       const SplitPathColumns & columns, const SplitPathOptions & options = { });
+
+    // SplitPathArena
+    //
+    // Splits cPaths paths stored back to back, each with its terminator, in
+    // the cbArena bytes at pArena, and also fills rgibStart.  Fails with
+    // EINVAL if the arena ends before the last terminator.
+
+    errno_t SplitPathArena(const char * pArena, size_t cbArena, size_t cPaths,
+                           const SplitPathColumns & columns, const SplitPathOptions & options = { });
+}
@@ -0,0 +1,217 @@
+//--------------------------------------------------------------------------------
+// PathFunctions.cpp - _makepath_s, _splitpath_s, SplitPath, MakePath
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Windows path syntax, as the CRT defines it: an optional "X:" drive, a
+// directory that runs through the last '\' or '/', a file name, and an
+// extension that starts at the last '.' after the directory.  SplitPath and
+// MakePath generalize that over the syntaxes in PathSyntax.h.
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "PathParts.h"
+
+#include <string.h>
+
+using namespace SafeStrings;
+
+namespace
+{
+    // AppendPiece
+    //
+    // Copies cch bytes to *ppDest if there's room for them plus a terminator.
+
+    inline bool AppendPiece(char ** ppDest, const char * pEnd, const char * src, size_t cch)
+    {
+        if ((size_t)(pEnd - *ppDest) <= cch)
+            return false;
+
+        memcpy(*ppDest, src, cch);
+        *ppDest += cch;
+        return true;
+    }
+
+    // CopyComponent
+    //
+    // Copies one piece of a split path into the caller's buffer, which may
+    // legitimately be null (with a size of zero) when they don't want it.
+
+    inline bool CopyComponent(char * dest, size_t destsz, const char * src, size_t cch)
+    {
+        if (dest == nullptr)
+            return true;
+
+        if (cch >= destsz)
+            return false;
+
+        memcpy(dest, src, cch);
+        dest[cch] = '\0';
+        return true;
+    }
+
+    inline void ResetComponent(char * dest, size_t destsz)
+    {
+        if (dest != nullptr && destsz > 0)
+            dest[0] = '\0';
+    }
+
+    // BuildPath
+    //
+    // The body of _makepath_s and MakePath, with path already validated.
+    // Returns false, leaving path empty, if the pieces don't fit.
+
+    template <typename Syntax>
+    bool BuildPath(char * path, size_t sizeInCharacters,
+                   const char * drive, const char * dir, const char * fname, const char * ext)
+    {
+        char *       p    = path;
+        const char * pEnd = path + sizeInCharacters;
+        bool         fOk  = true;
+
+        if (Syntax::c_fDrives && drive != nullptr && drive[0] != '\0')
+        {
+            const char szDrive[2] = { drive[0], ':' };
+            fOk = AppendPiece(&p, pEnd, szDrive, 2);
+        }
+
+        if (fOk && dir != nullptr && dir[0] != '\0')
+        {
+            size_t cch = strlen(dir);
+            fOk = AppendPiece(&p, pEnd, dir, cch);
+            if (fOk && !Syntax::IsSeparator(dir[cch - 1]))
+                fOk = AppendPiece(&p, pEnd, &Syntax::c_chSeparator, 1);
+        }
+
+        if (fOk && fname != nullptr)
+            fOk = AppendPiece(&p, pEnd, fname, strlen(fname));
+
+        if (fOk && ext != nullptr && ext[0] != '\0')
+        {
+            if (ext[0] != '.')
+                fOk = AppendPiece(&p, pEnd, ".", 1);
+            if (fOk)
+                fOk = AppendPiece(&p, pEnd, ext, strlen(ext));
+        }
+
+        if (SAFE_UNLIKELY(!fOk))
+        {
+            path[0] = '\0';
+            return false;
+        }
+
+        *p = '\0';
+        return true;
+    }
+}
+
+// _makepath_s
+//
+// Builds drive + dir + fname + ext into path, adding the ':' after the drive
+// letter, a '\' after the directory and a '.' before the extension when the
+// caller didn't supply them.  Any piece may be null or empty.
+
+extern "C" errno_t _makepath_s(char * path, size_t sizeInCharacters,
+                               const char * drive, const char * dir,
+                               const char * fname, const char * ext)
+{
+    SAFE_VALIDATE_STRING(path, sizeInCharacters, "_makepath_s", EINVAL);
+
+    if (SAFE_UNLIKELY(!BuildPath<WindowsPaths>(path, sizeInCharacters, drive, dir, fname, ext)))
+        return SAFE_RAISE(ERANGE, "Buffer is too small", "_makepath_s");
+
+    return 0;
+}
+
+// _splitpath_s
+//
+// The reverse of _makepath_s.  Each output buffer is optional, but a null
+// buffer must come with a zero size and vice versa.  If any piece doesn't fit
+// then every buffer is emptied and the handler is called with ERANGE.
+
+extern "C" errno_t _splitpath_s(const char * path,
+                                char * drive, size_t driveNumberOfElements,
+                                char * dir,   size_t dirNumberOfElements,
+                                char * fname, size_t nameNumberOfElements,
+                                char * ext,   size_t extNumberOfElements)
+{
+    if (SAFE_UNLIKELY(path == nullptr ||
+                      (drive == nullptr) != (driveNumberOfElements == 0) ||
+                      (dir   == nullptr) != (dirNumberOfElements   == 0) ||
+                      (fname == nullptr) != (nameNumberOfElements  == 0) ||
+                      (ext   == nullptr) != (extNumberOfElements   == 0)))
+    {
+        ResetComponent(drive, driveNumberOfElements);
+        ResetComponent(dir,   dirNumberOfElements);
+        ResetComponent(fname, nameNumberOfElements);
+        ResetComponent(ext,   extNumberOfElements);
+        return SAFE_RAISE(EINVAL, "path != nullptr && (buffer != nullptr) == (size != 0)", "_splitpath_s");
+    }
+
+    PathParts parts = SplitPath(std::string_view(path, strlen(path)));
+
+    bool fOk = CopyComponent(drive, driveNumberOfElements, parts.drive.data(), parts.drive.size())
+            && CopyComponent(dir,   dirNumberOfElements,   parts.dir.data(),   parts.dir.size())
+            && CopyComponent(fname, nameNumberOfElements,  parts.fname.data(), parts.fname.size())
+            && CopyComponent(ext,   extNumberOfElements,   parts.ext.data(),   parts.ext.size());
+
+    if (SAFE_UNLIKELY(!fOk))
+    {
+        ResetComponent(drive, driveNumberOfElements);
+        ResetComponent(dir,   dirNumberOfElements);
+        ResetComponent(fname, nameNumberOfElements);
+        ResetComponent(ext,   extNumberOfElements);
+        return SAFE_RAISE(ERANGE, "Buffer is too small", "_splitpath_s");
+    }
+
+    return 0;
+}
+
+// SplitPath
+//
+// The C string form of SplitPath in PathParts.h.  strlen is the only pass
+// over the whole path; the split itself only reads the file name.
+
+template <typename Syntax>
+errno_t SafeStrings::SplitPath(const char * path, PathParts & parts)
+{
+    if (SAFE_UNLIKELY(path == nullptr))
+    {
+        parts = PathParts();
+        return SAFE_RAISE(EINVAL, "path != nullptr", "SplitPath");
+    }
+
+    parts = SplitPath<Syntax>(std::string_view(path, strlen(path)));
+    return 0;
+}
+
+template <typename Syntax>
+errno_t SafeStrings::MakePath(char * path, size_t sizeInCharacters,
+                              const char * drive, const char * dir, const char * fname, const char * ext)
+{
+    SAFE_VALIDATE_STRING(path, sizeInCharacters, "MakePath", EINVAL);
+
+    if constexpr (!Syntax::c_fDrives)
+    {
+        if (SAFE_UNLIKELY(drive != nullptr && drive[0] != '\0'))
+        {
+            path[0] = '\0';
+            return SAFE_RAISE(EINVAL, "drive == nullptr || drive[0] == '\\0'", "MakePath");
+        }
+    }
+
+    if (SAFE_UNLIKELY(!BuildPath<Syntax>(path, sizeInCharacters, drive, dir, fname, ext)))
+        return SAFE_RAISE(ERANGE, "Buffer is too small", "MakePath");
+
+    return 0;
+}
+
+template errno_t SafeStrings::SplitPath<WindowsPaths>(const char *, PathParts &);
+template errno_t SafeStrings::SplitPath<PosixPaths>  (const char *, PathParts &);
+template errno_t SafeStrings::SplitPath<MixedPaths>  (const char *, PathParts &);
+
+template errno_t SafeStrings::MakePath<WindowsPaths>(char *, size_t, const char *, const char *, const char *, const char *);
+template errno_t SafeStrings::MakePath<PosixPaths>  (char *, size_t, const char *, const char *, const char *, const char *);
+template errno_t SafeStrings::MakePath<MixedPaths>  (char *, size_t, const char *, const char *, const char *, const char *);
@@ -0,0 +1,134 @@
+//--------------------------------------------------------------------------------
+// PathParts.h - _splitpath_s without the copies
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// _splitpath_s copies each part of a path into a buffer of its own, and the
+// buffers have to be sized for the worst case: _MAX_DRIVE + _MAX_DIR +
+// _MAX_FNAME + _MAX_EXT is over 500 bytes of stack per call.  SplitPath
+// returns the same four parts as views into the path itself:
+//
+//    SafeStrings::PathParts parts = SafeStrings::SplitPath(strPath);
+//    if (parts.ext == ".txt")
+//        ...
+//
+// The parts are exactly what _splitpath_s would have copied out - "C:",
+// "\foo\", "bar" and ".txt" for the path _makepath_s builds in the demo -
+// and they stay valid for as long as the path does.  Nothing can overflow,
+// so the only failure is a null path.
+//
+// The parts are found by walking back from the end of the path to the
+// last separator, so only the file name and extension are looked at; the
+// directory, usually the longest part, is never scanned.
+//
+// Both SplitPath and MakePath, the _makepath_s counterpart, take a path
+// syntax from PathSyntax.h as a template argument; it defaults to Windows
+// paths, matching the CRT functions:
+//
+//    SafeStrings::PathParts parts = SafeStrings::SplitPath<SafeStrings::PosixPaths>("/usr/lib/libc.so");
+//    SafeStrings::MakePath<SafeStrings::NativePaths>(szPath, nullptr, "/tmp", "log", "txt");
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "PathSyntax.h"
+#include "SafeStrings.h"
+
+#include <string_view>
+
+namespace SafeStrings
+{
+    struct PathParts
+    {
+        std::string_view drive;     // "X:", or empty
+        std::string_view dir;       // Up to and including the last separator
+        std::string_view fname;
+        std::string_view ext;       // From the last '.' in the file name, or empty
+    };
+
+    // SplitPath
+    //
+    // Splits a path whose length is already known.  constexpr, and never
+    // fails: every string has a (possibly empty) drive, dir, fname and ext.
+
+    template <typename Syntax = WindowsPaths>
+    constexpr PathParts SplitPath(std::string_view path) noexcept
+    {
+        const char * pStart = path.data();
+        const char * pEnd   = pStart + path.size();
+        const char * pDir   = pStart + ((Syntax::c_fDrives && path.size() >= 2 && path[1] == ':') ? 2 : 0);
+
+        // The extension is the first '.' seen on the way back, if there is
+        // one before the separator that ends the directory
+
+        const char * pFile = pEnd;
+        const char * pExt  = pEnd;
+        for (; pFile > pDir; --pFile)
+        {
+            char ch = pFile[-1];
+            if (Syntax::IsSeparator(ch))
+                break;
+            if (ch == '.' && pExt == pEnd)
+                pExt = pFile - 1;
+        }
+
+        // Leading dots belong to the name, so ".bashrc" and ".." have no
+        // extension but ".bashrc.old" does
+
+        if constexpr (Syntax::c_fDotFileIsName)
+        {
+            const char * p = pFile;
+            while (p < pExt && *p == '.')
+                ++p;
+            if (p == pExt)
+                pExt = pEnd;
+        }
+
+        return PathParts
+        {
+            std::string_view(pStart, pDir - pStart),
+            std::string_view(pDir,   pFile - pDir),
+            std::string_view(pFile,  pExt - pFile),
+            std::string_view(pExt,   pEnd - pExt),
+        };
+    }
+
+    // SplitPath
+    //
+    // The same for a C string.  A null path empties every part, calls the
+    // invalid parameter handler and returns EINVAL, as _splitpath_s does.
+
+    template <typename Syntax = WindowsPaths>
+    errno_t SplitPath(const char * path, PathParts & parts);
+
+    // MakePath
+    //
+    // _makepath_s under Syntax: drive + dir + fname + ext, adding the ':'
+    // after the drive letter, the syntax's separator after the directory and
+    // a '.' before the extension where the caller didn't.  Any piece may be
+    // null or empty; a drive under a syntax without drives is EINVAL.
+    // Fails like _makepath_s, with an empty path and ERANGE, if the result
+    // doesn't fit.
+
+    template <typename Syntax>
+    errno_t MakePath(char * path, size_t sizeInCharacters,
+                     const char * drive, const char * dir, const char * fname, const char * ext);
+
+    template <typename Syntax, size_t N>
+    errno_t MakePath(char (&path)[N], const char * drive, const char * dir, const char * fname, const char * ext)
+    {
+        return MakePath<Syntax>(path, N, drive, dir, fname, ext);
+    }
+
+    // Compiled once, in PathFunctions.cpp, for the syntaxes above
+
+    extern template errno_t SplitPath<WindowsPaths>(const char *, PathParts &);
+    extern template errno_t SplitPath<PosixPaths>  (const char *, PathParts &);
+    extern template errno_t SplitPath<MixedPaths>  (const char *, PathParts &);
+
+    extern template errno_t MakePath<WindowsPaths>(char *, size_t, const char *, const char *, const char *, const char *);
+    extern template errno_t MakePath<PosixPaths>  (char *, size_t, const char *, const char *, const char *, const char *);
+    extern template errno_t MakePath<MixedPaths>  (char *, size_t, const char *, const char *, const char *, const char *);
+}
@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------
+// PathSyntax.h - Path syntax policies for SplitPath and MakePath
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// _splitpath_s and _makepath_s only know Windows paths: a drive letter,
+// '\' (or '/') between directories, and a '\' added after the directory.
+// SplitPath and MakePath take the syntax as a template argument instead, so
+// each platform compiles straight to its own rules with nothing decided at
+// runtime:
+//
+//    WindowsPaths   exactly what _splitpath_s and _makepath_s do
+//    PosixPaths     '/' only, no drives, and a file name that starts with
+//                   a '.' (".bashrc", "..") has no extension
+//    MixedPaths     reads Windows paths - drives, '\' and '/' both - but
+//                   writes '/', for paths that arrive from Windows clients
+//
+// A syntax is just a struct with these members, so another can be added
+// without touching the functions.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+namespace SafeStrings
+{
+    struct WindowsPaths
+    {
+        static constexpr bool c_fDrives         = true;     // "X:" prefix
+        static constexpr bool c_fDotFileIsName  = false;    // ".bashrc" is all extension
+        static constexpr char c_chSeparator     = '\\';     // What MakePath adds after a directory
+
+        static constexpr bool IsSeparator(char ch) { return ch == '\\' || ch == '/'; }
+    };
+
+    struct PosixPaths
+    {
+        static constexpr bool c_fDrives         = false;
+        static constexpr bool c_fDotFileIsName  = true;
+        static constexpr char c_chSeparator     = '/';
+
+        static constexpr bool IsSeparator(char ch) { return ch == '/'; }
+    };
+
+    struct MixedPaths
+    {
+        static constexpr bool c_fDrives         = true;
+        static constexpr bool c_fDotFileIsName  = false;
+        static constexpr char c_chSeparator     = '/';
+
+        static constexpr bool IsSeparator(char ch) { return ch == '\\' || ch == '/'; }
+    };
+
+#ifdef _WIN32
+    using NativePaths = WindowsPaths;
+#else
+    using NativePaths = PosixPaths;
+#endif
+}
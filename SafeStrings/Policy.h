@@ -0,0 +1,303 @@
+//--------------------------------------------------------------------------------
+// Policy.h - strcpy_s, strcat_s and _snprintf_s with the failure policy fixed
+//            at compile time
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Every check in strcpy_s and friends ends in a call through whatever
+// pointer _set_invalid_parameter_handler installed, so the compiler can
+// neither see what a failure does nor inline the copy around it.  Here the
+// caller names the policy instead:
+//
+//    SafeStrings::Copy<SafeStrings::Policy::Truncate>(szBuffer, sizeof szBuffer, szName);
+//
+//    Truncate   keep what fits, terminated, and return STRUNCATE
+//    Ignore     empty the output and return the error
+//    Count      as Ignore, and add one to ThreadViolationCount()
+//    Throw      throw ConstraintError
+//    Abort      report on stderr and abort, as the default handler does
+//
+// A null or oversized destination or a null source is EINVAL under every
+// policy, Truncate included.  No policy sets errno or calls a handler, and
+// each failure path is a cold function of its own, so the success path of
+// Copy and Append is the inline copy loop and a branch per check.
+//
+// The policies are plain structs; a program can write its own with the same
+// two members.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "FastFormat.h"
+#include "SafeStrings.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <system_error>
+
+namespace SafeStrings
+{
+    // ConstraintError
+    //
+    // What Policy::Throw throws.  code() is the errno value the _s function
+    // would have returned, and what() names the function and the check.
+
+    class ConstraintError : public std::system_error
+    {
+    public:
+
+        ConstraintError(errno_t err, const char * expression, const char * function)
+            : std::system_error(err, std::generic_category(), std::string(function) + ": " + expression)
+        {
+        }
+    };
+
+    namespace Internal
+    {
+        // The out-of-line halves of Policy::Count and Policy::Abort, which
+        // share the thread count and the report with CountingHandler and
+        // the default handler.
+
+        [[gnu::cold, gnu::noinline]] void CountThreadViolation();
+
+        [[noreturn, gnu::cold, gnu::noinline]]
+        void AbortOnViolation(const char * expression, const char * function);
+
+        // Overflow
+        //
+        // The ERANGE path of Copy and Append: src didn't fit in the cbTail
+        // bytes at pTail.  Truncating policies keep the part that did;
+        // the rest empty all of dest and fail.
+
+        template <typename TPolicy>
+        [[gnu::cold, gnu::noinline]]
+        errno_t Overflow(char * dest, char * pTail, size_t cbTail, const char * src, const char * function)
+        {
+            if constexpr (TPolicy::c_fTruncate)
+            {
+                memcpy(pTail, src, cbTail - 1);
+                pTail[cbTail - 1] = '\0';
+                return STRUNCATE;
+            }
+            else
+            {
+                dest[0] = '\0';
+                return TPolicy::Fail(ERANGE, "Buffer is too small", function);
+            }
+        }
+
+        // FormatOutcome
+        //
+        // What Format returns once the engine has said what happened, after
+        // handing any failure to the policy.
+
+        template <typename TPolicy>
+        int FormatOutcome(char * buffer, const FormatStatus & status)
+        {
+            if (__builtin_expect(status.err == 0, 1))
+                return (int) status.cchWritten;
+
+            if (status.err == STRUNCATE)
+            {
+                if constexpr (!TPolicy::c_fTruncate)
+                {
+                    buffer[0] = '\0';
+                    TPolicy::Fail(ERANGE, status.pszExpression, "Format");
+                }
+                return -1;
+            }
+
+            TPolicy::Fail(status.err, status.pszExpression, "Format");
+            return -1;
+        }
+    }
+
+    namespace Policy
+    {
+        // Each policy says whether overflow truncates, and what Fail does
+        // with any other violation: return the errno value to hand back to
+        // the caller, or not return at all.
+
+        struct Truncate
+        {
+            static constexpr bool c_fTruncate = true;
+
+            [[gnu::cold]] static errno_t Fail(errno_t err, const char *, const char *)
+            {
+                return err;
+            }
+        };
+
+        struct Ignore
+        {
+            static constexpr bool c_fTruncate = false;
+
+            [[gnu::cold]] static errno_t Fail(errno_t err, const char *, const char *)
+            {
+                return err;
+            }
+        };
+
+        struct Count
+        {
+            static constexpr bool c_fTruncate = false;
+
+            [[gnu::cold]] static errno_t Fail(errno_t err, const char *, const char *)
+            {
+                Internal::CountThreadViolation();
+                return err;
+            }
+        };
+
+        struct Throw
+        {
+            static constexpr bool c_fTruncate = false;
+
+            [[noreturn, gnu::cold, gnu::noinline]]
+            static errno_t Fail(errno_t err, const char * expression, const char * function)
+            {
+                throw ConstraintError(err, expression, function);
+            }
+        };
+
+        struct Abort
+        {
+            static constexpr bool c_fTruncate = false;
+
+            [[noreturn, gnu::cold]]
+            static errno_t Fail(errno_t, const char * expression, const char * function)
+            {
+                Internal::AbortOnViolation(expression, function);
+            }
+        };
+    }
+
+    // Copy -> strcpy_s
+
+    template <typename TPolicy>
+    inline errno_t Copy(char * dest, rsize_t destsz, const char * src)
+    {
+        if (__builtin_expect(dest == nullptr || destsz == 0 || destsz > RSIZE_MAX, 0))
+            return TPolicy::Fail(EINVAL, "dest != nullptr && 0 < destsz <= RSIZE_MAX", "Copy");
+
+        if (__builtin_expect(src == nullptr, 0))
+        {
+            dest[0] = '\0';
+            return TPolicy::Fail(EINVAL, "src != nullptr", "Copy");
+        }
+
+        if (__builtin_expect(Internal::InlineCopy(dest, src, destsz) == destsz, 0))
+            return Internal::Overflow<TPolicy>(dest, dest, destsz, src, "Copy");
+
+        return 0;
+    }
+
+    // Append -> strcat_s
+
+    template <typename TPolicy>
+    inline errno_t Append(char * dest, rsize_t destsz, const char * src)
+    {
+        if (__builtin_expect(dest == nullptr || destsz == 0 || destsz > RSIZE_MAX, 0))
+            return TPolicy::Fail(EINVAL, "dest != nullptr && 0 < destsz <= RSIZE_MAX", "Append");
+
+        if (__builtin_expect(src == nullptr, 0))
+        {
+            dest[0] = '\0';
+            return TPolicy::Fail(EINVAL, "src != nullptr", "Append");
+        }
+
+        size_t cchDest = Internal::InlineLength(dest, destsz);
+        if (__builtin_expect(cchDest == destsz, 0))
+        {
+            dest[0] = '\0';
+            return TPolicy::Fail(EINVAL, "String is not null terminated", "Append");
+        }
+
+        size_t cbTail = destsz - cchDest;
+        if (__builtin_expect(Internal::InlineCopy(dest + cchDest, src, cbTail) == cbTail, 0))
+            return Internal::Overflow<TPolicy>(dest, dest + cchDest, cbTail, src, "Append");
+
+        return 0;
+    }
+
+    // Array forms
+    //
+    // The size inferred as in SafeStrings.h, and Copy's kernel unrolled for
+    // buffers of up to 64 bytes.
+
+    template <typename TPolicy, size_t size>
+    inline errno_t Copy(char (&dest)[size], const char * src)
+    {
+        if (__builtin_expect(src == nullptr, 0))
+        {
+            dest[0] = '\0';
+            return TPolicy::Fail(EINVAL, "src != nullptr", "Copy");
+        }
+
+        if (__builtin_expect(Internal::FixedCopy<size>(dest, src) == size, 0))
+            return Internal::Overflow<TPolicy>(dest, dest, size, src, "Copy");
+
+        return 0;
+    }
+
+    template <typename TPolicy, size_t size>
+    inline errno_t Append(char (&dest)[size], const char * src)
+    {
+        if (__builtin_expect(src == nullptr, 0))
+        {
+            dest[0] = '\0';
+            return TPolicy::Fail(EINVAL, "src != nullptr", "Append");
+        }
+
+        size_t cchDest = Internal::FixedLength<size>(dest);
+        if (__builtin_expect(cchDest == size, 0))
+        {
+            dest[0] = '\0';
+            return TPolicy::Fail(EINVAL, "String is not null terminated", "Append");
+        }
+
+        size_t cbTail = size - cchDest;
+        if (__builtin_expect(Internal::InlineCopy(dest + cchDest, src, cbTail) == cbTail, 0))
+            return Internal::Overflow<TPolicy>(dest, dest + cchDest, cbTail, src, "Append");
+
+        return 0;
+    }
+
+    template <typename TPolicy, SafeStringsPointer T> errno_t Copy(T && dest, const char * src) = delete;
+    template <typename TPolicy, SafeStringsPointer T> errno_t Append(T && dest, const char * src) = delete;
+
+    // Format -> _snprintf_s
+    //
+    // FastFormat's conversions, with the whole buffer as the count.  Returns
+    // the characters written, or -1 after a failure the policy returned from
+    // (Truncate leaves the prefix that fit).
+
+    template <typename TPolicy>
+    __attribute__((format(printf, 3, 4)))
+    int Format(char * buffer, size_t sizeOfBuffer, const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        Internal::FormatStatus status = Internal::VFormatStatus(buffer, sizeOfBuffer, format, args);
+        va_end(args);
+        return Internal::FormatOutcome<TPolicy>(buffer, status);
+    }
+
+    // The array form is C-variadic too, so the compiler checks its
+    // arguments against the format as it does the pointer form's
+
+    template <typename TPolicy, size_t size>
+    __attribute__((format(printf, 2, 3)))
+    int Format(char (&buffer)[size], const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        Internal::FormatStatus status = Internal::VFormatStatus(buffer, size, format, args);
+        va_end(args);
+        return Internal::FormatOutcome<TPolicy>(buffer, status);
+    }
+}
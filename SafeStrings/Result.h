@@ -0,0 +1,230 @@
+//--------------------------------------------------------------------------------
+// Result.h - strcpy_s, strcat_s and _snprintf_s that return what happened
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// For code that handles its own failures on the spot - a request loop that
+// rejects an oversized field and moves on - a trip through the invalid
+// parameter handler and errno is both slow and beside the point.  TryCopy,
+// TryAppend and TryFormat do the same checks but hand everything back in a
+// Result, and never call the handler or touch errno:
+//
+//    SafeStrings::Result result = SafeStrings::TryCopy(szName, pszField);
+//    if (!result)
+//        return Reject(result.status, result.cchNeeded);
+//
+// An output that doesn't fit is truncated, terminated, and reported as
+// Status::Truncated along with the length the whole thing needed, which is
+// measured only once it is known not to fit.  Any other failure leaves the
+// output empty where there is one.
+//
+// Where size_t is 64 bits a Result is two words, so it comes back in
+// registers: no string can be 2^56 bytes long, which leaves a byte of
+// cchNeeded for the status.  A 32-bit size_t has no bits to spare, and there
+// a Result is three words.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "FastFormat.h"
+#include "SafeStrings.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace SafeStrings
+{
+    enum class Status : uint8_t
+    {
+        Ok,
+        Truncated,              // Cut short to fit; cchNeeded says by how much
+        InvalidArgument,        // A null or oversized buffer, a null source or
+                                // format, or a format vsnprintf_s rejects
+        NotTerminated,          // TryAppend's destination held no terminator
+        EncodingError,          // A wide character that wouldn't convert
+    };
+
+    struct Result
+    {
+        size_t   cchWritten;        // Length of the string now in the output
+#if SIZE_MAX > UINT32_MAX
+        uint64_t cchNeeded : 56;    // Length the complete result needed
+        Status   status    : 8;
+#else
+        size_t   cchNeeded;
+        Status   status;
+#endif
+
+        constexpr bool Ok() const { return status == Status::Ok; }
+        constexpr explicit operator bool() const { return Ok(); }
+
+        // Errno
+        //
+        // The value the matching _s function would have returned, with
+        // Truncated as STRUNCATE, as _TRUNCATE reports it.
+
+        constexpr errno_t Errno() const
+        {
+            switch (status)
+            {
+                case Status::Ok:            return 0;
+                case Status::Truncated:     return STRUNCATE;
+                case Status::EncodingError: return EILSEQ;
+                default:                    return EINVAL;
+            }
+        }
+    };
+
+#if SIZE_MAX > UINT32_MAX
+    static_assert(sizeof(Result) == 2 * sizeof(size_t), "Result should fit in two registers");
+#else
+    static_assert(sizeof(Result) == 3 * sizeof(size_t), "Result should be no bigger than its fields");
+#endif
+
+    namespace Internal
+    {
+        // Truncated
+        //
+        // src didn't fit in the cbTail bytes at pTail, which follow cchBefore
+        // characters already in the output: keep what fits, and measure the
+        // rest.
+
+        [[gnu::cold, gnu::noinline]]
+        inline Result Truncated(char * pTail, size_t cchBefore, size_t cbTail, const char * src)
+        {
+            memcpy(pTail, src, cbTail - 1);
+            pTail[cbTail - 1] = '\0';
+
+            size_t cchWritten = cchBefore + cbTail - 1;
+            return { cchWritten, cchWritten + strlen(src + cbTail - 1), Status::Truncated };
+        }
+
+        inline Result TryAppendTail(char * dest, size_t cchDest, size_t destsz, const char * src)
+        {
+            if (__builtin_expect(cchDest == destsz, 0))
+            {
+                dest[0] = '\0';
+                return { 0, 0, Status::NotTerminated };
+            }
+
+            size_t cbTail = destsz - cchDest;
+            size_t cch    = InlineCopy(dest + cchDest, src, cbTail);
+            if (__builtin_expect(cch == cbTail, 0))
+                return Truncated(dest + cchDest, cchDest, cbTail, src);
+
+            return { cchDest + cch, cchDest + cch, Status::Ok };
+        }
+
+        // FormatResult
+        //
+        // The Result for what the engine reported.
+
+        inline Result FormatResult(const FormatStatus & status)
+        {
+            switch (status.err)
+            {
+                case 0:         return { status.cchWritten, status.cchNeeded, Status::Ok };
+                case STRUNCATE: return { status.cchWritten, status.cchNeeded, Status::Truncated };
+                case EILSEQ:    return { 0, 0, Status::EncodingError };
+                default:        return { 0, 0, Status::InvalidArgument };
+            }
+        }
+    }
+
+    // TryCopy -> strcpy_s
+
+    inline Result TryCopy(char * dest, rsize_t destsz, const char * src)
+    {
+        if (__builtin_expect(dest == nullptr || destsz == 0 || destsz > RSIZE_MAX, 0))
+            return { 0, 0, Status::InvalidArgument };
+
+        if (__builtin_expect(src == nullptr, 0))
+        {
+            dest[0] = '\0';
+            return { 0, 0, Status::InvalidArgument };
+        }
+
+        size_t cch = Internal::InlineCopy(dest, src, destsz);
+        if (__builtin_expect(cch == destsz, 0))
+            return Internal::Truncated(dest, 0, destsz, src);
+
+        return { cch, cch, Status::Ok };
+    }
+
+    // TryAppend -> strcat_s
+
+    inline Result TryAppend(char * dest, rsize_t destsz, const char * src)
+    {
+        if (__builtin_expect(dest == nullptr || destsz == 0 || destsz > RSIZE_MAX, 0))
+            return { 0, 0, Status::InvalidArgument };
+
+        if (__builtin_expect(src == nullptr, 0))
+        {
+            dest[0] = '\0';
+            return { 0, 0, Status::InvalidArgument };
+        }
+
+        return Internal::TryAppendTail(dest, Internal::InlineLength(dest, destsz), destsz, src);
+    }
+
+    // TryFormat -> _snprintf_s
+    //
+    // FastFormat's conversions into the whole buffer.
+
+    __attribute__((format(printf, 3, 4)))
+    inline Result TryFormat(char * buffer, size_t sizeOfBuffer, const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        Internal::FormatStatus status = Internal::VFormatStatus(buffer, sizeOfBuffer, format, args);
+        va_end(args);
+        return Internal::FormatResult(status);
+    }
+
+    // Array forms, as in SafeStrings.h
+
+    template <size_t size>
+    inline Result TryCopy(char (&dest)[size], const char * src)
+    {
+        if (__builtin_expect(src == nullptr, 0))
+        {
+            dest[0] = '\0';
+            return { 0, 0, Status::InvalidArgument };
+        }
+
+        size_t cch = Internal::FixedCopy<size>(dest, src);
+        if (__builtin_expect(cch == size, 0))
+            return Internal::Truncated(dest, 0, size, src);
+
+        return { cch, cch, Status::Ok };
+    }
+
+    template <size_t size>
+    inline Result TryAppend(char (&dest)[size], const char * src)
+    {
+        if (__builtin_expect(src == nullptr, 0))
+        {
+            dest[0] = '\0';
+            return { 0, 0, Status::InvalidArgument };
+        }
+
+        return Internal::TryAppendTail(dest, Internal::FixedLength<size>(dest), size, src);
+    }
+
+    template <size_t size>
+    __attribute__((format(printf, 2, 3)))
+    inline Result TryFormat(char (&buffer)[size], const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        Internal::FormatStatus status = Internal::VFormatStatus(buffer, size, format, args);
+        va_end(args);
+        return Internal::FormatResult(status);
+    }
+
+    template <SafeStringsPointer T> Result TryCopy(T && dest, const char * src) = delete;
+    template <SafeStringsPointer T> Result TryAppend(T && dest, const char * src) = delete;
+}
@@ -0,0 +1,299 @@
+//--------------------------------------------------------------------------------
+// SafeString.h - Fixed-capacity inline string that always knows its length
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// SafeString<N> replaces the "char szBuffer[16]; ... sizeof szBuffer" dance:
+// it holds up to N characters plus a terminator inline, and keeps the
+// current length in the smallest integer that can count to N.  Since the
+// length and capacity are always at hand, no operation has to measure the
+// string it already owns.
+//
+// Each operation follows the cheat-sheet function it stands in for:
+//
+//    Copy           -> strcpy_s       (empty + ERANGE if it won't fit)
+//    Append         -> strcat_s       (empty + ERANGE if it won't fit)
+//    Format         -> _snprintf_s    (count = capacity: empty + ERANGE)
+//    FormatTruncate -> _snprintf_s    (count = _TRUNCATE: keep what fits)
+//    SplitPath      -> _splitpath_s   (all parts empty + ERANGE)
+//
+// Copy and Append are constexpr; an overflow during constant evaluation
+// reaches the (non-constexpr) handler call and so fails to compile.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+#include "PathParts.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace SafeStrings
+{
+    template <size_t N>
+    class SafeString
+    {
+        static_assert(N > 0 && N < RSIZE_MAX, "SafeString capacity must be in (0, RSIZE_MAX)");
+
+    public:
+
+        using SizeType = std::conditional_t<(N <= UINT8_MAX),  uint8_t,
+                         std::conditional_t<(N <= UINT16_MAX), uint16_t,
+                         std::conditional_t<(N <= UINT32_MAX), uint32_t, size_t>>>;
+
+        static constexpr size_t Capacity = N;
+
+        // The unused tail of the buffer is left alone at runtime; during
+        // constant evaluation every byte has to have a value, so it's zeroed.
+
+        constexpr SafeString() noexcept
+        {
+            if (std::is_constant_evaluated())
+            {
+                for (size_t i = 0; i <= N; i++)
+                    _sz[i] = '\0';
+            }
+            _sz[0] = '\0';
+            _cch   = 0;
+        }
+
+        // From a string literal, checked at compile time.  This is consteval
+        // so that a runtime char array can't sneak in here and have its whole
+        // extent copied; use the pointer constructor or Copy for those.
+
+        template <size_t M>
+        consteval SafeString(const char (&sz)[M]) noexcept
+            : SafeString()
+        {
+            static_assert(M - 1 <= N, "String literal does not fit in this SafeString");
+            AssignUnchecked(sz, M - 1);
+        }
+
+        // From any other string, with the same semantics as Copy
+
+        template <typename T>
+            requires std::is_same_v<T, const char *> || std::is_same_v<T, char *>
+        explicit SafeString(T src)
+            : SafeString()
+        {
+            Copy(src);
+        }
+
+        constexpr const char * c_str()  const noexcept { return _sz; }
+        constexpr const char * data()   const noexcept { return _sz; }
+        constexpr char *       data()         noexcept { return _sz; }
+        constexpr size_t       Length() const noexcept { return _cch; }
+        constexpr bool         empty()  const noexcept { return _cch == 0; }
+
+        constexpr operator std::string_view() const noexcept
+        {
+            return std::string_view(_sz, _cch);
+        }
+
+        constexpr char operator[](size_t i) const noexcept
+        {
+            return _sz[i];
+        }
+
+        constexpr void Clear() noexcept
+        {
+            _sz[0] = '\0';
+            _cch   = 0;
+        }
+
+        // Copy -> strcpy_s
+
+        constexpr errno_t Copy(const char * src)
+        {
+            if (src == nullptr)
+            {
+                Clear();
+                return Violation(EINVAL, L"src != nullptr", L"SafeString::Copy");
+            }
+
+            size_t cch;
+            if (std::is_constant_evaluated())
+            {
+                for (cch = 0; cch <= N && src[cch] != '\0'; cch++)
+                    _sz[cch] = src[cch];
+            }
+            else
+            {
+                cch = CopyBounded(_sz, N + 1, src);
+            }
+
+            if (cch > N)
+            {
+                Clear();
+                return Violation(ERANGE, L"Buffer is too small", L"SafeString::Copy");
+            }
+
+            _sz[cch] = '\0';
+            _cch     = (SizeType) cch;
+            return 0;
+        }
+
+        constexpr errno_t Copy(std::string_view sv)
+        {
+            if (sv.size() > N)
+            {
+                Clear();
+                return Violation(ERANGE, L"Buffer is too small", L"SafeString::Copy");
+            }
+
+            AssignUnchecked(sv.data(), sv.size());
+            return 0;
+        }
+
+        // Append -> strcat_s, starting at the remembered end
+
+        constexpr errno_t Append(const char * src)
+        {
+            if (src == nullptr)
+            {
+                Clear();
+                return Violation(EINVAL, L"src != nullptr", L"SafeString::Append");
+            }
+
+            size_t cbAvail = N + 1 - _cch;
+            size_t cch;
+            if (std::is_constant_evaluated())
+            {
+                for (cch = 0; cch < cbAvail && src[cch] != '\0'; cch++)
+                    _sz[_cch + cch] = src[cch];
+                if (cch < cbAvail)
+                    _sz[_cch + cch] = '\0';
+            }
+            else
+            {
+                cch = CopyBounded(_sz + _cch, cbAvail, src);
+            }
+
+            if (cch == cbAvail)
+            {
+                Clear();
+                return Violation(ERANGE, L"Buffer is too small", L"SafeString::Append");
+            }
+
+            _cch = (SizeType)(_cch + cch);
+            return 0;
+        }
+
+        constexpr errno_t Append(std::string_view sv)
+        {
+            if (sv.size() > N - _cch)
+            {
+                Clear();
+                return Violation(ERANGE, L"Buffer is too small", L"SafeString::Append");
+            }
+
+            std::char_traits<char>::copy(_sz + _cch, sv.data(), sv.size());
+            _cch = (SizeType)(_cch + sv.size());
+            _sz[_cch] = '\0';
+            return 0;
+        }
+
+        constexpr errno_t Append(char ch)
+        {
+            return Append(std::string_view(&ch, 1));
+        }
+
+        template <size_t M>
+        constexpr errno_t Append(const SafeString<M> & other)
+        {
+            return Append(std::string_view(other));
+        }
+
+        // Format -> _snprintf_s(sz, sizeof sz, sizeof sz, ...): the whole
+        // result must fit or the string is emptied and the handler called
+
+        __attribute__((format(printf, 2, 3)))
+        errno_t Format(const char * format, ...)
+        {
+            va_list args;
+            va_start(args, format);
+            size_t  cch;
+            errno_t err = Internal::VSnprintfStatus(_sz, N + 1, N + 1, &cch, format, args);
+            va_end(args);
+            _cch = (SizeType) cch;
+            return err;
+        }
+
+        // FormatTruncate -> _snprintf_s(sz, sizeof sz, _TRUNCATE, ...): keep
+        // as much as fits, and return STRUNCATE if anything was lost
+
+        __attribute__((format(printf, 2, 3)))
+        errno_t FormatTruncate(const char * format, ...)
+        {
+            va_list args;
+            va_start(args, format);
+            size_t  cch;
+            errno_t err = Internal::VSnprintfStatus(_sz, N + 1, _TRUNCATE, &cch, format, args);
+            va_end(args);
+            _cch = (SizeType) cch;
+            return err;
+        }
+
+        // SplitPath -> _splitpath_s
+        //
+        // Works from the known length, so the only scan is the one back
+        // over the file name.  Any part that doesn't fit empties all four
+        // and reports ERANGE.
+
+        template <size_t D, size_t P, size_t F, size_t E>
+        errno_t SplitPath(SafeString<D> & drive, SafeString<P> & dir,
+                          SafeString<F> & fname, SafeString<E> & ext) const
+        {
+            PathParts parts = SafeStrings::SplitPath(std::string_view(*this));
+
+            if (parts.drive.size() > D || parts.dir.size() > P || parts.fname.size() > F || parts.ext.size() > E)
+            {
+                drive.Clear();
+                dir.Clear();
+                fname.Clear();
+                ext.Clear();
+                return Violation(ERANGE, L"Buffer is too small", L"SafeString::SplitPath");
+            }
+
+            drive.AssignUnchecked(parts.drive.data(), parts.drive.size());
+            dir.AssignUnchecked(parts.dir.data(), parts.dir.size());
+            fname.AssignUnchecked(parts.fname.data(), parts.fname.size());
+            ext.AssignUnchecked(parts.ext.data(), parts.ext.size());
+            return 0;
+        }
+
+        friend constexpr bool operator==(const SafeString & a, const SafeString & b) noexcept
+        {
+            return std::string_view(a) == std::string_view(b);
+        }
+
+    private:
+
+        template <size_t> friend class SafeString;
+
+        constexpr void AssignUnchecked(const char * src, size_t cch) noexcept
+        {
+            std::char_traits<char>::copy(_sz, src, cch);
+            _sz[cch] = '\0';
+            _cch     = (SizeType) cch;
+        }
+
+        [[gnu::cold, gnu::noinline]]
+        static errno_t Violation(errno_t err, const wchar_t * expression, const wchar_t * function)
+        {
+            return Internal::ConstraintViolation(err, expression, function, L"" __FILE__, __LINE__);
+        }
+
+        char     _sz[N + 1];
+        SizeType _cch;
+    };
+
+    static_assert(std::is_trivially_copyable_v<SafeString<15>>);
+    static_assert(sizeof(SafeString<15>) == 15 + 1 + sizeof(uint8_t));
+}
@@ -0,0 +1,296 @@
+//--------------------------------------------------------------------------------
+// SafeStrings - Portable Safe C String Library
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// A native implementation of every function in the StringTests cheat sheet
+// for platforms whose C runtime doesn't ship them (glibc has no Annex K).
+// Behavior follows the Microsoft CRT that the demo was written against:
+// a runtime constraint violation sets errno, calls the invalid parameter
+// handler, and then returns an error code to the caller.
+//
+//    Olden Days        Hipsters
+//    --------------------------------
+//    strlen         -> strnlen_s
+//    strcpy         -> strcpy_s
+//    strcat         -> strcat_s
+//    sprintf        -> _snprintf_s
+//    vsprintf       -> vsnprintf_s
+//    makepath       -> _makepath_s
+//    _splitpath     -> _splitpath_s
+//    scanf / sscanf -> sscanf_s
+//    snscanf        -> _snscanf_s
+//    gets           -> gets_s
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <wchar.h>
+
+// Types and limits that the Microsoft CRT and Annex K provide but glibc does not
+
+#ifndef _ERRNO_T_DEFINED
+#define _ERRNO_T_DEFINED
+typedef int errno_t;
+#endif
+
+#ifndef RSIZE_MAX
+typedef size_t rsize_t;
+#define RSIZE_MAX (SIZE_MAX >> 1)
+#endif
+
+#ifndef _TRUNCATE
+#define _TRUNCATE ((size_t)-1)
+#endif
+
+#ifndef STRUNCATE
+#define STRUNCATE 80
+#endif
+
+#ifndef _MAX_PATH
+#define _MAX_PATH   260
+#define _MAX_DRIVE  3
+#define _MAX_DIR    256
+#define _MAX_FNAME  256
+#define _MAX_EXT    256
+#endif
+
+// _invalid_parameter_handler
+//
+// Called whenever one of the functions below detects a constraint violation.
+// The strings are wide literals naming the failed check, the function and the
+// source file; when the handler returns, the failing function cleans up and
+// returns its error code.  With no handler installed the default reports the
+// violation on stderr and aborts, just as the CRT does.
+
+typedef void (*_invalid_parameter_handler)(const wchar_t * expression,
+                                           const wchar_t * function,
+                                           const wchar_t * file,
+                                           unsigned int    line,
+                                           uintptr_t       pReserved);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+_invalid_parameter_handler _set_invalid_parameter_handler(_invalid_parameter_handler pNew);
+_invalid_parameter_handler _get_invalid_parameter_handler(void);
+
+// _set_thread_local_invalid_parameter_handler
+//
+// As in the CRT, a handler for the calling thread alone, which takes
+// precedence over the process-wide one while it is set.  Installing or
+// finding it touches only the thread's own storage.  Setting nullptr goes
+// back to the process-wide handler.
+
+_invalid_parameter_handler _set_thread_local_invalid_parameter_handler(_invalid_parameter_handler pNew);
+_invalid_parameter_handler _get_thread_local_invalid_parameter_handler(void);
+
+// _invalid_parameter
+//
+// Invokes the thread's handler, or else the process-wide one (or the
+// default).  The library calls this for every violation it detects; it's
+// exported so that code layered on top of the library can report its own
+// violations the same way.
+
+void _invalid_parameter(const wchar_t * expression,
+                        const wchar_t * function,
+                        const wchar_t * file,
+                        unsigned int    line,
+                        uintptr_t       pReserved);
+
+size_t  strnlen_s(const char * str, size_t numberOfElements);
+errno_t strcpy_s(char * dest, rsize_t destsz, const char * src);
+errno_t strcat_s(char * dest, rsize_t destsz, const char * src);
+
+int     _snprintf_s(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...);
+int     vsnprintf_s(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, va_list argptr);
+
+errno_t _makepath_s(char * path, size_t sizeInCharacters,
+                    const char * drive, const char * dir,
+                    const char * fname, const char * ext);
+errno_t _splitpath_s(const char * path,
+                     char * drive, size_t driveNumberOfElements,
+                     char * dir,   size_t dirNumberOfElements,
+                     char * fname, size_t nameNumberOfElements,
+                     char * ext,   size_t extNumberOfElements);
+
+// %s, %c and %[ each take the destination buffer followed by its size as an
+// rsize_t, so passing sizeof works unchanged on 64-bit targets.
+
+int     sscanf_s(const char * buffer, const char * format, ...);
+int     _snscanf_s(const char * input, size_t length, const char * format, ...);
+
+char *  gets_s(char * buffer, rsize_t sizeInCharacters);
+
+#ifdef __cplusplus
+}
+
+namespace SafeStrings
+{
+    // CopyBounded
+    //
+    // The single-pass measure-and-copy behind strcpy_s, without the policy.
+    // If src and its terminator fit in destsz bytes they are copied and the
+    // length of src is returned.  Otherwise the result is destsz, dest holds
+    // an unterminated prefix, and nothing is reported - the caller decides
+    // what an overflow means.  dest and src must be valid and destsz > 0.
+
+    size_t CopyBounded(char * dest, rsize_t destsz, const char * src);
+
+    namespace Internal
+    {
+        // ConstraintViolation
+        //
+        // Sets errno to err, charges the SAFE_COUNTED call in progress (see
+        // CallSites.h), calls the installed invalid parameter handler and
+        // returns err so that callers can write "return SAFE_RAISE(...)".
+        // Every violation, in the library or in its header-only types, goes
+        // through here.  Kept out of line and cold so the checks compile
+        // down to a single branch.
+
+        [[gnu::cold, gnu::noinline]]
+        errno_t ConstraintViolation(errno_t         err,
+                                    const wchar_t * expression,
+                                    const wchar_t * function,
+                                    const wchar_t * file,
+                                    unsigned int    line);
+
+        // VSnprintfStatus
+        //
+        // vsnprintf_s, handing back what happened rather than leaving the
+        // caller to work it out from -1 and the buffer: 0, STRUNCATE if a
+        // truncating count cut the output short, or the errno value of the
+        // violation it raised.  *pcchWritten is the length left in buffer.
+
+        errno_t VSnprintfStatus(char * buffer, size_t sizeOfBuffer, size_t count,
+                                size_t * pcchWritten, const char * format, va_list argptr);
+    }
+}
+
+#include "InlineKernels.h"
+
+#include <type_traits>
+
+// Array forms
+//
+// As the CRT offers in C++, each function that writes to a buffer also takes
+// the buffer as an array, and infers its size rather than being handed
+// sizeof by hand.  A pointer doesn't bind to an array reference, and the
+// forms that would otherwise take one are deleted, so the size can't
+// silently become sizeof(char *).
+//
+// strnlen_s, strcpy_s and strcat_s run inline with the size as a constant:
+// up to 64 bytes the copy is a few unrolled block tests with no loop.  They
+// only call the library when a check fails, to report it exactly as the
+// pointer forms do.
+
+template <typename T>
+concept SafeStringsPointer = std::is_pointer_v<std::remove_cvref_t<T>>;
+
+template <SafeStringsPointer T> size_t  strnlen_s(T && str) = delete;
+template <SafeStringsPointer T> errno_t strcpy_s(T && dest, const char * src) = delete;
+template <SafeStringsPointer T> errno_t strcat_s(T && dest, const char * src) = delete;
+template <SafeStringsPointer T> char *  gets_s(T && buffer) = delete;
+template <SafeStringsPointer T> errno_t _makepath_s(T && path,
+                                                    const char * drive, const char * dir,
+                                                    const char * fname, const char * ext) = delete;
+
+template <size_t size>
+inline size_t strnlen_s(const char (&str)[size])
+{
+    return SafeStrings::Internal::FixedLength<size>(str);
+}
+
+template <size_t size>
+inline errno_t strcpy_s(char (&dest)[size], const char * src)
+{
+    if (__builtin_expect(src != nullptr && SafeStrings::Internal::FixedCopy<size>(dest, src) < size, 1))
+        return 0;
+
+    return strcpy_s(dest, size, src);
+}
+
+template <size_t size>
+inline errno_t strcat_s(char (&dest)[size], const char * src)
+{
+    if (__builtin_expect(src != nullptr, 1))
+    {
+        size_t cchDest = SafeStrings::Internal::FixedLength<size>(dest);
+        if (__builtin_expect(cchDest < size, 1))
+        {
+            if (__builtin_expect(SafeStrings::Internal::InlineCopy(dest + cchDest, src, size - cchDest) < size - cchDest, 1))
+                return 0;
+
+            // Put back the terminator the failed copy wrote over, so the
+            // library sees the string it was given
+
+            dest[cchDest] = '\0';
+        }
+    }
+
+    return strcat_s(dest, size, src);
+}
+
+// _snprintf_s
+//
+// The array form is what lets the demo write
+// _snprintf_s(szBuffer, sizeof szBuffer, "%s", ...) without a buffer size.
+
+template <size_t size>
+inline int _snprintf_s(char (&buffer)[size], size_t count, const char * format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int result = vsnprintf_s(buffer, size, count, format, args);
+    va_end(args);
+    return result;
+}
+
+template <size_t size>
+inline int vsnprintf_s(char (&buffer)[size], size_t count, const char * format, va_list argptr)
+{
+    return vsnprintf_s(buffer, size, count, format, argptr);
+}
+
+template <size_t size>
+inline errno_t _makepath_s(char (&path)[size],
+                           const char * drive, const char * dir,
+                           const char * fname, const char * ext)
+{
+    return _makepath_s(path, size, drive, dir, fname, ext);
+}
+
+template <size_t driveSize, size_t dirSize, size_t nameSize, size_t extSize>
+inline errno_t _splitpath_s(const char * path,
+                            char (&drive)[driveSize], char (&dir)[dirSize],
+                            char (&fname)[nameSize],  char (&ext)[extSize])
+{
+    return _splitpath_s(path, drive, driveSize, dir, dirSize, fname, nameSize, ext, extSize);
+}
+
+// _snscanf_s
+//
+// Here it's the input whose size is inferred; the sizes that follow each
+// %s, %c and %[ are still passed by hand (SafeStrings::Scan in ScanPlan.h
+// checks those at compile time).
+
+template <size_t size, typename... Args>
+inline int _snscanf_s(const char (&input)[size], const char * format, Args... args)
+{
+    return _snscanf_s(input, size, format, args...);
+}
+
+template <size_t size>
+inline char * gets_s(char (&buffer)[size])
+{
+    return gets_s(buffer, size);
+}
+
+#endif
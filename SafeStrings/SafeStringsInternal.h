@@ -0,0 +1,64 @@
+//--------------------------------------------------------------------------------
+// SafeStringsInternal.h - Shared plumbing for the SafeStrings implementation
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Not part of the public interface.  Every translation unit in the library
+// reports constraint violations through the helpers declared here so that
+// the errno/handler/return sequence is identical everywhere.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <errno.h>
+
+#define SAFE_LIKELY(x)   __builtin_expect(!!(x), 1)
+#define SAFE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace SafeStrings::Internal
+{
+    // ConstraintViolation, declared in SafeStrings.h so the header-only
+    // types can raise through it too, is what SAFE_RAISE calls.
+
+    // NoteViolation, NoteFailureSizes, NoteTruncation
+    //
+    // Charge the SAFE_COUNTED call in progress on this thread, if any (see
+    // CallSites.h).  ConstraintViolation notes every violation itself;
+    // failure paths that know the sizes involved note them before raising,
+    // and truncations that raise nothing note themselves.
+
+    [[gnu::cold, gnu::noinline]] void NoteViolation();
+    [[gnu::cold, gnu::noinline]] void NoteFailureSizes(size_t cbRequested, size_t cbAvailable);
+    [[gnu::cold, gnu::noinline]] void NoteTruncation(size_t cbRequested, size_t cbAvailable);
+}
+
+// SAFE_RAISE
+//
+// expression and function are narrow string literals; they are widened here
+// to match the _invalid_parameter_handler signature.
+
+#define SAFE_RAISE(err, expression, function)                                 \
+    SafeStrings::Internal::ConstraintViolation((err), L"" expression,        \
+                                               L"" function,                 \
+                                               L"" __FILE__, __LINE__)
+
+// SAFE_VALIDATE_STRING
+//
+// The destination check shared by every function that writes a string:
+// dest must be non-null and destsz must be in (0, RSIZE_MAX].
+
+#define SAFE_VALIDATE_STRING(dest, destsz, function, retexpr)                 \
+    do                                                                        \
+    {                                                                         \
+        if (SAFE_UNLIKELY((dest) == nullptr ||                                \
+                          (destsz) == 0 || (destsz) > RSIZE_MAX))             \
+        {                                                                     \
+            SAFE_RAISE(EINVAL, #dest " != nullptr && 0 < " #destsz            \
+                               " <= RSIZE_MAX", function);                    \
+            return (retexpr);                                                 \
+        }                                                                     \
+    } while (0)
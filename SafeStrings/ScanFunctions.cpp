@@ -0,0 +1,419 @@
+//--------------------------------------------------------------------------------
+// ScanFunctions.cpp - sscanf_s, _snscanf_s
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// glibc's sscanf has no idea that %s, %c and %[ should be followed by a
+// buffer size, so the scanner is implemented here from scratch.  It works on
+// a (pointer, length) window so that _snscanf_s never reads past the count
+// it was given, whether or not the input is terminated.
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+    enum class LengthModifier
+    {
+        None, hh, h, l, ll, j, z, t, L
+    };
+
+    inline bool IsSpace(char ch)
+    {
+        return ch == ' ' || (ch >= '\t' && ch <= '\r');
+    }
+
+    inline bool IsDigit(char ch)
+    {
+        return ch >= '0' && ch <= '9';
+    }
+
+    inline void SkipSpace(const char ** pp, const char * pEnd)
+    {
+        while (*pp < pEnd && IsSpace(**pp))
+            ++*pp;
+    }
+
+    // StoreSigned / StoreUnsigned
+    //
+    // Narrow a converted value to whatever the length modifier says the
+    // caller's pointer refers to.
+
+    void StoreSigned(va_list * pArgs, LengthModifier length, long long value)
+    {
+        switch (length)
+        {
+            case LengthModifier::hh: *va_arg(*pArgs, signed char *) = (signed char) value; break;
+            case LengthModifier::h:  *va_arg(*pArgs, short *)       = (short) value;       break;
+            case LengthModifier::l:  *va_arg(*pArgs, long *)        = (long) value;        break;
+            case LengthModifier::ll: *va_arg(*pArgs, long long *)   = value;               break;
+            case LengthModifier::j:  *va_arg(*pArgs, intmax_t *)    = (intmax_t) value;    break;
+            case LengthModifier::z:  *va_arg(*pArgs, size_t *)      = (size_t) value;      break;
+            case LengthModifier::t:  *va_arg(*pArgs, ptrdiff_t *)   = (ptrdiff_t) value;   break;
+            default:                 *va_arg(*pArgs, int *)         = (int) value;         break;
+        }
+    }
+
+    void StoreUnsigned(va_list * pArgs, LengthModifier length, unsigned long long value)
+    {
+        switch (length)
+        {
+            case LengthModifier::hh: *va_arg(*pArgs, unsigned char *)      = (unsigned char) value;  break;
+            case LengthModifier::h:  *va_arg(*pArgs, unsigned short *)     = (unsigned short) value; break;
+            case LengthModifier::l:  *va_arg(*pArgs, unsigned long *)      = (unsigned long) value;  break;
+            case LengthModifier::ll: *va_arg(*pArgs, unsigned long long *) = value;                  break;
+            case LengthModifier::j:  *va_arg(*pArgs, uintmax_t *)          = (uintmax_t) value;      break;
+            case LengthModifier::z:  *va_arg(*pArgs, size_t *)             = (size_t) value;         break;
+            case LengthModifier::t:  *va_arg(*pArgs, ptrdiff_t *)          = (ptrdiff_t) value;      break;
+            default:                 *va_arg(*pArgs, unsigned int *)       = (unsigned int) value;   break;
+        }
+    }
+
+    // StoreString
+    //
+    // Hands a scanned %s, %c or %[ field to the caller's buffer, whose size
+    // follows it in the argument list.  Returns false if the field (plus the
+    // terminator, unless fTerminate is false for %c) doesn't fit, in which
+    // case the buffer is emptied and the scan stops.
+
+    bool StoreString(va_list * pArgs, const char * src, size_t cch, bool fTerminate)
+    {
+        char *  dest   = va_arg(*pArgs, char *);
+        rsize_t destsz = va_arg(*pArgs, rsize_t);
+
+        if (SAFE_UNLIKELY(dest == nullptr))
+        {
+            SAFE_RAISE(EINVAL, "buffer != nullptr", "sscanf_s");
+            return false;
+        }
+
+        if (SAFE_UNLIKELY(cch + (fTerminate ? 1 : 0) > destsz))
+        {
+            if (destsz > 0)
+                dest[0] = '\0';
+            return false;
+        }
+
+        memcpy(dest, src, cch);
+        if (fTerminate)
+            dest[cch] = '\0';
+        return true;
+    }
+
+    // ParseScanSet
+    //
+    // Reads a %[...] set starting just past the '[' into a 256 entry table.
+    // A leading '^' inverts the set and a ']' immediately after the '[' (or
+    // '^') is a member rather than the terminator.  Returns the format
+    // position after the closing ']', or nullptr if there isn't one.
+
+    const char * ParseScanSet(const char * f, bool (&fInSet)[256])
+    {
+        bool fNegate = (*f == '^');
+        if (fNegate)
+            ++f;
+
+        bool fMember[256] = {};
+        const char * pFirst = f;
+        for (; *f && (*f != ']' || f == pFirst); ++f)
+        {
+            unsigned char chLow = (unsigned char) *f;
+            if (f[1] == '-' && f[2] != ']' && f[2] != '\0' && (unsigned char) f[2] >= chLow)
+            {
+                for (unsigned ch = chLow; ch <= (unsigned char) f[2]; ++ch)
+                    fMember[ch] = true;
+                f += 2;
+            }
+            else
+            {
+                fMember[chLow] = true;
+            }
+        }
+
+        if (*f != ']')
+            return nullptr;
+
+        for (unsigned ch = 0; ch < 256; ++ch)
+            fInSet[ch] = fMember[ch] != fNegate;
+
+        return f + 1;
+    }
+
+    // VScan
+    //
+    // The scanner shared by sscanf_s and _snscanf_s.  Returns the number of
+    // fields assigned, or EOF if the input ran out before the first
+    // conversion completed.
+
+    int VScan(const char * input, size_t length, const char * format, va_list argptr)
+    {
+        va_list args;
+        va_copy(args, argptr);
+
+        const char * p          = input;
+        const char * pEnd       = input + length;
+        int          cAssigned  = 0;
+        bool         fConverted = false;
+        bool         fEOF       = false;
+
+        for (const char * f = format; *f; )
+        {
+            // Whitespace in the format matches any amount (including none)
+
+            if (IsSpace(*f))
+            {
+                while (IsSpace(*f))
+                    ++f;
+                SkipSpace(&p, pEnd);
+                continue;
+            }
+
+            // Ordinary characters, and %%, must match exactly
+
+            if (*f != '%' || f[1] == '%')
+            {
+                if (*f == '%')
+                {
+                    ++f;
+                    SkipSpace(&p, pEnd);
+                }
+
+                if (p == pEnd)
+                {
+                    fEOF = true;
+                    break;
+                }
+
+                if (*p != *f)
+                    break;
+
+                ++p;
+                ++f;
+                continue;
+            }
+
+            ++f;
+
+            bool fSuppress = (*f == '*');
+            if (fSuppress)
+                ++f;
+
+            size_t cchWidth = 0;
+            while (IsDigit(*f))
+                cchWidth = cchWidth * 10 + (*f++ - '0');
+
+            LengthModifier lengthMod = LengthModifier::None;
+            switch (*f)
+            {
+                case 'h': lengthMod = (f[1] == 'h') ? (++f, LengthModifier::hh) : LengthModifier::h; ++f; break;
+                case 'l': lengthMod = (f[1] == 'l') ? (++f, LengthModifier::ll) : LengthModifier::l; ++f; break;
+                case 'j': lengthMod = LengthModifier::j; ++f; break;
+                case 'z': lengthMod = LengthModifier::z; ++f; break;
+                case 't': lengthMod = LengthModifier::t; ++f; break;
+                case 'L': lengthMod = LengthModifier::L; ++f; break;
+            }
+
+            char chConversion = *f++;
+
+            if (chConversion != 'c' && chConversion != '[' && chConversion != 'n')
+                SkipSpace(&p, pEnd);
+
+            if (chConversion == 'n')
+            {
+                if (!fSuppress)
+                    StoreSigned(&args, lengthMod, p - input);
+                continue;
+            }
+
+            if (p == pEnd)
+            {
+                fEOF = true;
+                break;
+            }
+
+            size_t cchAvail = pEnd - p;
+            size_t cchMax   = (cchWidth != 0 && cchWidth < cchAvail) ? cchWidth : cchAvail;
+            bool   fMatched = true;
+
+            switch (chConversion)
+            {
+                case 's':
+                {
+                    const char * pStart = p;
+                    while (p < pStart + cchMax && !IsSpace(*p))
+                        ++p;
+                    if (!fSuppress)
+                        fMatched = StoreString(&args, pStart, p - pStart, true);
+                    break;
+                }
+
+                case 'c':
+                {
+                    size_t cch = cchWidth ? cchWidth : 1;
+                    if (cch > cchAvail)
+                    {
+                        fEOF = true;
+                        fMatched = false;
+                        break;
+                    }
+                    if (!fSuppress)
+                        fMatched = StoreString(&args, p, cch, false);
+                    p += cch;
+                    break;
+                }
+
+                case '[':
+                {
+                    bool fInSet[256];
+                    f = ParseScanSet(f, fInSet);
+                    if (f == nullptr)
+                    {
+                        SAFE_RAISE(EINVAL, "(valid format specifier)", "sscanf_s");
+                        va_end(args);
+                        return EOF;
+                    }
+
+                    const char * pStart = p;
+                    while (p < pStart + cchMax && fInSet[(unsigned char) *p])
+                        ++p;
+                    fMatched = (p != pStart);
+                    if (fMatched && !fSuppress)
+                        fMatched = StoreString(&args, pStart, p - pStart, true);
+                    break;
+                }
+
+                case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'p':
+                {
+                    // strto* needs a terminated string, and must not be allowed
+                    // to wander past the width or the end of the window
+
+                    char szNumber[128];
+                    size_t cch = cchMax < sizeof szNumber - 1 ? cchMax : sizeof szNumber - 1;
+                    memcpy(szNumber, p, cch);
+                    szNumber[cch] = '\0';
+
+                    int base = 10;
+                    switch (chConversion)
+                    {
+                        case 'i': base = 0;  break;
+                        case 'o': base = 8;  break;
+                        case 'x': case 'X': case 'p': base = 16; break;
+                    }
+
+                    char * pStop = szNumber;
+                    if (chConversion == 'd' || chConversion == 'i')
+                    {
+                        long long value = strtoll(szNumber, &pStop, base);
+                        if (pStop != szNumber && !fSuppress)
+                            StoreSigned(&args, lengthMod, value);
+                    }
+                    else
+                    {
+                        unsigned long long value = strtoull(szNumber, &pStop, base);
+                        if (pStop != szNumber && !fSuppress)
+                        {
+                            if (chConversion == 'p')
+                                *va_arg(args, void **) = (void *)(uintptr_t) value;
+                            else
+                                StoreUnsigned(&args, lengthMod, value);
+                        }
+                    }
+
+                    fMatched = (pStop != szNumber);
+                    p += pStop - szNumber;
+                    break;
+                }
+
+                case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                {
+                    char szNumber[128];
+                    size_t cch = cchMax < sizeof szNumber - 1 ? cchMax : sizeof szNumber - 1;
+                    memcpy(szNumber, p, cch);
+                    szNumber[cch] = '\0';
+
+                    char * pStop = szNumber;
+                    if (lengthMod == LengthModifier::L)
+                    {
+                        long double value = strtold(szNumber, &pStop);
+                        if (pStop != szNumber && !fSuppress)
+                            *va_arg(args, long double *) = value;
+                    }
+                    else if (lengthMod == LengthModifier::l)
+                    {
+                        double value = strtod(szNumber, &pStop);
+                        if (pStop != szNumber && !fSuppress)
+                            *va_arg(args, double *) = value;
+                    }
+                    else
+                    {
+                        float value = strtof(szNumber, &pStop);
+                        if (pStop != szNumber && !fSuppress)
+                            *va_arg(args, float *) = value;
+                    }
+
+                    fMatched = (pStop != szNumber);
+                    p += pStop - szNumber;
+                    break;
+                }
+
+                default:
+                    SAFE_RAISE(EINVAL, "(valid format specifier)", "sscanf_s");
+                    va_end(args);
+                    return EOF;
+            }
+
+            if (!fMatched)
+                break;
+
+            fConverted = true;
+            if (!fSuppress)
+                ++cAssigned;
+        }
+
+        va_end(args);
+        return (fEOF && !fConverted) ? EOF : cAssigned;
+    }
+}
+
+// sscanf_s
+//
+// Scans a terminated string.
+
+extern "C" int sscanf_s(const char * buffer, const char * format, ...)
+{
+    if (SAFE_UNLIKELY(buffer == nullptr || format == nullptr))
+    {
+        SAFE_RAISE(EINVAL, "buffer != nullptr && format != nullptr", "sscanf_s");
+        return EOF;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int result = VScan(buffer, strlen(buffer), format, args);
+    va_end(args);
+    return result;
+}
+
+// _snscanf_s
+//
+// Scans at most length characters of input, stopping early at a terminator.
+
+extern "C" int _snscanf_s(const char * input, size_t length, const char * format, ...)
+{
+    if (SAFE_UNLIKELY(input == nullptr || format == nullptr))
+    {
+        SAFE_RAISE(EINVAL, "input != nullptr && format != nullptr", "_snscanf_s");
+        return EOF;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int result = VScan(input, strnlen(input, length), format, args);
+    va_end(args);
+    return result;
+}
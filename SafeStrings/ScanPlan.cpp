@@ -0,0 +1,274 @@
+//--------------------------------------------------------------------------------
+// ScanPlan.cpp - ScanPlan, and the out-of-line pieces of Scan
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "ScanPlan.h"
+
+#include <stdlib.h>
+
+using namespace SafeStrings::Internal;
+using SafeStrings::ScanCheck::Length;
+using SafeStrings::ScanCheck::Step;
+using SafeStrings::ScanCheck::StepKind;
+
+namespace
+{
+    // MatchFloatWith
+    //
+    // The scratch copy _snscanf_s makes of a numeric field, so strtod can't
+    // read past the width or the end of the input.
+
+    template <typename T, typename Convert>
+    bool MatchFloatWith(const char *& p, const char * pLimit, T & value, Convert convert)
+    {
+        char   szNumber[128];
+        size_t cch = (size_t)(pLimit - p) < sizeof szNumber - 1 ? (size_t)(pLimit - p) : sizeof szNumber - 1;
+        memcpy(szNumber, p, cch);
+        szNumber[cch] = '\0';
+
+        char * pStop = szNumber;
+        value = convert(szNumber, &pStop);
+        if (pStop == szNumber)
+            return false;
+
+        p += pStop - szNumber;
+        return true;
+    }
+
+    // StoreInteger
+    //
+    // StoreSigned and StoreUnsigned from ScanFunctions.cpp, in one.
+
+    template <typename T>
+    void StoreInteger(va_list & args, Length length, T value)
+    {
+        switch (length)
+        {
+            case Length::hh: *va_arg(args, char *)      = (char) value;      break;
+            case Length::h:  *va_arg(args, short *)     = (short) value;     break;
+            case Length::l:  *va_arg(args, long *)      = (long) value;      break;
+            case Length::ll: *va_arg(args, long long *) = (long long) value; break;
+            case Length::j:  *va_arg(args, intmax_t *)  = (intmax_t) value;  break;
+            case Length::z:  *va_arg(args, size_t *)    = (size_t) value;    break;
+            case Length::t:  *va_arg(args, ptrdiff_t *) = (ptrdiff_t) value; break;
+            default:         *va_arg(args, int *)       = (int) value;       break;
+        }
+    }
+}
+
+bool SafeStrings::Internal::MatchFloatSlow(const char *& p, const char * pLimit, float & value)
+{
+    return MatchFloatWith(p, pLimit, value, strtof);
+}
+
+bool SafeStrings::Internal::MatchFloatSlow(const char *& p, const char * pLimit, double & value)
+{
+    return MatchFloatWith(p, pLimit, value, strtod);
+}
+
+bool SafeStrings::Internal::MatchFloatSlow(const char *& p, const char * pLimit, long double & value)
+{
+    return MatchFloatWith(p, pLimit, value, strtold);
+}
+
+bool SafeStrings::Internal::ScanBufferViolation()
+{
+    SAFE_RAISE(EINVAL, "buffer != nullptr", "Scan");
+    return false;
+}
+
+int SafeStrings::Internal::ScanInputViolation(const wchar_t * function)
+{
+    ConstraintViolation(EINVAL, L"input != nullptr", function, L"" __FILE__, __LINE__);
+    return EOF;
+}
+
+SafeStrings::ScanPlan::ScanPlan(const char * pattern)
+{
+    _fValid = (pattern != nullptr) && ScanCheck::Compile(pattern, _steps) == ScanCheck::CompileResult::Ok;
+}
+
+// VScan
+//
+// The same steps as Scan runs, but taken from a vector, with the argument
+// types read off each step as VScan in ScanFunctions.cpp does.
+
+int SafeStrings::ScanPlan::VScan(const char * input, size_t length, va_list argptr) const
+{
+    if (SAFE_UNLIKELY(input == nullptr))
+        return ScanInputViolation(L"ScanPlan::Scan");
+
+    if (SAFE_UNLIKELY(!_fValid))
+    {
+        SAFE_RAISE(EINVAL, "(valid format specifier)", "ScanPlan::Scan");
+        return EOF;
+    }
+
+    va_list args;
+    va_copy(args, argptr);
+
+    ScanState state { input, input, input + strnlen(input, length) };
+
+    for (const Step & step : _steps)
+    {
+        if (step.kind == StepKind::Space)
+        {
+            SkipScanSpace(state.p, state.pEnd);
+            continue;
+        }
+
+        if (step.kind == StepKind::Literal)
+        {
+            if (step.fSkipSpace)
+                SkipScanSpace(state.p, state.pEnd);
+            if (state.p == state.pEnd)
+            {
+                state.fEOF = true;
+                break;
+            }
+            if (*state.p != step.chLiteral)
+                break;
+            ++state.p;
+            continue;
+        }
+
+        if (step.kind == StepKind::Count)
+        {
+            if (!step.fSuppress)
+                StoreInteger(args, step.length, (long long)(state.p - input));
+            continue;
+        }
+
+        if (step.kind != StepKind::Chars && step.kind != StepKind::Set)
+            SkipScanSpace(state.p, state.pEnd);
+
+        if (state.p == state.pEnd)
+        {
+            state.fEOF = true;
+            break;
+        }
+
+        size_t       cchAvail = state.pEnd - state.p;
+        const char * pLimit   = state.p + ((step.cchWidth != 0 && step.cchWidth < cchAvail) ? step.cchWidth : cchAvail);
+        bool         fMatched = true;
+
+        switch (step.kind)
+        {
+            case StepKind::Signed:
+            {
+                long long value;
+                fMatched = MatchSigned(state.p, pLimit, step.base, value);
+                if (fMatched && !step.fSuppress)
+                    StoreInteger(args, step.length, value);
+                break;
+            }
+
+            case StepKind::Unsigned:
+            case StepKind::Pointer:
+            {
+                unsigned long long value;
+                fMatched = MatchUnsigned(state.p, pLimit, step.base, value);
+                if (fMatched && !step.fSuppress)
+                {
+                    if (step.kind == StepKind::Pointer)
+                        *va_arg(args, void **) = (void *)(uintptr_t) value;
+                    else
+                        StoreInteger(args, step.length, value);
+                }
+                break;
+            }
+
+            case StepKind::Float:
+            {
+                if (step.length == Length::L)
+                {
+                    long double value;
+                    fMatched = MatchFloat(state.p, pLimit, value);
+                    if (fMatched && !step.fSuppress)
+                        *va_arg(args, long double *) = value;
+                }
+                else if (step.length == Length::l)
+                {
+                    double value;
+                    fMatched = MatchFloat(state.p, pLimit, value);
+                    if (fMatched && !step.fSuppress)
+                        *va_arg(args, double *) = value;
+                }
+                else
+                {
+                    float value;
+                    fMatched = MatchFloat(state.p, pLimit, value);
+                    if (fMatched && !step.fSuppress)
+                        *va_arg(args, float *) = value;
+                }
+                break;
+            }
+
+            case StepKind::Chars:
+            {
+                size_t cch = step.cchWidth ? step.cchWidth : 1;
+                if (cch > cchAvail)
+                {
+                    state.fEOF = true;
+                    fMatched   = false;
+                    break;
+                }
+                if (!step.fSuppress)
+                {
+                    char *  dest   = va_arg(args, char *);
+                    rsize_t destsz = va_arg(args, rsize_t);
+                    fMatched = StoreScanField(dest, destsz, state.p, cch, false);
+                }
+                state.p += cch;
+                break;
+            }
+
+            default:
+            {
+                const char * pStart = state.p;
+                if (step.kind == StepKind::String)
+                {
+                    state.p = FindSpace(state.p, pLimit);
+                }
+                else
+                {
+                    while (state.p < pLimit && step.InSet(*state.p))
+                        ++state.p;
+                    fMatched = (state.p != pStart);
+                }
+
+                if (fMatched && !step.fSuppress)
+                {
+                    char *  dest   = va_arg(args, char *);
+                    rsize_t destsz = va_arg(args, rsize_t);
+                    fMatched = StoreScanField(dest, destsz, pStart, state.p - pStart, true);
+                }
+                break;
+            }
+        }
+
+        if (!fMatched)
+            break;
+
+        state.fConverted = true;
+        if (!step.fSuppress)
+            state.cAssigned++;
+    }
+
+    va_end(args);
+    return state.Result();
+}
+
+int SafeStrings::ScanPlan::Scan(const char * input, size_t length, ...) const
+{
+    va_list args;
+    va_start(args, length);
+    int result = VScan(input, length, args);
+    va_end(args);
+    return result;
+}
@@ -0,0 +1,828 @@
+//--------------------------------------------------------------------------------
+// ScanPlan.h - sscanf_s patterns compiled once into a matcher
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// _snscanf_s walks its format on every call, and converts every number by
+// copying it to a scratch buffer for strtoll.  For fixed-format records
+// that is most of the cost.  Scan takes the pattern as a template argument
+// instead, so the compiler parses it, checks each argument against its
+// conversion, and emits one step per directive with nothing left to decide:
+//
+//    int  value;
+//    char szName[16];
+//    unsigned flags;
+//    int cFields = SafeStrings::Scan<"%d %s %x">(szRecord, sizeof szRecord,
+//                                                &value, szName, sizeof szName, &flags);
+//
+// A pattern that is only known at runtime can still be parsed once, into a
+// ScanPlan, and scanned from as often as needed.
+//
+// Either way the rules are _snscanf_s's: the same directives and length
+// modifiers, the input ending at length characters or a terminator, the
+// same buffer-size checks for %s, %c and %[ (a field that doesn't fit
+// empties the buffer and ends the scan), and the same result - the number
+// of fields assigned, or EOF if the input ran out before the first.
+// Numbers are parsed in place with std::from_chars, bounded by the field
+// width, and saturate on overflow as strtoll and strtoull do.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <array>
+#include <charconv>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace SafeStrings
+{
+    namespace ScanCheck
+    {
+        // As in FormatCheck, reaching one of these during the compile-time
+        // parse is what turns a bad pattern into an error naming the problem.
+
+        void InvalidConversionSpecifier();
+        void UnterminatedScanSet();
+        void ArgumentTypeDoesNotMatchConversion();
+        void TooFewArgumentsForPattern();
+        void TooManyArgumentsForPattern();
+
+        enum class StepKind : uint8_t
+        {
+            Space,          // Whitespace in the pattern: skip any amount
+            Literal,        // A character that must match (fSkipSpace for %%)
+            Signed,         // %d %i
+            Unsigned,       // %u %o %x %X
+            Pointer,        // %p
+            Float,          // %e %f %g %a and capitals
+            String,         // %s
+            Chars,          // %c
+            Set,            // %[
+            Count,          // %n
+        };
+
+        enum class Length : uint8_t
+        {
+            None, hh, h, l, ll, j, z, t, L
+        };
+
+        struct Step
+        {
+            StepKind kind       = StepKind::Space;
+            Length   length     = Length::None;
+            uint8_t  base       = 10;           // 0 for %i
+            bool     fSuppress  = false;
+            bool     fSkipSpace = false;
+            char     chLiteral  = 0;
+            size_t   cchWidth   = 0;            // 0 for none
+            uint64_t rgSet[4]   = { };          // %[ members, a bit per byte value
+
+            constexpr bool InSet(char ch) const
+            {
+                unsigned char b = (unsigned char) ch;
+                return (rgSet[b >> 6] >> (b & 63)) & 1;
+            }
+        };
+
+        enum class CompileResult
+        {
+            Ok,
+            InvalidConversion,
+            UnterminatedSet,
+        };
+
+        constexpr bool IsSpace(char ch)
+        {
+            return ch == ' ' || (ch >= '\t' && ch <= '\r');
+        }
+
+        constexpr bool IsDigit(char ch)
+        {
+            return ch >= '0' && ch <= '9';
+        }
+
+        // Compile
+        //
+        // The directive parse of VScan, done once.  constexpr so that Scan
+        // can run it at compile time; ScanPlan runs the same code at runtime.
+
+        constexpr CompileResult Compile(const char * pattern, std::vector<Step> & steps)
+        {
+            for (const char * f = pattern; *f; )
+            {
+                Step step;
+
+                if (IsSpace(*f))
+                {
+                    while (IsSpace(*f))
+                        ++f;
+                    step.kind = StepKind::Space;
+                    steps.push_back(step);
+                    continue;
+                }
+
+                if (*f != '%' || f[1] == '%')
+                {
+                    step.kind       = StepKind::Literal;
+                    step.fSkipSpace = (*f == '%');
+                    f += step.fSkipSpace ? 2 : 1;
+                    step.chLiteral  = f[-1];
+                    steps.push_back(step);
+                    continue;
+                }
+
+                ++f;
+                step.fSuppress = (*f == '*');
+                if (step.fSuppress)
+                    ++f;
+
+                while (IsDigit(*f))
+                    step.cchWidth = step.cchWidth * 10 + (*f++ - '0');
+
+                switch (*f)
+                {
+                    case 'h': step.length = (f[1] == 'h') ? (++f, Length::hh) : Length::h; ++f; break;
+                    case 'l': step.length = (f[1] == 'l') ? (++f, Length::ll) : Length::l; ++f; break;
+                    case 'j': step.length = Length::j; ++f; break;
+                    case 'z': step.length = Length::z; ++f; break;
+                    case 't': step.length = Length::t; ++f; break;
+                    case 'L': step.length = Length::L; ++f; break;
+                }
+
+                switch (*f++)
+                {
+                    case 'd':           step.kind = StepKind::Signed;                   break;
+                    case 'i':           step.kind = StepKind::Signed;   step.base = 0;  break;
+                    case 'u':           step.kind = StepKind::Unsigned;                 break;
+                    case 'o':           step.kind = StepKind::Unsigned; step.base = 8;  break;
+                    case 'x': case 'X': step.kind = StepKind::Unsigned; step.base = 16; break;
+                    case 'p':           step.kind = StepKind::Pointer;  step.base = 16; break;
+                    case 's':           step.kind = StepKind::String;                   break;
+                    case 'c':           step.kind = StepKind::Chars;                    break;
+                    case 'n':           step.kind = StepKind::Count;                    break;
+
+                    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                        step.kind = StepKind::Float;
+                        break;
+
+                    // ParseScanSet's rules: '^' inverts, a leading ']' is a
+                    // member, and a-b is a range when b isn't below a
+
+                    case '[':
+                    {
+                        step.kind = StepKind::Set;
+                        bool fNegate = (*f == '^');
+                        if (fNegate)
+                            ++f;
+
+                        uint64_t rgMember[4] = { };
+                        const char * pFirst = f;
+                        for (; *f && (*f != ']' || f == pFirst); ++f)
+                        {
+                            unsigned chLow  = (unsigned char) *f;
+                            unsigned chHigh = chLow;
+                            if (f[1] == '-' && f[2] != ']' && f[2] != '\0' && (unsigned char) f[2] >= chLow)
+                            {
+                                chHigh = (unsigned char) f[2];
+                                f += 2;
+                            }
+                            for (unsigned ch = chLow; ch <= chHigh; ++ch)
+                                rgMember[ch >> 6] |= (uint64_t) 1 << (ch & 63);
+                        }
+
+                        if (*f != ']')
+                            return CompileResult::UnterminatedSet;
+                        ++f;
+
+                        for (int i = 0; i < 4; i++)
+                            step.rgSet[i] = fNegate ? ~rgMember[i] : rgMember[i];
+                        break;
+                    }
+
+                    default:
+                        return CompileResult::InvalidConversion;
+                }
+
+                steps.push_back(step);
+            }
+
+            return CompileResult::Ok;
+        }
+
+        // Number of arguments a step consumes: a pointer, plus a size for
+        // the string conversions, and nothing when suppressed
+
+        constexpr size_t ArgsForStep(const Step & step)
+        {
+            switch (step.kind)
+            {
+                case StepKind::Space:
+                case StepKind::Literal:
+                    return 0;
+                case StepKind::Count:
+                    return step.fSuppress ? 0 : 1;
+                case StepKind::String:
+                case StepKind::Chars:
+                case StepKind::Set:
+                    return step.fSuppress ? 0 : 2;
+                default:
+                    return step.fSuppress ? 0 : 1;
+            }
+        }
+
+        constexpr size_t IntegerSize(Length length)
+        {
+            switch (length)
+            {
+                case Length::hh: return sizeof(char);
+                case Length::h:  return sizeof(short);
+                case Length::l:  return sizeof(long);
+                case Length::ll: return sizeof(long long);
+                case Length::j:  return sizeof(intmax_t);
+                case Length::z:  return sizeof(size_t);
+                case Length::t:  return sizeof(ptrdiff_t);
+                default:         return sizeof(int);
+            }
+        }
+
+        // PatternText
+        //
+        // A string literal as a template argument.
+
+        template <size_t N>
+        struct PatternText
+        {
+            char sz[N];
+
+            consteval PatternText(const char (&pattern)[N])
+            {
+                for (size_t i = 0; i < N; i++)
+                    sz[i] = pattern[i];
+            }
+        };
+
+        // Compiled
+        //
+        // The steps of one pattern, and the index of the first argument each
+        // step uses, as constants.
+
+        template <PatternText Pattern>
+        struct Compiled
+        {
+            static constexpr std::vector<Step> StepsOf()
+            {
+                std::vector<Step> steps;
+                switch (Compile(Pattern.sz, steps))
+                {
+                    case CompileResult::InvalidConversion: InvalidConversionSpecifier(); break;
+                    case CompileResult::UnterminatedSet:   UnterminatedScanSet();        break;
+                    default:                                                              break;
+                }
+                return steps;
+            }
+
+            static constexpr size_t c_cSteps = StepsOf().size();
+
+            static consteval std::array<Step, c_cSteps> MakeSteps()
+            {
+                std::vector<Step>          steps = StepsOf();
+                std::array<Step, c_cSteps> rgSteps { };
+                for (size_t i = 0; i < c_cSteps; i++)
+                    rgSteps[i] = steps[i];
+                return rgSteps;
+            }
+
+            static consteval std::array<size_t, c_cSteps + 1> MakeArgIndexes()
+            {
+                std::array<size_t, c_cSteps + 1> rgiArg { };
+                for (size_t i = 0; i < c_cSteps; i++)
+                    rgiArg[i + 1] = rgiArg[i] + ArgsForStep(c_rgSteps[i]);
+                return rgiArg;
+            }
+
+            static constexpr std::array<Step, c_cSteps>       c_rgSteps = MakeSteps();
+            static constexpr std::array<size_t, c_cSteps + 1> c_rgiArg  = MakeArgIndexes();
+        };
+
+        // CheckArgs
+        //
+        // Each pointer's pointee must be what its conversion stores - an
+        // integer of the modifier's size, the float type for the modifier,
+        // void * for %p - and each buffer a char * followed by an integer.
+
+        template <typename C, typename... Args>
+        consteval bool CheckArgs()
+        {
+            constexpr size_t cArgs = sizeof...(Args);
+            if (C::c_rgiArg[C::c_cSteps] > cArgs)
+                TooFewArgumentsForPattern();
+            if (C::c_rgiArg[C::c_cSteps] < cArgs)
+                TooManyArgumentsForPattern();
+
+            struct ArgType
+            {
+                bool   fPointer;
+                bool   fIntegerPointee;
+                bool   fInteger;
+                bool   fCharPointer;
+                bool   fVoidPointerPointer;
+                size_t cbPointee;
+                int    iFloat;                  // 1 float, 2 double, 3 long double, 0 not a float pointer
+            };
+
+            auto Describe = []<typename T>() -> ArgType
+            {
+                using P = std::remove_pointer_t<T>;
+                return
+                {
+                    std::is_pointer_v<T>,
+                    std::is_pointer_v<T> && std::is_integral_v<P> && !std::is_same_v<P, bool>,
+                    std::is_integral_v<T>,
+                    std::is_same_v<T, char *>,
+                    std::is_same_v<T, void **>,
+                    std::is_pointer_v<T> && !std::is_void_v<P> ? sizeof(std::conditional_t<std::is_void_v<P>, char, P>) : 0,
+                    std::is_same_v<T, float *> ? 1 : std::is_same_v<T, double *> ? 2 : std::is_same_v<T, long double *> ? 3 : 0,
+                };
+            };
+
+            constexpr ArgType rgArgs[cArgs + 1] = { Describe.template operator()<Args>()..., { } };
+
+            for (size_t i = 0; i < C::c_cSteps; i++)
+            {
+                const Step & step = C::c_rgSteps[i];
+                if (ArgsForStep(step) == 0)
+                    continue;
+
+                const ArgType & arg = rgArgs[C::c_rgiArg[i]];
+                bool fOk = true;
+                switch (step.kind)
+                {
+                    case StepKind::Signed:
+                    case StepKind::Unsigned:
+                    case StepKind::Count:
+                        fOk = arg.fIntegerPointee && arg.cbPointee == IntegerSize(step.length);
+                        break;
+                    case StepKind::Pointer:
+                        fOk = arg.fVoidPointerPointer;
+                        break;
+                    case StepKind::Float:
+                        fOk = arg.iFloat == (step.length == Length::L ? 3 : step.length == Length::l ? 2 : 1);
+                        break;
+                    default:
+                        fOk = arg.fCharPointer && rgArgs[C::c_rgiArg[i] + 1].fInteger;
+                        break;
+                }
+                if (!fOk)
+                    ArgumentTypeDoesNotMatchConversion();
+            }
+            return true;
+        }
+    }
+
+    namespace Internal
+    {
+        using ScanCheck::IsDigit;
+        using ScanCheck::IsSpace;
+
+        inline void SkipScanSpace(const char *& p, const char * pEnd)
+        {
+            while (p < pEnd && IsSpace(*p))
+                ++p;
+        }
+
+        inline bool IsHexDigit(char ch)
+        {
+            return IsDigit(ch) || (unsigned char)((ch | 0x20) - 'a') < 6;
+        }
+
+        // FindSpace
+        //
+        // The end of a %s field: the first whitespace in [p, pLimit), or
+        // pLimit.  Eight bytes at a time while eight remain, flagging
+        // spaces and '\t' through '\r' with exact per-byte tests so the
+        // lowest flag is the first whitespace byte.
+
+        inline const char * FindSpace(const char * p, const char * pLimit)
+        {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            const uint64_t kLows  = 0x7f7f7f7f7f7f7f7full;
+            const uint64_t kHighs = 0x8080808080808080ull;
+            const uint64_t kOnes  = 0x0101010101010101ull;
+
+            for (; pLimit - p >= 8; p += 8)
+            {
+                uint64_t word;
+                memcpy(&word, p, 8);
+
+                uint64_t spaces = word ^ (kOnes * ' ');
+                spaces = ~(((spaces & kLows) + kLows) | spaces | kLows);
+                uint64_t controls = ((kOnes * (127 + 14)) - (word & kLows)) & ~word & ((word & kLows) + kOnes * (127 - 8)) & kHighs;
+
+                if (spaces | controls)
+                    return p + (__builtin_ctzll(spaces | controls) >> 3);
+            }
+#endif
+            while (p < pLimit && !IsSpace(*p))
+                ++p;
+            return p;
+        }
+
+        // MatchMagnitude
+        //
+        // The digits of an integer field in [p, pLimit), after its sign, the
+        // way strtoull reads them: an optional 0x for base 16 (only when a
+        // hex digit follows), base 0 deciding between 8, 10 and 16.  Leaves
+        // p past the digits and returns false if there were none.
+
+        inline bool MatchMagnitude(const char *& p, const char * pLimit, int base, unsigned long long & magnitude, bool & fOverflow)
+        {
+            const char * q = p;
+            if ((base == 16 || base == 0) && pLimit - q > 2 && q[0] == '0' && (q[1] | 0x20) == 'x' && IsHexDigit(q[2]))
+            {
+                q   += 2;
+                base = 16;
+            }
+            else if (base == 0)
+            {
+                base = (q < pLimit && *q == '0') ? 8 : 10;
+            }
+
+            // Decimal fields of up to 19 digits and hex fields of up to 16,
+            // nearly all of them, can't overflow and don't need from_chars'
+            // general loop
+
+            if (base == 10 || base == 16)
+            {
+                const size_t       cchSafe = (base == 10) ? 19 : 16;
+                const char *       pDigits = q;
+                const char *       pFast   = (size_t)(pLimit - q) > cchSafe ? q + cchSafe : pLimit;
+                unsigned long long value   = 0;
+                for (; q < pFast; ++q)
+                {
+                    unsigned digit = (unsigned char) *q - '0';
+                    if (base == 16 && digit > 9)
+                        digit = (((unsigned char) *q | 0x20) - 'a' < 6) ? ((unsigned char) *q | 0x20) - 'a' + 10 : 99;
+                    if (digit >= (unsigned) base)
+                        break;
+                    value = value * base + digit;
+                }
+
+                if (q == pFast && q < pLimit && (base == 10 ? IsDigit(*q) : IsHexDigit(*q)))
+                {
+                    q = pDigits;
+                }
+                else
+                {
+                    if (q == pDigits)
+                        return false;
+                    magnitude = value;
+                    fOverflow = false;
+                    p = q;
+                    return true;
+                }
+            }
+
+            std::from_chars_result result = std::from_chars(q, pLimit, magnitude, base);
+            if (result.ptr == q)
+                return false;
+
+            fOverflow = (result.ec == std::errc::result_out_of_range);
+            p = result.ptr;
+            return true;
+        }
+
+        inline bool MatchSigned(const char *& p, const char * pLimit, int base, long long & value)
+        {
+            const char * q = p;
+            bool fNegative = (q < pLimit && *q == '-');
+            if (q < pLimit && (*q == '-' || *q == '+'))
+                ++q;
+
+            unsigned long long magnitude = 0;
+            bool               fOverflow = false;
+            if (!MatchMagnitude(q, pLimit, base, magnitude, fOverflow))
+                return false;
+
+            // strtoll saturates
+
+            if (fNegative)
+                value = (fOverflow || magnitude > (unsigned long long) LLONG_MAX + 1) ? LLONG_MIN : (long long)(0 - magnitude);
+            else
+                value = (fOverflow || magnitude > (unsigned long long) LLONG_MAX) ? LLONG_MAX : (long long) magnitude;
+
+            p = q;
+            return true;
+        }
+
+        inline bool MatchUnsigned(const char *& p, const char * pLimit, int base, unsigned long long & value)
+        {
+            const char * q = p;
+            bool fNegative = (q < pLimit && *q == '-');
+            if (q < pLimit && (*q == '-' || *q == '+'))
+                ++q;
+
+            unsigned long long magnitude = 0;
+            bool               fOverflow = false;
+            if (!MatchMagnitude(q, pLimit, base, magnitude, fOverflow))
+                return false;
+
+            // strtoull saturates, and negates a magnitude that fits
+
+            value = fOverflow ? ULLONG_MAX : fNegative ? 0 - magnitude : magnitude;
+            p = q;
+            return true;
+        }
+
+        // MatchFloatSlow
+        //
+        // Hex floats and out-of-range values, which from_chars either
+        // doesn't read or doesn't round the way strtod does, go through the
+        // scratch-buffer strtod path that _snscanf_s uses for every float.
+
+        bool MatchFloatSlow(const char *& p, const char * pLimit, float & value);
+        bool MatchFloatSlow(const char *& p, const char * pLimit, double & value);
+        bool MatchFloatSlow(const char *& p, const char * pLimit, long double & value);
+
+        template <typename T>
+        inline bool MatchFloat(const char *& p, const char * pLimit, T & value)
+        {
+            // from_chars takes '-' but not '+', and has no 0x form
+
+            const char * q = p;
+            if (q < pLimit && *q == '+')
+            {
+                if (++q < pLimit && *q == '-')
+                    return false;
+            }
+
+            const char * pDigits = (q < pLimit && *q == '-') ? q + 1 : q;
+            if (pLimit - pDigits > 1 && pDigits[0] == '0' && (pDigits[1] | 0x20) == 'x')
+                return MatchFloatSlow(p, pLimit, value);
+
+            std::from_chars_result result = std::from_chars(q, pLimit, value);
+            if (result.ptr == q)
+                return false;
+            if (result.ec == std::errc::result_out_of_range)
+                return MatchFloatSlow(p, pLimit, value);
+
+            p = result.ptr;
+            return true;
+        }
+
+        // StoreScanField
+        //
+        // StoreString from ScanFunctions.cpp: copies a %s, %c or %[ field,
+        // emptying the buffer and returning false if it doesn't fit.
+
+        [[gnu::cold, gnu::noinline]]
+        bool ScanBufferViolation();
+
+        inline bool StoreScanField(char * dest, rsize_t destsz, const char * src, size_t cch, bool fTerminate)
+        {
+            if (__builtin_expect(dest == nullptr, 0))
+                return ScanBufferViolation();
+
+            if (__builtin_expect(cch + (fTerminate ? 1 : 0) > destsz, 0))
+            {
+                if (destsz > 0)
+                    dest[0] = '\0';
+                return false;
+            }
+
+            // Fields are mostly short words, which a pair of overlapping
+            // fixed-size moves copies without a call to memcpy
+
+            if (cch >= 8 && cch <= 16)
+            {
+                memcpy(dest, src, 8);
+                memcpy(dest + cch - 8, src + cch - 8, 8);
+            }
+            else if (cch >= 4 && cch < 8)
+            {
+                memcpy(dest, src, 4);
+                memcpy(dest + cch - 4, src + cch - 4, 4);
+            }
+            else
+            {
+                memcpy(dest, src, cch);
+            }
+
+            if (fTerminate)
+                dest[cch] = '\0';
+            return true;
+        }
+
+        [[gnu::cold, gnu::noinline]]
+        int ScanInputViolation(const wchar_t * function);
+
+        struct ScanState
+        {
+            const char * pInput;
+            const char * p;
+            const char * pEnd;
+            int          cAssigned  = 0;
+            bool         fConverted = false;
+            bool         fEOF       = false;
+
+            int Result() const { return (fEOF && !fConverted) ? EOF : cAssigned; }
+        };
+
+        // RunStep
+        //
+        // One directive of a compiled pattern.  Every decision that depends
+        // on the pattern is an if constexpr, so each step of each pattern
+        // becomes straight-line code.  Returns false to end the scan.
+
+        template <typename C, size_t I, typename Tuple>
+        inline __attribute__((always_inline)) bool RunStep(ScanState & state, Tuple & args)
+        {
+            using namespace ScanCheck;
+
+            constexpr Step   step = C::c_rgSteps[I];
+            constexpr size_t iArg = C::c_rgiArg[I];
+
+            if constexpr (step.kind == StepKind::Space)
+            {
+                SkipScanSpace(state.p, state.pEnd);
+                return true;
+            }
+            else if constexpr (step.kind == StepKind::Literal)
+            {
+                if constexpr (step.fSkipSpace)
+                    SkipScanSpace(state.p, state.pEnd);
+                if (state.p == state.pEnd)
+                {
+                    state.fEOF = true;
+                    return false;
+                }
+                if (*state.p != step.chLiteral)
+                    return false;
+                ++state.p;
+                return true;
+            }
+            else if constexpr (step.kind == StepKind::Count)
+            {
+                if constexpr (!step.fSuppress)
+                {
+                    auto pCount = std::get<iArg>(args);
+                    *pCount = (std::remove_pointer_t<decltype(pCount)>)(state.p - state.pInput);
+                }
+                return true;
+            }
+            else
+            {
+                if constexpr (step.kind != StepKind::Chars && step.kind != StepKind::Set)
+                    SkipScanSpace(state.p, state.pEnd);
+
+                if (state.p == state.pEnd)
+                {
+                    state.fEOF = true;
+                    return false;
+                }
+
+                size_t       cchAvail = state.pEnd - state.p;
+                const char * pLimit   = state.p + ((step.cchWidth != 0 && step.cchWidth < cchAvail) ? step.cchWidth : cchAvail);
+                bool         fMatched = true;
+
+                if constexpr (step.kind == StepKind::Signed)
+                {
+                    long long value;
+                    fMatched = MatchSigned(state.p, pLimit, step.base, value);
+                    if constexpr (!step.fSuppress)
+                    {
+                        if (fMatched)
+                        {
+                            auto pValue = std::get<iArg>(args);
+                            *pValue = (std::remove_pointer_t<decltype(pValue)>) value;
+                        }
+                    }
+                }
+                else if constexpr (step.kind == StepKind::Unsigned || step.kind == StepKind::Pointer)
+                {
+                    unsigned long long value;
+                    fMatched = MatchUnsigned(state.p, pLimit, step.base, value);
+                    if constexpr (!step.fSuppress)
+                    {
+                        if (fMatched)
+                        {
+                            auto pValue = std::get<iArg>(args);
+                            if constexpr (step.kind == StepKind::Pointer)
+                                *pValue = (void *)(uintptr_t) value;
+                            else
+                                *pValue = (std::remove_pointer_t<decltype(pValue)>) value;
+                        }
+                    }
+                }
+                else if constexpr (step.kind == StepKind::Float)
+                {
+                    using T = std::conditional_t<step.length == Length::L, long double,
+                              std::conditional_t<step.length == Length::l, double, float>>;
+                    T value;
+                    fMatched = MatchFloat(state.p, pLimit, value);
+                    if constexpr (!step.fSuppress)
+                    {
+                        if (fMatched)
+                            *std::get<iArg>(args) = value;
+                    }
+                }
+                else if constexpr (step.kind == StepKind::Chars)
+                {
+                    size_t cch = step.cchWidth ? step.cchWidth : 1;
+                    if (cch > cchAvail)
+                    {
+                        state.fEOF = true;
+                        return false;
+                    }
+                    if constexpr (!step.fSuppress)
+                        fMatched = StoreScanField(std::get<iArg>(args), std::get<iArg + 1>(args), state.p, cch, false);
+                    state.p += cch;
+                }
+                else
+                {
+                    const char * pStart = state.p;
+                    if constexpr (step.kind == StepKind::String)
+                    {
+                        state.p = FindSpace(state.p, pLimit);
+                    }
+                    else
+                    {
+                        while (state.p < pLimit && step.InSet(*state.p))
+                            ++state.p;
+                        fMatched = (state.p != pStart);
+                    }
+
+                    if constexpr (!step.fSuppress)
+                    {
+                        if (fMatched)
+                            fMatched = StoreScanField(std::get<iArg>(args), std::get<iArg + 1>(args), pStart, state.p - pStart, true);
+                    }
+                }
+
+                if (!fMatched)
+                    return false;
+
+                state.fConverted = true;
+                if constexpr (!step.fSuppress)
+                    state.cAssigned++;
+                return true;
+            }
+        }
+
+        template <typename C, typename Tuple, size_t... I>
+        inline __attribute__((always_inline)) void RunSteps(ScanState & state, Tuple & args, std::index_sequence<I...>)
+        {
+            (RunStep<C, I>(state, args) && ...);
+        }
+    }
+
+    // Scan
+    //
+    // _snscanf_s(input, length, Pattern, args...) with the pattern compiled
+    // and checked against the argument types at compile time.
+
+    template <ScanCheck::PatternText Pattern, typename... Args>
+    inline int Scan(const char * input, size_t length, Args... args)
+    {
+        using C = ScanCheck::Compiled<Pattern>;
+        static_assert(ScanCheck::CheckArgs<C, Args...>());
+
+        if (__builtin_expect(input == nullptr, 0))
+            return Internal::ScanInputViolation(L"Scan");
+
+        Internal::ScanState state { input, input, input + strnlen(input, length) };
+        std::tuple<Args...> tArgs(args...);
+        Internal::RunSteps<C>(state, tArgs, std::make_index_sequence<C::c_cSteps>());
+        return state.Result();
+    }
+
+    // ScanPlan
+    //
+    // A pattern that isn't known until runtime, compiled once.  The argument
+    // types can't be checked, so as with _snscanf_s they must be right.  A
+    // pattern with a bad directive calls the handler on each scan.
+
+    class ScanPlan
+    {
+    public:
+
+        explicit ScanPlan(const char * pattern);
+
+        int VScan(const char * input, size_t length, va_list argptr) const;
+        int Scan(const char * input, size_t length, ...) const;
+
+    private:
+
+        bool                         _fValid;
+        std::vector<ScanCheck::Step> _steps;
+    };
+}
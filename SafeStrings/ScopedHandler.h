@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------
+// ScopedHandler.h - A thread's own invalid parameter handler, for a scope
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// _set_invalid_parameter_handler sets one policy for the whole process.
+// When threads want different ones - request threads that carry on and
+// count, batch threads that stop dead - each can install its own with
+// _set_thread_local_invalid_parameter_handler, and ScopedHandler does it
+// for the length of a scope:
+//
+//    void ServeRequest(...)
+//    {
+//        SafeStrings::ScopedHandler handler(SafeStrings::CountingHandler);
+//        ...
+//        if (SafeStrings::ThreadViolationCount() != 0)
+//            ...
+//    }
+//
+// Installing and restoring are a store to the thread's own storage, done
+// once per scope; the string functions themselves only look for a handler
+// when a check has already failed.  Scopes nest, each putting back the
+// handler it found.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+namespace SafeStrings
+{
+    class ScopedHandler
+    {
+    public:
+
+        explicit ScopedHandler(_invalid_parameter_handler pfnHandler)
+            : _pfnPrevious(_set_thread_local_invalid_parameter_handler(pfnHandler))
+        {
+        }
+
+        ~ScopedHandler()
+        {
+            _set_thread_local_invalid_parameter_handler(_pfnPrevious);
+        }
+
+        ScopedHandler(const ScopedHandler &) = delete;
+        ScopedHandler & operator=(const ScopedHandler &) = delete;
+
+    private:
+
+        _invalid_parameter_handler _pfnPrevious;
+    };
+
+    // CountingHandler
+    //
+    // Adds one to the calling thread's violation count and returns, so the
+    // failing call goes on to return its error with its output truncated or
+    // emptied as usual.
+
+    void CountingHandler(const wchar_t * expression, const wchar_t * function, const wchar_t * file,
+                         unsigned int line, uintptr_t pReserved);
+
+    // AbortingHandler
+    //
+    // What the process gets with no handler at all: the violation on
+    // stderr, then abort.  For a thread that must stop even when the
+    // process-wide handler carries on.
+
+    [[noreturn]]
+    void AbortingHandler(const wchar_t * expression, const wchar_t * function, const wchar_t * file,
+                         unsigned int line, uintptr_t pReserved);
+
+    // ThreadViolationCount
+    //
+    // How many violations CountingHandler has seen on the calling thread.
+    // ResetThreadViolationCount starts it again from zero.
+
+    size_t ThreadViolationCount();
+    void   ResetThreadViolationCount();
+}
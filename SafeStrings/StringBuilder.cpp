@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------------------
+// StringBuilder.cpp - Length-tracking strcat_s over a caller-supplied buffer
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "StringBuilder.h"
+#include "SafeStringsInternal.h"
+#include "StringKernels.h"
+
+#include <string.h>
+
+namespace SafeStrings
+{
+    StringBuilder::StringBuilder(char * buffer, rsize_t sizeInBytes)
+        : _pszBuffer(buffer), _cbBuffer(0), _cch(0)
+    {
+        if (SAFE_UNLIKELY(buffer == nullptr || sizeInBytes == 0 || sizeInBytes > RSIZE_MAX))
+        {
+            SAFE_RAISE(EINVAL, "buffer != nullptr && 0 < sizeInBytes <= RSIZE_MAX", "StringBuilder");
+            return;
+        }
+
+        _cbBuffer = sizeInBytes;
+        _pszBuffer[0] = '\0';
+    }
+
+    StringBuilder::StringBuilder(AttachTag, char * buffer, rsize_t sizeInBytes)
+        : _pszBuffer(buffer), _cbBuffer(0), _cch(0)
+    {
+        if (SAFE_UNLIKELY(buffer == nullptr || sizeInBytes == 0 || sizeInBytes > RSIZE_MAX))
+        {
+            SAFE_RAISE(EINVAL, "buffer != nullptr && 0 < sizeInBytes <= RSIZE_MAX", "StringBuilder::Attach");
+            return;
+        }
+
+        _cbBuffer = sizeInBytes;
+        _cch = Internal::BoundedLength(buffer, sizeInBytes);
+        if (SAFE_UNLIKELY(_cch == sizeInBytes))
+        {
+            _pszBuffer[0] = '\0';
+            _cch = 0;
+            SAFE_RAISE(EINVAL, "String is not null terminated", "StringBuilder::Attach");
+        }
+    }
+
+    StringBuilder StringBuilder::Attach(char * buffer, rsize_t sizeInBytes)
+    {
+        return StringBuilder(AttachTag(), buffer, sizeInBytes);
+    }
+
+    // Append
+    //
+    // strcat_s, except that the copy starts at the remembered end instead of
+    // at a freshly measured one.
+
+    errno_t StringBuilder::Append(const char * src)
+    {
+        if (SAFE_UNLIKELY(_cbBuffer == 0))
+            return SAFE_RAISE(EINVAL, "Buffer is not valid", "StringBuilder::Append");
+
+        if (SAFE_UNLIKELY(src == nullptr))
+        {
+            Clear();
+            return SAFE_RAISE(EINVAL, "src != nullptr", "StringBuilder::Append");
+        }
+
+        size_t cbAvail = _cbBuffer - _cch;
+        size_t cch     = Internal::BoundedCopy(_pszBuffer + _cch, src, cbAvail);
+        if (SAFE_UNLIKELY(cch == cbAvail))
+        {
+            Clear();
+            return SAFE_RAISE(ERANGE, "Buffer is too small", "StringBuilder::Append");
+        }
+
+        _cch += cch;
+        return 0;
+    }
+
+    // Append
+    //
+    // The first cch characters of src, which need not be terminated.
+
+    errno_t StringBuilder::Append(const char * src, size_t cch)
+    {
+        if (SAFE_UNLIKELY(_cbBuffer == 0))
+            return SAFE_RAISE(EINVAL, "Buffer is not valid", "StringBuilder::Append");
+
+        if (SAFE_UNLIKELY(src == nullptr && cch != 0))
+        {
+            Clear();
+            return SAFE_RAISE(EINVAL, "src != nullptr", "StringBuilder::Append");
+        }
+
+        if (SAFE_UNLIKELY(cch >= _cbBuffer - _cch))
+        {
+            Clear();
+            return SAFE_RAISE(ERANGE, "Buffer is too small", "StringBuilder::Append");
+        }
+
+        // src may be null when cch is 0, which memcpy doesn't allow
+
+        if (cch != 0)
+            memcpy(_pszBuffer + _cch, src, cch);
+        _cch += cch;
+        _pszBuffer[_cch] = '\0';
+        return 0;
+    }
+
+    errno_t StringBuilder::Append(char ch)
+    {
+        return Append(&ch, 1);
+    }
+}
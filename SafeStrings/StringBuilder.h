@@ -0,0 +1,78 @@
+//--------------------------------------------------------------------------------
+// StringBuilder.h - Length-tracking strcat_s over a caller-supplied buffer
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Every strcat_s call has to find the end of dest before it can append, so
+// building a string from N pieces rescans the whole thing N times - Joel's
+// Schlemiel the Painter.  StringBuilder remembers where the end is, which
+// makes each Append cost the length of the piece and nothing more.
+//
+// Failures behave exactly like strcat_s: a null piece or one that doesn't
+// fit empties the buffer, calls the invalid parameter handler and returns
+// EINVAL or ERANGE.  The builder is then empty and can be reused.
+//
+//    char szBuffer[16];
+//    SafeStrings::StringBuilder sb(szBuffer);
+//    sb.Append("C:");
+//    sb.Append("\\foo");
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+namespace SafeStrings
+{
+    class StringBuilder
+    {
+    public:
+
+        // Starts with an empty string in buffer.  A null buffer or a size of
+        // zero or more than RSIZE_MAX is reported through the handler and
+        // leaves a builder on which every Append fails with EINVAL.
+
+        StringBuilder(char * buffer, rsize_t sizeInBytes);
+
+        template <size_t size>
+        explicit StringBuilder(char (&buffer)[size])
+            : StringBuilder(buffer, size)
+        {
+        }
+
+        // Attach
+        //
+        // Takes over a buffer that already holds a string, measuring it once
+        // (with the same "must be terminated" check as strcat_s).
+
+        static StringBuilder Attach(char * buffer, rsize_t sizeInBytes);
+
+        errno_t Append(const char * src);
+        errno_t Append(const char * src, size_t cch);
+        errno_t Append(char ch);
+
+        void Clear()
+        {
+            if (_cbBuffer != 0)
+            {
+                _pszBuffer[0] = '\0';
+                _cch = 0;
+            }
+        }
+
+        const char * c_str()    const { return _pszBuffer; }
+        size_t       Length()   const { return _cch; }
+        size_t       Capacity() const { return _cbBuffer; }
+
+    private:
+
+        struct AttachTag { };
+        StringBuilder(AttachTag, char * buffer, rsize_t sizeInBytes);
+
+        char *  _pszBuffer;
+        rsize_t _cbBuffer;      // 0 if the buffer failed validation
+        size_t  _cch;           // Always < _cbBuffer when _cbBuffer != 0
+    };
+}
@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------------------
+// StringFunctions.cpp - strnlen_s, strcpy_s, strcat_s
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "StringKernels.h"
+
+// strnlen_s
+//
+// Length of str, but never looks at more than numberOfElements bytes.  A
+// null pointer is simply an empty string rather than a constraint violation.
+// The scan itself is the widest vector kernel the CPU supports.
+
+extern "C" size_t strnlen_s(const char * str, size_t numberOfElements)
+{
+    if (str == nullptr)
+        return 0;
+
+    return SafeStrings::Internal::BoundedLength(str, numberOfElements);
+}
+
+// CopyBounded
+
+size_t SafeStrings::CopyBounded(char * dest, rsize_t destsz, const char * src)
+{
+    return SafeStrings::Internal::BoundedCopy(dest, src, destsz);
+}
+
+// strcpy_s
+//
+// Copies src, terminator and all, into dest.  If it won't fit, dest is left
+// as an empty string and the handler is called with ERANGE.  Measuring and
+// copying happen in a single pass over src, so the overflow is only
+// discovered (and reported) once the copy has run out of room - and src is
+// not read any further, not even to tell SAFE_COUNTED how much it wanted.
+
+extern "C" errno_t strcpy_s(char * dest, rsize_t destsz, const char * src)
+{
+    SAFE_VALIDATE_STRING(dest, destsz, "strcpy_s", EINVAL);
+
+    if (SAFE_UNLIKELY(src == nullptr))
+    {
+        dest[0] = '\0';
+        return SAFE_RAISE(EINVAL, "src != nullptr", "strcpy_s");
+    }
+
+    if (SAFE_UNLIKELY(SafeStrings::Internal::BoundedCopy(dest, src, destsz) == destsz))
+    {
+        dest[0] = '\0';
+        SafeStrings::Internal::NoteFailureSizes(destsz + 1, destsz);
+        return SAFE_RAISE(ERANGE, "Buffer is too small", "strcpy_s");
+    }
+
+    return 0;
+}
+
+// strcat_s
+//
+// Appends src to the string already in dest.  dest must be terminated within
+// its first destsz bytes, and the combined string plus terminator must fit;
+// otherwise dest is emptied and the handler is called.
+
+extern "C" errno_t strcat_s(char * dest, rsize_t destsz, const char * src)
+{
+    SAFE_VALIDATE_STRING(dest, destsz, "strcat_s", EINVAL);
+
+    if (SAFE_UNLIKELY(src == nullptr))
+    {
+        dest[0] = '\0';
+        return SAFE_RAISE(EINVAL, "src != nullptr", "strcat_s");
+    }
+
+    size_t cchDest = SafeStrings::Internal::BoundedLength(dest, destsz);
+    if (SAFE_UNLIKELY(cchDest == destsz))
+    {
+        dest[0] = '\0';
+        return SAFE_RAISE(EINVAL, "String is not null terminated", "strcat_s");
+    }
+
+    size_t cbAvail = destsz - cchDest;
+    if (SAFE_UNLIKELY(SafeStrings::Internal::BoundedCopy(dest + cchDest, src, cbAvail) == cbAvail))
+    {
+        dest[0] = '\0';
+        SafeStrings::Internal::NoteFailureSizes(destsz + 1, destsz);
+        return SAFE_RAISE(ERANGE, "Buffer is too small", "strcat_s");
+    }
+
+    return 0;
+}
@@ -0,0 +1,292 @@
+//--------------------------------------------------------------------------------
+// StringKernels.cpp - Portable scalar kernels and startup CPU dispatch
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "StringKernels.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace SafeStrings::Internal
+{
+    namespace
+    {
+        typedef uint64_t __attribute__((may_alias)) AliasedWord;
+
+        const uint64_t kOnes  = 0x0101010101010101ull;
+        const uint64_t kHighs = 0x8080808080808080ull;
+
+        // StrnlenScalar
+        //
+        // SWAR fallback: eight bytes per step from aligned words, using the
+        // classic (v - 0x01..) & ~v & 0x80.. test.  That test can flag a byte
+        // above a real zero but never below one, so the lowest flag is exact.
+
+        SAFE_BLOCK_READS size_t StrnlenScalar(const char * str, size_t cchMax)
+        {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            if (cchMax == 0)
+                return 0;
+
+            uintptr_t           addr   = (uintptr_t) str;
+            size_t              offset = addr & 7;
+            const AliasedWord * pWord  = (const AliasedWord *)(addr - offset);
+
+            // Pretend the bytes before str are non-zero
+
+            uint64_t word = *pWord | ((uint64_t(1) << (offset * 8)) - 1);
+
+            for (;;)
+            {
+                uint64_t zeros = (word - kOnes) & ~word & kHighs;
+                if (zeros)
+                {
+                    size_t idx = (size_t)(((const char *) pWord - str) + (__builtin_ctzll(zeros) >> 3));
+                    return idx < cchMax ? idx : cchMax;
+                }
+
+                ++pWord;
+                if ((size_t)((const char *) pWord - str) >= cchMax)
+                    return cchMax;
+
+                word = *pWord;
+            }
+#else
+            return strnlen(str, cchMax);
+#endif
+        }
+
+        // CopyScalar
+        //
+        // Bytes one at a time until src is word aligned, then whole words
+        // (checked with the same zero-byte test) until the terminator turns up
+        // or the next word would overrun dest.
+
+        SAFE_BLOCK_READS size_t CopyScalar(char * dest, const char * src, size_t destsz)
+        {
+            size_t cch = 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            for (; ((uintptr_t)(src + cch) & 7) != 0; ++cch)
+            {
+                if (cch == destsz)
+                    return destsz;
+                if ((dest[cch] = src[cch]) == '\0')
+                    return cch;
+            }
+
+            while (cch + 8 <= destsz)
+            {
+                uint64_t word  = *(const AliasedWord *)(src + cch);
+                uint64_t zeros = (word - kOnes) & ~word & kHighs;
+                if (zeros)
+                {
+                    size_t idx = __builtin_ctzll(zeros) >> 3;
+                    CopySmall(dest + cch, src + cch, idx + 1);
+                    return cch + idx;
+                }
+                memcpy(dest + cch, &word, 8);
+                cch += 8;
+            }
+#endif
+
+            for (; cch < destsz; ++cch)
+            {
+                if ((dest[cch] = src[cch]) == '\0')
+                    return cch;
+            }
+
+            return destsz;
+        }
+
+        // ExactZeroBytes
+        //
+        // 0x80 in each byte of word that is zero, and nowhere else.  Unlike
+        // the test StrnlenScalar uses it never flags a byte above a real
+        // zero, which matters when the highest flag is the one wanted.
+
+        inline uint64_t ExactZeroBytes(uint64_t word)
+        {
+            const uint64_t kLows = ~kHighs;
+            return ~(((word & kLows) + kLows) | word | kLows);
+        }
+
+        // ScanPathScalar
+        //
+        // Aligned words as in StrnlenScalar, each classified three ways at
+        // once: terminator, separator and dot.  A flag is the high bit of
+        // its byte, so byte positions are bit positions divided by 8.
+
+        SAFE_BLOCK_READS PathScan ScanPathScalar(const char * str, size_t cchMax)
+        {
+            PathScan scan = { 0, 0, 0 };
+            if (cchMax == 0)
+                return scan;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            uintptr_t           addr   = (uintptr_t) str;
+            size_t              offset = addr & 7;
+            const AliasedWord * pWord  = (const AliasedWord *)(addr - offset);
+
+            size_t ichBlock = 0;                // Index in str of the block's first flag
+            size_t cchBlock = 8 - offset;       // Flags in the block that belong to str
+            size_t shift    = offset * 8;
+
+            for (;;)
+            {
+                uint64_t word  = *pWord;
+                uint64_t zeros = ExactZeroBytes(word) >> shift;
+                uint64_t seps  = (ExactZeroBytes(word ^ (kOnes * '\\')) | ExactZeroBytes(word ^ (kOnes * '/'))) >> shift;
+                uint64_t dots  = ExactZeroBytes(word ^ (kOnes * '.')) >> shift;
+
+                // Stop at the terminator or the bound, whichever comes first
+
+                size_t cchLeft = cchMax - ichBlock;
+                if (cchLeft < cchBlock)
+                    zeros |= 0x80ull << (cchLeft * 8);
+
+                bool fLast = (zeros != 0);
+                if (fLast)
+                {
+                    size_t   idx  = __builtin_ctzll(zeros) >> 3;
+                    uint64_t keep = idx ? ~0ull >> (64 - idx * 8) : 0;
+                    seps     &= keep;
+                    dots     &= keep;
+                    scan.cch  = ichBlock + idx;
+                }
+
+                if (seps)
+                    scan.ichAfterSeparator = ichBlock + ((63 - __builtin_clzll(seps)) >> 3) + 1;
+                if (dots)
+                    scan.ichAfterDot = ichBlock + ((63 - __builtin_clzll(dots)) >> 3) + 1;
+
+                if (fLast)
+                    return scan;
+
+                ichBlock += cchBlock;
+                if (ichBlock >= cchMax)
+                {
+                    scan.cch = cchMax;
+                    return scan;
+                }
+
+                ++pWord;
+                cchBlock = 8;
+                shift    = 0;
+            }
+#else
+            for (; scan.cch < cchMax && str[scan.cch] != '\0'; scan.cch++)
+            {
+                if (str[scan.cch] == '\\' || str[scan.cch] == '/')
+                    scan.ichAfterSeparator = scan.cch + 1;
+                else if (str[scan.cch] == '.')
+                    scan.ichAfterDot = scan.cch + 1;
+            }
+            return scan;
+#endif
+        }
+
+        // TokenizeScalar
+        //
+        // A byte at a time.  Every token boundary is a branch however the
+        // bytes are classified, so words of flags buy little here.
+
+        size_t TokenizeScalar(const char * str, size_t cchMax,
+                              std::string_view * rgTokens, size_t cTokensMax, size_t * pichRest)
+        {
+            auto IsSpace = [](char ch) { return ch == ' ' || (unsigned char)(ch - '\t') <= '\r' - '\t'; };
+
+            size_t cTokens = 0;
+            size_t ich     = 0;
+            while (cTokens < cTokensMax)
+            {
+                while (ich < cchMax && str[ich] != '\0' && IsSpace(str[ich]))
+                    ich++;
+                if (ich == cchMax || str[ich] == '\0')
+                    break;
+
+                size_t ichStart = ich;
+                while (ich < cchMax && str[ich] != '\0' && !IsSpace(str[ich]))
+                    ich++;
+                rgTokens[cTokens++] = std::string_view(str + ichStart, ich - ichStart);
+            }
+
+            *pichRest = ich;
+            return cTokens;
+        }
+    }
+
+    const StringKernelTable g_ScalarKernels =
+    {
+        "scalar",
+        StrnlenScalar,
+        CopyScalar,
+        ScanPathScalar,
+        TokenizeScalar,
+    };
+
+    constinit StringKernelTable g_Kernels =
+    {
+        "scalar",
+        StrnlenScalar,
+        CopyScalar,
+        ScanPathScalar,
+        TokenizeScalar,
+    };
+
+    namespace
+    {
+        // SelectKernels
+        //
+        // Picks the widest instruction set the CPU (and OS) supports.  Setting
+        // SAFESTRINGS_ISA to scalar, sse2, avx2 or avx512 caps the choice, which
+        // is handy for benchmarking the variants against one another.
+
+        const StringKernelTable * SelectKernels()
+        {
+            const char * pszCap = getenv("SAFESTRINGS_ISA");
+            auto Allowed = [pszCap](const char * pszName)
+            {
+                if (pszCap == nullptr)
+                    return true;
+
+                static const char * const s_rgOrder[] = { "scalar", "sse2", "avx2", "avx512" };
+                int iCap = -1, iName = -1;
+                for (int i = 0; i < 4; i++)
+                {
+                    if (strcmp(pszCap, s_rgOrder[i]) == 0)
+                        iCap = i;
+                    if (strcmp(pszName, s_rgOrder[i]) == 0)
+                        iName = i;
+                }
+                return iCap < 0 || iName <= iCap;
+            };
+
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && Allowed("avx512"))
+                return &g_Avx512Kernels;
+
+            if (__builtin_cpu_supports("avx2") && Allowed("avx2"))
+                return &g_Avx2Kernels;
+
+            if (__builtin_cpu_supports("sse2") && Allowed("sse2"))
+                return &g_Sse2Kernels;
+#else
+            (void) Allowed;
+#endif
+            return &g_ScalarKernels;
+        }
+
+        [[gnu::constructor]] void InitializeKernels()
+        {
+            g_Kernels = *SelectKernels();
+        }
+    }
+}
@@ -0,0 +1,171 @@
+//--------------------------------------------------------------------------------
+// StringKernels.h - Vectorized string primitives and their CPU dispatch table
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Not part of the public interface.  Each instruction set gets its own
+// translation unit and fills in one StringKernelTable; StringKernels.cpp
+// picks the best table the CPU supports once, during static initialization,
+// and every caller goes through g_Kernels from then on.
+//
+// All kernels share one rule: vector loads are aligned, so a load never
+// spans a page boundary, and a load is only issued if at least one of its
+// bytes lies inside the caller's bound.  Bytes outside the bound may be
+// read from the same aligned block but never influence the result.
+// AddressSanitizer can't tell those bytes from a real overrun, so the
+// kernels are built without its checks; the guard-page tests stand in.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <string_view>
+
+// SAFE_BLOCK_READS
+//
+// Marks a kernel, or a helper of one, that reads whole aligned blocks.
+
+#define SAFE_BLOCK_READS __attribute__((no_sanitize_address))
+
+namespace SafeStrings::Internal
+{
+    typedef size_t (*StrnlenKernel)(const char * str, size_t cchMax);
+
+    // CopyKernel
+    //
+    // Finds the terminator and copies in the same pass.  If src, terminator
+    // included, fits in destsz bytes it is copied and its length returned.
+    // Otherwise the result is destsz and dest holds an unspecified prefix;
+    // the kernel never writes beyond dest[destsz - 1].  destsz is non-zero.
+
+    typedef size_t (*CopyKernel)(char * dest, const char * src, size_t destsz);
+
+    // PathScanKernel
+    //
+    // Classifies every byte of a path in one pass, for the batch splitter:
+    // the length (up to cchMax, as strnlen) and the positions just past the
+    // last '\' or '/' and just past the last '.', each 0 if there is none.
+
+    struct PathScan
+    {
+        size_t cch;
+        size_t ichAfterSeparator;
+        size_t ichAfterDot;
+    };
+
+    typedef PathScan (*PathScanKernel)(const char * str, size_t cchMax);
+
+    // TokenKernel
+    //
+    // Finds up to cTokensMax runs of non-whitespace (whitespace as isspace
+    // in the C locale) in str, which ends at cchMax or a terminator, and
+    // returns how many it stored in rgTokens.  *pichRest is set to where a
+    // further call would carry on: just past the last token if cTokensMax
+    // was reached, otherwise the end of the string.
+
+    typedef size_t (*TokenKernel)(const char * str, size_t cchMax,
+                                  std::string_view * rgTokens, size_t cTokensMax, size_t * pichRest);
+
+    struct StringKernelTable
+    {
+        const char *   pszName;
+        StrnlenKernel  pfnStrnlen;
+        CopyKernel     pfnCopy;
+        PathScanKernel pfnScanPath;
+        TokenKernel    pfnTokenize;
+    };
+
+    extern const StringKernelTable g_ScalarKernels;
+
+#if defined(__x86_64__) || defined(__i386__)
+    extern const StringKernelTable g_Sse2Kernels;
+    extern const StringKernelTable g_Avx2Kernels;
+    extern const StringKernelTable g_Avx512Kernels;
+#endif
+
+    // g_Kernels
+    //
+    // Starts out as the scalar table (constant initialized, so it is usable
+    // from other static constructors) and is upgraded once at startup.
+
+    extern StringKernelTable g_Kernels;
+
+    // BoundedLength
+    //
+    // strnlen for a pointer already known to be non-null.
+
+    inline size_t BoundedLength(const char * str, size_t cchMax)
+    {
+        return g_Kernels.pfnStrnlen(str, cchMax);
+    }
+
+    // BoundedCopy
+    //
+    // strcpy that stops at destsz; see CopyKernel for the contract.
+
+    inline size_t BoundedCopy(char * dest, const char * src, size_t destsz)
+    {
+        return g_Kernels.pfnCopy(dest, src, destsz);
+    }
+
+    // ScanPath
+    //
+    // See PathScanKernel.
+
+    inline PathScan ScanPath(const char * str, size_t cchMax)
+    {
+        return g_Kernels.pfnScanPath(str, cchMax);
+    }
+
+    // FindTokens
+    //
+    // See TokenKernel.
+
+    inline size_t FindTokens(const char * str, size_t cchMax,
+                             std::string_view * rgTokens, size_t cTokensMax, size_t * pichRest)
+    {
+        return g_Kernels.pfnTokenize(str, cchMax, rgTokens, cTokensMax, pichRest);
+    }
+
+    // CopySmall
+    //
+    // Copies up to 64 bytes with at most two overlapping moves of a fixed
+    // size, so the tail of a vector kernel costs a couple of branches rather
+    // than a call to memcpy.  Only bytes in [src, src + cb) are read.
+
+    inline __attribute__((always_inline)) void CopySmall(char * dest, const char * src, size_t cb)
+    {
+        if (cb >= 32)
+        {
+            memcpy(dest, src, 32);
+            memcpy(dest + cb - 32, src + cb - 32, 32);
+        }
+        else if (cb >= 16)
+        {
+            memcpy(dest, src, 16);
+            memcpy(dest + cb - 16, src + cb - 16, 16);
+        }
+        else if (cb >= 8)
+        {
+            memcpy(dest, src, 8);
+            memcpy(dest + cb - 8, src + cb - 8, 8);
+        }
+        else if (cb >= 4)
+        {
+            memcpy(dest, src, 4);
+            memcpy(dest + cb - 4, src + cb - 4, 4);
+        }
+        else if (cb >= 2)
+        {
+            memcpy(dest, src, 2);
+            memcpy(dest + cb - 2, src + cb - 2, 2);
+        }
+        else if (cb == 1)
+        {
+            *dest = *src;
+        }
+    }
+}
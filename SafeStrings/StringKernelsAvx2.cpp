@@ -0,0 +1,373 @@
+//--------------------------------------------------------------------------------
+// StringKernelsAvx2.cpp - 32 byte kernels
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "StringKernels.h"
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#define SAFE_TARGET __attribute__((target("avx2"))) SAFE_BLOCK_READS
+
+namespace SafeStrings::Internal
+{
+    namespace
+    {
+        SAFE_TARGET inline uint32_t ZeroMask(const char * pBlock)
+        {
+            __m256i v = _mm256_load_si256((const __m256i *) pBlock);
+            return (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+        }
+
+        // StrnlenAvx2
+        //
+        // Same shape as the SSE2 kernel with 32 byte blocks: an aligned first
+        // load with the leading bytes shifted off, then pairs of aligned loads
+        // while both halves still overlap the bound.
+
+        SAFE_TARGET size_t StrnlenAvx2(const char * str, size_t cchMax)
+        {
+            if (cchMax == 0)
+                return 0;
+
+            uintptr_t    offset = (uintptr_t) str & 31;
+            const char * pBlock = str - offset;
+
+            uint32_t mask = ZeroMask(pBlock) >> offset;
+            if (mask)
+            {
+                size_t idx = __builtin_ctz(mask);
+                return idx < cchMax ? idx : cchMax;
+            }
+
+            size_t cchScanned = 32 - offset;
+
+            // One more single block if needed so that the pairs below start on
+            // a 64 byte boundary; a pair then never straddles a page, even
+            // when its first half holds the terminator.
+
+            if (((uintptr_t) pBlock & 32) == 0 && cchScanned < cchMax)
+            {
+                pBlock += 32;
+                mask = ZeroMask(pBlock);
+                if (mask)
+                {
+                    size_t idx = cchScanned + __builtin_ctz(mask);
+                    return idx < cchMax ? idx : cchMax;
+                }
+                cchScanned += 32;
+            }
+
+            // Two blocks per step while both overlap the bound
+
+            while (cchScanned + 32 < cchMax)
+            {
+                __m256i v0 = _mm256_load_si256((const __m256i *)(pBlock + 32));
+                __m256i v1 = _mm256_load_si256((const __m256i *)(pBlock + 64));
+                __m256i vMin = _mm256_min_epu8(v0, v1);
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(vMin, _mm256_setzero_si256())))
+                {
+                    uint64_t mask64 = (uint64_t) ZeroMask(pBlock + 32) | ((uint64_t) ZeroMask(pBlock + 64) << 32);
+                    size_t idx = cchScanned + __builtin_ctzll(mask64);
+                    return idx < cchMax ? idx : cchMax;
+                }
+                pBlock     += 64;
+                cchScanned += 64;
+            }
+
+            if (cchScanned < cchMax)
+            {
+                mask = ZeroMask(pBlock + 32);
+                if (mask)
+                {
+                    size_t idx = cchScanned + __builtin_ctz(mask);
+                    return idx < cchMax ? idx : cchMax;
+                }
+            }
+
+            return cchMax;
+        }
+
+        // CopyAvx2
+        //
+        // CopySse2 with 32 byte blocks.
+
+        SAFE_TARGET size_t CopyAvx2(char * dest, const char * src, size_t destsz)
+        {
+            uintptr_t    offset  = (uintptr_t) src & 31;
+            const char * pBlock  = src - offset;
+            size_t       cchHead = 32 - offset;
+
+            uint32_t mask = ZeroMask(pBlock) >> offset;
+            if (mask)
+            {
+                size_t idx = __builtin_ctz(mask);
+                if (idx >= destsz)
+                    return destsz;
+                CopySmall(dest, src, idx + 1);
+                return idx;
+            }
+
+            if (cchHead >= destsz)
+                return destsz;
+            CopySmall(dest, src, cchHead);
+
+            size_t cch = cchHead;
+            pBlock += 32;
+
+            // Single blocks until src is 128 byte aligned, so that the
+            // unrolled loop below never reads a block in the next page after
+            // one that already held the terminator
+
+            for (; ((uintptr_t) pBlock & 127) != 0 && cch + 32 <= destsz; pBlock += 32, cch += 32)
+            {
+                __m256i v = _mm256_load_si256((const __m256i *) pBlock);
+                mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+                if (mask)
+                {
+                    size_t idx = __builtin_ctz(mask);
+                    CopySmall(dest + cch, pBlock, idx + 1);
+                    return cch + idx;
+                }
+                _mm256_storeu_si256((__m256i *)(dest + cch), v);
+            }
+
+            // Four blocks per step.  The unsigned minimum of the four is zero
+            // exactly when one of them holds the terminator, and that block is
+            // then found by the single block loop that follows.
+
+            for (; cch + 128 <= destsz; pBlock += 128, cch += 128)
+            {
+                __m256i v0 = _mm256_load_si256((const __m256i *)(pBlock));
+                __m256i v1 = _mm256_load_si256((const __m256i *)(pBlock + 32));
+                __m256i v2 = _mm256_load_si256((const __m256i *)(pBlock + 64));
+                __m256i v3 = _mm256_load_si256((const __m256i *)(pBlock + 96));
+                __m256i vMin = _mm256_min_epu8(_mm256_min_epu8(v0, v1), _mm256_min_epu8(v2, v3));
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(vMin, _mm256_setzero_si256())))
+                    break;
+                _mm256_storeu_si256((__m256i *)(dest + cch), v0);
+                _mm256_storeu_si256((__m256i *)(dest + cch + 32), v1);
+                _mm256_storeu_si256((__m256i *)(dest + cch + 64), v2);
+                _mm256_storeu_si256((__m256i *)(dest + cch + 96), v3);
+            }
+
+            for (; cch + 32 <= destsz; pBlock += 32, cch += 32)
+            {
+                __m256i v = _mm256_load_si256((const __m256i *) pBlock);
+                mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+                if (mask)
+                {
+                    size_t idx = __builtin_ctz(mask);
+                    CopySmall(dest + cch, pBlock, idx + 1);
+                    return cch + idx;
+                }
+                _mm256_storeu_si256((__m256i *)(dest + cch), v);
+            }
+
+            if (cch < destsz)
+            {
+                mask = ZeroMask(pBlock);
+                size_t idx = mask ? __builtin_ctz(mask) : 32;
+                if (idx < destsz - cch)
+                {
+                    CopySmall(dest + cch, pBlock, idx + 1);
+                    return cch + idx;
+                }
+            }
+
+            return destsz;
+        }
+
+        SAFE_TARGET inline void ClassifyPath(const char * pBlock, uint64_t & zeros, uint64_t & seps, uint64_t & dots)
+        {
+            __m256i v = _mm256_load_si256((const __m256i *) pBlock);
+            zeros = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+            seps  = (uint32_t) _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')),
+                                                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'))));
+            dots  = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')));
+        }
+
+        // ScanPathAvx2
+        //
+        // ScanPathSse2 with 32 byte blocks.  The masks are widened to 64 bits
+        // so that the bound can be marked one past the end of a block.
+
+        SAFE_TARGET PathScan ScanPathAvx2(const char * str, size_t cchMax)
+        {
+            PathScan scan = { 0, 0, 0 };
+            if (cchMax == 0)
+                return scan;
+
+            uintptr_t    offset = (uintptr_t) str & 31;
+            const char * pBlock = str - offset;
+
+            size_t ichBlock = 0;                // Index in str of the block's first bit
+            size_t cchBlock = 32 - offset;      // Bits in the block that belong to str
+
+            for (;;)
+            {
+                uint64_t zeros, seps, dots;
+                ClassifyPath(pBlock, zeros, seps, dots);
+                zeros >>= offset;
+                seps  >>= offset;
+                dots  >>= offset;
+
+                // Stop at the terminator or the bound, whichever comes first
+
+                size_t cchLeft = cchMax - ichBlock;
+                if (cchLeft < cchBlock)
+                    zeros |= (uint64_t) 1 << cchLeft;
+
+                bool fLast = (zeros != 0);
+                if (fLast)
+                {
+                    size_t idx = __builtin_ctzll(zeros);
+                    seps     &= ((uint64_t) 1 << idx) - 1;
+                    dots     &= ((uint64_t) 1 << idx) - 1;
+                    scan.cch  = ichBlock + idx;
+                }
+
+                if (seps)
+                    scan.ichAfterSeparator = ichBlock + 64 - __builtin_clzll(seps);
+                if (dots)
+                    scan.ichAfterDot = ichBlock + 64 - __builtin_clzll(dots);
+
+                if (fLast)
+                    return scan;
+
+                ichBlock += cchBlock;
+                if (ichBlock >= cchMax)
+                {
+                    scan.cch = cchMax;
+                    return scan;
+                }
+
+                pBlock  += 32;
+                cchBlock = 32;
+                offset   = 0;
+            }
+        }
+
+        // TokenMask
+        //
+        // A mask with the low cb bits set, cb in [0, 63].
+
+        inline uint64_t TokenMask(size_t cb)
+        {
+            return ((uint64_t) 1 << cb) - 1;
+        }
+
+        SAFE_TARGET inline void ClassifySpace(const char * pBlock, uint64_t & zeros, uint64_t & spaces)
+        {
+            __m256i v = _mm256_load_si256((const __m256i *) pBlock);
+            __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+            zeros  = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+            spaces = (uint32_t) _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                                                     _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8('\r' - '\t')), t)));
+        }
+
+        // TokenizeAvx2
+        //
+        // TokenizeSse2 with 32 byte blocks.
+
+        SAFE_TARGET size_t TokenizeAvx2(const char * str, size_t cchMax,
+                                          std::string_view * rgTokens, size_t cTokensMax, size_t * pichRest)
+        {
+            size_t cTokens = 0;
+            *pichRest = 0;
+            if (cchMax == 0 || cTokensMax == 0)
+                return 0;
+
+            uintptr_t    offset = (uintptr_t) str & 31;
+            const char * pBlock = str - offset;
+
+            size_t ichBlock = 0;                // Index in str of the block's first bit
+            size_t cchBlock = 32 - offset;      // Bits in the block that belong to str
+            size_t ichStart = 0;
+            bool   fInToken = false;
+
+            for (;;)
+            {
+                uint64_t zeros, spaces;
+                ClassifySpace(pBlock, zeros, spaces);
+                zeros  >>= offset;
+                spaces >>= offset;
+
+                // Stop at the terminator or the bound, whichever comes first
+
+                size_t cchLeft = cchMax - ichBlock;
+                if (cchLeft < cchBlock)
+                    zeros |= (uint64_t) 1 << cchLeft;
+
+                bool     fLast  = (zeros != 0);
+                size_t   cchEnd = fLast ? __builtin_ctzll(zeros) : cchBlock;
+                uint64_t words  = ~spaces & TokenMask(cchEnd);
+                uint64_t before = (words << 1) | (fInToken ? 1 : 0);
+                uint64_t starts = words & ~before;
+                uint64_t ends   = ~words & before & TokenMask(fLast ? cchEnd + 1 : cchBlock);
+
+                for (;;)
+                {
+                    if (!fInToken)
+                    {
+                        if (!starts)
+                            break;
+                        ichStart = ichBlock + __builtin_ctzll(starts);
+                        starts  &= starts - 1;
+                        fInToken = true;
+                    }
+
+                    if (!ends)
+                        break;
+
+                    size_t ichEnd = ichBlock + __builtin_ctzll(ends);
+                    ends    &= ends - 1;
+                    fInToken = false;
+
+                    rgTokens[cTokens++] = std::string_view(str + ichStart, ichEnd - ichStart);
+                    if (cTokens == cTokensMax)
+                    {
+                        *pichRest = ichEnd;
+                        return cTokens;
+                    }
+                }
+
+                if (fLast)
+                {
+                    *pichRest = ichBlock + cchEnd;
+                    return cTokens;
+                }
+
+                ichBlock += cchBlock;
+                if (ichBlock >= cchMax)
+                {
+                    if (fInToken)
+                        rgTokens[cTokens++] = std::string_view(str + ichStart, cchMax - ichStart);
+                    *pichRest = cchMax;
+                    return cTokens;
+                }
+
+                pBlock  += 32;
+                cchBlock = 32;
+                offset   = 0;
+            }
+        }
+    }
+
+    const StringKernelTable g_Avx2Kernels =
+    {
+        "avx2",
+        StrnlenAvx2,
+        CopyAvx2,
+        ScanPathAvx2,
+        TokenizeAvx2,
+    };
+}
+
+#endif
@@ -0,0 +1,302 @@
+//--------------------------------------------------------------------------------
+// StringKernelsAvx512.cpp - 64 byte kernels
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "StringKernels.h"
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#define SAFE_TARGET __attribute__((target("avx512f,avx512bw"))) SAFE_BLOCK_READS
+
+namespace SafeStrings::Internal
+{
+    namespace
+    {
+        // LowMask
+        //
+        // A mask with the low cb bits set, cb in [0, 64].
+
+        inline uint64_t LowMask(size_t cb)
+        {
+            return cb >= 64 ? ~0ull : (1ull << cb) - 1;
+        }
+
+        SAFE_TARGET inline uint64_t ZeroMask(const char * pBlock)
+        {
+            __m512i v = _mm512_load_si512((const void *) pBlock);
+            return _mm512_testn_epi8_mask(v, v);
+        }
+
+        // StrnlenAvx512
+        //
+        // One aligned 64 byte block per step; the compare lands directly in a
+        // mask register, so there is no movemask and no pairing to bother with.
+
+        SAFE_TARGET size_t StrnlenAvx512(const char * str, size_t cchMax)
+        {
+            if (cchMax == 0)
+                return 0;
+
+            uintptr_t    offset = (uintptr_t) str & 63;
+            const char * pBlock = str - offset;
+
+            uint64_t mask = ZeroMask(pBlock) >> offset;
+            if (mask)
+            {
+                size_t idx = __builtin_ctzll(mask);
+                return idx < cchMax ? idx : cchMax;
+            }
+
+            size_t cchScanned = 64 - offset;
+
+            while (cchScanned < cchMax)
+            {
+                pBlock += 64;
+                mask = ZeroMask(pBlock);
+                if (mask)
+                {
+                    size_t idx = cchScanned + __builtin_ctzll(mask);
+                    return idx < cchMax ? idx : cchMax;
+                }
+                cchScanned += 64;
+            }
+
+            return cchMax;
+        }
+        // CopyAvx512
+        //
+        // Masked loads and stores make the ragged ends free: the head is read
+        // with a masked unaligned load that cannot touch the bytes before
+        // src, and the final partial block is written with a masked store
+        // that stops exactly at the terminator or the end of dest.
+
+        SAFE_TARGET size_t CopyAvx512(char * dest, const char * src, size_t destsz)
+        {
+            uintptr_t offset  = (uintptr_t) src & 63;
+            size_t    cchHead = 64 - offset;
+
+            __mmask64 kHead = LowMask(cchHead);
+            __m512i   v     = _mm512_maskz_loadu_epi8(kHead, src);
+            uint64_t  mask  = _mm512_testn_epi8_mask(v, v) & kHead;
+
+            size_t cch = 0;
+            const char * pBlock = src + cchHead;
+
+            if (!mask && cchHead < destsz)
+            {
+                _mm512_mask_storeu_epi8(dest, kHead, v);
+                cch = cchHead;
+
+                for (; cch + 64 <= destsz; pBlock += 64, cch += 64)
+                {
+                    v    = _mm512_load_si512((const void *) pBlock);
+                    mask = _mm512_testn_epi8_mask(v, v);
+                    if (mask)
+                        break;
+                    _mm512_storeu_si512((void *)(dest + cch), v);
+                }
+
+                if (!mask)
+                {
+                    if (cch == destsz)
+                        return destsz;
+                    v    = _mm512_load_si512((const void *) pBlock);
+                    mask = _mm512_testn_epi8_mask(v, v);
+                }
+            }
+
+            // v holds the block with the terminator (if mask is non-zero) and
+            // dest has room for destsz - cch more bytes
+
+            size_t idx = mask ? __builtin_ctzll(mask) : 64;
+            if (idx >= destsz - cch)
+                return destsz;
+
+            _mm512_mask_storeu_epi8(dest + cch, LowMask(idx + 1), v);
+            return cch + idx;
+        }
+
+        SAFE_TARGET inline void ClassifyPath(const char * pBlock, uint64_t & zeros, uint64_t & seps, uint64_t & dots)
+        {
+            __m512i v = _mm512_load_si512((const void *) pBlock);
+            zeros = _mm512_testn_epi8_mask(v, v);
+            seps  = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('/'));
+            dots  = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('.'));
+        }
+
+        // ScanPathAvx512
+        //
+        // ScanPathSse2 with 64 byte blocks, the compares landing straight in
+        // mask registers.  Most paths fit in a single block.
+
+        SAFE_TARGET PathScan ScanPathAvx512(const char * str, size_t cchMax)
+        {
+            PathScan scan = { 0, 0, 0 };
+            if (cchMax == 0)
+                return scan;
+
+            uintptr_t    offset = (uintptr_t) str & 63;
+            const char * pBlock = str - offset;
+
+            size_t ichBlock = 0;                // Index in str of the block's first bit
+            size_t cchBlock = 64 - offset;      // Bits in the block that belong to str
+
+            for (;;)
+            {
+                uint64_t zeros, seps, dots;
+                ClassifyPath(pBlock, zeros, seps, dots);
+                zeros >>= offset;
+                seps  >>= offset;
+                dots  >>= offset;
+
+                // Stop at the terminator or the bound, whichever comes first
+
+                size_t cchLeft = cchMax - ichBlock;
+                if (cchLeft < cchBlock)
+                    zeros |= (uint64_t) 1 << cchLeft;
+
+                bool fLast = (zeros != 0);
+                if (fLast)
+                {
+                    size_t idx = __builtin_ctzll(zeros);
+                    seps     &= ((uint64_t) 1 << idx) - 1;
+                    dots     &= ((uint64_t) 1 << idx) - 1;
+                    scan.cch  = ichBlock + idx;
+                }
+
+                if (seps)
+                    scan.ichAfterSeparator = ichBlock + 64 - __builtin_clzll(seps);
+                if (dots)
+                    scan.ichAfterDot = ichBlock + 64 - __builtin_clzll(dots);
+
+                if (fLast)
+                    return scan;
+
+                ichBlock += cchBlock;
+                if (ichBlock >= cchMax)
+                {
+                    scan.cch = cchMax;
+                    return scan;
+                }
+
+                pBlock  += 64;
+                cchBlock = 64;
+                offset   = 0;
+            }
+        }
+
+        SAFE_TARGET inline void ClassifySpace(const char * pBlock, uint64_t & zeros, uint64_t & spaces)
+        {
+            __m512i v = _mm512_load_si512((const void *) pBlock);
+            zeros  = _mm512_testn_epi8_mask(v, v);
+            spaces = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(' ')) |
+                     _mm512_cmple_epu8_mask(_mm512_sub_epi8(v, _mm512_set1_epi8('\t')), _mm512_set1_epi8('\r' - '\t'));
+        }
+
+        // TokenizeAvx512
+        //
+        // TokenizeSse2 with 64 byte blocks, and a real unsigned compare for
+        // the '\t' to '\r' range.
+
+        SAFE_TARGET size_t TokenizeAvx512(const char * str, size_t cchMax,
+                                          std::string_view * rgTokens, size_t cTokensMax, size_t * pichRest)
+        {
+            size_t cTokens = 0;
+            *pichRest = 0;
+            if (cchMax == 0 || cTokensMax == 0)
+                return 0;
+
+            uintptr_t    offset = (uintptr_t) str & 63;
+            const char * pBlock = str - offset;
+
+            size_t ichBlock = 0;                // Index in str of the block's first bit
+            size_t cchBlock = 64 - offset;      // Bits in the block that belong to str
+            size_t ichStart = 0;
+            bool   fInToken = false;
+
+            for (;;)
+            {
+                uint64_t zeros, spaces;
+                ClassifySpace(pBlock, zeros, spaces);
+                zeros  >>= offset;
+                spaces >>= offset;
+
+                // Stop at the terminator or the bound, whichever comes first
+
+                size_t cchLeft = cchMax - ichBlock;
+                if (cchLeft < cchBlock)
+                    zeros |= (uint64_t) 1 << cchLeft;
+
+                bool     fLast  = (zeros != 0);
+                size_t   cchEnd = fLast ? __builtin_ctzll(zeros) : cchBlock;
+                uint64_t words  = ~spaces & LowMask(cchEnd);
+                uint64_t before = (words << 1) | (fInToken ? 1 : 0);
+                uint64_t starts = words & ~before;
+                uint64_t ends   = ~words & before & LowMask(fLast ? cchEnd + 1 : cchBlock);
+
+                for (;;)
+                {
+                    if (!fInToken)
+                    {
+                        if (!starts)
+                            break;
+                        ichStart = ichBlock + __builtin_ctzll(starts);
+                        starts  &= starts - 1;
+                        fInToken = true;
+                    }
+
+                    if (!ends)
+                        break;
+
+                    size_t ichEnd = ichBlock + __builtin_ctzll(ends);
+                    ends    &= ends - 1;
+                    fInToken = false;
+
+                    rgTokens[cTokens++] = std::string_view(str + ichStart, ichEnd - ichStart);
+                    if (cTokens == cTokensMax)
+                    {
+                        *pichRest = ichEnd;
+                        return cTokens;
+                    }
+                }
+
+                if (fLast)
+                {
+                    *pichRest = ichBlock + cchEnd;
+                    return cTokens;
+                }
+
+                ichBlock += cchBlock;
+                if (ichBlock >= cchMax)
+                {
+                    if (fInToken)
+                        rgTokens[cTokens++] = std::string_view(str + ichStart, cchMax - ichStart);
+                    *pichRest = cchMax;
+                    return cTokens;
+                }
+
+                pBlock  += 64;
+                cchBlock = 64;
+                offset   = 0;
+            }
+        }
+    }
+
+    const StringKernelTable g_Avx512Kernels =
+    {
+        "avx512",
+        StrnlenAvx512,
+        CopyAvx512,
+        ScanPathAvx512,
+        TokenizeAvx512,
+    };
+}
+
+#endif
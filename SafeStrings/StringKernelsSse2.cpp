@@ -0,0 +1,387 @@
+//--------------------------------------------------------------------------------
+// StringKernelsSse2.cpp - 16 byte kernels
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "StringKernels.h"
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#define SAFE_TARGET __attribute__((target("sse2"))) SAFE_BLOCK_READS
+
+namespace SafeStrings::Internal
+{
+    namespace
+    {
+        SAFE_TARGET inline unsigned ZeroMask(const char * pBlock)
+        {
+            __m128i v = _mm_load_si128((const __m128i *) pBlock);
+            return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+        }
+
+        // StrnlenSse2
+        //
+        // The first load is rounded down to a 16 byte boundary and the bits for
+        // bytes before str are shifted away; after that every load is aligned
+        // and only issued while some of its bytes are still inside cchMax.
+
+        SAFE_TARGET size_t StrnlenSse2(const char * str, size_t cchMax)
+        {
+            if (cchMax == 0)
+                return 0;
+
+            uintptr_t    offset = (uintptr_t) str & 15;
+            const char * pBlock = str - offset;
+
+            unsigned mask = ZeroMask(pBlock) >> offset;
+            if (mask)
+            {
+                size_t idx = __builtin_ctz(mask);
+                return idx < cchMax ? idx : cchMax;
+            }
+
+            size_t cchScanned = 16 - offset;
+
+            // One more single block if needed so that the pairs below start on
+            // a 32 byte boundary; a pair then never straddles a page, even
+            // when its first half holds the terminator.
+
+            if (((uintptr_t) pBlock & 16) == 0 && cchScanned < cchMax)
+            {
+                pBlock += 16;
+                mask = ZeroMask(pBlock);
+                if (mask)
+                {
+                    size_t idx = cchScanned + __builtin_ctz(mask);
+                    return idx < cchMax ? idx : cchMax;
+                }
+                cchScanned += 16;
+            }
+
+            // Two blocks per step while both overlap the bound
+
+            while (cchScanned + 16 < cchMax)
+            {
+                unsigned mask0 = ZeroMask(pBlock + 16);
+                unsigned mask1 = ZeroMask(pBlock + 32);
+                if (mask0 | mask1)
+                {
+                    size_t idx = cchScanned + __builtin_ctz(mask0 | (mask1 << 16));
+                    return idx < cchMax ? idx : cchMax;
+                }
+                pBlock     += 32;
+                cchScanned += 32;
+            }
+
+            if (cchScanned < cchMax)
+            {
+                mask = ZeroMask(pBlock + 16);
+                if (mask)
+                {
+                    size_t idx = cchScanned + __builtin_ctz(mask);
+                    return idx < cchMax ? idx : cchMax;
+                }
+            }
+
+            return cchMax;
+        }
+
+        // CopySse2
+        //
+        // Fused strlen + copy: each aligned 16 byte block of src is tested
+        // for the terminator and, if it has none and fits, stored straight to
+        // dest from the register it was tested in.  The head (before the first
+        // aligned block) and the block holding the terminator go through
+        // CopySmall so that nothing past the terminator is written.
+
+        SAFE_TARGET size_t CopySse2(char * dest, const char * src, size_t destsz)
+        {
+            uintptr_t    offset  = (uintptr_t) src & 15;
+            const char * pBlock  = src - offset;
+            size_t       cchHead = 16 - offset;
+
+            unsigned mask = ZeroMask(pBlock) >> offset;
+            if (mask)
+            {
+                size_t idx = __builtin_ctz(mask);
+                if (idx >= destsz)
+                    return destsz;
+                CopySmall(dest, src, idx + 1);
+                return idx;
+            }
+
+            if (cchHead >= destsz)
+                return destsz;
+            CopySmall(dest, src, cchHead);
+
+            size_t cch = cchHead;
+            pBlock += 16;
+
+            // Single blocks until src is 64 byte aligned, so that the
+            // unrolled loop below never reads a block in the next page after
+            // one that already held the terminator
+
+            for (; ((uintptr_t) pBlock & 63) != 0 && cch + 16 <= destsz; pBlock += 16, cch += 16)
+            {
+                __m128i v = _mm_load_si128((const __m128i *) pBlock);
+                mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+                if (mask)
+                {
+                    size_t idx = __builtin_ctz(mask);
+                    CopySmall(dest + cch, pBlock, idx + 1);
+                    return cch + idx;
+                }
+                _mm_storeu_si128((__m128i *)(dest + cch), v);
+            }
+
+            // Four blocks per step.  The unsigned minimum of the four is zero
+            // exactly when one of them holds the terminator, and that block is
+            // then found by the single block loop that follows.
+
+            for (; cch + 64 <= destsz; pBlock += 64, cch += 64)
+            {
+                __m128i v0 = _mm_load_si128((const __m128i *)(pBlock));
+                __m128i v1 = _mm_load_si128((const __m128i *)(pBlock + 16));
+                __m128i v2 = _mm_load_si128((const __m128i *)(pBlock + 32));
+                __m128i v3 = _mm_load_si128((const __m128i *)(pBlock + 48));
+                __m128i vMin = _mm_min_epu8(_mm_min_epu8(v0, v1), _mm_min_epu8(v2, v3));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(vMin, _mm_setzero_si128())))
+                    break;
+                _mm_storeu_si128((__m128i *)(dest + cch), v0);
+                _mm_storeu_si128((__m128i *)(dest + cch + 16), v1);
+                _mm_storeu_si128((__m128i *)(dest + cch + 32), v2);
+                _mm_storeu_si128((__m128i *)(dest + cch + 48), v3);
+            }
+
+            for (; cch + 16 <= destsz; pBlock += 16, cch += 16)
+            {
+                __m128i v = _mm_load_si128((const __m128i *) pBlock);
+                mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+                if (mask)
+                {
+                    size_t idx = __builtin_ctz(mask);
+                    CopySmall(dest + cch, pBlock, idx + 1);
+                    return cch + idx;
+                }
+                _mm_storeu_si128((__m128i *)(dest + cch), v);
+            }
+
+            // Less than a block of room left; only worth copying if the
+            // terminator lands inside it
+
+            if (cch < destsz)
+            {
+                mask = ZeroMask(pBlock);
+                size_t idx = mask ? __builtin_ctz(mask) : 16;
+                if (idx < destsz - cch)
+                {
+                    CopySmall(dest + cch, pBlock, idx + 1);
+                    return cch + idx;
+                }
+            }
+
+            return destsz;
+        }
+
+        // ClassifyPath
+        //
+        // A bit per byte of the aligned block for each class of interest.
+
+        SAFE_TARGET inline void ClassifyPath(const char * pBlock, uint32_t & zeros, uint32_t & seps, uint32_t & dots)
+        {
+            __m128i v = _mm_load_si128((const __m128i *) pBlock);
+            zeros = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+            seps  = (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')),
+                                                             _mm_cmpeq_epi8(v, _mm_set1_epi8('/'))));
+            dots  = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+        }
+
+        // ScanPathSse2
+        //
+        // One aligned 16 byte block per step, compared against the terminator,
+        // both separators and '.'.  Paths are short enough that the first
+        // block or two usually holds the whole thing.
+
+        SAFE_TARGET PathScan ScanPathSse2(const char * str, size_t cchMax)
+        {
+            PathScan scan = { 0, 0, 0 };
+            if (cchMax == 0)
+                return scan;
+
+            uintptr_t    offset = (uintptr_t) str & 15;
+            const char * pBlock = str - offset;
+
+            size_t ichBlock = 0;                // Index in str of the block's first bit
+            size_t cchBlock = 16 - offset;      // Bits in the block that belong to str
+
+            for (;;)
+            {
+                uint32_t zeros, seps, dots;
+                ClassifyPath(pBlock, zeros, seps, dots);
+                zeros >>= offset;
+                seps  >>= offset;
+                dots  >>= offset;
+
+                // Stop at the terminator or the bound, whichever comes first
+
+                size_t cchLeft = cchMax - ichBlock;
+                if (cchLeft < cchBlock)
+                    zeros |= (uint32_t) 1 << cchLeft;
+
+                bool fLast = (zeros != 0);
+                if (fLast)
+                {
+                    size_t idx = __builtin_ctz(zeros);
+                    seps     &= ((uint32_t) 1 << idx) - 1;
+                    dots     &= ((uint32_t) 1 << idx) - 1;
+                    scan.cch  = ichBlock + idx;
+                }
+
+                if (seps)
+                    scan.ichAfterSeparator = ichBlock + 32 - __builtin_clz(seps);
+                if (dots)
+                    scan.ichAfterDot = ichBlock + 32 - __builtin_clz(dots);
+
+                if (fLast)
+                    return scan;
+
+                ichBlock += cchBlock;
+                if (ichBlock >= cchMax)
+                {
+                    scan.cch = cchMax;
+                    return scan;
+                }
+
+                pBlock  += 16;
+                cchBlock = 16;
+                offset   = 0;
+            }
+        }
+
+        // TokenMask
+        //
+        // A mask with the low cb bits set, cb in [0, 63].
+
+        inline uint64_t TokenMask(size_t cb)
+        {
+            return ((uint64_t) 1 << cb) - 1;
+        }
+
+        SAFE_TARGET inline void ClassifySpace(const char * pBlock, uint64_t & zeros, uint64_t & spaces)
+        {
+            __m128i v = _mm_load_si128((const __m128i *) pBlock);
+            __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+            zeros  = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+            spaces = (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                                               _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8('\r' - '\t')), t)));
+        }
+
+        // TokenizeSse2
+        //
+        // Token starts are word bytes whose predecessor isn't one, token ends
+        // the reverse; both come out of one shift of the word mask per block,
+        // with fInToken carrying the last byte over into the next block.
+        // Starts and ends alternate, so they pair up in order.  SSE2 has no
+        // unsigned compare, so "between '\t' and '\r'" is a min and an equal.
+
+        SAFE_TARGET size_t TokenizeSse2(const char * str, size_t cchMax,
+                                          std::string_view * rgTokens, size_t cTokensMax, size_t * pichRest)
+        {
+            size_t cTokens = 0;
+            *pichRest = 0;
+            if (cchMax == 0 || cTokensMax == 0)
+                return 0;
+
+            uintptr_t    offset = (uintptr_t) str & 15;
+            const char * pBlock = str - offset;
+
+            size_t ichBlock = 0;                // Index in str of the block's first bit
+            size_t cchBlock = 16 - offset;      // Bits in the block that belong to str
+            size_t ichStart = 0;
+            bool   fInToken = false;
+
+            for (;;)
+            {
+                uint64_t zeros, spaces;
+                ClassifySpace(pBlock, zeros, spaces);
+                zeros  >>= offset;
+                spaces >>= offset;
+
+                // Stop at the terminator or the bound, whichever comes first
+
+                size_t cchLeft = cchMax - ichBlock;
+                if (cchLeft < cchBlock)
+                    zeros |= (uint64_t) 1 << cchLeft;
+
+                bool     fLast  = (zeros != 0);
+                size_t   cchEnd = fLast ? __builtin_ctzll(zeros) : cchBlock;
+                uint64_t words  = ~spaces & TokenMask(cchEnd);
+                uint64_t before = (words << 1) | (fInToken ? 1 : 0);
+                uint64_t starts = words & ~before;
+                uint64_t ends   = ~words & before & TokenMask(fLast ? cchEnd + 1 : cchBlock);
+
+                for (;;)
+                {
+                    if (!fInToken)
+                    {
+                        if (!starts)
+                            break;
+                        ichStart = ichBlock + __builtin_ctzll(starts);
+                        starts  &= starts - 1;
+                        fInToken = true;
+                    }
+
+                    if (!ends)
+                        break;
+
+                    size_t ichEnd = ichBlock + __builtin_ctzll(ends);
+                    ends    &= ends - 1;
+                    fInToken = false;
+
+                    rgTokens[cTokens++] = std::string_view(str + ichStart, ichEnd - ichStart);
+                    if (cTokens == cTokensMax)
+                    {
+                        *pichRest = ichEnd;
+                        return cTokens;
+                    }
+                }
+
+                if (fLast)
+                {
+                    *pichRest = ichBlock + cchEnd;
+                    return cTokens;
+                }
+
+                ichBlock += cchBlock;
+                if (ichBlock >= cchMax)
+                {
+                    if (fInToken)
+                        rgTokens[cTokens++] = std::string_view(str + ichStart, cchMax - ichStart);
+                    *pichRest = cchMax;
+                    return cTokens;
+                }
+
+                pBlock  += 16;
+                cchBlock = 16;
+                offset   = 0;
+            }
+        }
+    }
+
+    const StringKernelTable g_Sse2Kernels =
+    {
+        "sse2",
+        StrnlenSse2,
+        CopySse2,
+        ScanPathSse2,
+        TokenizeSse2,
+    };
+}
+
+#endif
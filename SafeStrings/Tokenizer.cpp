@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------
+// Tokenizer.cpp - Tokenize, TokenizeCopy
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "StringKernels.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdio.h>
+#include <string.h>
+
+using namespace SafeStrings::Internal;
+
+size_t SafeStrings::Tokenize(const char * input, size_t length,
+                             std::string_view * rgTokens, size_t cTokensMax, size_t * pichRest)
+{
+    if (SAFE_UNLIKELY(input == nullptr || (rgTokens == nullptr && cTokensMax != 0)))
+    {
+        if (pichRest != nullptr)
+            *pichRest = 0;
+        SAFE_RAISE(EINVAL, "input != nullptr && rgTokens != nullptr", "Tokenize");
+        return 0;
+    }
+
+    size_t ichRest;
+    size_t cTokens = FindTokens(input, length, rgTokens, cTokensMax, &ichRest);
+    if (pichRest != nullptr)
+        *pichRest = ichRest;
+    return cTokens;
+}
+
+// TokenizeCopy
+//
+// Finds the words a chunk at a time into a small array on the stack, so a
+// long list of buffers never needs an allocation.
+
+int SafeStrings::TokenizeCopy(const char * input, size_t length, const TokenBuffer * rgBuffers, size_t cBuffers)
+{
+    if (SAFE_UNLIKELY(input == nullptr || (rgBuffers == nullptr && cBuffers != 0)))
+    {
+        SAFE_RAISE(EINVAL, "input != nullptr && rgBuffers != nullptr", "TokenizeCopy");
+        return EOF;
+    }
+
+    std::string_view rgTokens[16];
+    size_t           iBuffer = 0;
+
+    while (iBuffer < cBuffers)
+    {
+        size_t ichRest;
+        size_t cWanted = std::min(cBuffers - iBuffer, std::size(rgTokens));
+        size_t cTokens = FindTokens(input, length, rgTokens, cWanted, &ichRest);
+
+        for (size_t i = 0; i < cTokens; i++, iBuffer++)
+        {
+            const TokenBuffer & buffer = rgBuffers[iBuffer];
+            if (SAFE_UNLIKELY(buffer.psz == nullptr))
+            {
+                SAFE_RAISE(EINVAL, "buffer != nullptr", "TokenizeCopy");
+                return (int) iBuffer;
+            }
+
+            if (SAFE_UNLIKELY(rgTokens[i].size() >= buffer.cch))
+            {
+                if (buffer.cch > 0)
+                    buffer.psz[0] = '\0';
+                return (int) iBuffer;
+            }
+
+            memcpy(buffer.psz, rgTokens[i].data(), rgTokens[i].size());
+            buffer.psz[rgTokens[i].size()] = '\0';
+        }
+
+        // The input ran out before the buffers did
+
+        if (cTokens < cWanted)
+            break;
+
+        input  += ichRest;
+        length -= ichRest;
+    }
+
+    return (iBuffer == 0 && cBuffers != 0) ? EOF : (int) iBuffer;
+}
@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------
+// Tokenizer.h - Whitespace separated words without _snscanf_s
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Pulling words out of a line with _snscanf_s(input, n, "%s %s %s %s", ...)
+// means a buffer and a size per word and a trip through the whole scanf
+// machinery.  Tokenize finds the same words with vector compares and
+// returns them as views into the input, with no copies at all:
+//
+//    std::string_view rgWords[4];
+//    size_t cWords = SafeStrings::Tokenize(szLine, sizeof szLine, rgWords);
+//
+// The words are what "%s" would match: runs of anything but whitespace,
+// with whitespace as isspace has it in the C locale.  As with _snscanf_s
+// the input ends at length characters or a terminator, whichever is first.
+//
+// TokenizeCopy is the drop-in for the _snscanf_s call itself, copying each
+// word into a buffer whose size the compiler already knows:
+//
+//    SafeStrings::TokenizeCopy(szLine, sizeof szLine, szWord1, szWord2, szWord3, szWord4);
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <string_view>
+
+namespace SafeStrings
+{
+    // Tokenize
+    //
+    // Finds up to cTokensMax words and returns how many it found.  If
+    // pichRest isn't null it gets the index just past the last word when
+    // the array filled up, or the end of the input when it didn't, so a
+    // long line can be taken a chunk of words at a time.  A null input
+    // calls the handler and returns 0.
+
+    size_t Tokenize(const char * input, size_t length,
+                    std::string_view * rgTokens, size_t cTokensMax, size_t * pichRest = nullptr);
+
+    template <size_t N>
+    size_t Tokenize(const char * input, size_t length, std::string_view (&rgTokens)[N], size_t * pichRest = nullptr)
+    {
+        return Tokenize(input, length, rgTokens, N, pichRest);
+    }
+
+    // TokenBuffer
+    //
+    // One destination for TokenizeCopy.
+
+    struct TokenBuffer
+    {
+        char *  psz;
+        rsize_t cch;
+    };
+
+    // TokenizeCopy
+    //
+    // Copies successive words into the buffers with _snscanf_s's "%s"
+    // rules: returns the number of words stored, or EOF if the input ended
+    // before the first one.  A word that doesn't fit (with its terminator)
+    // leaves its buffer empty and ends the scan there, and buffers past the
+    // last word are left alone.  A null input or buffer calls the handler.
+
+    int TokenizeCopy(const char * input, size_t length, const TokenBuffer * rgBuffers, size_t cBuffers);
+
+    template <size_t... N>
+    int TokenizeCopy(const char * input, size_t length, char (&... rgsz)[N])
+    {
+        const TokenBuffer rgBuffers[] = { { rgsz, N }... };
+        return TokenizeCopy(input, length, rgBuffers, sizeof...(N));
+    }
+}
@@ -0,0 +1,216 @@
+//--------------------------------------------------------------------------------
+// ViolationLog.cpp - ViolationLog
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "SafeStringsInternal.h"
+#include "ViolationLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+    // The active log, and how many reports are looking at it.  A log being
+    // destroyed clears the pointer and then waits for the count to drain,
+    // so no report can still be pushing into its ring when it is freed.
+
+    std::atomic<SafeStrings::ViolationLog *> g_pActiveLog { nullptr };
+    std::atomic<size_t>                      g_cReporting { 0 };
+
+    uint32_t CurrentThreadId()
+    {
+        static thread_local uint32_t t_tid = (uint32_t) gettid();
+        return t_tid;
+    }
+}
+
+SafeStrings::ViolationLog::ViolationLog(FILE * out, size_t cRecords, unsigned msInterval)
+    : _out(out),
+      _msInterval(msInterval)
+{
+    size_t cSlots = 1;
+    while (cSlots < cRecords)
+        cSlots <<= 1;
+
+    _rgSlots.reset(new Slot[cSlots]);
+    _iMask = cSlots - 1;
+    for (size_t i = 0; i < cSlots; i++)
+        _rgSlots[i].sequence.store(i, std::memory_order_relaxed);
+
+    ViolationLog * pNone = nullptr;
+    g_pActiveLog.compare_exchange_strong(pNone, this);
+
+    _writer = std::thread(&ViolationLog::WriterMain, this);
+}
+
+SafeStrings::ViolationLog::~ViolationLog()
+{
+    ViolationLog * pThis = this;
+    g_pActiveLog.compare_exchange_strong(pThis, nullptr);
+    while (g_cReporting.load() != 0)
+        std::this_thread::yield();
+
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _fStop = true;
+    }
+    _cv.notify_one();
+    _writer.join();
+}
+
+bool SafeStrings::ViolationLog::Report(const wchar_t * expression, const wchar_t * function,
+                                       const wchar_t * file, unsigned int line)
+{
+    ViolationRecord record;
+    record.expression = expression;
+    record.function   = function;
+    record.file       = file;
+    record.line       = line;
+    record.tid        = CurrentThreadId();
+    record.nsTime     = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    g_cReporting.fetch_add(1);
+    ViolationLog * pLog = g_pActiveLog.load();
+    bool fRecorded = (pLog != nullptr) && pLog->Push(record);
+    g_cReporting.fetch_sub(1, std::memory_order_release);
+
+    return fRecorded;
+}
+
+void SafeStrings::ViolationLog::Handler(const wchar_t * expression, const wchar_t * function,
+                                        const wchar_t * file, unsigned int line, uintptr_t)
+{
+    Report(expression, function, file, line);
+}
+
+// Push
+//
+// Claims the next ticket if its slot has been read since the last lap,
+// writes the record, and publishes it by advancing the slot's sequence.  A
+// slot still a lap behind means the ring is full.
+
+bool SafeStrings::ViolationLog::Push(const ViolationRecord & record)
+{
+    uint64_t iTicket = _iTail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Slot &   slot     = _rgSlots[iTicket & _iMask];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int64_t  lag      = (int64_t)(sequence - iTicket);
+
+        if (lag == 0)
+        {
+            if (_iTail.compare_exchange_weak(iTicket, iTicket + 1, std::memory_order_relaxed))
+            {
+                slot.record = record;
+                slot.sequence.store(iTicket + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (lag < 0)
+        {
+            _cDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            iTicket = _iTail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool SafeStrings::ViolationLog::Pop(ViolationRecord & record)
+{
+    Slot & slot = _rgSlots[_iHead & _iMask];
+    if (slot.sequence.load(std::memory_order_acquire) != _iHead + 1)
+        return false;
+
+    record = slot.record;
+    slot.sequence.store(_iHead + _iMask + 1, std::memory_order_release);
+    _iHead++;
+    return true;
+}
+
+// WriteAll
+//
+// Formats everything in the ring into one buffer and writes it with as few
+// calls as it fits in.
+
+void SafeStrings::ViolationLog::WriteAll()
+{
+    char   szBatch[16384];
+    size_t cb = 0;
+
+    auto append = [&](int cch)
+    {
+        if (cch > 0)
+            cb += std::min((size_t) cch, sizeof szBatch - cb - 1);
+    };
+
+    // Reports come in bursts, so the date and time to the second is
+    // formatted once per second rather than once per record
+
+    time_t secondsFormatted = -1;
+    char   szSeconds[32]    = "";
+
+    ViolationRecord record;
+    while (Pop(record))
+    {
+        if (sizeof szBatch - cb < 1024)
+        {
+            fwrite(szBatch, 1, cb, _out);
+            cb = 0;
+        }
+
+        time_t seconds = (time_t)(record.nsTime / 1000000000);
+        if (seconds != secondsFormatted)
+        {
+            struct tm tmUtc;
+            gmtime_r(&seconds, &tmUtc);
+            strftime(szSeconds, sizeof szSeconds, "%Y-%m-%dT%H:%M:%S", &tmUtc);
+            secondsFormatted = seconds;
+        }
+
+        append(snprintf(szBatch + cb, sizeof szBatch - cb, "%s.%06dZ [%u] %ls: %ls (%ls:%u)\n", szSeconds,
+                        (int)(record.nsTime % 1000000000 / 1000), record.tid,
+                        record.function   ? record.function   : L"",
+                        record.expression ? record.expression : L"",
+                        record.file       ? record.file       : L"",
+                        record.line));
+    }
+
+    size_t cDropped = _cDropped.load(std::memory_order_relaxed);
+    if (cDropped != _cDroppedWritten)
+    {
+        append(snprintf(szBatch + cb, sizeof szBatch - cb, "%zu violation reports dropped\n", cDropped - _cDroppedWritten));
+        _cDroppedWritten = cDropped;
+    }
+
+    if (cb != 0)
+    {
+        fwrite(szBatch, 1, cb, _out);
+        fflush(_out);
+    }
+}
+
+void SafeStrings::ViolationLog::WriterMain()
+{
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (!_fStop)
+    {
+        lock.unlock();
+        WriteAll();
+        lock.lock();
+        _cv.wait_for(lock, std::chrono::milliseconds(_msInterval), [&] { return _fStop; });
+    }
+    lock.unlock();
+
+    WriteAll();
+}
@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------
+// ViolationLog.h - Constraint violations reported off the failing thread
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// A handler that prints each violation does its console I/O inside the
+// failing call, so one stream of bad input can stall a worker on a slow
+// terminal.  ViolationLog lets the handler just record what happened - a
+// few pointers, the line, the thread and the time - in a lock-free ring,
+// and formats and writes the records in batches on a thread of its own:
+//
+//    SafeStrings::ViolationLog log(stderr);
+//    _set_invalid_parameter_handler(SafeStrings::ViolationLog::Handler);
+//
+// or, from a handler that does more, ViolationLog::Report(...).
+//
+// Any number of threads can report at once; a report never blocks, takes
+// no lock and makes no system call.  If the ring is full the report is
+// dropped and counted, and the count appears in the output.
+//
+// Records keep the expression, function and file pointers rather than
+// copies, so they must outlive the log.  The library's own are string
+// literals.  One log can be active at a time; reports with none active
+// are dropped.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+
+namespace SafeStrings
+{
+    struct ViolationRecord
+    {
+        const wchar_t * expression;
+        const wchar_t * function;
+        const wchar_t * file;
+        unsigned int    line;
+        uint32_t        tid;
+        int64_t         nsTime;         // Since the epoch
+    };
+
+    class ViolationLog
+    {
+    public:
+
+        // Starts the writer thread, which wakes every msInterval to write
+        // out whatever has arrived.  The ring holds cRecords rounded up to
+        // a power of two.  The destructor writes out the rest and stops.
+
+        explicit ViolationLog(FILE * out = stderr, size_t cRecords = 4096, unsigned msInterval = 10);
+        ~ViolationLog();
+
+        ViolationLog(const ViolationLog &) = delete;
+        ViolationLog & operator=(const ViolationLog &) = delete;
+
+        // Report
+        //
+        // Records a violation in the active log.  Returns false if it was
+        // dropped: the ring was full, or no log is active.
+
+        static bool Report(const wchar_t * expression, const wchar_t * function, const wchar_t * file, unsigned int line);
+
+        // Handler
+        //
+        // An _invalid_parameter_handler that just calls Report.
+
+        static void Handler(const wchar_t * expression, const wchar_t * function, const wchar_t * file,
+                            unsigned int line, uintptr_t pReserved);
+
+        size_t Dropped() const { return _cDropped.load(std::memory_order_relaxed); }
+
+    private:
+
+        // Slot
+        //
+        // One entry of Vyukov's bounded queue.  sequence says whose turn the
+        // slot is: equal to a producer's ticket when the slot is free for
+        // it, one more once the record is written.
+
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> sequence;
+            ViolationRecord       record;
+        };
+
+        bool Push(const ViolationRecord & record);
+        bool Pop(ViolationRecord & record);
+        void WriterMain();
+        void WriteAll();
+
+        std::unique_ptr<Slot[]> _rgSlots;
+        size_t                  _iMask;
+        FILE *                  _out;
+        unsigned                _msInterval;
+
+        alignas(64) std::atomic<uint64_t> _iTail { 0 };     // Next ticket for a producer
+        alignas(64) uint64_t              _iHead = 0;       // Next slot to read; writer thread only
+        std::atomic<size_t>               _cDropped { 0 };
+        size_t                            _cDroppedWritten = 0;
+
+        std::mutex              _mtx;
+        std::condition_variable _cv;
+        bool                    _fStop = false;
+        std::thread             _writer;
+    };
+}
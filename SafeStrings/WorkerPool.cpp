@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------------
+// WorkerPool.cpp - A small fixed thread pool for the batch functions
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+//--------------------------------------------------------------------------------
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+namespace SafeStrings::Internal
+{
+    WorkerPool & WorkerPool::Instance()
+    {
+        static WorkerPool s_pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return s_pool;
+    }
+
+    WorkerPool::WorkerPool(size_t cWorkers)
+    {
+        _threads.reserve(cWorkers);
+        for (size_t i = 0; i < cWorkers; i++)
+            _threads.emplace_back(&WorkerPool::WorkerMain, this, i);
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _fStop = true;
+        }
+        _cvWork.notify_all();
+
+        for (std::thread & thread : _threads)
+            thread.join();
+    }
+
+    void WorkerPool::TakePieces()
+    {
+        for (size_t i; (i = _iNextPiece.fetch_add(1, std::memory_order_relaxed)) < _cPieces; )
+            (*_pfnPiece)(i);
+    }
+
+    // WorkerMain
+    //
+    // Sleeps until a job is posted, joins in if it is one of the first
+    // _cWorkers workers, and reports back when the pieces run out.
+
+    void WorkerPool::WorkerMain(size_t iWorker)
+    {
+        uint64_t generationSeen = 0;
+
+        std::unique_lock<std::mutex> lock(_mtx);
+        for (;;)
+        {
+            _cvWork.wait(lock, [&] { return _fStop || _generation != generationSeen; });
+            if (_fStop)
+                return;
+
+            generationSeen = _generation;
+            if (iWorker >= _cWorkers)
+                continue;
+
+            lock.unlock();
+            TakePieces();
+            lock.lock();
+
+            if (--_cBusy == 0)
+                _cvDone.notify_one();
+        }
+    }
+
+    void WorkerPool::Run(size_t cPieces, size_t cThreadsMax, const std::function<void(size_t)> & piece)
+    {
+        std::lock_guard<std::mutex> lockRun(_mtxRun);
+
+        size_t cWorkers = std::min({ _threads.size(), cThreadsMax ? cThreadsMax - 1 : 0, cPieces ? cPieces - 1 : 0 });
+        if (cWorkers == 0)
+        {
+            for (size_t i = 0; i < cPieces; i++)
+                piece(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _pfnPiece = &piece;
+            _cPieces  = cPieces;
+            _iNextPiece.store(0, std::memory_order_relaxed);
+            _cWorkers = cWorkers;
+            _cBusy    = cWorkers;
+            _generation++;
+        }
+        _cvWork.notify_all();
+
+        TakePieces();
+
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cvDone.wait(lock, [&] { return _cBusy == 0; });
+    }
+}
@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------
+// WorkerPool.h - A small fixed thread pool for the batch functions
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Not part of the public interface.  The batch functions split a large job
+// into pieces and ask the pool to run them; the calling thread takes pieces
+// too, so a pool that has no workers (or a job of one piece) simply runs on
+// the caller.  One job runs at a time.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace SafeStrings::Internal
+{
+    class WorkerPool
+    {
+    public:
+
+        // Instance
+        //
+        // The process-wide pool, with a worker per hardware thread beyond the
+        // caller's.  The threads are started the first time it's used.
+
+        static WorkerPool & Instance();
+
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool &)             = delete;
+        WorkerPool & operator=(const WorkerPool &) = delete;
+
+        // Threads
+        //
+        // How many threads a job can run on, counting the caller.
+
+        size_t Threads() const { return _threads.size() + 1; }
+
+        // Run
+        //
+        // Calls piece(i) for every i in [0, cPieces) on at most cThreadsMax
+        // threads, the caller included, and returns when all have finished.
+
+        void Run(size_t cPieces, size_t cThreadsMax, const std::function<void(size_t)> & piece);
+
+    private:
+
+        explicit WorkerPool(size_t cWorkers);
+
+        void WorkerMain(size_t iWorker);
+        void TakePieces();
+
+        std::mutex                          _mtxRun;        // Held for the length of a job
+        std::mutex                          _mtx;
+        std::condition_variable             _cvWork;
+        std::condition_variable             _cvDone;
+        std::vector<std::thread>            _threads;
+
+        const std::function<void(size_t)> * _pfnPiece   = nullptr;
+        size_t                              _cPieces    = 0;
+        std::atomic<size_t>                 _iNextPiece { 0 };
+        size_t                              _cWorkers   = 0;  // Workers taking part in this job
+        size_t                              _cBusy      = 0;  // Of those, how many haven't finished
+        uint64_t                            _generation = 0;  // Bumped for each job
+        bool                                _fStop      = false;
+    };
+}
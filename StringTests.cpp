@@ -31,16 +31,33 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
-#include <wtypes.h>
 #include <stdlib.h>
-#include <crtdbg.h>
 #include <cassert>
 
+// On Windows the safe functions come from the CRT.  Everywhere else they
+// come from libsafestrings, which implements the same cheat sheet natively.
+
+#ifdef _MSC_VER
+#include <wtypes.h>
+#include <crtdbg.h>
+#else
+#include "SafeStrings.h"
+#include "ViolationLog.h"
+#endif
+
 // Forward declarations of functions that are defined after main
 
 void TestVarArgs(char *, size_t, const char*, ...);
 void TurnOffAsserts();
 
+// Outside of Windows, violations are recorded by the handler and printed by
+// a background thread, so a failing call never waits on the console.  The
+// log is written out in full when it is destroyed after main returns.
+
+#ifndef _MSC_VER
+SafeStrings::ViolationLog g_violationLog(stdout);
+#endif
+
 // main
 //
 // Entry point. Calls each string function properly as a quick demo
@@ -216,9 +233,13 @@ void OurParameterValidationFailureHandler(
     unsigned int    line,
     uintptr_t       pReserved)
 {
+#ifdef _MSC_VER
     wprintf_s(L"Bad Mojo!  The invalid parameter handler has been "
-        L"called in %snFunction:%snFile:%snLine:%un",
+        L"called in %s\nFunction:%s\nFile:%s\nLine:%u\n",
         expression, function, file, line);
+#else
+    SafeStrings::ViolationLog::Report(expression, function, file, line);
+#endif
 }
 
 // TurnOffAsserts
@@ -232,7 +253,9 @@ void TurnOffAsserts()
     // Prevent showing "debug assertion failed" dialog box, since we'll be
     // handling any such errors and continuing.
 
+#ifdef _MSC_VER
     _CrtSetReportMode(_CRT_ASSERT, 0);
+#endif
 
     // The CRT now provides runtime checks when you're using the _s versions
     // of the string functions.  Normally if something is amiss it will just
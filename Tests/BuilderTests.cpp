@@ -0,0 +1,114 @@
+//--------------------------------------------------------------------------------
+// BuilderTests.cpp - StringBuilder against a strcat_s loop
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// A builder must leave exactly what the same run of strcat_s calls would,
+// return the same errors and call the handler the same number of times;
+// random runs of pieces are fed to both and compared after every append.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "StringBuilder.h"
+
+#include <errno.h>
+#include <random>
+
+using SafeStrings::StringBuilder;
+
+namespace
+{
+    void TestAgainstAppend()
+    {
+        std::mt19937 rng(42);
+
+        for (int run = 0; run < 2000; run++)
+        {
+            char szBuilder[48];
+            char szAppend[48];
+
+            StringBuilder sb(szBuilder);
+            szAppend[0] = '\0';
+
+            for (int iPiece = 0; iPiece < 12; iPiece++)
+            {
+                char szPiece[24];
+                size_t cch = rng() % 20;
+                for (size_t ich = 0; ich < cch; ich++)
+                    szPiece[ich] = (char)('a' + rng() % 26);
+                szPiece[cch] = '\0';
+
+                errno_t errBuilder = sb.Append(szPiece);
+                int     cBuilder   = Test::TakeViolations();
+                errno_t errAppend  = strcat_s(szAppend, sizeof szAppend, szPiece);
+                int     cAppend    = Test::TakeViolations();
+
+                if (!CHECK(errBuilder == errAppend && cBuilder == cAppend &&
+                           strcmp(szBuilder, szAppend) == 0 && sb.Length() == strlen(szAppend)))
+                {
+                    fprintf(stderr, "    run %d, piece %d: \"%s\" vs \"%s\"\n", run, iPiece, szBuilder, szAppend);
+                    return;
+                }
+            }
+        }
+    }
+
+    void TestCounted()
+    {
+        char szBuffer[8];
+        StringBuilder sb(szBuffer);
+
+        const char rgchUnterminated[] = { 'a', 'b', 'c' };
+        CHECK(sb.Append(rgchUnterminated, 2) == 0);
+        CHECK(sb.Append('-') == 0);
+        CHECK(sb.Append(nullptr, 0) == 0);
+        CHECK_STR(sb.c_str(), "ab-");
+        CHECK(sb.Length() == 3);
+
+        CHECK(sb.Append("1234", 4) == 0);
+        CHECK_STR(sb.c_str(), "ab-1234");
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(sb.Append('x') == ERANGE);
+        CHECK_STR(szBuffer, "");
+        CHECK(sb.Length() == 0);
+        CHECK(Test::TakeViolations() == 1);
+
+        CHECK(sb.Append(nullptr, 1) == EINVAL);
+        CHECK(Test::TakeViolations() == 1);
+    }
+
+    void TestAttach()
+    {
+        char szBuffer[8] = "abc";
+        StringBuilder sb = StringBuilder::Attach(szBuffer, sizeof szBuffer);
+        CHECK(sb.Length() == 3);
+        CHECK(sb.Append("def") == 0);
+        CHECK_STR(szBuffer, "abcdef");
+        CHECK(Test::TakeViolations() == 0);
+
+        memset(szBuffer, 'x', sizeof szBuffer);
+        StringBuilder sbBad = StringBuilder::Attach(szBuffer, sizeof szBuffer);
+        CHECK(sbBad.Length() == 0);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        StringBuilder sbNull(nullptr, 8);
+        CHECK(Test::TakeViolations() == 1);
+        CHECK(sbNull.Append("a") == EINVAL);
+        CHECK(Test::TakeViolations() == 1);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestAgainstAppend();
+    TestCounted();
+    TestAttach();
+
+    return Test::Finish();
+}
@@ -0,0 +1,135 @@
+//--------------------------------------------------------------------------------
+// CallSiteTests.cpp - SAFE_COUNTED's counters
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Every way the library can fail - the C functions, the formatters and the
+// header-only types - must charge the SAFE_COUNTED site it happened under,
+// once, and leave the call's own behaviour alone.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "CallSites.h"
+#include "CheckedFormat.h"
+#include "FastFormat.h"
+#include "SafeString.h"
+
+#include <errno.h>
+
+using SafeStrings::CallSite;
+
+namespace
+{
+    // Site
+    //
+    // The site registered for line, or null if it was never reached.
+
+    const CallSite * Site(unsigned int line)
+    {
+        for (const CallSite * pSite = SafeStrings::FirstCallSite(); pSite != nullptr; pSite = pSite->pNext)
+        {
+            if (pSite->line == line)
+                return pSite;
+        }
+        return nullptr;
+    }
+
+    bool Counted(unsigned int line, uint64_t cCalls, uint64_t cViolations, uint64_t cTruncations)
+    {
+        const CallSite * pSite = Site(line);
+        return pSite != nullptr && pSite->cCalls == cCalls && pSite->cViolations == cViolations &&
+               pSite->cTruncations == cTruncations;
+    }
+
+    // TestCopyFailures
+    //
+    // strcpy_s and strcat_s stop reading src once it won't fit, counted or
+    // not, so an unterminated source that ends at the guard page is safe.
+
+    void TestCopyFailures(Test::GuardedBuffer & guarded)
+    {
+        char szDest[8];
+        const char * src = guarded.Place("0123456789abcdef", 16);
+
+        errno_t err = SAFE_COUNTED(strcpy_s(szDest, sizeof szDest, src)); unsigned int lineCopy = __LINE__;
+        CHECK(err == ERANGE && szDest[0] == '\0');
+        CHECK(Counted(lineCopy, 1, 1, 0));
+        CHECK(Site(lineCopy)->cbRequestedMax == sizeof szDest + 1 && Site(lineCopy)->cbAvailable == sizeof szDest);
+
+        strcpy(szDest, "ab");
+        err = SAFE_COUNTED(strcat_s(szDest, sizeof szDest, src)); unsigned int lineCat = __LINE__;
+        CHECK(err == ERANGE && szDest[0] == '\0');
+        CHECK(Counted(lineCat, 1, 1, 0));
+        CHECK(Site(lineCat)->cbRequestedMax == sizeof szDest + 1);
+        CHECK(Test::TakeViolations() == 2);
+
+        for (int i = 0; i < 3; i++)
+            SAFE_COUNTED(strcpy_s(szDest, "ok"));
+        unsigned int lineOk = __LINE__ - 1;
+        CHECK(Counted(lineOk, 3, 0, 0));
+    }
+
+    // TestHeaderOnly
+    //
+    // SafeString and CheckedFormat raise from inline code in the caller's
+    // translation unit, and are charged all the same.
+
+    void TestHeaderOnly()
+    {
+        SafeStrings::SafeString<4> s;
+        errno_t err = SAFE_COUNTED(s.Copy("far too long")); unsigned int lineCopy = __LINE__;
+        CHECK(err == ERANGE && s.empty());
+        CHECK(Counted(lineCopy, 1, 1, 0));
+
+        err = SAFE_COUNTED(s.Append(nullptr)); unsigned int lineAppend = __LINE__;
+        CHECK(err == EINVAL);
+        CHECK(Counted(lineAppend, 1, 1, 0));
+
+        char szBuffer[16];
+        int  result = SAFE_COUNTED(SafeStrings::CheckedFormat(szBuffer, _TRUNCATE, "%s", (const char *) nullptr));
+        unsigned int lineFormat = __LINE__ - 1;
+        CHECK(result == -1 && szBuffer[0] == '\0');
+        CHECK(Counted(lineFormat, 1, 1, 0));
+        CHECK(Test::TakeViolations() == 3);
+    }
+
+    // TestTruncation
+    //
+    // _TRUNCATE is counted as a truncation, not a violation, along with the
+    // whole size the text wanted.
+
+    void TestTruncation()
+    {
+        char szBuffer[8];
+        int  result = SAFE_COUNTED(SafeStrings::FastFormat(szBuffer, sizeof szBuffer, _TRUNCATE, "%s-%d", "abcdef", 12345));
+        unsigned int line = __LINE__ - 1;
+        CHECK(result == -1);
+        CHECK(Counted(line, 1, 0, 1));
+        CHECK(Site(line)->cbRequestedMax == 13 && Site(line)->cbAvailable == sizeof szBuffer);
+        CHECK(Test::TakeViolations() == 0);
+
+        FILE * file = tmpfile();
+        CHECK(SafeStrings::WriteCallSiteMetrics(file, SafeStrings::MetricsFormat::Prometheus) == 0);
+        rewind(file);
+        char   szMetrics[16384];
+        size_t cb = fread(szMetrics, 1, sizeof szMetrics - 1, file);
+        szMetrics[cb] = '\0';
+        fclose(file);
+        CHECK(strstr(szMetrics, "safestrings_available_bytes") != nullptr);
+        CHECK(strstr(szMetrics, "CallSiteTests.cpp") != nullptr);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    Test::GuardedBuffer guarded;
+    TestCopyFailures(guarded);
+    TestHeaderOnly();
+    TestTruncation();
+
+    return Test::Finish();
+}
@@ -0,0 +1,301 @@
+//--------------------------------------------------------------------------------
+// CheatSheetTests.cpp - The cheat-sheet functions and their constraint checks
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Each function on its success path, at the edge of fitting, and on every
+// violation the Microsoft CRT reports, checking the return value, what's
+// left in the output and that the handler was called exactly when it
+// should have been.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+
+#include <errno.h>
+#include <string.h>
+
+namespace
+{
+    int VFormat(char * buffer, size_t sizeOfBuffer, size_t count, const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int result = vsnprintf_s(buffer, sizeOfBuffer, count, format, args);
+        va_end(args);
+        return result;
+    }
+
+    // Formats are passed through here so the compiler doesn't object to the
+    // ones that are wrong on purpose.
+
+    const char * Format(const char * psz)
+    {
+        return psz;
+    }
+
+    void TestLength()
+    {
+        CHECK(strnlen_s("hello", 100) == 5);
+        CHECK(strnlen_s("hello", 5) == 5);
+        CHECK(strnlen_s("hello", 3) == 3);
+        CHECK(strnlen_s("", 10) == 0);
+        CHECK(strnlen_s(nullptr, RSIZE_MAX) == 0);
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    void TestCopy()
+    {
+        char szBuffer[8];
+
+        CHECK(strcpy_s(szBuffer, sizeof szBuffer, "abc") == 0);
+        CHECK_STR(szBuffer, "abc");
+
+        CHECK(strcpy_s(szBuffer, sizeof szBuffer, "1234567") == 0);
+        CHECK_STR(szBuffer, "1234567");
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(strcpy_s(szBuffer, sizeof szBuffer, "12345678") == ERANGE);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        strcpy(szBuffer, "x");
+        CHECK(strcpy_s(szBuffer, sizeof szBuffer, nullptr) == EINVAL);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        CHECK(strcpy_s(nullptr, 8, "abc") == EINVAL);
+        CHECK(strcpy_s(szBuffer, 0, "abc") == EINVAL);
+        CHECK(strcpy_s(szBuffer, RSIZE_MAX + 1, "abc") == EINVAL);
+        CHECK(Test::TakeViolations() == 3);
+    }
+
+    void TestAppend()
+    {
+        char szBuffer[8] = "abc";
+
+        CHECK(strcat_s(szBuffer, sizeof szBuffer, "defg") == 0);
+        CHECK_STR(szBuffer, "abcdefg");
+        CHECK(Test::TakeViolations() == 0);
+
+        strcpy(szBuffer, "abc");
+        CHECK(strcat_s(szBuffer, sizeof szBuffer, "defgh") == ERANGE);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        memset(szBuffer, 'x', sizeof szBuffer);
+        CHECK(strcat_s(szBuffer, sizeof szBuffer, "a") == EINVAL);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        strcpy(szBuffer, "abc");
+        CHECK(strcat_s(szBuffer, sizeof szBuffer, nullptr) == EINVAL);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+    }
+
+    void TestFormat()
+    {
+        char szBuffer[8];
+
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, _TRUNCATE, "%d-%s", 42, "ab") == 5);
+        CHECK_STR(szBuffer, "42-ab");
+
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, _TRUNCATE, "%s", "123456789") == -1);
+        CHECK_STR(szBuffer, "1234567");
+
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, 3, "%s", "abcdef") == -1);
+        CHECK_STR(szBuffer, "abc");
+
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, 3, "%s", "ab") == 2);
+        CHECK_STR(szBuffer, "ab");
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, sizeof szBuffer, "%s", "123456789") == -1);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        int n = 0;
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, _TRUNCATE, Format("ab%n"), &n) == -1);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, _TRUNCATE, Format("%s"), (const char *) nullptr) == -1);
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, _TRUNCATE, Format("%1$s"), "a") == -1);
+        CHECK(_snprintf_s(szBuffer, sizeof szBuffer, _TRUNCATE, nullptr) == -1);
+        CHECK(Test::TakeViolations() == 3);
+
+        CHECK(_snprintf_s(nullptr, 0, 0, "%d", 1) == 0);
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(VFormat(szBuffer, sizeof szBuffer, _TRUNCATE, "%05.1f", 2.25) == 5);
+        CHECK_STR(szBuffer, "002.2");
+        CHECK(VFormat(szBuffer, sizeof szBuffer, sizeof szBuffer, "%s", "too long!") == -1);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+    }
+
+    void TestMakePath()
+    {
+        char szPath[_MAX_PATH];
+
+        CHECK(_makepath_s(szPath, sizeof szPath, "C", "\\foo", "bar", "txt") == 0);
+        CHECK_STR(szPath, "C:\\foo\\bar.txt");
+
+        CHECK(_makepath_s(szPath, sizeof szPath, "C:", "\\foo\\", "bar", ".txt") == 0);
+        CHECK_STR(szPath, "C:\\foo\\bar.txt");
+
+        CHECK(_makepath_s(szPath, sizeof szPath, nullptr, "dir/", "name", nullptr) == 0);
+        CHECK_STR(szPath, "dir/name");
+
+        CHECK(_makepath_s(szPath, sizeof szPath, "", "", "", "") == 0);
+        CHECK_STR(szPath, "");
+        CHECK(Test::TakeViolations() == 0);
+
+        char szSmall[8];
+        CHECK(_makepath_s(szSmall, sizeof szSmall, "C", "\\foo", "bar", "txt") == ERANGE);
+        CHECK_STR(szSmall, "");
+        CHECK(Test::TakeViolations() == 1);
+    }
+
+    void TestSplitPath()
+    {
+        char szDrive[_MAX_DRIVE], szDir[_MAX_DIR], szName[_MAX_FNAME], szExt[_MAX_EXT];
+
+        CHECK(_splitpath_s("C:\\foo\\bar.txt", szDrive, sizeof szDrive, szDir, sizeof szDir,
+                           szName, sizeof szName, szExt, sizeof szExt) == 0);
+        CHECK_STR(szDrive, "C:");
+        CHECK_STR(szDir, "\\foo\\");
+        CHECK_STR(szName, "bar");
+        CHECK_STR(szExt, ".txt");
+
+        CHECK(_splitpath_s("/a.b/c.tar.gz", szDrive, sizeof szDrive, szDir, sizeof szDir,
+                           szName, sizeof szName, szExt, sizeof szExt) == 0);
+        CHECK_STR(szDrive, "");
+        CHECK_STR(szDir, "/a.b/");
+        CHECK_STR(szName, "c.tar");
+        CHECK_STR(szExt, ".gz");
+
+        CHECK(_splitpath_s("name", nullptr, 0, nullptr, 0, szName, sizeof szName, szExt, sizeof szExt) == 0);
+        CHECK_STR(szName, "name");
+        CHECK_STR(szExt, "");
+        CHECK(Test::TakeViolations() == 0);
+
+        char szTiny[3];
+        CHECK(_splitpath_s("C:\\foo\\bar.txt", szDrive, sizeof szDrive, szDir, sizeof szDir,
+                           szTiny, sizeof szTiny, szExt, sizeof szExt) == ERANGE);
+        CHECK_STR(szDrive, "");
+        CHECK_STR(szDir, "");
+        CHECK_STR(szTiny, "");
+        CHECK_STR(szExt, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        CHECK(_splitpath_s("a.b", nullptr, 3, nullptr, 0, nullptr, 0, nullptr, 0) == EINVAL);
+        CHECK(Test::TakeViolations() == 1);
+    }
+
+    void TestScan()
+    {
+        int  n = 0;
+        char szWord[8];
+        char szShort[3];
+
+        CHECK(sscanf_s("42 hello", "%d %s", &n, szWord, (rsize_t) sizeof szWord) == 2);
+        CHECK(n == 42);
+        CHECK_STR(szWord, "hello");
+
+        // A field that doesn't fit stops the scan, with the buffer emptied
+
+        n = 0;
+        CHECK(sscanf_s("hello 42", "%s %d", szShort, (rsize_t) sizeof szShort, &n) == 0);
+        CHECK_STR(szShort, "");
+        CHECK(n == 0);
+
+        char ch = 0;
+        CHECK(sscanf_s("xyz", "%c", &ch, (rsize_t) 1) == 1);
+        CHECK(ch == 'x');
+
+        CHECK(sscanf_s("abc123", "%[a-z]%d", szWord, (rsize_t) sizeof szWord, &n) == 2);
+        CHECK_STR(szWord, "abc");
+        CHECK(n == 123);
+
+        CHECK(sscanf_s("", "%d", &n) == EOF);
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(sscanf_s(nullptr, "%d", &n) == EOF);
+        CHECK(sscanf_s("1", nullptr) == EOF);
+        CHECK(Test::TakeViolations() == 2);
+
+        // _snscanf_s reads no further than the length it's given
+
+        CHECK(_snscanf_s("12345", 3, "%d", &n) == 1);
+        CHECK(n == 123);
+
+        const char rgchUnterminated[] = { '7', '8' };
+        CHECK(_snscanf_s(rgchUnterminated, sizeof rgchUnterminated, "%d", &n) == 1);
+        CHECK(n == 78);
+
+        CHECK(_snscanf_s("9 xy", 100, "%d %s", &n, szWord, (rsize_t) sizeof szWord) == 2);
+        CHECK(n == 9);
+        CHECK_STR(szWord, "xy");
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    void TestGets()
+    {
+        char szPath[] = "/tmp/CheatSheetTestsXXXXXX";
+        int  fd = mkstemp(szPath);
+        if (!CHECK(fd >= 0))
+            return;
+
+        const char c_szInput[] = "one\n"
+                                 "this line is too long\n"
+                                 "\n"
+                                 "last";
+        CHECK(write(fd, c_szInput, sizeof c_szInput - 1) == (ssize_t)(sizeof c_szInput - 1));
+        close(fd);
+
+        if (!CHECK(freopen(szPath, "rb", stdin) != nullptr))
+            return;
+
+        char szLine[8];
+        CHECK(gets_s(szLine, sizeof szLine) == szLine);
+        CHECK_STR(szLine, "one");
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(gets_s(szLine, sizeof szLine) == nullptr);
+        CHECK_STR(szLine, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        CHECK(gets_s(szLine, sizeof szLine) == szLine);
+        CHECK_STR(szLine, "");
+
+        CHECK(gets_s(szLine, sizeof szLine) == szLine);
+        CHECK_STR(szLine, "last");
+
+        CHECK(gets_s(szLine, sizeof szLine) == nullptr);
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(gets_s(nullptr, 8) == nullptr);
+        CHECK(Test::TakeViolations() == 1);
+
+        unlink(szPath);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestLength();
+    TestCopy();
+    TestAppend();
+    TestFormat();
+    TestMakePath();
+    TestSplitPath();
+    TestScan();
+    TestGets();
+
+    return Test::Finish();
+}
@@ -0,0 +1,334 @@
+//--------------------------------------------------------------------------------
+// FormatTests.cpp - The formatters against _snprintf_s and snprintf
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Every formatter in the library promises _snprintf_s's buffer, count and
+// _TRUNCATE rules; they differ only in how they get there.  Each is run on
+// the same formats, arguments, buffer sizes and counts as _snprintf_s and
+// must leave the same text, return the same value and call the handler as
+// often.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "CheckedFormat.h"
+#include "FastFormat.h"
+#include "FormatPlan.h"
+
+#include <errno.h>
+#include <new>
+#include <random>
+#include <stdlib.h>
+
+// Counts heap allocations, so the append tests can see how many a call made
+
+static int g_cAllocations = 0;
+
+void * operator new(size_t cb)
+{
+    g_cAllocations++;
+    if (void * pv = malloc(cb ? cb : 1))
+        return pv;
+    throw std::bad_alloc();
+}
+
+void operator delete(void * pv) noexcept
+{
+    free(pv);
+}
+
+void operator delete(void * pv, size_t) noexcept
+{
+    free(pv);
+}
+
+namespace
+{
+    const size_t c_rgCounts[] = { 0, 3, 8, _TRUNCATE };
+
+    // Outcome
+    //
+    // What one call did: its return, the text left and the handler calls.
+
+    struct Outcome
+    {
+        int         result;
+        std::string str;
+        int         cViolations;
+
+        bool operator==(const Outcome &) const = default;
+    };
+
+    template <typename Call>
+    Outcome Run(char * buffer, size_t sizeOfBuffer, Call && call)
+    {
+        memset(buffer, '#', sizeOfBuffer);
+        int result = call();
+        return { result, std::string(buffer, strnlen(buffer, sizeOfBuffer)), Test::TakeViolations() };
+    }
+
+    // Compare
+    //
+    // formatter(buffer, size, count) against _snprintf_s with the same
+    // format and arguments, over a range of buffer sizes and counts.
+
+    template <typename Formatter, typename Reference>
+    bool Compare(const char * pszCase, Formatter && formatter, Reference && reference)
+    {
+        char rgchActual[40];
+        char rgchExpected[40];
+
+        for (size_t size = 1; size <= sizeof rgchActual; size++)
+        {
+            for (size_t count : c_rgCounts)
+            {
+                Outcome actual   = Run(rgchActual, size, [&] { return formatter(rgchActual, size, count); });
+                Outcome expected = Run(rgchExpected, size, [&] { return reference(rgchExpected, size, count); });
+                if (!CHECK(actual == expected))
+                {
+                    fprintf(stderr, "    %s, size %zu, count %zu: %d \"%s\" (%d) vs %d \"%s\" (%d)\n",
+                            pszCase, size, count,
+                            actual.result, actual.str.c_str(), actual.cViolations,
+                            expected.result, expected.str.c_str(), expected.cViolations);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+// Runs FORMATTER(buffer, size, count, format, ...) and _snprintf_s on the
+// same literal format and arguments
+
+#define COMPARE_FORMAT(FORMATTER, ...)                                                          \
+    Compare(#__VA_ARGS__,                                                                       \
+            [&](char * b, size_t n, size_t c) { return FORMATTER(b, n, c, __VA_ARGS__); },      \
+            [&](char * b, size_t n, size_t c) { return _snprintf_s(b, n, c, __VA_ARGS__); })
+
+    void TestCheckedFormat()
+    {
+        using SafeStrings::CheckedFormat;
+
+        std::mt19937 rng(42);
+        for (int run = 0; run < 200; run++)
+        {
+            int          i  = (int)(rng() - (rng() >> 1));
+            unsigned     u  = rng();
+            long long    ll = (long long) rng() << 20;
+            double       d  = (double)(int) rng() / 977.0;
+            char         sz[16];
+            size_t       cch = rng() % 15;
+            for (size_t ich = 0; ich < cch; ich++)
+                sz[ich] = (char)('a' + rng() % 26);
+            sz[cch] = '\0';
+
+            COMPARE_FORMAT(CheckedFormat, "%d|%s|%x", i, sz, u);
+            COMPARE_FORMAT(CheckedFormat, "%-8.3s|%+05d|%lld", sz, i, ll);
+            COMPARE_FORMAT(CheckedFormat, "%.2f %g %e", d, d, d);
+            COMPARE_FORMAT(CheckedFormat, "%c%%%10u", 'x', u);
+        }
+
+        char szBuffer[16];
+        CHECK(CheckedFormat(szBuffer, _TRUNCATE, "%d %s", 1, (const char *) nullptr) == -1);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        CHECK(CheckedFormat(szBuffer, _TRUNCATE, "%d %s", 1, "ok") == 4);
+        CHECK_STR(szBuffer, "1 ok");
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    // TestFastFormat
+    //
+    // The fast paths and the per-conversion fallback against _snprintf_s.
+    // Float conversions without a precision print the shortest text that
+    // reads back, so those are checked by reading them back instead.
+
+    void TestFastFormat()
+    {
+        using SafeStrings::FastFormat;
+
+        std::mt19937 rng(7);
+        for (int run = 0; run < 200; run++)
+        {
+            int          i  = (int)(rng() - (rng() >> 1));
+            unsigned     u  = rng() >> (rng() % 32);
+            long long    ll = ((long long) rng() << 32 | rng()) >> (rng() % 64);
+            double       d  = (double)(int) rng() / (double)(1u << (rng() % 24));
+            char         sz[16];
+            size_t       cch = rng() % 15;
+            for (size_t ich = 0; ich < cch; ich++)
+                sz[ich] = (char)('a' + rng() % 26);
+            sz[cch] = '\0';
+
+            COMPARE_FORMAT(FastFormat, "%d|%i|%u|%x|%X|%o", i, i, u, u, u, u);
+            COMPARE_FORMAT(FastFormat, "[%-6d][% 6d][%+06d][%.3d][%*d]", i, i, i, i, 5, i);
+            COMPARE_FORMAT(FastFormat, "%lld %llx %hd %hhu", ll, ll, (short) i, (unsigned char) u);
+            COMPARE_FORMAT(FastFormat, "%s|%.3s|%-10s|%10s|%c", sz, sz, sz, sz, 'q');
+            COMPARE_FORMAT(FastFormat, "%.2f|%.0f|%10.4f|%-+9.1f", d, d, d, d);
+            COMPARE_FORMAT(FastFormat, "%.3e|%.4E|%.5g|%.1G", d, d, d, d);
+            COMPARE_FORMAT(FastFormat, "%.3Lf", (long double) d);
+            COMPARE_FORMAT(FastFormat, "%#x|%#o|%p|%a", u, u, (void *) sz, d);
+
+            char szShortest[64];
+            CHECK(FastFormat(szShortest, _TRUNCATE, "%f", d) > 0);
+            if (!CHECK(strtod(szShortest, nullptr) == d))
+                fprintf(stderr, "    %%f of %.17g gave \"%s\"\n", d, szShortest);
+            CHECK(FastFormat(szShortest, _TRUNCATE, "%g", d) > 0);
+            CHECK(strtod(szShortest, nullptr) == d);
+        }
+
+        CHECK(COMPARE_FORMAT(FastFormat, "%d %s", 1, (const char *) nullptr));
+        CHECK(COMPARE_FORMAT(FastFormat, "100%"));
+        CHECK(COMPARE_FORMAT(FastFormat, "%5"));
+        CHECK(COMPARE_FORMAT(FastFormat, "%-.*", 3));
+        CHECK(COMPARE_FORMAT(FastFormat, "%ll"));
+        CHECK(COMPARE_FORMAT(FastFormat, "%q", 1));
+
+        int  cch;
+        char szBuffer[16];
+        CHECK(FastFormat(szBuffer, _TRUNCATE, "ab%n", &cch) == -1);
+        CHECK_STR(szBuffer, "");
+        CHECK(Test::TakeViolations() == 1);
+
+        CHECK(FastFormat(szBuffer, _TRUNCATE, "%f %g", 0.1, 2.5e-7) == 11);
+        CHECK_STR(szBuffer, "0.1 2.5e-07");
+    }
+
+    // TestFormatPlan
+    //
+    // A plan, and the per-thread cache, against FastFormat on the same
+    // format, which itself was checked against _snprintf_s above.
+
+// Runs a FormatPlan and FormatCached on FORMAT against FastFormat
+
+#define COMPARE_PLAN(FORMAT, ...)                                                                       \
+    do                                                                                                  \
+    {                                                                                                   \
+        const char * format = FORMAT;                                                                   \
+        FormatPlan   plan(format);                                                                      \
+        Compare(format,                                                                                 \
+                [&](char * b, size_t n, size_t c) { return plan.Format(b, n, c, __VA_ARGS__); },        \
+                [&](char * b, size_t n, size_t c) { return FastFormat(b, n, c, format, __VA_ARGS__); });\
+        Compare(format,                                                                                 \
+                [&](char * b, size_t n, size_t c) { return FormatCached(b, n, c, format, __VA_ARGS__); },\
+                [&](char * b, size_t n, size_t c) { return FastFormat(b, n, c, format, __VA_ARGS__); });\
+    } while (0)
+
+    void TestFormatPlan()
+    {
+        using SafeStrings::FastFormat;
+        using SafeStrings::FormatCached;
+        using SafeStrings::FormatPlan;
+
+        std::mt19937 rng(11);
+        for (int run = 0; run < 100; run++)
+        {
+            int          i   = (int)(rng() - (rng() >> 1));
+            double       d   = (double)(int) rng() / 977.0;
+            const char * psz = (run % 5 == 4) ? nullptr : "word";
+
+            COMPARE_PLAN("%d|%s|%x", i, psz, (unsigned) i);
+            COMPARE_PLAN("[%-6d][%+06d]%s", i, i, psz);
+            COMPARE_PLAN("%s=%.2f (%g)", psz, d, d);
+            COMPARE_PLAN("%d%%%s%c", i, psz, 'z');
+            COMPARE_PLAN("%*d|%.*s", 6, i, 3, psz);
+            COMPARE_PLAN("%#x %p", (unsigned) i, (void *) &i);
+            COMPARE_PLAN("plain text %d", i);
+            COMPARE_PLAN("%d %n", i, (int *) nullptr);
+        }
+
+        // A null format is a violation on every call, planned or cached
+
+        char szBuffer[16];
+        FormatPlan planNull(nullptr);
+        CHECK(planNull.Format(szBuffer, _TRUNCATE) == -1);
+        CHECK(FormatCached(szBuffer, _TRUNCATE, nullptr) == -1);
+        CHECK(planNull.Format(szBuffer, _TRUNCATE) == -1);
+        CHECK(Test::TakeViolations() == 3);
+
+        // The cache is keyed on the address, and clearing it picks up new text
+
+        char szFormat[8] = "a%d";
+        CHECK(FormatCached(szBuffer, _TRUNCATE, szFormat, 1) == 2);
+        CHECK_STR(szBuffer, "a1");
+        SafeStrings::ClearFormatPlanCache();
+        strcpy(szFormat, "b%d");
+        CHECK(FormatCached(szBuffer, _TRUNCATE, szFormat, 2) == 2);
+        CHECK_STR(szBuffer, "b2");
+    }
+
+    // TestMeasuredAndAppend
+    //
+    // FormatMeasured must report what snprintf would need, and FormatAppend
+    // must append what snprintf would write with at most one allocation,
+    // and none at all when str already has the room.
+
+    void TestMeasuredAndAppend()
+    {
+        using SafeStrings::FormatAppend;
+        using SafeStrings::FormatMeasured;
+
+        std::string strPiece;
+        for (size_t cchPiece : { 0, 1, 100, 255, 256, 257, 1000, 5000 })
+        {
+            strPiece.assign(cchPiece, 'p');
+            std::string strExpected(cchPiece + 32, '\0');
+            int cchExpected = snprintf(&strExpected[0], strExpected.size(), "<%s|%d>", strPiece.c_str(), 42);
+            strExpected.resize(cchExpected);
+
+            char   szSmall[16];
+            size_t cchNeeded = 0;
+            CHECK(FormatMeasured(szSmall, &cchNeeded, "<%s|%d>", strPiece.c_str(), 42) == (cchExpected < 16 ? cchExpected : -1));
+            CHECK(cchNeeded == (size_t) cchExpected);
+            CHECK(strncmp(szSmall, strExpected.c_str(), 15) == 0);
+            CHECK(FormatMeasured(nullptr, 0, &cchNeeded, "<%s|%d>", strPiece.c_str(), 42) == 0);
+            CHECK(cchNeeded == (size_t) cchExpected);
+
+            for (size_t cchReserve : { (size_t) 0, (size_t) 300, (size_t) cchExpected + 8 })
+            {
+                std::string str = "head";
+                str.reserve(cchReserve);
+                const char * pchBefore = str.data();
+                bool fRoom = str.capacity() - str.size() >= (size_t) cchExpected;
+
+                g_cAllocations = 0;
+                CHECK(FormatAppend(str, "<%s|%d>", strPiece.c_str(), 42) == 0);
+                int cAllocations = g_cAllocations;
+
+                CHECK(str == "head" + strExpected);
+                CHECK(cAllocations <= 1);
+                if (fRoom)
+                    CHECK(cAllocations == 0 && str.data() == pchBefore);
+            }
+        }
+
+        // A short append writes only its own bytes, however much spare
+        // capacity there is: the bytes past them keep what was left there
+
+        std::string str(1 << 20, 'x');
+        str.resize(4);
+        CHECK(FormatAppend(str, "<%d>", 42) == 0 && str == "xxxx<42>");
+        CHECK(memchr(str.data() + str.size() + 1, '\0', (1 << 20) - str.size() - 1) == nullptr);
+
+        str = "keep";
+        str.reserve(1000);
+        CHECK(FormatAppend(str, "%s", (const char *) nullptr) == EINVAL);
+        CHECK(str == "keep");
+        CHECK(Test::TakeViolations() == 1);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestCheckedFormat();
+    TestFastFormat();
+    TestFormatPlan();
+    TestMeasuredAndAppend();
+
+    return Test::Finish();
+}
@@ -0,0 +1,211 @@
+//--------------------------------------------------------------------------------
+// HandlerTests.cpp - ViolationLog and the per-thread handlers
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Violations are reported from several threads at once, and what comes out
+// the other end - the log's lines, or each thread's own count - must
+// account for every one of them exactly once.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "ScopedHandler.h"
+#include "ViolationLog.h"
+
+#include <chrono>
+#include <errno.h>
+#include <set>
+#include <signal.h>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+
+using SafeStrings::ViolationLog;
+
+namespace
+{
+    // ReadLog
+    //
+    // Everything written to file so far, a line at a time.
+
+    std::vector<std::string> ReadLog(FILE * file)
+    {
+        std::vector<std::string> rgstr;
+        char szLine[512];
+        rewind(file);
+        while (fgets(szLine, sizeof szLine, file) != nullptr)
+        {
+            szLine[strcspn(szLine, "\n")] = '\0';
+            rgstr.push_back(szLine);
+        }
+        return rgstr;
+    }
+
+    // TestViolationLog
+    //
+    // Producers each report a numbered run of violations; the log must hold
+    // every (thread, number) pair once, each thread's in the order sent.
+
+    void TestViolationLog()
+    {
+        const int c_cThreads = 4;
+        const int c_cReports = 3000;
+
+        FILE * file = tmpfile();
+        if (!CHECK(file != nullptr))
+            return;
+
+        {
+            ViolationLog log(file, c_cThreads * c_cReports, 1);
+
+            std::vector<std::thread> rgThreads;
+            for (int iThread = 0; iThread < c_cThreads; iThread++)
+            {
+                rgThreads.emplace_back([iThread]
+                {
+                    for (int iReport = 0; iReport < c_cReports; iReport++)
+                        ViolationLog::Report(L"expression", L"Producer", L"file", (unsigned)(iThread * c_cReports + iReport));
+                });
+            }
+            for (std::thread & thread : rgThreads)
+                thread.join();
+
+            CHECK(log.Dropped() == 0);
+        }
+
+        std::set<unsigned> setSeen;
+        std::vector<int>   rgiLast(c_cThreads, -1);
+        bool               fInOrder = true;
+        for (const std::string & str : ReadLog(file))
+        {
+            unsigned line = 0;
+            const char * pszLine = strstr(str.c_str(), "(file:");
+            if (!CHECK(pszLine != nullptr && strstr(str.c_str(), "Producer: expression") != nullptr &&
+                       sscanf(pszLine, "(file:%u)", &line) == 1))
+                break;
+
+            setSeen.insert(line);
+            int iThread = (int) line / c_cReports;
+            fInOrder = fInOrder && (int) line % c_cReports > rgiLast[iThread];
+            rgiLast[iThread] = (int) line % c_cReports;
+        }
+        CHECK(setSeen.size() == (size_t)(c_cThreads * c_cReports));
+        CHECK(fInOrder);
+        fclose(file);
+
+        // A full ring drops the rest and says how many
+
+        file = tmpfile();
+        {
+            ViolationLog log(file, 4, 1000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            int cRecorded = 0;
+            for (int iReport = 0; iReport < 10; iReport++)
+                cRecorded += ViolationLog::Report(L"x", L"Full", L"file", iReport);
+            CHECK(cRecorded == 4);
+            CHECK(log.Dropped() == 6);
+        }
+        std::vector<std::string> rgstr = ReadLog(file);
+        CHECK(rgstr.size() == 5 && rgstr.back() == "6 violation reports dropped");
+        fclose(file);
+
+        // The library's own violations, through the handler, and reports with
+        // no log active
+
+        file = tmpfile();
+        {
+            ViolationLog log(file);
+            _invalid_parameter_handler pfnPrevious = _set_invalid_parameter_handler(ViolationLog::Handler);
+            char szBuffer[4];
+            CHECK(strcpy_s(szBuffer, sizeof szBuffer, "too long") == ERANGE);
+            _set_invalid_parameter_handler(pfnPrevious);
+        }
+        rgstr = ReadLog(file);
+        CHECK(rgstr.size() == 1 && strstr(rgstr[0].c_str(), "strcpy_s") != nullptr);
+        fclose(file);
+
+        CHECK(!ViolationLog::Report(L"x", L"Nobody", L"file", 1));
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    void Fail(int cTimes)
+    {
+        char szBuffer[4];
+        for (int i = 0; i < cTimes; i++)
+            strcpy_s(szBuffer, sizeof szBuffer, "too long");
+    }
+
+    // TestScopedHandler
+    //
+    // Each thread counts only its own violations, the process-wide handler
+    // sees none of them while a scope is open, and nested scopes put back
+    // what they found.
+
+    void TestScopedHandler()
+    {
+        const int c_cThreads = 8;
+
+        std::vector<std::thread> rgThreads;
+        std::vector<size_t>      rgcCounted(c_cThreads);
+        for (int iThread = 0; iThread < c_cThreads; iThread++)
+        {
+            rgThreads.emplace_back([iThread, &rgcCounted]
+            {
+                SafeStrings::ScopedHandler handler(SafeStrings::CountingHandler);
+                SafeStrings::ResetThreadViolationCount();
+                Fail(1000 + iThread);
+                rgcCounted[iThread] = SafeStrings::ThreadViolationCount();
+            });
+        }
+        for (std::thread & thread : rgThreads)
+            thread.join();
+
+        for (int iThread = 0; iThread < c_cThreads; iThread++)
+            CHECK(rgcCounted[iThread] == (size_t)(1000 + iThread));
+        CHECK(Test::TakeViolations() == 0);
+
+        {
+            SafeStrings::ScopedHandler outer(SafeStrings::CountingHandler);
+            SafeStrings::ResetThreadViolationCount();
+            {
+                SafeStrings::ScopedHandler inner(Test::CountViolation);
+                Fail(2);
+                CHECK(_get_thread_local_invalid_parameter_handler() == Test::CountViolation);
+            }
+            Fail(3);
+            CHECK(_get_thread_local_invalid_parameter_handler() == SafeStrings::CountingHandler);
+            CHECK(SafeStrings::ThreadViolationCount() == 3);
+            CHECK(Test::TakeViolations() == 2);
+        }
+        CHECK(_get_thread_local_invalid_parameter_handler() == nullptr);
+        Fail(1);
+        CHECK(Test::TakeViolations() == 1);
+
+        // A thread that must stop does, whatever the process-wide handler does
+
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            fclose(stderr);
+            SafeStrings::ScopedHandler handler(SafeStrings::AbortingHandler);
+            Fail(1);
+            _exit(0);
+        }
+        int status = 0;
+        CHECK(pid > 0 && waitpid(pid, &status, 0) == pid && WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestViolationLog();
+    TestScopedHandler();
+
+    return Test::Finish();
+}
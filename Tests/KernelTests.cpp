@@ -0,0 +1,380 @@
+//--------------------------------------------------------------------------------
+// KernelTests.cpp - Every vector kernel the CPU can run, against a naive loop
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// The kernels read whole aligned blocks, so the cases that matter are the
+// ones where the string, or the caller's bound, ends near a page that isn't
+// there.  Each table the CPU supports is checked directly, not just the one
+// dispatch picked, over every length and alignment up to a few blocks with
+// the data placed right against a guard page.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "StringKernels.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <iterator>
+#include <vector>
+
+using namespace SafeStrings::Internal;
+
+namespace
+{
+    const size_t c_cchMaxTested = 300;
+
+    // Tables
+    //
+    // The kernel tables this CPU can run.
+
+    std::vector<const StringKernelTable *> Tables()
+    {
+        std::vector<const StringKernelTable *> rgpTables = { &g_ScalarKernels };
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2"))
+            rgpTables.push_back(&g_Sse2Kernels);
+        if (__builtin_cpu_supports("avx2"))
+            rgpTables.push_back(&g_Avx2Kernels);
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+            rgpTables.push_back(&g_Avx512Kernels);
+#endif
+        return rgpTables;
+    }
+
+    size_t NaiveLength(const char * str, size_t cchMax)
+    {
+        size_t cch = 0;
+        while (cch < cchMax && str[cch] != '\0')
+            cch++;
+        return cch;
+    }
+
+    // Fill
+    //
+    // cch letters, with a byte pattern that never repeats within a block so
+    // a copy from the wrong offset shows.
+
+    void Fill(char * pch, size_t cch)
+    {
+        for (size_t ich = 0; ich < cch; ich++)
+            pch[ich] = (char)('A' + ich % 53);
+    }
+
+    void TestLength(const StringKernelTable & table, Test::GuardedBuffer & guarded)
+    {
+        char rgch[c_cchMaxTested + 1];
+
+        for (size_t cch = 0; cch <= c_cchMaxTested; cch++)
+        {
+            Fill(rgch, cch);
+            rgch[cch] = '\0';
+
+            // Terminated, with the terminator the last readable byte
+
+            const char * str = guarded.Place(rgch, cch + 1);
+            for (size_t cchMax : { (size_t) 0, cch / 2, cch, cch + 1, RSIZE_MAX })
+            {
+                if (!CHECK(table.pfnStrnlen(str, cchMax) == NaiveLength(str, cchMax)))
+                    fprintf(stderr, "    %s: length %zu, bound %zu\n", table.pszName, cch, cchMax);
+            }
+
+            // Unterminated, with the bound ending at the guard page
+
+            str = guarded.Place(rgch, cch);
+            if (!CHECK(table.pfnStrnlen(str, cch) == cch))
+                fprintf(stderr, "    %s: unterminated length %zu\n", table.pszName, cch);
+        }
+    }
+
+    // TestCopy
+    //
+    // The copy must match strlen and memcpy when src fits, report destsz
+    // when it doesn't, and never write past dest[destsz - 1] either way.
+
+    void TestCopy(const StringKernelTable & table, Test::GuardedBuffer & guarded)
+    {
+        const char c_chCanary = '#';
+
+        char rgch[c_cchMaxTested + 1];
+        char rgchDest[c_cchMaxTested + 2 + 64];
+
+        for (size_t cch = 0; cch <= c_cchMaxTested; cch++)
+        {
+            Fill(rgch, cch);
+            rgch[cch] = '\0';
+
+            const char * src = guarded.Place(rgch, cch + 1);
+            for (size_t destsz : { (size_t) 1, cch / 2 + 1, cch, cch + 1, cch + 2 + 63 })
+            {
+                if (destsz == 0)
+                    continue;
+
+                memset(rgchDest, c_chCanary, sizeof rgchDest);
+                size_t result = table.pfnCopy(rgchDest, src, destsz);
+
+                bool fFits = cch + 1 <= destsz;
+                bool fOk   = fFits ? (result == cch && memcmp(rgchDest, rgch, cch + 1) == 0)
+                                   : result == destsz;
+                for (size_t ich = destsz; ich < sizeof rgchDest; ich++)
+                    fOk = fOk && rgchDest[ich] == c_chCanary;
+
+                if (!CHECK(fOk))
+                    fprintf(stderr, "    %s: length %zu, destsz %zu, result %zu\n", table.pszName, cch, destsz, result);
+            }
+
+            // Unterminated, with destsz ending at the guard page
+
+            if (cch > 0)
+            {
+                src = guarded.Place(rgch, cch);
+                if (!CHECK(table.pfnCopy(rgchDest, src, cch) == cch))
+                    fprintf(stderr, "    %s: unterminated length %zu\n", table.pszName, cch);
+            }
+        }
+    }
+
+    // TestScanPath
+    //
+    // The path classifier against a byte loop, over text dense with
+    // separators and dots so the last of each lands in every lane.
+
+    void TestScanPath(const StringKernelTable & table, Test::GuardedBuffer & guarded)
+    {
+        static const char c_rgchAlphabet[] = "ab.\\/:";
+
+        char rgch[c_cchMaxTested + 1];
+        unsigned seed = 1;
+
+        for (size_t cch = 0; cch <= c_cchMaxTested; cch++)
+        {
+            for (size_t ich = 0; ich < cch; ich++)
+            {
+                seed = seed * 1103515245 + 12345;
+                rgch[ich] = c_rgchAlphabet[(seed >> 16) % (sizeof c_rgchAlphabet - 1)];
+            }
+            rgch[cch] = '\0';
+
+            for (bool fTerminated : { true, false })
+            {
+                const char * str    = guarded.Place(rgch, fTerminated ? cch + 1 : cch);
+                size_t       cchMax = fTerminated ? RSIZE_MAX : cch;
+
+                PathScan expected = { 0, 0, 0 };
+                for (; expected.cch < cchMax && str[expected.cch] != '\0'; expected.cch++)
+                {
+                    char ch = str[expected.cch];
+                    if (ch == '\\' || ch == '/')
+                        expected.ichAfterSeparator = expected.cch + 1;
+                    else if (ch == '.')
+                        expected.ichAfterDot = expected.cch + 1;
+                }
+
+                PathScan actual = table.pfnScanPath(str, cchMax);
+                if (!CHECK(actual.cch == expected.cch && actual.ichAfterSeparator == expected.ichAfterSeparator &&
+                           actual.ichAfterDot == expected.ichAfterDot))
+                {
+                    fprintf(stderr, "    %s: \"%.*s\" gave %zu %zu %zu\n", table.pszName, (int) cch, str,
+                            actual.cch, actual.ichAfterSeparator, actual.ichAfterDot);
+                    return;
+                }
+            }
+        }
+    }
+
+    // TestTokenize
+    //
+    // The word finder against a byte loop, with every kind of C-locale
+    // whitespace and the words cut off at the guard page.
+
+    void TestTokenize(const StringKernelTable & table, Test::GuardedBuffer & guarded)
+    {
+        static const char c_rgchAlphabet[] = "ab \t\n\v\f\rx";
+
+        char             rgch[c_cchMaxTested + 1];
+        std::string_view rgTokens[8];
+        unsigned         seed = 1;
+
+        for (size_t cch = 0; cch <= c_cchMaxTested; cch++)
+        {
+            for (size_t ich = 0; ich < cch; ich++)
+            {
+                seed = seed * 1103515245 + 12345;
+                rgch[ich] = c_rgchAlphabet[(seed >> 16) % (sizeof c_rgchAlphabet - 1)];
+            }
+            rgch[cch] = '\0';
+
+            for (bool fTerminated : { true, false })
+            {
+                const char * str    = guarded.Place(rgch, fTerminated ? cch + 1 : cch);
+                size_t       cchMax = fTerminated ? RSIZE_MAX : cch;
+
+                std::vector<std::string_view> expected;
+                size_t ichExpectedRest = 0;
+                size_t ich = 0;
+                while (ich < cch)
+                {
+                    while (ich < cch && isspace((unsigned char) str[ich]))
+                        ich++;
+                    if (ich == cch)
+                        break;
+                    size_t ichStart = ich;
+                    while (ich < cch && !isspace((unsigned char) str[ich]))
+                        ich++;
+                    expected.emplace_back(str + ichStart, ich - ichStart);
+                    if (expected.size() == std::size(rgTokens))
+                        break;
+                }
+                ichExpectedRest = (expected.size() == std::size(rgTokens)) ? ich : cch;
+
+                size_t ichRest = 0;
+                size_t cTokens = table.pfnTokenize(str, cchMax, rgTokens, std::size(rgTokens), &ichRest);
+                bool   fOk     = cTokens == expected.size() && ichRest == ichExpectedRest;
+                for (size_t iToken = 0; fOk && iToken < cTokens; iToken++)
+                    fOk = rgTokens[iToken].data() == expected[iToken].data() && rgTokens[iToken] == expected[iToken];
+
+                if (!CHECK(fOk))
+                {
+                    fprintf(stderr, "    %s: length %zu, %zu tokens (expected %zu), rest %zu (expected %zu)\n",
+                            table.pszName, cch, cTokens, expected.size(), ichRest, ichExpectedRest);
+                    return;
+                }
+            }
+        }
+    }
+
+    // TestFixed
+    //
+    // FixedCopy and FixedLength for one buffer size, as TestCopy and
+    // TestLength check the tables.
+
+    template <size_t N>
+    void TestFixed(Test::GuardedBuffer & guarded)
+    {
+        const char c_chCanary = '#';
+
+        char rgch[c_cchMaxTested + 1];
+        char rgchDest[N + 64];
+
+        for (size_t cch = 0; cch <= N + 40 && cch <= c_cchMaxTested; cch++)
+        {
+            Fill(rgch, cch);
+            rgch[cch] = '\0';
+
+            const char * src = guarded.Place(rgch, cch + 1);
+            memset(rgchDest, c_chCanary, sizeof rgchDest);
+            size_t result = FixedCopy<N>(rgchDest, src);
+
+            bool fOk = cch + 1 <= N ? (result == cch && memcmp(rgchDest, rgch, cch + 1) == 0) : result == N;
+            for (size_t ich = N; ich < sizeof rgchDest; ich++)
+                fOk = fOk && rgchDest[ich] == c_chCanary;
+            fOk = fOk && FixedLength<N>(src) == NaiveLength(src, N);
+            if (!CHECK(fOk))
+                fprintf(stderr, "    Fixed<%zu>: length %zu, result %zu\n", N, cch, result);
+
+            // Unterminated, with the buffer ending at the guard page
+
+            if (cch == N)
+            {
+                src = guarded.Place(rgch, cch);
+                CHECK(FixedLength<N>(src) == N && FixedCopy<N>(rgchDest, src) == N);
+            }
+        }
+    }
+
+    // TestInline
+    //
+    // The kernels compiled into callers, which take the scalar path in
+    // AddressSanitizer builds and aligned blocks otherwise.
+
+    void TestInline(Test::GuardedBuffer & guarded)
+    {
+        char rgch[c_cchMaxTested + 1];
+        char rgchDest[c_cchMaxTested + 2];
+
+        for (size_t cch = 0; cch <= c_cchMaxTested; cch++)
+        {
+            Fill(rgch, cch);
+            rgch[cch] = '\0';
+
+            const char * src = guarded.Place(rgch, cch + 1);
+            for (size_t cchMax : { (size_t) 1, cch / 2 + 1, cch, cch + 1, RSIZE_MAX })
+            {
+                if (cchMax == 0)
+                    continue;
+
+                size_t destsz = cchMax < sizeof rgchDest ? cchMax : sizeof rgchDest;
+                size_t result = InlineCopy(rgchDest, src, destsz);
+                bool   fOk    = cch + 1 <= destsz ? (result == cch && memcmp(rgchDest, rgch, cch + 1) == 0)
+                                                  : result == destsz;
+                fOk = fOk && InlineLength(src, cchMax) == NaiveLength(src, cchMax);
+                if (!CHECK(fOk))
+                    fprintf(stderr, "    Inline: length %zu, bound %zu, result %zu\n", cch, cchMax, result);
+            }
+
+            if (cch > 0)
+            {
+                src = guarded.Place(rgch, cch);
+                CHECK(InlineLength(src, cch) == cch && InlineCopy(rgchDest, src, cch) == cch);
+            }
+        }
+
+        TestFixed<1>(guarded);
+        TestFixed<8>(guarded);
+        TestFixed<16>(guarded);
+        TestFixed<17>(guarded);
+        TestFixed<33>(guarded);
+        TestFixed<64>(guarded);
+        TestFixed<65>(guarded);
+        TestFixed<200>(guarded);
+    }
+
+    // TestPublicCopy
+    //
+    // strcpy_s and strcat_s on sources that end at the guard page.
+
+    void TestPublicCopy(Test::GuardedBuffer & guarded)
+    {
+        char rgch[c_cchMaxTested + 1];
+        char szDest[64];
+
+        for (size_t cch = 0; cch <= c_cchMaxTested; cch++)
+        {
+            Fill(rgch, cch);
+            rgch[cch] = '\0';
+            const char * src = guarded.Place(rgch, cch + 1);
+
+            bool fFits = cch < sizeof szDest;
+            CHECK(strcpy_s(szDest, sizeof szDest, src) == (fFits ? 0 : ERANGE));
+            CHECK(strcmp(szDest, fFits ? rgch : "") == 0);
+
+            strcpy(szDest, "key=");
+            fFits = 4 + cch < sizeof szDest;
+            CHECK(strcat_s(szDest, sizeof szDest, src) == (fFits ? 0 : ERANGE));
+            CHECK(fFits ? (strncmp(szDest, "key=", 4) == 0 && strcmp(szDest + 4, rgch) == 0) : szDest[0] == '\0');
+        }
+        Test::TakeViolations();
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    Test::GuardedBuffer guarded;
+    for (const StringKernelTable * pTable : Tables())
+    {
+        printf("%s\n", pTable->pszName);
+        TestLength(*pTable, guarded);
+        TestCopy(*pTable, guarded);
+        TestScanPath(*pTable, guarded);
+        TestTokenize(*pTable, guarded);
+    }
+    TestInline(guarded);
+    TestPublicCopy(guarded);
+
+    return Test::Finish();
+}
@@ -0,0 +1,258 @@
+//--------------------------------------------------------------------------------
+// LineTests.cpp - LineReader and LineCursor against a plain split on '\n'
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Random text with lines from empty to several times the limit is read
+// through small buffers, so that lines straddle refills and long lines are
+// dropped across several of them, and through a LineCursor over the same
+// text, and must come out as the reference split says for each long-line
+// policy.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "LineReader.h"
+#include "MappedFile.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <random>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using SafeStrings::LineCursor;
+using SafeStrings::LineReader;
+using SafeStrings::LongLinePolicy;
+
+namespace
+{
+    // The line a Raise reader rejected, in the results below
+
+    const char c_szRaised[] = "<raised>";
+
+    std::string RandomText(std::mt19937 & rng, size_t cchMaxLine)
+    {
+        std::string str;
+        for (size_t cLines = rng() % 40; cLines > 0; cLines--)
+        {
+            size_t cch = (rng() % 4 == 0) ? rng() % (4 * cchMaxLine) : rng() % (cchMaxLine + 2);
+            for (size_t ich = 0; ich < cch; ich++)
+                str += (char)('a' + rng() % 26);
+            str += '\n';
+        }
+        if (rng() % 2)
+            str += "tail";
+        return str;
+    }
+
+    // ReferenceSplit
+    //
+    // What a reader under policy should return for str, one line at a time.
+
+    std::vector<std::string> ReferenceSplit(const std::string & str, size_t cchMaxLine, LongLinePolicy policy)
+    {
+        std::vector<std::string> rgstr;
+        size_t ich = 0;
+        while (ich < str.size())
+        {
+            size_t ichNewline = str.find('\n', ich);
+            if (ichNewline == std::string::npos)
+                ichNewline = str.size();
+
+            std::string strLine = str.substr(ich, ichNewline - ich);
+            if (strLine.size() <= cchMaxLine)
+                rgstr.push_back(strLine);
+            else if (policy == LongLinePolicy::Truncate)
+                rgstr.push_back(strLine.substr(0, cchMaxLine));
+            else if (policy == LongLinePolicy::Raise)
+                rgstr.push_back(c_szRaised);
+
+            ich = ichNewline + 1;
+        }
+        return rgstr;
+    }
+
+    template <typename Reader>
+    std::vector<std::string> ReadAll(Reader & reader)
+    {
+        std::vector<std::string> rgstr;
+        std::string_view line;
+        while (!reader.Eof())
+        {
+            if (reader.ReadLine(line))
+                rgstr.emplace_back(line);
+            else if (Test::TakeViolations() != 0)
+                rgstr.push_back(c_szRaised);
+        }
+        return rgstr;
+    }
+
+    void TestPolicies()
+    {
+        std::mt19937 rng(42);
+
+        for (int run = 0; run < 3000; run++)
+        {
+            size_t      cchMaxLine = 1 + rng() % 40;
+            size_t      cbBuffer   = 1 + rng() % 100;
+            std::string str        = RandomText(rng, cchMaxLine);
+
+            for (LongLinePolicy policy : { LongLinePolicy::Truncate, LongLinePolicy::Skip, LongLinePolicy::Raise })
+            {
+                FILE * file = fmemopen(str.empty() ? nullptr : &str[0], str.size(), "r");
+                if (file == nullptr)
+                    file = fopen("/dev/null", "r");
+
+                LineReader reader(file, cchMaxLine, policy, cbBuffer);
+                std::vector<std::string> rgstrActual   = ReadAll(reader);
+                std::vector<std::string> rgstrExpected = ReferenceSplit(str, cchMaxLine, policy);
+                fclose(file);
+
+                if (!CHECK(rgstrActual == rgstrExpected && reader.Error() == 0))
+                {
+                    fprintf(stderr, "    policy %d, max %zu, buffer %zu: %zu lines, expected %zu\n",
+                            (int) policy, cchMaxLine, cbBuffer, rgstrActual.size(), rgstrExpected.size());
+                    return;
+                }
+
+                LineCursor cursor(str, cchMaxLine, policy);
+                if (!CHECK(ReadAll(cursor) == rgstrExpected))
+                {
+                    fprintf(stderr, "    cursor, policy %d, max %zu\n", (int) policy, cchMaxLine);
+                    return;
+                }
+            }
+        }
+    }
+
+    // TestSplitFields
+    //
+    // Against a split on the delimiter, with the last field that fits
+    // taking the rest of the line.
+
+    void TestSplitFields()
+    {
+        std::mt19937 rng(9);
+
+        for (int run = 0; run < 20000; run++)
+        {
+            std::string strLine(rng() % 30, '\0');
+            for (char & ch : strLine)
+                ch = "ab\t,"[rng() % 4];
+
+            std::vector<std::string_view> rgExpected;
+            std::string_view rest = strLine;
+            const size_t c_cFieldsMax = 4;
+            while (rgExpected.size() + 1 < c_cFieldsMax && rest.find('\t') != std::string_view::npos)
+            {
+                rgExpected.push_back(rest.substr(0, rest.find('\t')));
+                rest.remove_prefix(rest.find('\t') + 1);
+            }
+            rgExpected.push_back(rest);
+
+            std::string_view rgFields[c_cFieldsMax];
+            size_t cFields = SafeStrings::SplitFields(strLine, '\t', rgFields);
+            bool fOk = cFields == rgExpected.size();
+            for (size_t iField = 0; fOk && iField < cFields; iField++)
+                fOk = rgFields[iField].data() == rgExpected[iField].data() && rgFields[iField] == rgExpected[iField];
+            if (!CHECK(fOk))
+            {
+                fprintf(stderr, "    \"%s\": %zu fields, expected %zu\n", strLine.c_str(), cFields, rgExpected.size());
+                return;
+            }
+        }
+    }
+
+    // TestMappedFile
+    //
+    // A regular file maps to exactly its contents; anything else fails
+    // with ENODEV instead of passing for an empty file.
+
+    void TestMappedFile()
+    {
+        char szPath[] = "/tmp/LineTestsXXXXXX";
+        int  fd       = mkstemp(szPath);
+        if (!CHECK(fd >= 0))
+            return;
+
+        std::string str = "first\nsecond\n\nlast";
+        CHECK(write(fd, str.data(), str.size()) == (ssize_t) str.size());
+        close(fd);
+
+        {
+            SafeStrings::MappedFile file(szPath);
+            CHECK(file.IsOpen() && file.View() == str);
+
+            LineCursor cursor(file.View());
+            CHECK(ReadAll(cursor) == ReferenceSplit(str, 4096, LongLinePolicy::Raise));
+        }
+
+        truncate(szPath, 0);
+        {
+            SafeStrings::MappedFile file(szPath, { .fSequential = false, .fHugePages = true, .fPopulate = true });
+            CHECK(file.IsOpen() && file.View().empty());
+        }
+        unlink(szPath);
+
+        SafeStrings::MappedFile missing(szPath);
+        CHECK(!missing.IsOpen() && missing.Error() == ENOENT && missing.View().empty());
+
+        // A pipe, through its /proc/self/fd link, and a FIFO with no writer
+
+        int rgfd[2];
+        if (CHECK(pipe(rgfd) == 0))
+        {
+            CHECK(write(rgfd[1], "data\n", 5) == 5);
+            char szPipe[64];
+            snprintf(szPipe, sizeof szPipe, "/proc/self/fd/%d", rgfd[0]);
+            SafeStrings::MappedFile piped(szPipe);
+            CHECK(!piped.IsOpen() && piped.Error() == ENODEV && piped.View().empty());
+            close(rgfd[0]);
+            close(rgfd[1]);
+        }
+
+        char szFifo[] = "/tmp/LineTestsFifoXXXXXX";
+        if (CHECK(mkdtemp(szFifo) != nullptr))
+        {
+            std::string strFifo = std::string(szFifo) + "/fifo";
+            if (CHECK(mkfifo(strFifo.c_str(), 0600) == 0))
+            {
+                SafeStrings::MappedFile fifo(strFifo.c_str());
+                CHECK(fifo.Error() == ENODEV);
+                unlink(strFifo.c_str());
+            }
+            rmdir(szFifo);
+        }
+
+        SafeStrings::MappedFile procfs("/proc/self/status");
+        CHECK(procfs.Error() == ENODEV);
+
+        SafeStrings::MappedFile null(nullptr);
+        CHECK(null.Error() == EINVAL && Test::TakeViolations() == 1);
+    }
+
+    void TestNullFile()
+    {
+        LineReader reader(nullptr);
+        CHECK(Test::TakeViolations() == 1);
+        CHECK(reader.Eof() && reader.Error() == EINVAL);
+
+        std::string_view line;
+        CHECK(!reader.ReadLine(line));
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestPolicies();
+    TestNullFile();
+    TestSplitFields();
+    TestMappedFile();
+
+    return Test::Finish();
+}
@@ -0,0 +1,207 @@
+//--------------------------------------------------------------------------------
+// NumberTests.cpp - ParseNumber against strtoll, strtoull, strtod and strtof
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Random number text - long runs of digits, leading zeros, fractions,
+// exponents, the special values and trailing junk - is parsed by both and
+// must give the same value, the same count of characters used and the same
+// overflow.  Every input sits against a guard page, terminated with a
+// length that runs far past the terminator, and unterminated with a length
+// that ends exactly at the page.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "NumberParse.h"
+
+#include <errno.h>
+#include <limits>
+#include <math.h>
+#include <random>
+#include <stdlib.h>
+
+namespace
+{
+    // RandomNumber
+    //
+    // Text strtod would read as a number, or part of one, or not at all.
+
+    std::string RandomNumber(std::mt19937 & rng, bool fFloat)
+    {
+        static const char * const c_rgpszSpecial[] = { "inf", "INFINITY", "nan", "NaN(12ab)", "infinit", "n" };
+        static const char * const c_rgpszJunk[]    = { "", "", "x", " 5", ".", "e", "e+", "-", "\t" };
+
+        std::string str;
+        switch (rng() % 3)
+        {
+            case 0:  str += '-'; break;
+            case 1:  str += '+'; break;
+            default: break;
+        }
+
+        if (fFloat && rng() % 10 == 0)
+        {
+            str += c_rgpszSpecial[rng() % std::size(c_rgpszSpecial)];
+        }
+        else
+        {
+            for (size_t cch = rng() % 4; cch > 0; cch--)
+                str += '0';
+            for (size_t cch = rng() % 26; cch > 0; cch--)
+                str += (char)('0' + rng() % 10);
+
+            if (fFloat && rng() % 2)
+            {
+                str += '.';
+                for (size_t cch = rng() % 20; cch > 0; cch--)
+                    str += (char)('0' + rng() % 10);
+            }
+            if (fFloat && rng() % 2)
+            {
+                str += "eE"[rng() % 2];
+                if (rng() % 2)
+                    str += "+-"[rng() % 2];
+                for (size_t cch = rng() % 4; cch > 0; cch--)
+                    str += (char)('0' + rng() % 10);
+            }
+        }
+
+        str += c_rgpszJunk[rng() % std::size(c_rgpszJunk)];
+        return str;
+    }
+
+    // Reference
+    //
+    // strtoll, strtoull, strtod or strtof into T, with errno and the count
+    // of characters used, clamped as ParseNumber clamps.
+
+    template <typename T>
+    struct Reference
+    {
+        T      value;
+        size_t cchUsed;
+        bool   fRange;
+    };
+
+    template <typename T>
+    Reference<T> Parse(const char * psz)
+    {
+        char * pEnd = nullptr;
+        errno = 0;
+
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            T value = std::is_same_v<T, float> ? strtof(psz, &pEnd) : strtod(psz, &pEnd);
+            return { value, (size_t)(pEnd - psz), errno == ERANGE && isinf(value) };
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            long long value  = strtoll(psz, &pEnd, 10);
+            bool      fRange = errno == ERANGE;
+            if (value > std::numeric_limits<T>::max())
+                return { std::numeric_limits<T>::max(), (size_t)(pEnd - psz), true };
+            if (value < std::numeric_limits<T>::min())
+                return { std::numeric_limits<T>::min(), (size_t)(pEnd - psz), true };
+            return { (T) value, (size_t)(pEnd - psz), fRange };
+        }
+        else
+        {
+            unsigned long long value  = strtoull(psz, &pEnd, 10);
+            bool               fRange = errno == ERANGE;
+            if (value > std::numeric_limits<T>::max())
+                return { std::numeric_limits<T>::max(), (size_t)(pEnd - psz), true };
+            return { (T) value, (size_t)(pEnd - psz), fRange };
+        }
+    }
+
+    bool SameValue(double a, double b)
+    {
+        return (isnan(a) && isnan(b)) || (a == b && signbit(a) == signbit(b));
+    }
+
+    // TestType
+    //
+    // ParseNumber into T against the C library.  strtoull wraps a negative
+    // number rather than rejecting it, so unsigned types only see "-0".
+
+    template <typename T>
+    void TestType(const char * pszType, Test::GuardedBuffer & guarded)
+    {
+        std::mt19937 rng(17);
+
+        for (int run = 0; run < 20000; run++)
+        {
+            std::string str = RandomNumber(rng, std::is_floating_point_v<T>);
+            if (std::is_unsigned_v<T> && str[0] == '-' && str.find_first_not_of("-0") < str.size() &&
+                isdigit((unsigned char) str[str.find_first_not_of("-0")]))
+                str[0] = '+';
+
+            // strtoll skips leading whitespace and ParseNumber doesn't
+
+            Reference<T> expected = Parse<T>(str.c_str());
+            bool         fNumber  = expected.cchUsed != 0 && !isspace((unsigned char) str[0]);
+
+            for (bool fTerminated : { true, false })
+            {
+                const char * input  = guarded.Place(str.c_str(), fTerminated ? str.size() + 1 : str.size());
+                size_t       length = fTerminated ? str.size() + 100 : str.size();
+
+                T       value   = (T) 7;
+                size_t  cchUsed = 99;
+                errno_t err     = SafeStrings::ParseNumber(input, length, value, &cchUsed);
+                int     cViolations = Test::TakeViolations();
+
+                bool fOk = fNumber ? (err == (expected.fRange ? ERANGE : 0) && cchUsed == expected.cchUsed &&
+                                      SameValue((double) value, (double) expected.value) &&
+                                      cViolations == (expected.fRange ? 1 : 0))
+                                   : (err == EINVAL && cchUsed == 0 && value == (T) 7 && cViolations == 0);
+                if (!CHECK(fOk))
+                {
+                    fprintf(stderr, "    %s: \"%s\" gave %d, %zu used; expected %zu used%s\n", pszType, str.c_str(),
+                            err, cchUsed, expected.cchUsed, expected.fRange ? ", ERANGE" : "");
+                    return;
+                }
+            }
+        }
+    }
+
+    void TestEdges(Test::GuardedBuffer & guarded)
+    {
+        // A short field at the end of a page, with a much longer length
+
+        int          i;
+        const char * input = guarded.Place("12", 3);
+        CHECK(SafeStrings::ParseNumber(input, 100, i) == 0 && i == 12);
+
+        double d;
+        input = guarded.Place("1.00000000000000000000001", 26);
+        CHECK(SafeStrings::ParseNumber(input, 100, d) == 0 && d == 1.0);
+        input = guarded.Place("-infinity", 10);
+        CHECK(SafeStrings::ParseNumber(input, 100, d) == 0 && d == -INFINITY);
+
+        size_t cchUsed;
+        CHECK(SafeStrings::ParseNumber("123456", 3, i, &cchUsed) == 0 && i == 123 && cchUsed == 3);
+        CHECK(SafeStrings::ParseNumber(nullptr, 3, i, &cchUsed) == EINVAL && cchUsed == 0);
+        CHECK(Test::TakeViolations() == 1);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    Test::GuardedBuffer guarded;
+    TestType<int>("int", guarded);
+    TestType<long>("long", guarded);
+    TestType<long long>("long long", guarded);
+    TestType<unsigned int>("unsigned int", guarded);
+    TestType<unsigned long>("unsigned long", guarded);
+    TestType<unsigned long long>("unsigned long long", guarded);
+    TestType<float>("float", guarded);
+    TestType<double>("double", guarded);
+    TestEdges(guarded);
+
+    return Test::Finish();
+}
@@ -0,0 +1,307 @@
+//--------------------------------------------------------------------------------
+// PathTests.cpp - SplitPath, the batch splitter and the syntaxes
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// _splitpath_s and a naive byte loop per syntax are the references for
+// SplitPath and MakePath, and SplitPath is the reference for the batch
+// splitter built on top of it.  Paths are drawn at random from an alphabet
+// of nothing but separators, dots, colons and a couple of letters, so the
+// corner cases come up constantly.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "PathBatch.h"
+#include "PathParts.h"
+
+#include <errno.h>
+#include <random>
+#include <vector>
+
+using SafeStrings::PathParts;
+using SafeStrings::SplitPath;
+
+namespace
+{
+    std::string RandomPath(std::mt19937 & rng)
+    {
+        static const char c_rgchAlphabet[] = "ab.\\/:C";
+
+        std::string str(rng() % 21, '\0');
+        for (char & ch : str)
+            ch = c_rgchAlphabet[rng() % (sizeof c_rgchAlphabet - 1)];
+        return str;
+    }
+
+    bool SameParts(const PathParts & parts, const char * pszDrive, const char * pszDir, const char * pszFname, const char * pszExt)
+    {
+        return parts.drive == pszDrive && parts.dir == pszDir && parts.fname == pszFname && parts.ext == pszExt;
+    }
+
+    // TestSplitPath
+    //
+    // Both forms of SplitPath against _splitpath_s with room for every part.
+
+    void TestSplitPath()
+    {
+        std::mt19937 rng(42);
+
+        for (int run = 0; run < 20000; run++)
+        {
+            std::string strPath = RandomPath(rng);
+
+            char szDrive[_MAX_DRIVE], szDir[_MAX_DIR], szFname[_MAX_FNAME], szExt[_MAX_EXT];
+            CHECK(_splitpath_s(strPath.c_str(), szDrive, szDir, szFname, szExt) == 0);
+
+            PathParts parts = SplitPath(strPath);
+            if (!CHECK(SameParts(parts, szDrive, szDir, szFname, szExt)))
+            {
+                fprintf(stderr, "    \"%s\": \"%s\" \"%s\" \"%s\" \"%s\"\n", strPath.c_str(), szDrive, szDir, szFname, szExt);
+                return;
+            }
+
+            PathParts partsC;
+            CHECK(SplitPath(strPath.c_str(), partsC) == 0);
+            CHECK(SameParts(partsC, szDrive, szDir, szFname, szExt));
+        }
+
+        // The demo's path, which _makepath_s builds
+
+        char szPath[_MAX_PATH];
+        CHECK(_makepath_s(szPath, "C", "\\foo", "bar", "txt") == 0);
+        CHECK(SameParts(SplitPath(szPath), "C:", "\\foo\\", "bar", ".txt"));
+        static_assert(SplitPath("C:\\foo\\bar.txt").ext == ".txt");
+
+        PathParts parts = SplitPath("x");
+        CHECK(SplitPath(nullptr, parts) == EINVAL);
+        CHECK(SameParts(parts, "", "", "", ""));
+        CHECK(Test::TakeViolations() == 1);
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    // NaiveSplit
+    //
+    // A forward, one-byte-at-a-time split under Syntax, written from the
+    // rules in PathSyntax.h rather than from SplitPath.
+
+    template <typename Syntax>
+    PathParts NaiveSplit(std::string_view path)
+    {
+        size_t ichDir = (Syntax::c_fDrives && path.size() >= 2 && path[1] == ':') ? 2 : 0;
+
+        size_t ichFname = ichDir;
+        for (size_t ich = ichDir; ich < path.size(); ich++)
+        {
+            if (Syntax::IsSeparator(path[ich]))
+                ichFname = ich + 1;
+        }
+
+        size_t ichExt = path.size();
+        for (size_t ich = ichFname; ich < path.size(); ich++)
+        {
+            if (path[ich] == '.')
+                ichExt = ich;
+        }
+
+        if (Syntax::c_fDotFileIsName && path.find_first_not_of('.', ichFname) >= ichExt)
+            ichExt = path.size();
+
+        return { path.substr(0, ichDir), path.substr(ichDir, ichFname - ichDir),
+                 path.substr(ichFname, ichExt - ichFname), path.substr(ichExt) };
+    }
+
+    // NaiveMake
+    //
+    // MakePath's rules as string concatenation.
+
+    template <typename Syntax>
+    std::string NaiveMake(const std::string & strDrive, const std::string & strDir, const std::string & strFname, const std::string & strExt)
+    {
+        std::string str;
+        if (Syntax::c_fDrives && !strDrive.empty())
+            str += strDrive.substr(0, 1) + ":";
+        if (!strDir.empty())
+        {
+            str += strDir;
+            if (!Syntax::IsSeparator(strDir.back()))
+                str += Syntax::c_chSeparator;
+        }
+        str += strFname;
+        if (!strExt.empty())
+            str += (strExt[0] == '.' ? "" : ".") + strExt;
+        return str;
+    }
+
+    // TestSyntax
+    //
+    // SplitPath and MakePath under Syntax against the naive versions, for
+    // random paths and random pieces, into buffers that sometimes fit.
+
+    template <typename Syntax>
+    void TestSyntax(const char * pszSyntax)
+    {
+        std::mt19937 rng(3);
+
+        for (int run = 0; run < 20000; run++)
+        {
+            std::string strPath  = RandomPath(rng);
+            PathParts   actual   = SplitPath<Syntax>(strPath);
+            PathParts   expected = NaiveSplit<Syntax>(strPath);
+            if (!CHECK(actual.drive == expected.drive && actual.dir == expected.dir &&
+                       actual.fname == expected.fname && actual.ext == expected.ext))
+            {
+                fprintf(stderr, "    %s: \"%s\"\n", pszSyntax, strPath.c_str());
+                return;
+            }
+
+            std::string strDir   = RandomPath(rng);
+            std::string strFname = RandomPath(rng).substr(0, 6);
+            std::string strExt   = RandomPath(rng).substr(0, 4);
+            std::string strDrive = (rng() % 2 && Syntax::c_fDrives) ? "D" : "";
+            std::string strMade  = NaiveMake<Syntax>(strDrive, strDir, strFname, strExt);
+
+            char   szPath[40];
+            size_t cbPath = 1 + rng() % sizeof szPath;
+            errno_t err   = SafeStrings::MakePath<Syntax>(szPath, cbPath, strDrive.c_str(), strDir.c_str(), strFname.c_str(), strExt.c_str());
+            bool   fFits  = strMade.size() < cbPath;
+            if (!CHECK(err == (fFits ? 0 : ERANGE) && strcmp(szPath, fFits ? strMade.c_str() : "") == 0))
+            {
+                fprintf(stderr, "    %s: made \"%s\", expected \"%s\"\n", pszSyntax, szPath, strMade.c_str());
+                return;
+            }
+            CHECK(Test::TakeViolations() == (fFits ? 0 : 1));
+        }
+
+        if constexpr (!Syntax::c_fDrives)
+        {
+            char szPath[16];
+            CHECK(SafeStrings::MakePath<Syntax>(szPath, "C", "dir", "name", "ext") == EINVAL);
+            CHECK(Test::TakeViolations() == 1);
+        }
+    }
+
+    void TestSyntaxes()
+    {
+        TestSyntax<SafeStrings::WindowsPaths>("WindowsPaths");
+        TestSyntax<SafeStrings::PosixPaths>("PosixPaths");
+        TestSyntax<SafeStrings::MixedPaths>("MixedPaths");
+
+        char szPath[32];
+        CHECK(SafeStrings::MakePath<SafeStrings::PosixPaths>(szPath, nullptr, "/usr/lib", "libc", "so") == 0);
+        CHECK_STR(szPath, "/usr/lib/libc.so");
+        CHECK(SafeStrings::MakePath<SafeStrings::MixedPaths>(szPath, "C", "\\share\\dir", "log", "txt") == 0);
+        CHECK_STR(szPath, "C:\\share\\dir/log.txt");
+
+        PathParts parts = SplitPath<SafeStrings::PosixPaths>("/home/user/.bashrc");
+        CHECK(parts.dir == "/home/user/" && parts.fname == ".bashrc" && parts.ext.empty());
+        parts = SplitPath<SafeStrings::PosixPaths>("C:\\dir\\a.b");
+        CHECK(parts.drive.empty() && parts.dir.empty() && parts.fname == "C:\\dir\\a" && parts.ext == ".b");
+    }
+
+    // Columns
+    //
+    // Storage for the batch splitter's output.
+
+    struct Columns
+    {
+        explicit Columns(size_t cPaths)
+            : rgichDir(cPaths), rgichFname(cPaths), rgichExt(cPaths), rgichEnd(cPaths), rgibStart(cPaths)
+        {
+        }
+
+        SafeStrings::SplitPathColumns View()
+        {
+            return { rgichDir.data(), rgichFname.data(), rgichExt.data(), rgichEnd.data(), rgibStart.data() };
+        }
+
+        // Path i's parts as SplitPath would return them
+
+        bool Matches(size_t i, std::string_view path) const
+        {
+            PathParts expected = SplitPath(path);
+            return rgichEnd[i] == path.size() &&
+                   path.substr(0, rgichDir[i])                                == expected.drive &&
+                   path.substr(rgichDir[i], rgichFname[i] - rgichDir[i])      == expected.dir   &&
+                   path.substr(rgichFname[i], rgichExt[i] - rgichFname[i])    == expected.fname &&
+                   path.substr(rgichExt[i], rgichEnd[i] - rgichExt[i])        == expected.ext;
+        }
+
+        std::vector<uint32_t> rgichDir, rgichFname, rgichExt, rgichEnd;
+        std::vector<size_t>   rgibStart;
+    };
+
+    // TestSplitPaths
+    //
+    // The pointer and arena batches against SplitPath, on one thread and
+    // spread over the pool in small slices.
+
+    void TestSplitPaths()
+    {
+        const size_t c_cPaths = 5000;
+
+        std::mt19937 rng(7);
+        std::vector<std::string>  rgstrPaths(c_cPaths);
+        std::vector<const char *> rgpszPaths(c_cPaths);
+        std::string               strArena;
+        for (size_t i = 0; i < c_cPaths; i++)
+        {
+            rgstrPaths[i] = RandomPath(rng);
+            rgpszPaths[i] = rgstrPaths[i].c_str();
+            strArena.append(rgstrPaths[i]).push_back('\0');
+        }
+
+        for (unsigned cThreads : { 1u, 4u, 0u })
+        {
+            SafeStrings::SplitPathOptions options;
+            options.cThreads        = cThreads;
+            options.cPathsPerThread = 100;
+
+            Columns columns(c_cPaths);
+            CHECK(SafeStrings::SplitPaths(rgpszPaths.data(), c_cPaths, columns.View(), options) == 0);
+            for (size_t i = 0; i < c_cPaths; i++)
+            {
+                if (!CHECK(columns.Matches(i, rgstrPaths[i])))
+                {
+                    fprintf(stderr, "    %u threads, path %zu \"%s\"\n", cThreads, i, rgpszPaths[i]);
+                    break;
+                }
+            }
+
+            Columns columnsArena(c_cPaths);
+            CHECK(SafeStrings::SplitPathArena(strArena.data(), strArena.size(), c_cPaths, columnsArena.View(), options) == 0);
+            for (size_t i = 0; i < c_cPaths; i++)
+            {
+                if (!CHECK(columnsArena.Matches(i, strArena.data() + columnsArena.rgibStart[i])))
+                    break;
+            }
+            CHECK(columnsArena.rgibStart[c_cPaths - 1] + rgstrPaths[c_cPaths - 1].size() + 1 == strArena.size());
+        }
+        CHECK(Test::TakeViolations() == 0);
+
+        // A null path is cleared and fails the batch after the rest are split
+
+        rgpszPaths[10] = nullptr;
+        Columns columns(c_cPaths);
+        CHECK(SafeStrings::SplitPaths(rgpszPaths.data(), c_cPaths, columns.View()) == EINVAL);
+        CHECK(columns.rgichEnd[10] == 0 && columns.Matches(11, rgstrPaths[11]) && columns.Matches(c_cPaths - 1, rgstrPaths[c_cPaths - 1]));
+        CHECK(Test::TakeViolations() == 1);
+
+        // An arena that ends inside its last path
+
+        CHECK(SafeStrings::SplitPathArena(strArena.data(), strArena.size() - 1, c_cPaths, columns.View()) == EINVAL);
+        CHECK(Test::TakeViolations() == 1);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestSplitPath();
+    TestSplitPaths();
+    TestSyntaxes();
+
+    return Test::Finish();
+}
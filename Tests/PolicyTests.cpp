@@ -0,0 +1,183 @@
+//--------------------------------------------------------------------------------
+// PolicyTests.cpp - The compile-time policies against the handler versions
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Each policy is checked against strcpy_s, strcat_s and _snprintf_s on the
+// same random inputs.  Ignore, Count, Throw and Abort must fail exactly
+// when they do, leaving the same output.  Truncate must keep what
+// _TRUNCATE would.  None may call the handler or set errno.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "Policy.h"
+#include "ScopedHandler.h"
+
+#include <errno.h>
+#include <random>
+#include <signal.h>
+#include <sys/wait.h>
+
+namespace Policy = SafeStrings::Policy;
+
+namespace
+{
+    std::string RandomWord(std::mt19937 & rng, size_t cchMax)
+    {
+        std::string str(rng() % (cchMax + 1), '\0');
+        for (char & ch : str)
+            ch = (char)('a' + rng() % 26);
+        return str;
+    }
+
+    // Expected
+    //
+    // The handler version's result and output, and what Truncate should
+    // leave instead when it overflowed.
+
+    struct Expected
+    {
+        errno_t     err;
+        std::string str;
+        std::string strTruncated;
+    };
+
+    Expected ExpectCopy(size_t destsz, const std::string & strSrc, const char * pszPrefix)
+    {
+        char szDest[32];
+        strcpy(szDest, pszPrefix);
+        errno_t err = pszPrefix[0] ? strcat_s(szDest, destsz, strSrc.c_str()) : strcpy_s(szDest, destsz, strSrc.c_str());
+        Test::TakeViolations();
+        return { err, szDest, (std::string(pszPrefix) + strSrc).substr(0, destsz - 1) };
+    }
+
+    // Run
+    //
+    // Copy or Append under TPolicy, checked against expected.
+
+    template <typename TPolicy>
+    bool Run(size_t destsz, const std::string & strSrc, const char * pszPrefix, const Expected & expected)
+    {
+        char szDest[32];
+        strcpy(szDest, pszPrefix);
+        errno = 0;
+
+        errno_t err;
+        try
+        {
+            err = pszPrefix[0] ? SafeStrings::Append<TPolicy>(szDest, destsz, strSrc.c_str())
+                               : SafeStrings::Copy<TPolicy>(szDest, destsz, strSrc.c_str());
+        }
+        catch (const SafeStrings::ConstraintError & error)
+        {
+            err = error.code().value();
+            if (!CHECK((std::is_same_v<TPolicy, Policy::Throw>) && err != 0))
+                return false;
+        }
+
+        bool fTruncated = TPolicy::c_fTruncate && expected.err == ERANGE;
+        return CHECK(err == (fTruncated ? STRUNCATE : expected.err) &&
+                     szDest == (fTruncated ? expected.strTruncated : expected.str) &&
+                     errno == 0 && Test::TakeViolations() == 0);
+    }
+
+    void TestCopyAndAppend()
+    {
+        std::mt19937 rng(42);
+
+        for (int run = 0; run < 5000; run++)
+        {
+            size_t      destsz   = 1 + rng() % 24;
+            std::string strSrc   = RandomWord(rng, 30);
+            std::string strStart = RandomWord(rng, destsz - 1);
+
+            for (const char * pszPrefix : { "", strStart.c_str() })
+            {
+                Expected expected = ExpectCopy(destsz, strSrc, pszPrefix);
+
+                SafeStrings::ResetThreadViolationCount();
+                bool fOk = Run<Policy::Truncate>(destsz, strSrc, pszPrefix, expected) &&
+                           Run<Policy::Ignore>(destsz, strSrc, pszPrefix, expected) &&
+                           Run<Policy::Count>(destsz, strSrc, pszPrefix, expected) &&
+                           Run<Policy::Throw>(destsz, strSrc, pszPrefix, expected);
+                fOk = fOk && CHECK(SafeStrings::ThreadViolationCount() == (expected.err ? 1u : 0u));
+                if (!fOk)
+                {
+                    fprintf(stderr, "    destsz %zu, \"%s\" + \"%s\"\n", destsz, pszPrefix, strSrc.c_str());
+                    return;
+                }
+            }
+        }
+
+        // The array forms, and the EINVAL checks every policy keeps
+
+        char szSmall[4];
+        CHECK(SafeStrings::Copy<Policy::Truncate>(szSmall, "abcdef") == STRUNCATE);
+        CHECK_STR(szSmall, "abc");
+        CHECK(SafeStrings::Append<Policy::Ignore>(szSmall, "d") == ERANGE);
+        CHECK_STR(szSmall, "");
+        CHECK(SafeStrings::Copy<Policy::Truncate>(szSmall, nullptr) == EINVAL);
+        CHECK(SafeStrings::Copy<Policy::Truncate>(nullptr, 4, "a") == EINVAL);
+        CHECK(SafeStrings::Copy<Policy::Ignore>(szSmall, 0, "a") == EINVAL);
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    void TestFormat()
+    {
+        char szBuffer[8];
+        char szExpected[8];
+
+        CHECK(SafeStrings::Format<Policy::Ignore>(szBuffer, "%d-%s", 12, "ab") == 5);
+        CHECK_STR(szBuffer, "12-ab");
+
+        _snprintf_s(szExpected, _TRUNCATE, "%d-%s", 12345, "abcdef");
+        CHECK(SafeStrings::Format<Policy::Truncate>(szBuffer, "%d-%s", 12345, "abcdef") == -1);
+        CHECK_STR(szBuffer, szExpected);
+
+        CHECK(SafeStrings::Format<Policy::Ignore>(szBuffer, "%d-%s", 12345, "abcdef") == -1);
+        CHECK_STR(szBuffer, "");
+
+        try
+        {
+            SafeStrings::Format<Policy::Throw>(szBuffer, "%s", (const char *) nullptr);
+            CHECK(false);
+        }
+        catch (const SafeStrings::ConstraintError & error)
+        {
+            CHECK(error.code().value() == EINVAL);
+        }
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    // TestAbort
+    //
+    // Abort stops the process even with a handler that would carry on.
+
+    void TestAbort()
+    {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            fclose(stderr);
+            char szSmall[4];
+            SafeStrings::Copy<Policy::Abort>(szSmall, "far too long");
+            _exit(0);
+        }
+        int status = 0;
+        CHECK(pid > 0 && waitpid(pid, &status, 0) == pid && WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestCopyAndAppend();
+    TestFormat();
+    TestAbort();
+
+    return Test::Finish();
+}
@@ -0,0 +1,164 @@
+//--------------------------------------------------------------------------------
+// ResultTests.cpp - TryCopy, TryAppend and TryFormat against the _s functions
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// On random inputs each must succeed exactly when the matching _s function
+// does, with the same output.  When the output doesn't fit, it must keep
+// what _TRUNCATE would and measure the whole.  None may call the handler or
+// touch errno.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "Result.h"
+
+#include <errno.h>
+#include <random>
+
+using SafeStrings::Result;
+using SafeStrings::Status;
+
+namespace
+{
+    std::string RandomWord(std::mt19937 & rng, size_t cchMax)
+    {
+        std::string str(rng() % (cchMax + 1), '\0');
+        for (char & ch : str)
+            ch = (char)('a' + rng() % 26);
+        return str;
+    }
+
+    // Matches
+    //
+    // result and buffer against what the _s function left in szExpected and
+    // returned as err, given that the whole output was strFull.
+
+    bool Matches(const Result & result, const char * buffer, size_t destsz, errno_t err, const char * szExpected,
+                 const std::string & strFull)
+    {
+        if (err == 0)
+            return result.Ok() && result.Errno() == 0 && result.cchWritten == strFull.size() &&
+                   result.cchNeeded == strFull.size() && strcmp(buffer, szExpected) == 0;
+
+        std::string strKept = strFull.substr(0, destsz - 1);
+        return result.status == Status::Truncated && !result && result.Errno() == STRUNCATE &&
+               result.cchWritten == strKept.size() && result.cchNeeded == strFull.size() && buffer == strKept;
+    }
+
+    void TestCopyAndAppend()
+    {
+        std::mt19937 rng(23);
+
+        for (int run = 0; run < 20000; run++)
+        {
+            size_t      destsz   = 1 + rng() % 40;
+            std::string strSrc   = RandomWord(rng, 60);
+            std::string strStart = RandomWord(rng, destsz - 1);
+
+            char szExpected[64];
+            char szActual[64];
+
+            errno_t err = strcpy_s(szExpected, destsz, strSrc.c_str());
+            Test::TakeViolations();
+            errno = 0;
+            Result result = SafeStrings::TryCopy(szActual, destsz, strSrc.c_str());
+            bool   fOk    = Matches(result, szActual, destsz, err, szExpected, strSrc) && errno == 0;
+
+            strcpy(szExpected, strStart.c_str());
+            strcpy(szActual, strStart.c_str());
+            err = strcat_s(szExpected, destsz, strSrc.c_str());
+            Test::TakeViolations();
+            errno  = 0;
+            result = SafeStrings::TryAppend(szActual, destsz, strSrc.c_str());
+            fOk    = fOk && Matches(result, szActual, destsz, err, szExpected, strStart + strSrc) && errno == 0;
+
+            if (!CHECK(fOk && Test::TakeViolations() == 0))
+            {
+                fprintf(stderr, "    destsz %zu, \"%s\" + \"%s\"\n", destsz, strStart.c_str(), strSrc.c_str());
+                return;
+            }
+        }
+
+        // The array forms, which share FixedCopy with the _s ones
+
+        char szSmall[8];
+        Result result = SafeStrings::TryCopy(szSmall, "abcdefghij");
+        CHECK(result.status == Status::Truncated && result.cchWritten == 7 && result.cchNeeded == 10);
+        CHECK_STR(szSmall, "abcdefg");
+
+        strcpy(szSmall, "ab");
+        result = SafeStrings::TryAppend(szSmall, "cd");
+        CHECK(result && result.cchWritten == 4);
+        CHECK_STR(szSmall, "abcd");
+
+        memset(szSmall, 'x', sizeof szSmall);
+        result = SafeStrings::TryAppend(szSmall, "a");
+        CHECK(result.status == Status::NotTerminated && result.Errno() == EINVAL && szSmall[0] == '\0');
+
+        CHECK(SafeStrings::TryCopy(szSmall, nullptr).status == Status::InvalidArgument && szSmall[0] == '\0');
+        CHECK(SafeStrings::TryCopy(nullptr, 8, "a").status == Status::InvalidArgument);
+        CHECK(SafeStrings::TryAppend(szSmall, 0, "a").status == Status::InvalidArgument);
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    void TestFormat()
+    {
+        std::mt19937 rng(5);
+
+        for (int run = 0; run < 5000; run++)
+        {
+            size_t      size   = 1 + rng() % 40;
+            std::string strArg = RandomWord(rng, 30);
+            int         value  = (int)(rng() - (rng() % 2 ? 0u : 1000000u));
+
+            char szFull[128];
+            snprintf(szFull, sizeof szFull, "%d:%s|%5x", value, strArg.c_str(), (unsigned) value & 0xfff);
+
+            char szExpected[64];
+            char szActual[64];
+            int  cch = _snprintf_s(szExpected, size, _TRUNCATE, "%d:%s|%5x", value, strArg.c_str(), (unsigned) value & 0xfff);
+            errno = 0;
+            Result result = SafeStrings::TryFormat(szActual, size, "%d:%s|%5x", value, strArg.c_str(), (unsigned) value & 0xfff);
+
+            if (!CHECK(Matches(result, szActual, size, cch < 0 ? STRUNCATE : 0, szExpected, szFull) && errno == 0))
+            {
+                fprintf(stderr, "    size %zu, \"%s\"\n", size, szFull);
+                return;
+            }
+        }
+
+        char szBuffer[8];
+        CHECK(SafeStrings::TryFormat(szBuffer, "%s", "fits") && strcmp(szBuffer, "fits") == 0);
+        CHECK(SafeStrings::TryFormat(szBuffer, nullptr).status == Status::InvalidArgument);
+        CHECK(SafeStrings::TryFormat(szBuffer, "%s", (const char *) nullptr).status == Status::InvalidArgument);
+        CHECK(SafeStrings::TryFormat(szBuffer, "%ls", L"\xd800").Errno() == EILSEQ);
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    // TestLayout
+    //
+    // cchNeeded holds any length a string can have alongside the status.
+
+    void TestLayout()
+    {
+        Result result = { 1, SIZE_MAX >> 8, Status::EncodingError };
+        CHECK(result.cchNeeded == SIZE_MAX >> 8 && result.status == Status::EncodingError);
+        CHECK(result.Errno() == EILSEQ);
+
+        result.cchNeeded = 12345;
+        CHECK(result.cchNeeded == 12345 && result.status == Status::EncodingError);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestCopyAndAppend();
+    TestFormat();
+    TestLayout();
+
+    return Test::Finish();
+}
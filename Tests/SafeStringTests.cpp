@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------------
+// SafeStringTests.cpp - SafeString<N> against the functions it stands in for
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Each operation is run next to its cheat-sheet counterpart on a buffer of
+// the same capacity, and must agree with it on the result, the string left
+// behind and the handler calls, while keeping Length() right.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "SafeString.h"
+
+#include <errno.h>
+#include <random>
+
+using SafeStrings::SafeString;
+
+namespace
+{
+    const size_t c_cchCapacity = 15;
+
+    std::string RandomWord(std::mt19937 & rng, size_t cchMax)
+    {
+        std::string str(rng() % (cchMax + 1), '\0');
+        for (char & ch : str)
+            ch = (char)('a' + rng() % 26);
+        return str;
+    }
+
+    bool Matches(const SafeString<c_cchCapacity> & s, const char * psz)
+    {
+        return strcmp(s.c_str(), psz) == 0 && s.Length() == strlen(psz);
+    }
+
+    void TestCopyAndAppend()
+    {
+        std::mt19937 rng(42);
+
+        for (int run = 0; run < 2000; run++)
+        {
+            SafeString<c_cchCapacity> s;
+            char szBuffer[c_cchCapacity + 1];
+
+            std::string str = RandomWord(rng, 24);
+            errno_t errSafe = s.Copy(str.c_str());
+            int     cSafe   = Test::TakeViolations();
+            errno_t errCrt  = strcpy_s(szBuffer, sizeof szBuffer, str.c_str());
+            CHECK(errSafe == errCrt && cSafe == Test::TakeViolations() && Matches(s, szBuffer));
+
+            for (int iPiece = 0; iPiece < 4; iPiece++)
+            {
+                str     = RandomWord(rng, 8);
+                errSafe = (iPiece % 2) ? s.Append(str.c_str()) : s.Append(std::string_view(str));
+                cSafe   = Test::TakeViolations();
+                errCrt  = strcat_s(szBuffer, sizeof szBuffer, str.c_str());
+                if (!CHECK(errSafe == errCrt && cSafe == Test::TakeViolations() && Matches(s, szBuffer)))
+                    return;
+            }
+        }
+
+        SafeString<c_cchCapacity> s("abc");
+        CHECK(s.Copy(nullptr) == EINVAL);
+        CHECK(s.empty());
+        CHECK(s.Append(nullptr) == EINVAL);
+        CHECK(Test::TakeViolations() == 2);
+
+        static_assert(SafeString<8>("abc").Length() == 3);
+        static_assert([] { SafeString<8> s; s.Copy("abcd"); s.Append("efgh"); return s.Length(); }() == 8);
+    }
+
+    void TestFormat()
+    {
+        SafeString<c_cchCapacity> s;
+        char szBuffer[c_cchCapacity + 1];
+
+        CHECK(s.Format("%d-%s", 42, "abc") == 0);
+        CHECK(Matches(s, "42-abc"));
+        CHECK(s.Format("%f", 0.1) == 0);
+        CHECK(Matches(s, "0.100000"));
+
+        CHECK(s.Format("%s", "this is far too long") == ERANGE);
+        CHECK(Matches(s, ""));
+        CHECK(Test::TakeViolations() == 1);
+
+        CHECK(s.FormatTruncate("%s", "this is far too long") == STRUNCATE);
+        _snprintf_s(szBuffer, sizeof szBuffer, _TRUNCATE, "%s", "this is far too long");
+        CHECK(Matches(s, szBuffer));
+        CHECK(s.Length() == c_cchCapacity);
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(s.FormatTruncate("%s", (const char *) nullptr) == EINVAL);
+        CHECK(s.empty());
+        CHECK(Test::TakeViolations() == 1);
+
+        // A truncated result that starts with a null character is still a
+        // truncation, not a failure
+
+        SafeString<3> s3;
+        errno = 0;
+        CHECK(s3.FormatTruncate("%c%s", 0, "abcdef") == STRUNCATE);
+        CHECK(s3.Length() == 3);
+        CHECK(s3[0] == '\0' && s3[1] == 'a' && s3[2] == 'b');
+        CHECK(Test::TakeViolations() == 0);
+
+        CHECK(s3.Format("%c%s", 0, "ab") == 0);
+        CHECK(s3.Length() == 3);
+        CHECK(s3.Format("%c%s", 0, "abc") == ERANGE);
+        CHECK(s3.Length() == 0);
+        CHECK(Test::TakeViolations() == 1);
+    }
+
+    void TestSplitPath()
+    {
+        SafeString<64> path("C:\\dir\\sub\\name.ext");
+        SafeString<2>  drive;
+        SafeString<16> dir;
+        SafeString<8>  fname;
+        SafeString<8>  ext;
+
+        CHECK(path.SplitPath(drive, dir, fname, ext) == 0);
+        CHECK(std::string_view(drive) == "C:");
+        CHECK(std::string_view(dir) == "\\dir\\sub\\");
+        CHECK(std::string_view(fname) == "name");
+        CHECK(std::string_view(ext) == ".ext");
+        CHECK(Test::TakeViolations() == 0);
+
+        SafeString<2> fnameSmall;
+        CHECK(path.SplitPath(drive, dir, fnameSmall, ext) == ERANGE);
+        CHECK(drive.empty() && dir.empty() && fnameSmall.empty() && ext.empty());
+        CHECK(Test::TakeViolations() == 1);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestCopyAndAppend();
+    TestFormat();
+    TestSplitPath();
+
+    return Test::Finish();
+}
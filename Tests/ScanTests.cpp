@@ -0,0 +1,261 @@
+//--------------------------------------------------------------------------------
+// ScanTests.cpp - The tokenizer and the scan plans against _snscanf_s
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Each of these promises _snscanf_s's answer for the same input, length
+// and buffers, so each is run side by side with it on random lines and
+// must agree on the result, what lands in every buffer and the handler
+// calls.
+//
+//--------------------------------------------------------------------------------
+
+#include "TestCommon.h"
+#include "ScanPlan.h"
+#include "Tokenizer.h"
+
+#include <errno.h>
+#include <random>
+
+namespace
+{
+    // RandomLine
+    //
+    // Runs of up to 20 letters, separated by up to two characters of mixed
+    // whitespace - sometimes none, which joins them into one longer word.
+
+    std::string RandomLine(std::mt19937 & rng)
+    {
+        static const char c_rgchSpace[] = " \t\n\v\f\r";
+
+        std::string str;
+        size_t cWords = rng() % 7;
+        for (size_t iWord = 0; iWord < cWords; iWord++)
+        {
+            for (size_t cch = rng() % 3; cch > 0; cch--)
+                str += c_rgchSpace[rng() % (sizeof c_rgchSpace - 1)];
+            for (size_t cch = 1 + rng() % 20; cch > 0; cch--)
+                str += (char)('a' + rng() % 26);
+        }
+        for (size_t cch = rng() % 3; cch > 0; cch--)
+            str += ' ';
+        return str;
+    }
+
+    // TestTokenize
+    //
+    // Tokenize and TokenizeCopy against "%s %s %s %s", with buffers big
+    // enough for every word, then with buffers that often aren't, and with
+    // lengths that cut the line short.
+
+    void TestTokenize()
+    {
+        std::mt19937 rng(42);
+
+        for (int run = 0; run < 20000; run++)
+        {
+            std::string strLine = RandomLine(rng);
+            size_t      length  = (run % 3 == 0) ? rng() % (strLine.size() + 1) : strLine.size() + 1;
+
+            char szA[160], szB[160], szC[160], szD[160];
+            szA[0] = szB[0] = szC[0] = szD[0] = '\0';
+            int cExpected = _snscanf_s(strLine.c_str(), length, "%s %s %s %s",
+                                       szA, (unsigned) sizeof szA, szB, (unsigned) sizeof szB,
+                                       szC, (unsigned) sizeof szC, szD, (unsigned) sizeof szD);
+
+            std::string_view rgTokens[4];
+            size_t cTokens = SafeStrings::Tokenize(strLine.c_str(), length, rgTokens);
+            const char * rgpsz[] = { szA, szB, szC, szD };
+            bool fOk = (int) cTokens == (cExpected == EOF ? 0 : cExpected);
+            for (size_t iToken = 0; fOk && iToken < cTokens; iToken++)
+                fOk = rgTokens[iToken] == rgpsz[iToken];
+            if (!CHECK(fOk))
+            {
+                fprintf(stderr, "    \"%s\", length %zu: %zu tokens, _snscanf_s %d\n", strLine.c_str(), length, cTokens, cExpected);
+                return;
+            }
+
+            // Buffers of 4 to 12 characters, so long words fail the scan
+
+            size_t rgcch[4];
+            for (size_t & cch : rgcch)
+                cch = 4 + rng() % 9;
+
+            char rgszExpected[4][12], rgszActual[4][12];
+            memset(rgszExpected, '#', sizeof rgszExpected);
+            memset(rgszActual, '#', sizeof rgszActual);
+
+            cExpected = _snscanf_s(strLine.c_str(), length, "%s %s %s %s",
+                                   rgszExpected[0], (unsigned) rgcch[0], rgszExpected[1], (unsigned) rgcch[1],
+                                   rgszExpected[2], (unsigned) rgcch[2], rgszExpected[3], (unsigned) rgcch[3]);
+            int cViolationsExpected = Test::TakeViolations();
+
+            const SafeStrings::TokenBuffer rgBuffers[] =
+            {
+                { rgszActual[0], rgcch[0] }, { rgszActual[1], rgcch[1] }, { rgszActual[2], rgcch[2] }, { rgszActual[3], rgcch[3] },
+            };
+            int cActual = SafeStrings::TokenizeCopy(strLine.c_str(), length, rgBuffers, 4);
+
+            if (!CHECK(cActual == cExpected && memcmp(rgszActual, rgszExpected, sizeof rgszActual) == 0 &&
+                       Test::TakeViolations() == cViolationsExpected))
+            {
+                fprintf(stderr, "    \"%s\", length %zu: TokenizeCopy %d, _snscanf_s %d\n", strLine.c_str(), length, cActual, cExpected);
+                return;
+            }
+        }
+
+        // A long line a chunk at a time
+
+        const char       szLine[] = " one two  three\tfour five ";
+        std::string_view rgTokens[2];
+        size_t           ichRest = 0;
+        CHECK(SafeStrings::Tokenize(szLine, sizeof szLine, rgTokens, &ichRest) == 2);
+        CHECK(rgTokens[0] == "one" && rgTokens[1] == "two");
+        CHECK(SafeStrings::Tokenize(szLine + ichRest, sizeof szLine - ichRest, rgTokens, &ichRest) == 2);
+        CHECK(rgTokens[0] == "three" && rgTokens[1] == "four");
+
+        CHECK(SafeStrings::Tokenize(nullptr, 8, rgTokens) == 0);
+        CHECK(Test::TakeViolations() == 1);
+
+        char szWord[8];
+        CHECK(SafeStrings::TokenizeCopy(" \t ", 4, szWord) == EOF);
+        CHECK(Test::TakeViolations() == 0);
+    }
+
+    // Record
+    //
+    // Somewhere for every conversion the scan tests use to land.  Each scan
+    // starts from the same fill, so bytes a scan didn't assign compare too.
+
+    struct Record
+    {
+        int                i;
+        unsigned           u;
+        long long          ll;
+        unsigned long long ull;
+        short              h;
+        signed char        hh;
+        float              f;
+        double             d;
+        char               sz[8];
+        char               rgch[3];
+        char               szSet[6];
+        int                n;
+    };
+
+    // RandomRecord
+    //
+    // Fields that scan cleanly, fields that overflow, and fields that stop
+    // a conversion part way, with the odd punctuation the patterns expect.
+
+    std::string RandomRecord(std::mt19937 & rng)
+    {
+        static const char * const c_rgpszFields[] =
+        {
+            "0", "42", "-17", "+9", "0x1f", "-0X7fffffff", "077", "2147483648", "-9223372036854775809",
+            "18446744073709551616", "4294967296", "300", "-129", "ffff", "12abc", "abc", "toolongword", "z",
+            "3.25", "-1e-3", "1e400", "inf", "nan", ".5", "-", "+", "0x", "1,2", "%", "%%", ",", "a-b_c",
+        };
+
+        std::string str;
+        for (size_t cFields = rng() % 6; cFields > 0; cFields--)
+        {
+            str += c_rgpszFields[rng() % std::size(c_rgpszFields)];
+            if (rng() % 4 != 0)
+                str += (rng() % 2) ? " " : "\t ";
+        }
+        return str;
+    }
+
+    // CompareScan
+    //
+    // The three scanners on one input, each into its own Record.
+
+    template <typename Reference, typename Compiled, typename Planned>
+    bool CompareScan(const char * pszPattern, const std::string & strInput, size_t length,
+                     Reference && reference, Compiled && compiled, Planned && planned)
+    {
+        Record rgRecords[3];
+        int    rgResults[3];
+        int    rgcViolations[3];
+        memset(rgRecords, 0x5a, sizeof rgRecords);
+
+        rgResults[0] = reference(rgRecords[0]);
+        rgcViolations[0] = Test::TakeViolations();
+        rgResults[1] = compiled(rgRecords[1]);
+        rgcViolations[1] = Test::TakeViolations();
+        rgResults[2] = planned(rgRecords[2]);
+        rgcViolations[2] = Test::TakeViolations();
+
+        for (int iScanner = 1; iScanner < 3; iScanner++)
+        {
+            if (!CHECK(rgResults[iScanner] == rgResults[0] && rgcViolations[iScanner] == rgcViolations[0] &&
+                       memcmp(&rgRecords[iScanner], &rgRecords[0], sizeof(Record)) == 0))
+            {
+                fprintf(stderr, "    %s on \"%s\", length %zu: %s gave %d, _snscanf_s %d\n", pszPattern, strInput.c_str(),
+                        length, iScanner == 1 ? "Scan" : "ScanPlan", rgResults[iScanner], rgResults[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+// Runs _snscanf_s, Scan<PATTERN> and a ScanPlan for PATTERN with the same
+// arguments, written in terms of a Record r
+
+#define COMPARE_SCAN(PATTERN, ...)                                                                  \
+    do                                                                                              \
+    {                                                                                               \
+        SafeStrings::ScanPlan plan(PATTERN);                                                        \
+        const char * input = strInput.c_str();                                                      \
+        if (!CompareScan(PATTERN, strInput, length,                                                 \
+                         [&](Record & r) { return _snscanf_s(input, length, PATTERN, __VA_ARGS__); },\
+                         [&](Record & r) { return SafeStrings::Scan<PATTERN>(input, length, __VA_ARGS__); },\
+                         [&](Record & r) { return plan.Scan(input, length, __VA_ARGS__); }))        \
+            return;                                                                                 \
+    } while (0)
+
+    // TestScan
+    //
+    // Patterns covering each kind of directive, on random records with
+    // lengths that sometimes cut them short.
+
+    void TestScan()
+    {
+        std::mt19937 rng(5);
+
+        for (int run = 0; run < 20000; run++)
+        {
+            std::string strInput = RandomRecord(rng);
+            size_t      length   = (run % 4 == 0) ? rng() % (strInput.size() + 1) : strInput.size() + 1;
+
+            COMPARE_SCAN("%d %s %x", &r.i, r.sz, sizeof r.sz, &r.u);
+            COMPARE_SCAN("%i,%i %n", &r.i, &r.u, &r.n);
+            COMPARE_SCAN("%lld %llu %hd %hhd", &r.ll, &r.ull, &r.h, &r.hh);
+            COMPARE_SCAN("%3d%2s%o", &r.i, r.sz, sizeof r.sz, &r.u);
+            COMPARE_SCAN("%f %lf %*s %X", &r.f, &r.d, &r.u);
+            COMPARE_SCAN("%c%2c %%%d", r.rgch, sizeof r.rgch, r.rgch + 1, (size_t) 2, &r.i);
+            COMPARE_SCAN("%[a-z0-9] %[^ ]%n", r.szSet, sizeof r.szSet, r.sz, sizeof r.sz, &r.n);
+        }
+
+        Record r;
+        CHECK(SafeStrings::Scan<"%d">(nullptr, 4, &r.i) == EOF);
+        CHECK(Test::TakeViolations() == 1);
+
+        SafeStrings::ScanPlan planBad("%d %y");
+        CHECK(planBad.Scan("1 2", 4, &r.i, &r.u) == EOF);
+        CHECK(planBad.Scan("1 2", 4, &r.i, &r.u) == EOF);
+        CHECK(Test::TakeViolations() == 2);
+    }
+}
+
+int main()
+{
+    Test::Begin();
+
+    TestTokenize();
+    TestScan();
+
+    return Test::Finish();
+}
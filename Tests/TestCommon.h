@@ -0,0 +1,151 @@
+//--------------------------------------------------------------------------------
+// TestCommon.h - Minimal checking harness shared by the SafeStrings tests
+//--------------------------------------------------------------------------------
+//
+// Provided under the GPL Gnu Public License 2.0
+//
+// Each test program is a plain main() that runs its checks and returns
+// Test::Finish(), which is nonzero if any failed; CTest runs them all.  A
+// failed CHECK reports itself and carries on, so one run shows every
+// failure rather than just the first.
+//
+// The invalid parameter handler is replaced for the whole run by one that
+// counts and returns, so a test can provoke a violation and then check
+// that it was reported - TakeViolations() hands back the count since the
+// last call.  GuardedBuffer places bytes so they end right against an
+// unmapped page, which turns any read past them into a crash.
+//
+//--------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SafeStrings.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Test
+{
+    inline int g_cChecks;
+    inline int g_cFailures;
+    inline int g_cViolations;
+
+    inline bool Check(bool fPassed, const char * pszExpression, const char * pszFile, int line)
+    {
+        g_cChecks++;
+        if (!fPassed)
+        {
+            g_cFailures++;
+            fprintf(stderr, "%s(%d): CHECK(%s) failed\n", pszFile, line, pszExpression);
+        }
+        return fPassed;
+    }
+
+    // CheckString
+    //
+    // Compares two strings, printing both when they differ.
+
+    inline bool CheckString(const char * pszActual, const char * pszExpected,
+                            const char * pszExpression, const char * pszFile, int line)
+    {
+        bool fPassed = pszActual != nullptr && strcmp(pszActual, pszExpected) == 0;
+        if (!Check(fPassed, pszExpression, pszFile, line))
+            fprintf(stderr, "    got      \"%s\"\n    expected \"%s\"\n", pszActual ? pszActual : "(null)", pszExpected);
+        return fPassed;
+    }
+
+    inline bool CheckString(const std::string & strActual, const char * pszExpected,
+                            const char * pszExpression, const char * pszFile, int line)
+    {
+        return CheckString(strActual.c_str(), pszExpected, pszExpression, pszFile, line);
+    }
+
+    // Handler
+    //
+    // Counts violations instead of aborting.
+
+    inline void CountViolation(const wchar_t *, const wchar_t *, const wchar_t *, unsigned int, uintptr_t)
+    {
+        g_cViolations++;
+    }
+
+    inline int TakeViolations()
+    {
+        int cViolations = g_cViolations;
+        g_cViolations = 0;
+        return cViolations;
+    }
+
+    inline void Begin()
+    {
+        _set_invalid_parameter_handler(CountViolation);
+    }
+
+    inline int Finish()
+    {
+        if (g_cFailures != 0)
+            fprintf(stderr, "%d of %d checks failed\n", g_cFailures, g_cChecks);
+        else
+            printf("%d checks passed\n", g_cChecks);
+        return g_cFailures != 0;
+    }
+
+    // GuardedBuffer
+    //
+    // A few writable pages followed by one that isn't mapped.  Place copies
+    // bytes so that the last of them is the last byte before the guard.
+
+    class GuardedBuffer
+    {
+    public:
+        static const size_t c_cPages = 16;
+
+        GuardedBuffer()
+        {
+            _cbPage = (size_t) sysconf(_SC_PAGESIZE);
+            _pb = (char *) mmap(nullptr, (c_cPages + 1) * _cbPage, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (_pb == MAP_FAILED || mprotect(_pb + c_cPages * _cbPage, _cbPage, PROT_NONE) != 0)
+            {
+                perror("GuardedBuffer");
+                exit(2);
+            }
+        }
+
+        ~GuardedBuffer()
+        {
+            munmap(_pb, (c_cPages + 1) * _cbPage);
+        }
+
+        GuardedBuffer(const GuardedBuffer &) = delete;
+        GuardedBuffer & operator=(const GuardedBuffer &) = delete;
+
+        size_t Capacity() const
+        {
+            return c_cPages * _cbPage;
+        }
+
+        char * Place(const void * pb, size_t cb)
+        {
+            char * pDest = End() - cb;
+            memcpy(pDest, pb, cb);
+            return pDest;
+        }
+
+        char * End() const
+        {
+            return _pb + c_cPages * _cbPage;
+        }
+
+    private:
+        char * _pb;
+        size_t _cbPage;
+    };
+}
+
+#define CHECK(expr)             Test::Check((expr), #expr, __FILE__, __LINE__)
+#define CHECK_STR(actual, str)  Test::CheckString((actual), (str), #actual " == " #str, __FILE__, __LINE__)